@@ -3,10 +3,23 @@
 #define _UNIT_TEST false
 #include "liolib/Test.hpp"
 
+#include <vector>
+
+#include <cerrno>
+#include <cstring> // strcmp()
+#include <ctime> // clock_gettime()
+
+#include <dirent.h> // opendir()
+#include <sys/stat.h> // lstat()
+#include <sys/timerfd.h> // timerfd_create()
+#include <unistd.h> // read() close()
+
+#include "liolib/AsyncIo.hpp" // addFdToEpoll()
+
 
 namespace lio {
 
-// ===== Exception Implementation ===== 
+// ===== Exception Implementation =====
 const char* const
 AsyncInotify::Exception::exceptionMessages_[] = {
   ASYNCINOTIFY_EXCEPTION_MESSAGES
@@ -26,31 +39,368 @@ const AsyncInotify::ExceptionType
 AsyncInotify::Exception::type() const noexcept {
   return this->exceptionType_;
 }
-// ===== Exception Implementation End ===== 
+// ===== Exception Implementation End =====
 
+static const uint32_t WATCH_EVENTS =
+  IN_CREATE | IN_MODIFY | IN_DELETE | IN_MOVE | IN_ONLYDIR;
 
-AsyncInotify::AsyncInotify() {
-  DEBUG_FUNC_START; // Prints out function name in yellow
+AsyncInotify::AsyncInotify(int epollFd, Config config) :
+  config_(config),
+  epollFd_(epollFd),
+  inotiFd_(inotify_init1(IN_NONBLOCK | IN_CLOEXEC)),
+  timerFd_(timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC)),
+  buffer_(),
+  armedDeadline_(0),
+  numEventsRead_(0),
+  numEventsDelivered_(0),
+  numOverflows_(0)
+{
+  DEBUG_FUNC_START;
+  if (this->inotiFd_ < 0 || this->timerFd_ < 0) {
+    DEBUG_cerr << "Failed to initialize. errno: " << errno << endl;
+    if (this->inotiFd_ >= 0) {
+      close(this->inotiFd_);
+    }
+    if (this->timerFd_ >= 0) {
+      close(this->timerFd_);
+    }
+    throw Exception(ExceptionType::INIT_FAIL);
+  }
+  // One event holds a name of up to NAME_MAX.
+  if (this->config_.readBufferSize < sizeof(struct inotify_event) + NAME_MAX + 1) {
+    this->config_.readBufferSize = sizeof(struct inotify_event) + NAME_MAX + 1;
+  }
+  this->buffer_.reset(new char[this->config_.readBufferSize]);
 
+  AsyncIo::addFdToEpoll(this->epollFd_, this->inotiFd_);
+  AsyncIo::addFdToEpoll(this->epollFd_, this->timerFd_);
 }
 
 AsyncInotify::~AsyncInotify() {
   DEBUG_FUNC_START;
+  // Closing removes them from epoll as well.
+  close(this->timerFd_);
+  close(this->inotiFd_);
+}
+
+size_t AsyncInotify::AddToWatch(const string& dirPath, bool isRecursive) {
+  return this->addTree(dirPath, isRecursive, false);
+}
+
+void AsyncInotify::RemoveFromWatch(const string& dirPath) {
+  string path = dirPath;
+  if (path.length() > 1 && path.back() == '/') {
+    path.pop_back();
+  }
+  const string prefix = path + "/";
+  std::vector<int> wds;
+  for (auto& watch : this->watches_) {
+    if (watch.second.path == path || watch.second.path.compare(0, prefix.length(), prefix) == 0) {
+      wds.push_back(watch.first);
+    }
+  }
+  for (int wd : wds) {
+    this->removeWatch(wd);
+  }
+}
+
+bool AsyncInotify::IsWatching(const string& dirPath) const {
+  string path = dirPath;
+  if (path.length() > 1 && path.back() == '/') {
+    path.pop_back();
+  }
+  return this->watchDescriptors_.find(path) != this->watchDescriptors_.end();
+}
+
+void AsyncInotify::SetFileCreateHandler(Handler handler) {
+  this->fileCreateHandler_ = handler;
+}
+
+void AsyncInotify::SetFileModifyHandler(Handler handler) {
+  this->fileModifyHandler_ = handler;
+}
+
+void AsyncInotify::SetFileDeleteHandler(Handler handler) {
+  this->fileDeleteHandler_ = handler;
+}
+
+void AsyncInotify::SetOverflowHandler(OverflowHandler handler) {
+  this->overflowHandler_ = handler;
+}
+
+bool AsyncInotify::HandleFdEvent(int fd) {
+  if (fd == this->inotiFd_) {
+    this->readEvents();
+    if (this->config_.debounceMs == 0) {
+      this->deliver(getNow());
+    } else if (this->pendingOrder_.empty() == false && this->armedDeadline_ == 0) {
+      this->armTimer(this->pending_[this->pendingOrder_.front()].deadline);
+    }
+    return true;
+  }
+
+  if (fd == this->timerFd_) {
+    uint64_t numExpirations = 0;
+    while (read(this->timerFd_, &numExpirations, sizeof(numExpirations)) > 0) { }
+    this->armedDeadline_ = 0;
+    this->deliver(getNow());
+    return true;
+  }
 
+  return false;
 }
 
-void AsyncInotify::sampleFunc() {
-  DEBUG_POINT; // prints out LINE NUMBER and a messaage "POINT REACHED" in GREEN.
-  DEBUG_cout << "Prints out Debug message with Pid, FileName, and LineNumber in Blue" << endl;
-  DEBUG_cout << "This line is removed when _DEBUG is false." << endl;
-  
-  DEBUG_cerr << "Prints out error message in Red." << endl; 
-  DEBUG_cerr << "This line persists even if DEBUG mode is off. When Debug mode is on, it prints more information with color." << endl; 
+size_t AsyncInotify::Flush() {
+  return this->deliver(UINT64_MAX);
+}
 
-  DEBUG_clog << "Prints out log" << endl;
+int AsyncInotify::GetInotifyFd() const {
+  return this->inotiFd_;
 }
 
-//AsyncInotify::
+int AsyncInotify::GetTimerFd() const {
+  return this->timerFd_;
+}
+
+AsyncInotify::Stats AsyncInotify::GetStats() const {
+  Stats stats;
+  stats.numEventsRead = this->numEventsRead_;
+  stats.numEventsDelivered = this->numEventsDelivered_;
+  stats.numOverflows = this->numOverflows_;
+  stats.numWatches = this->watches_.size();
+  return stats;
+}
+
+size_t AsyncInotify::addTree(const string& dirPath, bool isRecursive, bool isNew) {
+  string root = dirPath;
+  if (root.length() > 1 && root.back() == '/') {
+    root.pop_back();
+  }
+
+  size_t numAdded = 0;
+  std::vector<string> dirs(1, root);
+  while (dirs.empty() == false) {
+    const string dir = dirs.back();
+    dirs.pop_back();
+
+    if (this->watchDescriptors_.find(dir) == this->watchDescriptors_.end()) {
+      if (this->addWatch(dir, isRecursive) < 0) {
+        continue;
+      }
+      numAdded += 1;
+    }
+    if (isRecursive == false && isNew == false) {
+      break;
+    }
+
+    DIR* dirStream = opendir(dir.c_str());
+    if (dirStream == nullptr) {
+      continue;
+    }
+    struct dirent* entry = nullptr;
+    while ((entry = readdir(dirStream)) != nullptr) {
+      if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
+        continue;
+      }
+      string entryPath = dir;
+      if (entryPath.back() != '/') {
+        entryPath.push_back('/');
+      }
+      entryPath.append(entry->d_name);
+
+      unsigned char type = entry->d_type;
+      if (type == DT_UNKNOWN) {
+        struct stat entryStat;
+        if (lstat(entryPath.c_str(), &entryStat) != 0) {
+          continue;
+        }
+        type = S_ISDIR(entryStat.st_mode) ? DT_DIR : (S_ISREG(entryStat.st_mode) ? DT_REG : 0);
+      }
+      if (type == DT_DIR && isRecursive == true) {
+        dirs.push_back(entryPath);
+      } else if (type == DT_REG && isNew == true) {
+        this->addChange(entryPath, Change::CREATE);
+      }
+    }
+    closedir(dirStream);
+  }
+  return numAdded;
+}
+
+int AsyncInotify::addWatch(const string& dirPath, bool isRecursive) {
+  int wd = inotify_add_watch(this->inotiFd_, dirPath.c_str(), WATCH_EVENTS);
+  if (wd < 0) {
+    DEBUG_cerr << "Failed to add to watch. path: " << dirPath << " errno: " << errno << endl;
+    return -1;
+  }
+  Watch& watch = this->watches_[wd];
+  if (watch.path.empty() == false) {
+    // Same directory by another path.
+    this->watchDescriptors_.erase(watch.path);
+  }
+  watch.path = dirPath;
+  watch.isRecursive = isRecursive;
+  this->watchDescriptors_[dirPath] = wd;
+  return wd;
+}
+
+void AsyncInotify::removeWatch(int wd) {
+  auto it = this->watches_.find(wd);
+  if (it == this->watches_.end()) {
+    return;
+  }
+  inotify_rm_watch(this->inotiFd_, wd);
+  this->watchDescriptors_.erase(it->second.path);
+  this->watches_.erase(it);
+}
+
+void AsyncInotify::readEvents() {
+  char* buffer = this->buffer_.get();
+  while (true) {
+    const ssize_t readCount = read(this->inotiFd_, buffer, this->config_.readBufferSize);
+    if (readCount <= 0) {
+      if (readCount < 0 && errno != EAGAIN) {
+        DEBUG_cerr << "read Error. errno: " << errno << endl;
+      }
+      break;
+    }
+
+    ssize_t index = 0;
+    while (readCount > index) {
+      const struct inotify_event* event = (const struct inotify_event*) &buffer[index];
+      index += sizeof(struct inotify_event) + event->len;
+      this->numEventsRead_ += 1;
+
+      if ((event->mask & IN_Q_OVERFLOW) != 0) {
+        this->numOverflows_ += 1;
+        if (this->overflowHandler_) {
+          this->overflowHandler_();
+        }
+        continue;
+      }
+      if ((event->mask & IN_IGNORED) != 0) {
+        // Directory is gone or the watch was removed.
+        auto it = this->watches_.find(event->wd);
+        if (it != this->watches_.end()) {
+          this->watchDescriptors_.erase(it->second.path);
+          this->watches_.erase(it);
+        }
+        continue;
+      }
+
+      auto it = this->watches_.find(event->wd);
+      if (it == this->watches_.end() || event->len == 0) {
+        continue;
+      }
+      string filePath = it->second.path;
+      if (filePath.back() != '/') {
+        filePath.push_back('/');
+      }
+      filePath.append(event->name);
+
+      if ((event->mask & IN_ISDIR) != 0) {
+        if ((event->mask & (IN_CREATE | IN_MOVED_TO)) != 0) {
+          if (it->second.isRecursive == true) {
+            this->addTree(filePath, true, true);
+          }
+        } else if ((event->mask & (IN_DELETE | IN_MOVED_FROM)) != 0) {
+          // Watches under a moved directory would report the old path.
+          this->RemoveFromWatch(filePath);
+        }
+        continue;
+      }
+
+      if ((event->mask & (IN_CREATE | IN_MOVED_TO)) != 0) {
+        this->addChange(filePath, Change::CREATE);
+      } else if ((event->mask & (IN_DELETE | IN_MOVED_FROM)) != 0) {
+        this->addChange(filePath, Change::DELETE);
+      } else if ((event->mask & IN_MODIFY) != 0) {
+        this->addChange(filePath, Change::MODIFY);
+      }
+    }
+  }
+}
+
+void AsyncInotify::addChange(const string& filePath, Change change) {
+  auto it = this->pending_.find(filePath);
+  if (it == this->pending_.end()) {
+    Pending& pending = this->pending_[filePath];
+    pending.change = change;
+    pending.deadline = getNow() + this->config_.debounceMs;
+    this->pendingOrder_.push_back(filePath);
+    return;
+  }
+
+  Change& merged = it->second.change;
+  switch (change) {
+  case Change::DELETE:
+    merged = Change::DELETE;
+    break;
+  case Change::CREATE:
+    merged = (merged == Change::DELETE) ? Change::MODIFY : Change::CREATE;
+    break;
+  case Change::MODIFY:
+    if (merged == Change::DELETE) {
+      merged = Change::MODIFY;
+    }
+    break;
+  }
+}
+
+size_t AsyncInotify::deliver(uint64_t now) {
+  size_t numDelivered = 0;
+  while (this->pendingOrder_.empty() == false) {
+    auto it = this->pending_.find(this->pendingOrder_.front());
+    if (it->second.deadline > now) {
+      break;
+    }
+    const string filePath = std::move(this->pendingOrder_.front());
+    const Change change = it->second.change;
+    this->pending_.erase(it);
+    this->pendingOrder_.pop_front();
+
+    const Handler* handler = &this->fileModifyHandler_;
+    if (change == Change::CREATE) {
+      handler = &this->fileCreateHandler_;
+    } else if (change == Change::DELETE) {
+      handler = &this->fileDeleteHandler_;
+    }
+    if (*handler) {
+      (*handler)(filePath);
+    }
+    numDelivered += 1;
+  }
+  this->numEventsDelivered_ += numDelivered;
+
+  if (this->pendingOrder_.empty() == true) {
+    this->armTimer(0);
+  } else {
+    this->armTimer(this->pending_[this->pendingOrder_.front()].deadline);
+  }
+  return numDelivered;
+}
+
+void AsyncInotify::armTimer(uint64_t deadline) {
+  if (deadline == this->armedDeadline_) {
+    return;
+  }
+  struct itimerspec spec;
+  memset(&spec, 0, sizeof(spec));
+  // All zero disarms.
+  spec.it_value.tv_sec = deadline / 1000;
+  spec.it_value.tv_nsec = (deadline % 1000) * 1000 * 1000;
+  if (timerfd_settime(this->timerFd_, TFD_TIMER_ABSTIME, &spec, nullptr) != 0) {
+    DEBUG_cerr << "timerfd_settime failed. errno: " << errno << endl;
+    return;
+  }
+  this->armedDeadline_ = deadline;
+}
+
+uint64_t AsyncInotify::getNow() {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint64_t) now.tv_sec * 1000 + now.tv_nsec / (1000 * 1000);
+}
 
 }
 
@@ -59,18 +409,160 @@ void AsyncInotify::sampleFunc() {
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 
+#include <fstream>
+#include <map>
+#include <string>
+
+#include <sys/epoll.h>
+
 using namespace lio;
+using std::string;
+
+class AsyncInotifyTest : public ::testing::Test {
+protected:
+  void SetUp() {
+    char dirTemplate[] = "/tmp/AsyncInotifyTestXXXXXX";
+    this->dir = mkdtemp(dirTemplate);
+    this->epollFd = AsyncIo::createEpoll();
+  }
 
-class MockAsyncInotify : public AsyncInotify {
-public:
-  MOCK_METHOD0(Test, void());
+  void TearDown() {
+    close(this->epollFd);
+    string command = "rm -rf " + this->dir;
+    EXPECT_EQ(system(command.c_str()), 0);
+  }
 
+  void setHandlers(AsyncInotify& inotify) {
+    inotify.SetFileCreateHandler([this](const string& path) { this->created[path] += 1; });
+    inotify.SetFileModifyHandler([this](const string& path) { this->modified[path] += 1; });
+    inotify.SetFileDeleteHandler([this](const string& path) { this->deleted[path] += 1; });
+  }
+
+  // Runs the loop until nothing happens for idleMs.
+  void pump(AsyncInotify& inotify, int idleMs = 300) {
+    struct epoll_event events[8];
+    while (true) {
+      int numEvents = epoll_wait(this->epollFd, events, 8, idleMs);
+      if (numEvents <= 0) {
+        break;
+      }
+      for (int i = 0; numEvents > i; ++i) {
+        EXPECT_EQ(inotify.HandleFdEvent(events[i].data.fd), true);
+      }
+    }
+  }
+
+  void writeFile(const string& path, const string& content, bool isAppend = false) {
+    std::ofstream file(path, isAppend ? std::ios::app : std::ios::trunc);
+    file << content;
+  }
+
+  string dir;
+  int epollFd;
+  std::map<string, int> created;
+  std::map<string, int> modified;
+  std::map<string, int> deleted;
 };
 
-using ::testing::AtLeast;
+TEST_F(AsyncInotifyTest, Coalesce) {
+  AsyncInotify::Config config;
+  config.debounceMs = 50;
+  AsyncInotify inotify(this->epollFd, config);
+  this->setHandlers(inotify);
+  EXPECT_EQ(inotify.AddToWatch(this->dir), 1);
+  EXPECT_EQ(inotify.HandleFdEvent(this->epollFd), false);
+
+  const string path = this->dir + "/app.js";
+  this->writeFile(path, "var a;");
+  for (int i = 0; 5 > i; ++i) {
+    this->writeFile(path, "var b;", true);
+  }
+  this->pump(inotify);
+  EXPECT_EQ(this->created[path], 1);
+  EXPECT_EQ(this->modified.size(), 0);
+
+  for (int i = 0; 5 > i; ++i) {
+    this->writeFile(path, "var c;", true);
+  }
+  this->pump(inotify);
+  EXPECT_EQ(this->modified[path], 1);
+
+  // Replaced by rename, as deploy scripts do.
+  this->writeFile(path + ".tmp", "var d;");
+  EXPECT_EQ(rename((path + ".tmp").c_str(), path.c_str()), 0);
+  this->pump(inotify);
+  EXPECT_EQ(this->created[path], 2);
+  EXPECT_EQ(this->deleted[path + ".tmp"], 1);
+
+  unlink(path.c_str());
+  this->pump(inotify);
+  EXPECT_EQ(this->deleted[path], 1);
+  EXPECT_EQ(inotify.GetStats().numEventsDelivered, 5);
+}
+
+TEST_F(AsyncInotifyTest, Recursive) {
+  ASSERT_EQ(mkdir((this->dir + "/a").c_str(), 0755), 0);
+  ASSERT_EQ(mkdir((this->dir + "/a/b").c_str(), 0755), 0);
 
-TEST(AsyncInotify, TESTNAME) {
-  MockAsyncInotify mockAsyncInotify;
+  AsyncInotify::Config config;
+  config.debounceMs = 20;
+  AsyncInotify inotify(this->epollFd, config);
+  this->setHandlers(inotify);
+  EXPECT_EQ(inotify.AddToWatch(this->dir + "/"), 3);
+  EXPECT_EQ(inotify.AddToWatch(this->dir), 0);
+  EXPECT_EQ(inotify.IsWatching(this->dir + "/a/b"), true);
+
+  this->writeFile(this->dir + "/a/b/deep.css", "a {}");
+  // Written before its watch may be added.
+  ASSERT_EQ(mkdir((this->dir + "/new").c_str(), 0755), 0);
+  ASSERT_EQ(mkdir((this->dir + "/new/sub").c_str(), 0755), 0);
+  this->writeFile(this->dir + "/new/sub/early.css", "b {}");
+  this->pump(inotify);
+  this->writeFile(this->dir + "/new/sub/late.css", "c {}");
+  this->pump(inotify);
+
+  EXPECT_EQ(this->created[this->dir + "/a/b/deep.css"], 1);
+  EXPECT_EQ(this->created[this->dir + "/new/sub/early.css"], 1);
+  EXPECT_EQ(this->created[this->dir + "/new/sub/late.css"], 1);
+  EXPECT_EQ(inotify.IsWatching(this->dir + "/new/sub"), true);
+  EXPECT_EQ(inotify.GetStats().numWatches, 5);
+
+  string command = "rm -rf " + this->dir + "/new";
+  ASSERT_EQ(system(command.c_str()), 0);
+  this->pump(inotify);
+  EXPECT_EQ(inotify.IsWatching(this->dir + "/new"), false);
+  EXPECT_EQ(inotify.GetStats().numWatches, 3);
+
+  inotify.RemoveFromWatch(this->dir + "/a");
+  EXPECT_EQ(inotify.GetStats().numWatches, 1);
+}
+
+TEST_F(AsyncInotifyTest, Burst) {
+  AsyncInotify::Config config;
+  config.debounceMs = 60 * 1000;
+  AsyncInotify inotify(this->epollFd, config);
+  size_t numCalls = 0;
+  inotify.SetFileCreateHandler([&](const string&) { numCalls += 1; });
+  inotify.SetFileModifyHandler([&](const string&) { numCalls += 1; });
+  inotify.AddToWatch(this->dir);
+
+  const size_t NUM_FILES = 1000;
+  for (size_t i = 0; NUM_FILES > i; ++i) {
+    const string path = this->dir + "/f" + std::to_string(i) + ".html";
+    for (int j = 0; 3 > j; ++j) {
+      this->writeFile(path, "<p>" + std::to_string(j) + "</p>", true);
+    }
+  }
+  inotify.HandleFdEvent(inotify.GetInotifyFd());
+  EXPECT_EQ(numCalls, 0); // Waits for the window.
+  EXPECT_EQ(inotify.Flush(), NUM_FILES);
+  EXPECT_EQ(numCalls, NUM_FILES);
+
+  AsyncInotify::Stats stats = inotify.GetStats();
+  std::cout << "Events read: " << stats.numEventsRead
+            << " Handlers called: " << stats.numEventsDelivered << endl;
+  // Kernel merges only identical events in a row.
+  EXPECT_GT(stats.numEventsRead, NUM_FILES);
 }
 
 int main (int argc, char** argv) {
@@ -85,4 +577,3 @@ int main (int argc, char** argv) {
 #endif
 
 #undef _UNIT_TEST
-
@@ -3,53 +3,94 @@
 /*
   Name
     AsyncInotify
+      Watches directory trees from an epoll loop and coalesces file events.
 
   Authors
     [ETL] Eun T. Leem (eunleem@gmail.com)
 
+  Description
+    Inotify runs its own epoll loop and calls a handler for every event.
+    A deploy that rewrites a few thousand files makes several events per
+    file, and each one would drop and reload a cache entry.
+
+    AsyncInotify adds its inotify fd and a timerfd to an epoll the caller
+    already waits on, like the one of AsyncSockets. The caller passes every
+    fd event to HandleFdEvent(), which returns false for fds that are not
+    its own.
+
+    Events are read in batches of up to Config::readBufferSize. Events of a
+    path are merged until debounceMs after the first of them, then one
+    handler is called:
+      create, then modify       -> create
+      modify, modify ...        -> modify
+      anything, then delete     -> delete
+      delete, then create       -> modify (replaced)
+    Renames count as delete of the old path and create of the new one.
+
+    With recursive watching, every directory under the root is watched,
+    and so are directories created or moved in later. Files that appear in
+    a new directory before its watch is added are reported as created.
+
+    When the kernel queue overflows, events are lost. The overflow handler
+    is called and the caller should rescan.
+
   Last Modified Date
-    March 25, 2014
-  
+    Oct 19, 2026
+
   History
     March 25, 2014
       Created
+    October 19, 2026
+      Implemented on epoll with timerfd debouncing and recursive watching.
 
   ToDos
-    
+
 
 
   Milestones
     1.0
-      
+
 
   Learning Resources
-    http://
-  
+    inotify(7)
+      http://man7.org/linux/man-pages/man7/inotify.7.html
+
   Copyright (c) All rights reserved to LIFEINO.
 */
 
 #ifdef _DEBUG
   #undef _DEBUG
 #endif
-#define _DEBUG true
+#define _DEBUG false
 
 #include "liolib/Debug.hpp"
 
+#include <string>
+#include <deque>
+#include <unordered_map>
+#include <functional> // function
+#include <memory> // unique_ptr
+
+#include <cstdint>
 
-//#inclue "liolib/DataBlock.hpp"
+#include <sys/inotify.h> // IN_MOVE
 
 namespace lio {
 
+using std::string;
+
 
 class AsyncInotify {
 public:
 
 // ******** Exception Declaration *********
 enum class ExceptionType : std::uint8_t {
-  GENERAL
+  GENERAL,
+  INIT_FAIL
 };
 #define ASYNCINOTIFY_EXCEPTION_MESSAGES \
-  "AsyncInotify Exception has been thrown."
+  "AsyncInotify Exception has been thrown.", \
+  "Could not init inotify or timerfd."
 
 class Exception : public std::exception {
 public:
@@ -57,32 +98,115 @@ public:
 
   virtual const char*         what() const noexcept;
   virtual const               ExceptionType type() const noexcept;
-  
+
 private:
   const ExceptionType         exceptionType_;
   static const char* const    exceptionMessages_[];
 };
 // ******** Exception Declaration END*********
 
-
-  AsyncInotify();
+  struct Config {
+    Config() :
+      debounceMs(100),
+      readBufferSize(64 * 1024)
+    { }
+    uint32_t debounceMs; // 0 delivers events right after they are read.
+    size_t readBufferSize;
+  };
+
+  struct Stats {
+    uint64_t numEventsRead;
+    uint64_t numEventsDelivered;
+    uint64_t numOverflows;
+    size_t numWatches;
+  };
+
+  typedef std::function<void(const string& filePath)> Handler;
+  typedef std::function<void()> OverflowHandler;
+
+  AsyncInotify(int epollFd, Config config = Config());
   ~AsyncInotify();
-protected:
-  
-private:
 
-/** FUNC_NAME 
- *    DESCRIPTION
- *  Input
- *    DESCRIPTION_ABOUT_PARAMETERS
- *  Returns
- *    void NOTHING
- */
-  void sampleFunc();
-  
+  // Returns number of directories added. Existing watches are kept.
+  size_t          AddToWatch(const string& dirPath, bool isRecursive = true);
+  void            RemoveFromWatch(const string& dirPath);
+  bool            IsWatching(const string& dirPath) const;
+
+  void            SetFileCreateHandler(Handler handler);
+  void            SetFileModifyHandler(Handler handler);
+  void            SetFileDeleteHandler(Handler handler);
+  // Events were lost. Watched directories should be rescanned.
+  void            SetOverflowHandler(OverflowHandler handler);
+
+  // True when fd is the inotify fd or the timer of this instance.
+  bool            HandleFdEvent(int fd);
+
+  // Delivers all merged events now, without waiting for the timer.
+  size_t          Flush();
+
+  int             GetInotifyFd() const;
+  int             GetTimerFd() const;
+  Stats           GetStats() const;
+
+private:
+  enum class Change : uint8_t {
+    CREATE,
+    MODIFY,
+    DELETE
+  };
+
+  struct Pending {
+    Change          change;
+    uint64_t        deadline; // Milliseconds on CLOCK_MONOTONIC.
+  };
+
+  struct Watch {
+    string          path;
+    bool            isRecursive;
+  };
+
+  Config          config_;
+  int             epollFd_;
+  int             inotiFd_;
+  int             timerFd_;
+  std::unique_ptr<char[]> buffer_;
+
+  std::unordered_map<int, Watch> watches_; // wd to directory.
+  std::unordered_map<string, int> watchDescriptors_; // Directory to wd.
+
+  std::unordered_map<string, Pending> pending_;
+  // Paths in the order they became pending. Deadlines are ascending.
+  std::deque<string> pendingOrder_;
+  uint64_t        armedDeadline_; // 0 when the timer is off.
+
+  Handler         fileCreateHandler_;
+  Handler         fileModifyHandler_;
+  Handler         fileDeleteHandler_;
+  OverflowHandler overflowHandler_;
+
+  uint64_t        numEventsRead_;
+  uint64_t        numEventsDelivered_;
+  uint64_t        numOverflows_;
+
+  // Returns number of watches added. isNew reports files found as created,
+  // since they may have appeared before the watch.
+  size_t          addTree(const string& dirPath, bool isRecursive, bool isNew);
+  int             addWatch(const string& dirPath, bool isRecursive);
+  void            removeWatch(int wd);
+
+  void            readEvents();
+  void            addChange(const string& filePath, Change change);
+  // Delivers merged events whose deadline is at or before now.
+  size_t          deliver(uint64_t now);
+  void            armTimer(uint64_t deadline);
+
+  static
+  uint64_t        getNow();
+
+  AsyncInotify(const AsyncInotify&) = delete;
+  AsyncInotify& operator=(const AsyncInotify&) = delete;
 };
 
 }
 
 #endif
-
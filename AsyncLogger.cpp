@@ -0,0 +1,1179 @@
+#include "AsyncLogger.hpp"
+
+#define _UNIT_TEST false
+#include "liolib/Test.hpp"
+
+#include <chrono>
+#include <ostream>
+#include <streambuf>
+
+#include <cerrno>
+#include <cstdio> // snprintf()
+#include <ctime> // gmtime_r()
+
+#include <sys/uio.h> // writev()
+
+#include "liolib/LogSink.hpp"
+#include "liolib/Util.hpp" // Util::Time::FormatMilliseconds()
+
+#if defined(__x86_64__) || defined(__i386__)
+  #include <x86intrin.h> // __rdtsc()
+#endif
+
+
+namespace lio {
+
+// ===== Exception Implementation =====
+const char* const
+AsyncLogger::Exception::exceptionMessages_[] = {
+  ASYNCLOGGER_EXCEPTION_MESSAGES
+};
+#undef ASYNCLOGGER_EXCEPTION_MESSAGES // undef helps reducing unnecessary preprocessing work.
+
+
+AsyncLogger::Exception::Exception(ExceptionType exceptionType) :
+  exceptionType_(exceptionType) { }
+
+const char*
+AsyncLogger::Exception::what() const noexcept {
+  return this->exceptionMessages_[(int) this->exceptionType_];
+}
+
+const AsyncLogger::ExceptionType
+AsyncLogger::Exception::type() const noexcept {
+  return this->exceptionType_;
+}
+// ===== Exception Implementation End =====
+
+
+// Header of a record in a ring. Payload follows, then padding to 8 bytes.
+// Only size and kind are written for PADDING, which fills the end of the
+// buffer when a record does not fit there.
+struct AsyncLogger::Record {
+  enum Kind : uint8_t {
+    PADDING,
+    TEXT,
+    FORMAT
+  };
+
+  uint32_t        size; // With header and padding.
+  uint8_t         kind;
+  uint8_t         type; // Logger::Type
+  uint16_t        reserved;
+  uint32_t        length; // Of payload.
+  uint32_t        reserved2;
+  uint64_t        ticks;
+  const char*     format; // FORMAT only.
+};
+
+
+// Single producer, the thread that owns it, and single consumer, the
+// background thread. Positions only grow; the offset is position & mask.
+class AsyncLogger::Ring {
+public:
+  Ring(size_t capacity) :
+    buffer_(new uint64_t[capacity / 8]),
+    mask_(capacity - 1),
+    head_(0),
+    reservedHead_(0),
+    tail_(0),
+    numDropped_(0),
+    isClosed_(false)
+  { }
+
+  // Producer. size is a multiple of 8 and at most half of the capacity.
+  char* Reserve(size_t size) {
+    uint64_t head = this->head_.load(std::memory_order_relaxed);
+    const uint64_t tail = this->tail_.load(std::memory_order_acquire);
+    const size_t offset = head & this->mask_;
+    const size_t contiguous = this->mask_ + 1 - offset;
+    const size_t needed = (size > contiguous) ? contiguous + size : size;
+    if (head + needed - tail > this->mask_ + 1) {
+      return nullptr;
+    }
+
+    if (size > contiguous) {
+      Record* padding = (Record*) (this->getData() + offset);
+      padding->size = contiguous;
+      padding->kind = Record::Kind::PADDING;
+      head += contiguous;
+    }
+    this->reservedHead_ = head;
+    return this->getData() + (head & this->mask_);
+  }
+
+  // Producer. Returns bytes in use.
+  size_t Commit(size_t size) {
+    const uint64_t head = this->reservedHead_ + size;
+    this->head_.store(head, std::memory_order_release);
+    return head - this->tail_.load(std::memory_order_relaxed);
+  }
+
+  void AddDropped() {
+    this->numDropped_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  // Producer. The ring is removed once it is drained.
+  void Close() {
+    this->isClosed_.store(true, std::memory_order_release);
+  }
+
+  size_t GetCapacity() const {
+    return this->mask_ + 1;
+  }
+
+  // Consumer.
+  uint64_t GetHead() const {
+    return this->head_.load(std::memory_order_acquire);
+  }
+
+  uint64_t GetTail() const {
+    return this->tail_.load(std::memory_order_relaxed);
+  }
+
+  const Record* At(uint64_t position) const {
+    return (const Record*) (this->getData() + (position & this->mask_));
+  }
+
+  // Records before tail are written and their space can be reused.
+  void Release(uint64_t tail) {
+    this->tail_.store(tail, std::memory_order_release);
+  }
+
+  uint64_t TakeDropped() {
+    return this->numDropped_.exchange(0, std::memory_order_relaxed);
+  }
+
+  bool IsClosed() const {
+    return this->isClosed_.load(std::memory_order_acquire);
+  }
+
+private:
+  std::unique_ptr<uint64_t[]> buffer_;
+  const size_t    mask_;
+
+  // Producer side and consumer side are on their own cache lines.
+  std::atomic<uint64_t> head_;
+  uint64_t        reservedHead_;
+  char            padding_[64 - 16];
+  std::atomic<uint64_t> tail_;
+  char            padding2_[64 - 8];
+
+  std::atomic<uint64_t> numDropped_;
+  std::atomic<bool> isClosed_;
+
+  char* getData() const {
+    return (char*) this->buffer_.get();
+  }
+
+  Ring(const Ring&) = delete;
+  Ring& operator=(const Ring&) = delete;
+};
+
+
+// Collects a LOG_* line of the thread and pushes it on std::endl.
+class AsyncLogger::RecordBuffer : public std::streambuf {
+public:
+  RecordBuffer() :
+    type_(Logger::Type::INFO)
+  {
+    this->setp(this->area_, this->area_ + sizeof(this->area_));
+  }
+
+  void SetType(Logger::Type type) {
+    this->type_ = type;
+  }
+
+  bool IsEmpty() const {
+    return this->pptr() == this->pbase() && this->text_.empty() == true;
+  }
+
+  void Push() {
+    this->text_.append(this->pbase(), this->pptr() - this->pbase());
+    this->setp(this->area_, this->area_ + sizeof(this->area_));
+    if (this->text_.empty() == true) {
+      return;
+    }
+    AsyncLogger::pushText(this->type_, this->text_.data(), this->text_.size());
+    this->text_.clear();
+  }
+
+protected:
+  int_type overflow(int_type ch) {
+    this->text_.append(this->pbase(), this->pptr() - this->pbase());
+    this->setp(this->area_, this->area_ + sizeof(this->area_));
+    if (traits_type::eq_int_type(ch, traits_type::eof()) == false) {
+      this->text_ += traits_type::to_char_type(ch);
+    }
+    return traits_type::not_eof(ch);
+  }
+
+  int sync() {
+    this->Push();
+    return 0;
+  }
+
+private:
+  char            area_[256];
+  string          text_; // Lines longer than area_.
+  Logger::Type    type_;
+};
+
+
+struct AsyncLogger::ThreadState {
+  ThreadState() :
+    generation(0),
+    stream(&buffer),
+    logger(nullptr),
+    isFallback(false),
+    reservedSize(0),
+    fallbackFormat(nullptr)
+  { }
+
+  ~ThreadState() {
+    AsyncLogger* logger = AsyncLogger::instance_.load(std::memory_order_acquire);
+    if (logger != nullptr && logger->generation_ == this->generation &&
+        this->buffer.IsEmpty() == false) {
+      this->buffer.Push();
+    }
+    if (this->ring != nullptr) {
+      this->ring->Close();
+    }
+  }
+
+  std::shared_ptr<Ring> ring;
+  uint64_t        generation; // Of the logger of ring.
+  RecordBuffer    buffer;
+  std::ostream    stream;
+
+  // Record between beginRecord() and endRecord().
+  AsyncLogger*    logger;
+  bool            isFallback;
+  size_t          reservedSize;
+  const char*     fallbackFormat;
+  std::vector<char> fallbackArgs; // Without a running logger.
+};
+
+
+struct AsyncLogger::Batch {
+  struct Piece {
+    const char*   data; // In a ring. nullptr for buffer.
+    size_t        offset; // In buffer.
+    size_t        length;
+  };
+  static const size_t MAX_PIECES = 512; // Below IOV_MAX.
+
+  // Adds buffer from start to its end.
+  void AddBuffered(size_t start) {
+    if (this->pieces.empty() == false) {
+      Piece& last = this->pieces.back();
+      if (last.data == nullptr && last.offset + last.length == start) {
+        last.length = this->buffer.size() - last.offset;
+        return;
+      }
+    }
+    this->pieces.push_back(Piece{ nullptr, start, this->buffer.size() - start });
+  }
+
+  void AddExternal(const char* data, size_t length) {
+    this->pieces.push_back(Piece{ data, 0, length });
+  }
+
+  string          buffer; // Prefixes and formatted lines.
+  std::vector<Piece> pieces;
+  std::vector<struct iovec> iovecs;
+};
+
+
+std::atomic<AsyncLogger*> AsyncLogger::instance_(nullptr);
+std::atomic<uint64_t> AsyncLogger::lastGeneration_(0);
+thread_local AsyncLogger::ThreadState AsyncLogger::threadState_;
+
+
+AsyncLogger::AsyncLogger(Config config) :
+  config_(config),
+  generation_(++AsyncLogger::lastGeneration_),
+  isStopping_(false),
+  isWakeRequested_(false),
+  numFlushRequested_(0),
+  numFlushed_(0),
+  numRecords_(0),
+  numDropped_(0),
+  numWrites_(0),
+  cachedSecond_(-1)
+{
+  DEBUG_FUNC_START;
+
+  size_t ringSize = 4096;
+  while (this->config_.ringSize > ringSize) {
+    ringSize *= 2;
+  }
+  this->config_.ringSize = ringSize;
+
+  // Rough ticks per ns for the first records. calibrate() refines it.
+  this->anchorTicks_ = AsyncLogger::getTicks();
+  this->anchorNs_ = AsyncLogger::getRealtimeNs();
+  std::this_thread::sleep_for(std::chrono::milliseconds(2));
+  const uint64_t ticks = AsyncLogger::getTicks();
+  const int64_t ns = AsyncLogger::getRealtimeNs();
+  this->nsPerTick_ = (double) (ns - this->anchorNs_) / (ticks - this->anchorTicks_);
+
+  for (size_t i = 0; (size_t) Logger::Type::FATAL >= i; ++i) {
+    const Logger::Type type = (Logger::Type) i;
+    if (this->config_.isColored == true) {
+      this->prefixes_[i] = Logger::getColor(type) + Logger::toString(type) +
+                           TCOLOR::RESET + TCOLOR::BLUE + " ";
+    } else {
+      this->prefixes_[i] = Logger::toString(type) + " ";
+    }
+  }
+  char pidString[16];
+  snprintf(pidString, sizeof(pidString), "%6d ", (int) getpid());
+  this->pidString_ = pidString;
+
+  AsyncLogger* expected = nullptr;
+  if (AsyncLogger::instance_.compare_exchange_strong(expected, this) == false) {
+    throw Exception(ExceptionType::ALREADY_RUNNING);
+  }
+  this->thread_ = std::thread(&AsyncLogger::run, this);
+  Logger::SetStreamHook(&AsyncLogger::getStream);
+}
+
+AsyncLogger::~AsyncLogger() {
+  DEBUG_FUNC_START;
+  ThreadState& state = AsyncLogger::threadState_;
+  if (state.generation == this->generation_ && state.buffer.IsEmpty() == false) {
+    state.buffer.Push();
+  }
+
+  Logger::SetStreamHook(nullptr);
+  AsyncLogger::instance_.store(nullptr, std::memory_order_release);
+
+  {
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    this->isStopping_ = true;
+  }
+  this->wakeCv_.notify_one();
+  this->thread_.join();
+}
+
+void AsyncLogger::Flush() {
+  DEBUG_FUNC_START;
+  ThreadState& state = AsyncLogger::threadState_;
+  if (state.generation == this->generation_ && state.buffer.IsEmpty() == false) {
+    state.buffer.Push();
+  }
+
+  std::unique_lock<std::mutex> lock(this->mutex_);
+  const uint64_t flushId = ++this->numFlushRequested_;
+  this->wakeCv_.notify_one();
+  this->flushCv_.wait(lock, [this, flushId] { return this->numFlushed_ >= flushId; });
+}
+
+AsyncLogger::Stats AsyncLogger::GetStats() const {
+  Stats stats;
+  stats.numRecords = this->numRecords_.load(std::memory_order_relaxed);
+  stats.numDropped = this->numDropped_.load(std::memory_order_relaxed);
+  stats.numWrites = this->numWrites_.load(std::memory_order_relaxed);
+  std::lock_guard<std::mutex> lock(this->mutex_);
+  stats.numRings = this->rings_.size();
+  return stats;
+}
+
+AsyncLogger* AsyncLogger::GetInstance() {
+  return AsyncLogger::instance_.load(std::memory_order_acquire);
+}
+
+void AsyncLogger::run() {
+  Batch out;
+  Batch err;
+  std::vector<std::shared_ptr<Ring>> rings;
+  while (true) {
+    uint64_t numRequested = 0;
+    bool isStopping = false;
+    {
+      std::unique_lock<std::mutex> lock(this->mutex_);
+      this->wakeCv_.wait_for(lock, std::chrono::milliseconds(this->config_.flushIntervalMs),
+          [this] {
+            return this->isStopping_ == true ||
+                   this->numFlushRequested_ != this->numFlushed_ ||
+                   this->isWakeRequested_.load(std::memory_order_relaxed) == true;
+          });
+      this->isWakeRequested_.store(false, std::memory_order_relaxed);
+      isStopping = this->isStopping_;
+      numRequested = this->numFlushRequested_;
+      rings = this->rings_;
+    }
+
+    this->calibrate();
+    for (const std::shared_ptr<Ring>& ring : rings) {
+      this->drain(ring.get(), out, err);
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(this->mutex_);
+      this->numFlushed_ = numRequested;
+      // Closed before the drain, so nothing is pushed to them anymore.
+      for (size_t i = 0; this->rings_.size() > i;) {
+        Ring* ring = this->rings_[i].get();
+        if (ring->IsClosed() == true && ring->GetHead() == ring->GetTail()) {
+          this->rings_[i] = this->rings_.back();
+          this->rings_.pop_back();
+        } else {
+          ++i;
+        }
+      }
+    }
+    this->flushCv_.notify_all();
+    rings.clear();
+
+    if (isStopping == true) {
+      break;
+    }
+  }
+}
+
+size_t AsyncLogger::drain(Ring* ring, Batch& out, Batch& err) {
+  uint64_t tail = ring->GetTail();
+  const uint64_t head = ring->GetHead();
+  size_t numRecords = 0;
+  while (head > tail) {
+    const Record* record = ring->At(tail);
+    if (record->kind == Record::Kind::PADDING) {
+      tail += record->size;
+      continue;
+    }
+
+    const Logger::Type type = (Logger::Type) record->type;
+    Batch& batch = (this->getFd(type) == this->config_.outFd) ? out : err;
+    const size_t start = batch.buffer.size();
+    this->appendPrefix(batch.buffer, type, record->ticks);
+    const char* payload = (const char*) (record + 1);
+    if (record->kind == Record::Kind::TEXT) {
+      batch.AddBuffered(start);
+      batch.AddExternal(payload, record->length);
+    } else {
+      if (this->config_.isColored == true) {
+        batch.buffer += TCOLOR::END;
+      }
+      AsyncLogger::format(record->format, payload, payload + record->length, batch.buffer);
+      batch.buffer += '\n';
+      batch.AddBuffered(start);
+    }
+    numRecords += 1;
+    tail += record->size;
+
+    if (out.pieces.size() >= Batch::MAX_PIECES || err.pieces.size() >= Batch::MAX_PIECES) {
+      this->writeBatch(out, this->config_.outFd);
+      this->writeBatch(err, this->config_.errFd);
+      ring->Release(tail);
+    }
+  }
+
+  const uint64_t numDropped = ring->TakeDropped();
+  if (numDropped > 0) {
+    Batch& batch = (this->getFd(Logger::Type::WARNING) == this->config_.outFd) ? out : err;
+    const size_t start = batch.buffer.size();
+    this->appendPrefix(batch.buffer, Logger::Type::WARNING, AsyncLogger::getTicks());
+    if (this->config_.isColored == true) {
+      batch.buffer += TCOLOR::END;
+    }
+    batch.buffer += "AsyncLogger dropped " + std::to_string(numDropped) + " records.\n";
+    batch.AddBuffered(start);
+    this->numDropped_.fetch_add(numDropped, std::memory_order_relaxed);
+  }
+
+  this->writeBatch(out, this->config_.outFd);
+  this->writeBatch(err, this->config_.errFd);
+  ring->Release(tail);
+  this->numRecords_.fetch_add(numRecords, std::memory_order_relaxed);
+  return numRecords;
+}
+
+void AsyncLogger::writeBatch(Batch& batch, int fd) {
+  if (batch.pieces.empty() == true) {
+    return;
+  }
+
+  batch.iovecs.clear();
+  for (const Batch::Piece& piece : batch.pieces) {
+    const char* data = (piece.data != nullptr) ? piece.data : batch.buffer.data() + piece.offset;
+    batch.iovecs.push_back(iovec{ (void*) data, piece.length });
+  }
+
+  struct iovec* iovecs = batch.iovecs.data();
+  size_t numIovecs = batch.iovecs.size();
+  if (this->config_.sink != nullptr) {
+    this->config_.sink->Write(iovecs, (int) numIovecs);
+    this->numWrites_.fetch_add(1, std::memory_order_relaxed);
+    numIovecs = 0;
+  }
+  while (numIovecs > 0) {
+    const ssize_t written = writev(fd, iovecs, numIovecs);
+    this->numWrites_.fetch_add(1, std::memory_order_relaxed);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      break; // Nowhere to report it.
+    }
+
+    size_t remaining = written;
+    while (numIovecs > 0 && remaining >= iovecs->iov_len) {
+      remaining -= iovecs->iov_len;
+      ++iovecs;
+      --numIovecs;
+    }
+    if (numIovecs > 0) {
+      iovecs->iov_base = (char*) iovecs->iov_base + remaining;
+      iovecs->iov_len -= remaining;
+    }
+  }
+
+  batch.buffer.clear();
+  batch.pieces.clear();
+}
+
+void AsyncLogger::calibrate() {
+  const uint64_t ticks = AsyncLogger::getTicks();
+  const int64_t ns = AsyncLogger::getRealtimeNs();
+  const int64_t elapsedNs = ns - this->anchorNs_;
+  if (elapsedNs < 100 * 1000 * 1000 || ticks <= this->anchorTicks_) {
+    return;
+  }
+
+  this->nsPerTick_ = (double) elapsedNs / (ticks - this->anchorTicks_);
+  if (elapsedNs > (int64_t) 60 * 1000 * 1000 * 1000) {
+    // Follows steps of the wall clock.
+    this->anchorTicks_ = ticks;
+    this->anchorNs_ = ns;
+  }
+}
+
+void AsyncLogger::appendPrefix(string& buffer, Logger::Type type, uint64_t ticks) {
+  const int64_t ns = this->anchorNs_ +
+                     (int64_t) ((double) (int64_t) (ticks - this->anchorTicks_) * this->nsPerTick_);
+  const time_t second = ns / (1000 * 1000 * 1000);
+  if (second != this->cachedSecond_) {
+    struct tm time;
+    gmtime_r(&second, &time);
+    strftime(this->cachedDate_, sizeof(this->cachedDate_), "%F %T", &time);
+    this->cachedSecond_ = second;
+  }
+
+  char milliseconds[] = ".000 GMT";
+  Util::Time::FormatMilliseconds(milliseconds + 1, (ns / (1000 * 1000)) % 1000);
+
+  buffer += this->prefixes_[(size_t) type];
+  buffer += this->cachedDate_;
+  buffer += milliseconds;
+  buffer += this->pidString_;
+}
+
+int AsyncLogger::getFd(Logger::Type type) const {
+  // Same as Logger::getStream().
+  switch (type) {
+    case Logger::Type::INFO:
+    case Logger::Type::WARNING:
+    case Logger::Type::SECURITY_WARNING:
+      return this->config_.outFd;
+    default:
+      return this->config_.errFd;
+  }
+}
+
+void AsyncLogger::wake() {
+  if (this->isWakeRequested_.exchange(true, std::memory_order_relaxed) == false) {
+    this->wakeCv_.notify_one();
+  }
+}
+
+AsyncLogger::Ring* AsyncLogger::getRing() {
+  ThreadState& state = AsyncLogger::threadState_;
+  if (state.generation != this->generation_) {
+    state.ring = std::make_shared<Ring>(this->config_.ringSize);
+    state.generation = this->generation_;
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    this->rings_.push_back(state.ring);
+  }
+  return state.ring.get();
+}
+
+char* AsyncLogger::reserve(Ring* ring, size_t size) {
+  if (size > ring->GetCapacity() / 2) {
+    ring->AddDropped();
+    return nullptr;
+  }
+
+  char* buffer = nullptr;
+  while ((buffer = ring->Reserve(size)) == nullptr) {
+    this->wake();
+    if (this->config_.fullPolicy == FullPolicy::DROP) {
+      ring->AddDropped();
+      return nullptr;
+    }
+    std::this_thread::yield();
+  }
+  return buffer;
+}
+
+char* AsyncLogger::beginRecord(Logger::Type type, const char* format, size_t argsSize) {
+  ThreadState& state = AsyncLogger::threadState_;
+  AsyncLogger* logger = AsyncLogger::instance_.load(std::memory_order_acquire);
+  if (logger == nullptr) {
+    state.isFallback = true;
+    state.fallbackFormat = format;
+    state.fallbackArgs.resize(argsSize + 1);
+    return state.fallbackArgs.data();
+  }
+
+  Ring* ring = logger->getRing();
+  if (state.buffer.IsEmpty() == false) {
+    state.buffer.Push();
+  }
+
+  const size_t size = (sizeof(Record) + argsSize + 7) & ~(size_t) 7;
+  char* buffer = logger->reserve(ring, size);
+  if (buffer == nullptr) {
+    return nullptr;
+  }
+
+  Record* record = (Record*) buffer;
+  record->size = size;
+  record->kind = Record::Kind::FORMAT;
+  record->type = (uint8_t) type;
+  record->length = argsSize;
+  record->ticks = AsyncLogger::getTicks();
+  record->format = format;
+
+  state.logger = logger;
+  state.isFallback = false;
+  state.reservedSize = size;
+  return (char*) (record + 1);
+}
+
+void AsyncLogger::endRecord(Logger::Type type) {
+  ThreadState& state = AsyncLogger::threadState_;
+  if (state.isFallback == true) {
+    state.isFallback = false;
+    string line;
+    AsyncLogger::format(state.fallbackFormat, state.fallbackArgs.data(),
+                        state.fallbackArgs.data() + state.fallbackArgs.size() - 1, line);
+    Logger::Log(type) << TCOLOR::END << line << std::endl;
+    return;
+  }
+
+  AsyncLogger* logger = state.logger;
+  const size_t used = state.ring->Commit(state.reservedSize);
+  if (type == Logger::Type::FATAL || type == Logger::Type::ALERT) {
+    logger->Flush();
+  } else if (used > state.ring->GetCapacity() / 2) {
+    logger->wake();
+  }
+}
+
+std::ostream& AsyncLogger::getStream(Logger::Type type) {
+  ThreadState& state = AsyncLogger::threadState_;
+  if (state.buffer.IsEmpty() == false) {
+    state.buffer.Push();
+  }
+  state.buffer.SetType(type);
+  return state.stream;
+}
+
+void AsyncLogger::pushText(Logger::Type type, const char* text, size_t length) {
+  AsyncLogger* logger = AsyncLogger::instance_.load(std::memory_order_acquire);
+  if (logger == nullptr) {
+    Logger::getStream(type).write(text, length);
+    return;
+  }
+
+  Ring* ring = logger->getRing();
+  length = std::min(length, ring->GetCapacity() / 4);
+  const size_t size = (sizeof(Record) + length + 7) & ~(size_t) 7;
+  char* buffer = logger->reserve(ring, size);
+  if (buffer == nullptr) {
+    return;
+  }
+
+  Record* record = (Record*) buffer;
+  record->size = size;
+  record->kind = Record::Kind::TEXT;
+  record->type = (uint8_t) type;
+  record->length = length;
+  record->ticks = AsyncLogger::getTicks();
+  memcpy(record + 1, text, length);
+
+  const size_t used = ring->Commit(size);
+  if (type == Logger::Type::FATAL || type == Logger::Type::ALERT) {
+    logger->Flush();
+  } else if (used > ring->GetCapacity() / 2) {
+    logger->wake();
+  }
+}
+
+namespace {
+
+// Appends snprintf() of one conversion.
+template<typename T>
+void appendFormatted(std::string& buffer, const char* spec, T value) {
+  const size_t start = buffer.size();
+  buffer.resize(start + 64);
+  int length = snprintf(&buffer[start], 64, spec, value);
+  if (length < 0) {
+    length = 0;
+  } else if (length >= 64) {
+    buffer.resize(start + length + 1);
+    snprintf(&buffer[start], length + 1, spec, value);
+  }
+  buffer.resize(start + length);
+}
+
+}
+
+void AsyncLogger::format(const char* format, const char* args, const char* argsEnd,
+                         string& buffer) {
+  const char* position = format;
+  while (*position != '\0') {
+    const char* percent = strchr(position, '%');
+    if (percent == nullptr) {
+      buffer.append(position);
+      break;
+    }
+    buffer.append(position, percent - position);
+    if (percent[1] == '%') {
+      buffer += '%';
+      position = percent + 2;
+      continue;
+    }
+
+    // %[flags][width][.precision][length]conversion
+    const char* specEnd = percent + 1;
+    specEnd += strspn(specEnd, "-+ #0");
+    specEnd += strspn(specEnd, "0123456789");
+    if (*specEnd == '.') {
+      specEnd += 1;
+      specEnd += strspn(specEnd, "0123456789");
+    }
+    const char* conversion = specEnd + strspn(specEnd, "hlLqjzt");
+    if (*conversion == '\0' || strchr("diouxXcfFeEgGaAsp", *conversion) == nullptr ||
+        args >= argsEnd) {
+      // Not supported, like "%*d", or no argument left. Kept as it is.
+      const size_t length = (*conversion == '\0') ? conversion - percent : conversion - percent + 1;
+      buffer.append(percent, length);
+      position = percent + length;
+      continue;
+    }
+    position = conversion + 1;
+
+    char spec[32];
+    const size_t specLength = std::min<size_t>(specEnd - percent, sizeof(spec) - 4);
+    memcpy(spec, percent, specLength);
+    char* specTail = spec + specLength;
+
+    const ArgTag tag = (ArgTag) *args;
+    switch (tag) {
+      case ArgTag::INT:
+      case ArgTag::UINT: {
+        uint64_t value;
+        memcpy(&value, args + 1, 8);
+        args += 1 + 8;
+        if (*conversion == 'c') {
+          memcpy(specTail, "c", 2);
+          appendFormatted(buffer, spec, (int) value);
+          break;
+        }
+        char integerConversion = *conversion;
+        if (strchr("diouxX", integerConversion) == nullptr) {
+          integerConversion = (tag == ArgTag::INT) ? 'd' : 'u';
+        }
+        specTail[0] = 'l';
+        specTail[1] = 'l';
+        specTail[2] = integerConversion;
+        specTail[3] = '\0';
+        appendFormatted(buffer, spec, (long long) value);
+        break;
+      }
+      case ArgTag::DOUBLE: {
+        double value;
+        memcpy(&value, args + 1, 8);
+        args += 1 + 8;
+        specTail[0] = (strchr("fFeEgGaA", *conversion) != nullptr) ? *conversion : 'g';
+        specTail[1] = '\0';
+        appendFormatted(buffer, spec, value);
+        break;
+      }
+      case ArgTag::STRING: {
+        uint32_t length;
+        memcpy(&length, args + 1, 4);
+        const char* value = args + 1 + 4;
+        args += 1 + 4 + length + 1;
+        if (specLength == 1) {
+          buffer.append(value, length);
+          break;
+        }
+        memcpy(specTail, "s", 2);
+        appendFormatted(buffer, spec, value);
+        break;
+      }
+      case ArgTag::POINTER: {
+        uint64_t value;
+        memcpy(&value, args + 1, 8);
+        args += 1 + 8;
+        memcpy(specTail, "p", 2);
+        appendFormatted(buffer, spec, (void*) (uintptr_t) value);
+        break;
+      }
+      default:
+        args = argsEnd; // Corrupt. Stops reading arguments.
+        break;
+    }
+  }
+}
+
+uint64_t AsyncLogger::getTicks() {
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint64_t) now.tv_sec * 1000 * 1000 * 1000 + now.tv_nsec;
+#endif
+}
+
+int64_t AsyncLogger::getRealtimeNs() {
+  struct timespec now;
+  clock_gettime(CLOCK_REALTIME, &now);
+  return (int64_t) now.tv_sec * 1000 * 1000 * 1000 + now.tv_nsec;
+}
+
+}
+
+#if _UNIT_TEST
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include <fcntl.h> // open()
+
+using namespace lio;
+using std::string;
+
+class AsyncLoggerTest : public ::testing::Test {
+protected:
+  void SetUp() {
+    char fileTemplate[] = "/tmp/AsyncLoggerTestXXXXXX";
+    this->fd = mkstemp(fileTemplate);
+    this->filePath = fileTemplate;
+    this->config.isColored = false;
+    this->config.outFd = this->fd;
+    this->config.errFd = this->fd;
+  }
+
+  void TearDown() {
+    close(this->fd);
+    unlink(this->filePath.c_str());
+  }
+
+  string readFile() {
+    std::ifstream file(this->filePath);
+    std::stringstream content;
+    content << file.rdbuf();
+    return content.str();
+  }
+
+  size_t countLines(const string& content) {
+    return std::count(content.begin(), content.end(), '\n');
+  }
+
+  int fd;
+  string filePath;
+  AsyncLogger::Config config;
+};
+
+TEST_F(AsyncLoggerTest, Format) {
+  AsyncLogger logger(this->config);
+  EXPECT_EQ(AsyncLogger::GetInstance(), &logger);
+  EXPECT_THROW(AsyncLogger another, AsyncLogger::Exception);
+
+  const string path = "/index.html";
+  EXPECT_EQ(AsyncLogger::Log(Logger::Type::INFO, "GET %s %d %lu %5.2f %x%%", path, -7,
+                             (unsigned long) 42, 3.14159, 255u), true);
+  EXPECT_EQ(AsyncLogger::Log(Logger::Type::ERROR, "[%-6s] %c %s missing %d", "ab", 'z',
+                             (const char*) nullptr), true);
+  EXPECT_EQ(AsyncLogger::Log(Logger::Type::WARNING, "%s %d", 2.5, "x"), true);
+  logger.Flush();
+
+  const string content = this->readFile();
+  EXPECT_EQ(this->countLines(content), 3);
+  EXPECT_NE(content.find("INF "), string::npos);
+  EXPECT_NE(content.find(" GMT "), string::npos);
+  EXPECT_NE(content.find("GET /index.html -7 42  3.14 ff%\n"), string::npos);
+  EXPECT_NE(content.find("ERR "), string::npos);
+  EXPECT_NE(content.find("[ab    ] z (null) missing %d\n"), string::npos);
+  // Conversions follow the arguments.
+  EXPECT_NE(content.find("WRN "), string::npos);
+  EXPECT_NE(content.find(" 2.5 x\n"), string::npos);
+
+  AsyncLogger::Stats stats = logger.GetStats();
+  EXPECT_EQ(stats.numRecords, 3);
+  EXPECT_EQ(stats.numDropped, 0);
+  EXPECT_EQ(stats.numRings, 1);
+}
+
+TEST_F(AsyncLoggerTest, Streams) {
+  {
+    AsyncLogger logger(this->config);
+    LOG_info << "hello " << 42 << endl;
+    LOG_err << "no endl";
+    LOG_warn << string(1000, 'w') << endl;
+    logger.Flush();
+
+    const string content = this->readFile();
+    EXPECT_EQ(this->countLines(content), 2);
+    EXPECT_NE(content.find("INF "), string::npos);
+    EXPECT_NE(content.find("AsyncLogger.cpp"), string::npos);
+    EXPECT_NE(content.find("hello 42\n"), string::npos);
+    EXPECT_NE(content.find("ERR "), string::npos);
+    EXPECT_NE(content.find("no endl"), string::npos);
+    EXPECT_NE(content.find(string(1000, 'w') + "\n"), string::npos);
+    EXPECT_EQ(logger.GetStats().numRecords, 3);
+  }
+
+  // Back to std streams.
+  std::stringstream captured;
+  std::streambuf* original = std::cout.rdbuf(captured.rdbuf());
+  LOG_info << "sync" << endl;
+  AsyncLogger::Log(Logger::Type::INFO, "fallback %d", 1);
+  std::cout.rdbuf(original);
+  EXPECT_NE(captured.str().find("sync\n"), string::npos);
+  EXPECT_NE(captured.str().find("fallback 1\n"), string::npos);
+}
+
+TEST_F(AsyncLoggerTest, Levels) {
+  static_assert(Logger::IsCompiledIn(Logger::Type::INFO) == true, "INFO is compiled in");
+  static_assert(Logger::IsCompiledIn(Logger::Type::LOG) == true, "LOG is never filtered");
+
+  AsyncLogger logger(this->config);
+  Logger::SetLevel(Logger::Type::WARNING);
+  size_t numEvaluated = 0;
+  auto evaluate = [&numEvaluated]() { numEvaluated += 1; return "evaluated"; };
+
+  LOG_info << evaluate() << endl;
+  EXPECT_EQ(LOGF_info("%s", evaluate()), false);
+  EXPECT_EQ(AsyncLogger::Log(Logger::Type::INFO, "direct"), false);
+  EXPECT_EQ(numEvaluated, 0);
+
+  if (numEvaluated == 0)
+    LOG_info << evaluate() << endl;
+  else
+    numEvaluated = 100;
+  EXPECT_EQ(numEvaluated, 0);
+
+  LOG_warn << evaluate() << " warn" << endl;
+  EXPECT_EQ(LOGF_err("code %d %s", 500, evaluate()), true);
+  LOG_log << "always" << endl;
+  EXPECT_EQ(numEvaluated, 2);
+  Logger::SetLevel(Logger::Type::INFO);
+  logger.Flush();
+
+  const string content = this->readFile();
+  EXPECT_EQ(this->countLines(content), 3);
+  EXPECT_EQ(content.find("INF "), string::npos);
+  EXPECT_NE(content.find("evaluated warn\n"), string::npos);
+  // Same layout as _FILE_LINE_INFO.
+  EXPECT_NE(content.find("AsyncLogger.cpp"), string::npos);
+  EXPECT_NE(content.find(" : code 500 evaluated\n"), string::npos);
+  EXPECT_NE(content.find("always\n"), string::npos);
+}
+
+TEST_F(AsyncLoggerTest, Sink) {
+  LogSink::Config sinkConfig(this->filePath + ".sink");
+  {
+    LogSink sink(sinkConfig);
+    this->config.sink = &sink;
+    AsyncLogger logger(this->config);
+    LOG_info << "to the sink" << endl;
+    EXPECT_EQ(LOGF_err("code %d", 500), true);
+    logger.Flush();
+    EXPECT_EQ(sink.GetStats().numWrites, 1);
+  }
+
+  std::ifstream file(sinkConfig.path);
+  std::stringstream content;
+  content << file.rdbuf();
+  EXPECT_EQ(this->countLines(content.str()), 2);
+  EXPECT_NE(content.str().find("to the sink\n"), string::npos);
+  EXPECT_NE(content.str().find("code 500\n"), string::npos);
+  EXPECT_EQ(this->readFile(), "");
+  unlink(sinkConfig.path.c_str());
+}
+
+TEST(UtilTimeTest, Timestamp) {
+  for (uint32_t i = 0; 1000 > i; ++i) {
+    char expected[8];
+    snprintf(expected, sizeof(expected), "%03u", i);
+    char digits[3];
+    Util::Time::FormatMilliseconds(digits, i);
+    ASSERT_EQ(string(digits, 3), expected);
+  }
+
+  // 2015-03-14 09:26:53.589 GMT
+  const datetime tp = std::chrono::system_clock::from_time_t(1426325213) +
+                      std::chrono::milliseconds(589);
+  char buffer[Util::Time::TIMESTAMP_LENGTH];
+  EXPECT_EQ(Util::Time::FormatTimestamp(buffer, tp), Util::Time::TIMESTAMP_LENGTH);
+  EXPECT_EQ(string(buffer, sizeof(buffer)), "2015-03-14 09:26:53.589 GMT");
+  Util::Time::FormatTimestamp(buffer, tp + std::chrono::milliseconds(411));
+  EXPECT_EQ(string(buffer, sizeof(buffer)), "2015-03-14 09:26:54.000 GMT");
+
+  // Cached per thread, but never across times or formats.
+  EXPECT_EQ(Util::Time::ToString(1426325213, "%F %T %Z", false), "2015-03-14 09:26:53 GMT");
+  EXPECT_EQ(Util::Time::ToString(1426325213, "%Y%m%d%H%M%S", false), "20150314092653");
+  EXPECT_EQ(Util::Time::ToString(1426325214, "%Y%m%d%H%M%S", false), "20150314092654");
+  EXPECT_EQ(Util::Time::ToString(1426325214, "http", false), "Sat, 14 Mar 2015 09:26:54 GMT");
+
+  const int64_t difference = std::chrono::duration_cast<std::chrono::milliseconds>(
+      Util::Time::GetNow() - Util::Time::GetNowCoarse()).count();
+  EXPECT_GE(difference, 0);
+  EXPECT_LT(difference, 50);
+  EXPECT_LE(Util::Time::GetSecondsCoarse(), time(nullptr));
+  EXPECT_EQ(Logger::Timestamp(), Util::Time::Timestamp("%F %T %Z", false));
+
+  PERFTEST {
+    const size_t numCalls = 1000000;
+    size_t sum = 0;
+    lio::Test::Measure("GetNow()", 1, numCalls, [&sum](size_t) {
+      sum += Util::Time::GetNow().time_since_epoch().count();
+    });
+    lio::Test::Measure("GetNowCoarse()", 1, numCalls, [&sum](size_t) {
+      sum += Util::Time::GetNowCoarse().time_since_epoch().count();
+    });
+    lio::Test::Measure("strftime() per call", 1, numCalls, [&sum](size_t) {
+      const time_t now = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+      std::string value(32, '\0');
+      value.resize(strftime(&value[0], 32, "%F %T %Z", std::gmtime(&now)));
+      sum += value.size();
+    });
+    lio::Test::Measure("Timestamp()", 1, numCalls, [&sum](size_t) {
+      sum += Util::Time::Timestamp("%F %T %Z", false).size();
+    });
+    lio::Test::Measure("FormatTimestamp()", 1, numCalls, [&sum](size_t) {
+      char buffer[Util::Time::TIMESTAMP_LENGTH];
+      sum += Util::Time::FormatTimestamp(buffer) + buffer[22];
+    });
+    std::cout << sum % 10 << endl;
+  }
+}
+
+TEST_F(AsyncLoggerTest, Threads) {
+  const size_t numThreads = 4;
+  const size_t numRecords = 20000;
+  const AsyncLogger::FullPolicy policies[] = {
+    AsyncLogger::FullPolicy::DROP,
+    AsyncLogger::FullPolicy::BLOCK
+  };
+  for (AsyncLogger::FullPolicy policy : policies) {
+    EXPECT_EQ(ftruncate(this->fd, 0), 0);
+    EXPECT_EQ(lseek(this->fd, 0, SEEK_SET), 0);
+    this->config.ringSize = 4096;
+    this->config.fullPolicy = policy;
+    AsyncLogger logger(this->config);
+
+    std::vector<std::thread> threads;
+    for (size_t i = 0; numThreads > i; ++i) {
+      threads.emplace_back([i, numRecords] {
+        for (size_t j = 0; numRecords > j; ++j) {
+          AsyncLogger::Log(Logger::Type::INFO, "thread %zu record %zu", i, j);
+        }
+      });
+    }
+    for (std::thread& thread : threads) {
+      thread.join();
+    }
+    logger.Flush();
+
+    AsyncLogger::Stats stats = logger.GetStats();
+    EXPECT_EQ(stats.numRecords + stats.numDropped, numThreads * numRecords);
+    EXPECT_EQ(stats.numRings, 0); // Removed when threads are gone.
+    const string content = this->readFile();
+    if (policy == AsyncLogger::FullPolicy::BLOCK) {
+      EXPECT_EQ(stats.numDropped, 0);
+      EXPECT_NE(content.find("thread 3 record 19999\n"), string::npos);
+    }
+    if (stats.numDropped > 0) {
+      EXPECT_NE(content.find("AsyncLogger dropped"), string::npos);
+    }
+    std::cout << "dropped " << stats.numDropped << " writes " << stats.numWrites << endl;
+  }
+}
+
+TEST_F(AsyncLoggerTest, Benchmark) {
+  PERFTEST {
+    const size_t numCalls = 200000;
+    std::ofstream devNull("/dev/null");
+    const int nullFd = open("/dev/null", O_WRONLY);
+
+    std::streambuf* original = std::cout.rdbuf(devNull.rdbuf());
+    std::streambuf* originalErr = std::cerr.rdbuf(devNull.rdbuf());
+    std::streambuf* originalLog = std::clog.rdbuf(devNull.rdbuf());
+    auto syncStart = std::chrono::steady_clock::now();
+    for (size_t i = 0; numCalls > i; ++i) {
+      LOG_info << "request " << i << " from " << "127.0.0.1" << endl;
+    }
+    auto syncNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - syncStart).count();
+    std::cout.rdbuf(original);
+    std::cerr.rdbuf(originalErr);
+    std::clog.rdbuf(originalLog);
+    std::cout << std::setw(20) << std::left << "sync stream" << syncNs / numCalls << " ns/call" << endl;
+
+    AsyncLogger::Config config;
+    config.outFd = nullFd;
+    config.errFd = nullFd;
+    config.fullPolicy = AsyncLogger::FullPolicy::BLOCK;
+    {
+      AsyncLogger logger(config);
+      lio::Test::Measure("async stream", 1, numCalls, [](size_t i) {
+        LOG_info << "request " << i << " from " << "127.0.0.1" << endl;
+      });
+      lio::Test::Measure("async printf", 1, numCalls, [](size_t i) {
+        AsyncLogger::Log(Logger::Type::INFO, "request %zu from %s", i, "127.0.0.1");
+      });
+      lio::Test::Measure("async LOGF_info", 1, numCalls, [](size_t i) {
+        LOGF_info("request %zu from %s", i, "127.0.0.1");
+      });
+      logger.Flush();
+      AsyncLogger::Stats stats = logger.GetStats();
+      std::cout << "records " << stats.numRecords << " writes " << stats.numWrites << endl;
+
+      // Below the level. LOG_MIN_LEVEL removes them entirely.
+      Logger::SetLevel(Logger::Type::WARNING);
+      lio::Test::Measure("disabled LOG_info", 1, numCalls, [](size_t i) {
+        LOG_info << "request " << i << " from " << "127.0.0.1" << endl;
+      });
+      lio::Test::Measure("disabled LOGF_info", 1, numCalls, [](size_t i) {
+        LOGF_info("request %zu from %s", i, "127.0.0.1");
+      });
+      Logger::SetLevel(Logger::Type::INFO);
+    }
+    close(nullFd);
+  }
+}
+
+int main (int argc, char** argv) {
+  ::testing::InitGoogleMock(&argc, argv);
+  return RUN_ALL_TESTS();
+}
+
+#else
+// Executable File's Main Comes here.
+
+
+#endif
+
+#undef _UNIT_TEST
@@ -0,0 +1,400 @@
+#ifndef _ASYNCLOGGER_HPP_
+#define _ASYNCLOGGER_HPP_
+/*
+  Name
+    AsyncLogger
+      Background writer of Logger records, fed by per-thread ring buffers.
+
+  Description
+    Logger::Log() formats the prefix with iostreams, strftime() and
+    getpid() and writes to std::cout or std::cerr in the calling thread.
+    While an AsyncLogger is alive, the calling thread only copies a record
+    into a ring buffer of its own and a background thread formats it and
+    writes it with writev().
+
+    Every thread gets a single producer single consumer ring the first time
+    it logs. Pushing is a copy and a release store, without locks or
+    allocation. Records are
+      FORMAT  printf style format and arguments in binary, from Log().
+              The format is kept as a pointer, so it has to be a literal.
+      TEXT    Bytes of a LOG_* line, collected by a thread local streambuf
+              and pushed on std::endl.
+    Both carry the type and a TSC timestamp, converted to wall clock time
+    by the background thread.
+
+    When a ring is full, DROP counts the record as dropped and returns,
+    and BLOCK waits for the background thread. Dropped records are
+    reported in the log. FATAL and ALERT records are flushed before the
+    call returns.
+
+    LOGF_info("GET %s %d", path, code) and the rest are the LOG_* lines of
+    this path. Like LOG_*, arguments are not evaluated when the type is
+    below LOG_MIN_LEVEL or Logger::SetLevel().
+
+    Lines are in order per thread. Lines of different threads are in order
+    only as far as flushIntervalMs goes.
+
+    The logger has to outlive threads that log while it is destroyed. The
+    background thread does not survive fork(), so create it in the child.
+
+    With Config::sink, batches go to a LogSink instead of outFd and errFd,
+    for rotation and records kept whole across prefork workers.
+
+  Last Modified Date
+    Oct 19, 2026
+
+  History
+    October 19, 2026
+      Created
+      LOGF_* macros with level filtering.
+      Config::sink.
+
+  ToDos
+
+
+  Milestones
+    1.0
+
+
+  Learning Resources
+    NanoLog: A Nanosecond Scale Logging System
+      https://www.usenix.org/conference/atc18/presentation/yang-stephen
+
+  Copyright (c) All rights reserved to LIFEINO.
+*/
+
+#ifdef _DEBUG
+  #undef _DEBUG
+#endif
+#define _DEBUG false
+
+#include "liolib/Debug.hpp"
+
+#include <algorithm> // min()
+#include <atomic>
+#include <condition_variable>
+#include <memory> // shared_ptr
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits> // enable_if
+#include <vector>
+
+#include <cstdint>
+#include <cstring> // memcpy(), strlen()
+
+#include <unistd.h> // STDOUT_FILENO
+
+#include "liolib/Log.hpp"
+
+namespace lio {
+
+using std::string;
+
+class LogSink;
+
+
+class AsyncLogger {
+public:
+
+// ******** Exception Declaration *********
+enum class ExceptionType : std::uint8_t {
+  GENERAL,
+  ALREADY_RUNNING
+};
+#define ASYNCLOGGER_EXCEPTION_MESSAGES \
+  "AsyncLogger Exception has been thrown.", \
+  "Another AsyncLogger is running."
+
+class Exception : public std::exception {
+public:
+  Exception (ExceptionType exceptionType = ExceptionType::GENERAL);
+
+  virtual const char*         what() const noexcept;
+  virtual const               ExceptionType type() const noexcept;
+
+private:
+  const ExceptionType         exceptionType_;
+  static const char* const    exceptionMessages_[];
+};
+// ******** Exception Declaration END*********
+
+  enum class FullPolicy : uint8_t {
+    DROP,
+    BLOCK
+  };
+
+  struct Config {
+    Config() :
+      ringSize(256 * 1024),
+      fullPolicy(FullPolicy::DROP),
+      flushIntervalMs(10),
+      isColored(true),
+      outFd(STDOUT_FILENO),
+      errFd(STDERR_FILENO),
+      sink(nullptr)
+    { }
+    size_t ringSize; // Per thread. Rounded up to a power of 2.
+    FullPolicy fullPolicy;
+    uint32_t flushIntervalMs; // Longest time a record waits in a ring.
+    bool isColored;
+    int outFd; // INFO and WARNING, like std::cout.
+    int errFd; // The rest, like std::clog and std::cerr.
+    LogSink* sink; // Takes every record instead of the fds. Has to outlive the logger.
+  };
+
+  struct Stats {
+    uint64_t numRecords; // Written.
+    uint64_t numDropped;
+    uint64_t numWrites; // writev() calls.
+    size_t numRings;
+  };
+
+  // Starts the background thread and routes Logger::Log() to it.
+  // Throws ALREADY_RUNNING.
+  AsyncLogger(Config config = Config());
+  // Writes what is left in the rings.
+  ~AsyncLogger();
+
+  // printf style. Integers, floating points, strings and pointers.
+  // Length modifiers of format are ignored. Without a running
+  // AsyncLogger the line is written right away through Logger::Log().
+  // False when the record was dropped or the type is disabled.
+  template<typename... Args>
+  static
+  bool            Log(Logger::Type type, const char* format, const Args&... args);
+
+  // Blocks until every record pushed before the call is written.
+  void            Flush();
+
+  Stats           GetStats() const;
+
+  static
+  AsyncLogger*    GetInstance();
+
+private:
+  enum ArgTag : uint8_t {
+    INT,
+    UINT,
+    DOUBLE,
+    STRING,
+    POINTER
+  };
+  static const size_t MAX_STRING_ARG = 1024; // Longer strings are cut.
+
+  struct Record;
+  class Ring;
+  class RecordBuffer;
+  struct ThreadState;
+  struct Batch;
+
+  Config          config_;
+  uint64_t        generation_; // Tells rings of an earlier logger apart.
+  std::thread     thread_;
+
+  mutable std::mutex mutex_;
+  std::condition_variable wakeCv_;
+  std::condition_variable flushCv_;
+  std::vector<std::shared_ptr<Ring>> rings_;
+  bool            isStopping_;
+  std::atomic<bool> isWakeRequested_;
+  uint64_t        numFlushRequested_;
+  uint64_t        numFlushed_;
+
+  std::atomic<uint64_t> numRecords_;
+  std::atomic<uint64_t> numDropped_;
+  std::atomic<uint64_t> numWrites_;
+
+  // Background thread only.
+  uint64_t        anchorTicks_;
+  int64_t         anchorNs_; // CLOCK_REALTIME at anchorTicks_.
+  double          nsPerTick_;
+  time_t          cachedSecond_;
+  char            cachedDate_[24]; // "%F %T" of cachedSecond_.
+  string          prefixes_[(size_t) Logger::Type::FATAL + 1];
+  string          pidString_;
+
+  static std::atomic<AsyncLogger*> instance_;
+  static std::atomic<uint64_t> lastGeneration_;
+  static thread_local ThreadState threadState_;
+
+  void            run();
+  // Returns number of records.
+  size_t          drain(Ring* ring, Batch& out, Batch& err);
+  void            writeBatch(Batch& batch, int fd);
+  void            calibrate();
+  // Appends "INF 2026-10-19 12:34:56.789 GMT  1234 " of the record.
+  void            appendPrefix(string& buffer, Logger::Type type, uint64_t ticks);
+  int             getFd(Logger::Type type) const;
+  void            wake();
+
+  // Ring of the calling thread. Registers one on the first call.
+  Ring*           getRing();
+  // Space of a record in ring, by fullPolicy. nullptr when dropped.
+  char*           reserve(Ring* ring, size_t size);
+
+  // Reserves a FORMAT record with argsSize bytes of arguments. Returns
+  // where to write them, or nullptr when the record was dropped.
+  static
+  char*           beginRecord(Logger::Type type, const char* format, size_t argsSize);
+  static
+  void            endRecord(Logger::Type type);
+
+  static
+  std::ostream&   getStream(Logger::Type type);
+  // Pushes a TEXT record. Writes right away without a running logger.
+  static
+  void            pushText(Logger::Type type, const char* text, size_t length);
+
+  // Formats a FORMAT record into buffer.
+  static
+  void            format(const char* format, const char* args, const char* argsEnd,
+                         string& buffer);
+
+  static
+  uint64_t        getTicks();
+  static
+  int64_t         getRealtimeNs();
+
+  // ===== Argument Encoding =====
+  static
+  size_t          getArgsSize() { return 0; }
+
+  template<typename T, typename... Rest>
+  static
+  size_t          getArgsSize(const T& arg, const Rest&... rest) {
+    return getArgSize(arg) + getArgsSize(rest...);
+  }
+
+  template<typename T>
+  static
+  typename std::enable_if<std::is_arithmetic<T>::value, size_t>::type
+                  getArgSize(const T&) { return 1 + 8; }
+  template<typename T>
+  static
+  size_t          getArgSize(const T*) { return 1 + 8; }
+  static
+  size_t          getArgSize(const char* arg) {
+    return 1 + 4 + getStringLength(arg) + 1;
+  }
+  static
+  size_t          getArgSize(const string& arg) {
+    return 1 + 4 + std::min(arg.size(), MAX_STRING_ARG) + 1;
+  }
+
+  static
+  size_t          getStringLength(const char* arg) {
+    if (arg == nullptr) {
+      return 6; // "(null)"
+    }
+    return strnlen(arg, MAX_STRING_ARG);
+  }
+
+  static
+  void            writeArgs(char*) { }
+
+  template<typename T, typename... Rest>
+  static
+  void            writeArgs(char* buffer, const T& arg, const Rest&... rest) {
+    writeArgs(writeArg(buffer, arg), rest...);
+  }
+
+  template<typename T>
+  static
+  typename std::enable_if<std::is_integral<T>::value && std::is_signed<T>::value, char*>::type
+                  writeArg(char* buffer, const T& arg) {
+    const int64_t value = arg;
+    return writeValue(buffer, ArgTag::INT, &value);
+  }
+  template<typename T>
+  static
+  typename std::enable_if<std::is_integral<T>::value && std::is_unsigned<T>::value, char*>::type
+                  writeArg(char* buffer, const T& arg) {
+    const uint64_t value = arg;
+    return writeValue(buffer, ArgTag::UINT, &value);
+  }
+  template<typename T>
+  static
+  typename std::enable_if<std::is_floating_point<T>::value, char*>::type
+                  writeArg(char* buffer, const T& arg) {
+    const double value = arg;
+    return writeValue(buffer, ArgTag::DOUBLE, &value);
+  }
+  template<typename T>
+  static
+  char*           writeArg(char* buffer, const T* arg) {
+    const uint64_t value = (uintptr_t) arg;
+    return writeValue(buffer, ArgTag::POINTER, &value);
+  }
+  static
+  char*           writeArg(char* buffer, const char* arg) {
+    return writeString(buffer, (arg == nullptr) ? "(null)" : arg, getStringLength(arg));
+  }
+  static
+  char*           writeArg(char* buffer, const string& arg) {
+    return writeString(buffer, arg.data(), std::min(arg.size(), MAX_STRING_ARG));
+  }
+
+  static
+  char*           writeValue(char* buffer, ArgTag tag, const void* value) {
+    *buffer = tag;
+    memcpy(buffer + 1, value, 8);
+    return buffer + 1 + 8;
+  }
+  static
+  char*           writeString(char* buffer, const char* arg, size_t length) {
+    *buffer = ArgTag::STRING;
+    const uint32_t length32 = length;
+    memcpy(buffer + 1, &length32, 4);
+    memcpy(buffer + 1 + 4, arg, length);
+    buffer[1 + 4 + length] = '\0';
+    return buffer + 1 + 4 + length + 1;
+  }
+  // ===== Argument Encoding End =====
+
+  AsyncLogger(const AsyncLogger&) = delete;
+  AsyncLogger& operator=(const AsyncLogger&) = delete;
+};
+
+
+template<typename... Args>
+bool AsyncLogger::Log(Logger::Type type, const char* format, const Args&... args) {
+  if (Logger::IsEnabled(type) == false) {
+    return false;
+  }
+  char* buffer = AsyncLogger::beginRecord(type, format, AsyncLogger::getArgsSize(args...));
+  if (buffer == nullptr) {
+    return false;
+  }
+  AsyncLogger::writeArgs(buffer, args...);
+  AsyncLogger::endRecord(type);
+  return true;
+}
+
+}
+
+
+#define _LOGF(x, format, ...)                                                  \
+  ((lio::Logger::IsCompiledIn(x) == false || lio::Logger::IsEnabled(x) == false) \
+    ? false                                                                    \
+    : lio::AsyncLogger::Log(x, "%-30s:%5d : " format, __FILE__, __LINE__, ##__VA_ARGS__))
+
+#define LOGF_log(format, ...) _LOGF(lio::Logger::Type::LOG, format, ##__VA_ARGS__)
+
+#define LOGF_info(format, ...) _LOGF(lio::Logger::Type::INFO, format, ##__VA_ARGS__)
+
+#define LOGF_secinfo(format, ...)                                              \
+  _LOGF(lio::Logger::Type::SECURITY_INFO, format, ##__VA_ARGS__)
+
+#define LOGF_warn(format, ...) _LOGF(lio::Logger::Type::WARNING, format, ##__VA_ARGS__)
+
+#define LOGF_secwarn(format, ...)                                              \
+  _LOGF(lio::Logger::Type::SECURITY_WARNING, format, ##__VA_ARGS__)
+
+#define LOGF_err(format, ...) _LOGF(lio::Logger::Type::ERROR, format, ##__VA_ARGS__)
+
+#define LOGF_alert(format, ...) _LOGF(lio::Logger::Type::ALERT, format, ##__VA_ARGS__)
+
+#define LOGF_fatal(format, ...) _LOGF(lio::Logger::Type::FATAL, format, ##__VA_ARGS__)
+
+#endif
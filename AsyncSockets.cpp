@@ -30,6 +30,13 @@ AsyncSockets::Exception::type() const noexcept {
 
 const int AsyncSockets::defaultNumEventMax_ = 100;
 
+Statistics::Counter AsyncSockets::numWakeUps_ =
+    Statistics::GetCounter("asyncsockets_wakeups_total", "epoll_wait() returns.");
+Statistics::Histogram AsyncSockets::eventsPerWakeUp_ =
+    Statistics::GetHistogram("asyncsockets_events_per_wakeup", "Events returned by one epoll_wait().");
+Statistics::Counter AsyncSockets::numErrorEvents_ =
+    Statistics::GetCounter("asyncsockets_error_events_total", "EPOLLERR and EPOLLHUP events.");
+
 // SERVER MODE
 
 AsyncSockets::AsyncSockets() :
@@ -301,6 +308,9 @@ void AsyncSockets::waitForEvent(ssize_t epollTimeout) {
                << " errmsg: " << strerror(errno) << endl;
       continue;
     }
+    AsyncSockets::numWakeUps_.Add();
+    AsyncSockets::eventsPerWakeUp_.Record(numEvents);
+    Trace::DumpIfRequested();
     for (int i = 0; numEvents > i; ++i) {
       if ((this->events_[i].events & EPOLLIN) ||
           (this->events_[i].events & EPOLLOUT))
@@ -313,12 +323,14 @@ void AsyncSockets::waitForEvent(ssize_t epollTimeout) {
           eventType = FdEventArgs::EventType::EPOLLOUT;
         }
 
+        Trace::Span span("asyncsockets.dispatch");
         this->OnFdEvent(FdEventArgs(this->events_[i].data.fd, eventType));
 
       } else if ( (this->events_[i].events & EPOLLERR) ||
                   (this->events_[i].events & EPOLLHUP) )
       {
         LOG_err << "EPOLLERR & EPOLLHUP Error!!" << endl;
+        AsyncSockets::numErrorEvents_.Add();
         close (this->events_[i].data.fd);
         continue;
 
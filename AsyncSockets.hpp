@@ -12,9 +12,12 @@
     Provides Asynchronous Socket (event-based) input.
 
   Last Modified Date
-    Sep 29, 2015
+    Oct 19, 2026
 
   History
+    October 19, 2026
+      Statistics of wakeups, events and errors.
+      Trace spans of event dispatch. Trace dumps on request at wakeups.
     July 17, 2013
       Decoupling with Socket class.
       Socket class is used as composition rather than inheritance.
@@ -86,6 +89,8 @@
 
 #include "liolib/Socket.hpp"
 #include "liolib/Util.hpp"
+#include "liolib/Statistics.hpp"
+#include "liolib/Trace.hpp"
 
 
 
@@ -203,6 +208,7 @@ protected:
 
   virtual
   void          OnFdEvent(const FdEventArgs& event) = 0;
+
   
   
   std::map<uint16_t, std::pair<Socket*, SocketMode>> networkSockets_;
@@ -216,6 +222,10 @@ protected:
 
 private:
   static const int defaultNumEventMax_;
+
+  static Statistics::Counter    numWakeUps_;
+  static Statistics::Histogram  eventsPerWakeUp_;
+  static Statistics::Counter    numErrorEvents_;
   bool isSetToStop_;
   struct epoll_event* events_;
 
@@ -0,0 +1,301 @@
+#include "DirectoryPreloader.hpp"
+
+#define _UNIT_TEST false
+#include "liolib/Test.hpp"
+
+#include <algorithm> // min()
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include <cstring> // strcmp()
+
+#include <dirent.h> // opendir()
+#include <sys/stat.h> // lstat()
+
+#include "liolib/Util.hpp" // Util::File::IsDirectoryExisting()
+
+
+namespace lio {
+
+// ===== Exception Implementation =====
+const char* const
+DirectoryPreloader::Exception::exceptionMessages_[] = {
+  DIRECTORYPRELOADER_EXCEPTION_MESSAGES
+};
+#undef DIRECTORYPRELOADER_EXCEPTION_MESSAGES // undef helps reducing unnecessary preprocessing work.
+
+
+DirectoryPreloader::Exception::Exception(ExceptionType exceptionType) :
+  exceptionType_(exceptionType) { }
+
+const char*
+DirectoryPreloader::Exception::what() const noexcept {
+  return this->exceptionMessages_[(int) this->exceptionType_];
+}
+
+const DirectoryPreloader::ExceptionType
+DirectoryPreloader::Exception::type() const noexcept {
+  return this->exceptionType_;
+}
+// ===== Exception Implementation End =====
+
+DirectoryPreloader::DirectoryPreloader(FileCache* cache, Config config) :
+  cache_(cache),
+  config_(config),
+  progressHandler_()
+{
+  DEBUG_FUNC_START;
+  if (this->config_.numThreads == 0) {
+    this->config_.numThreads = std::thread::hardware_concurrency();
+  }
+  if (this->config_.numThreads == 0) {
+    this->config_.numThreads = 1;
+  }
+}
+
+DirectoryPreloader::~DirectoryPreloader() {
+  DEBUG_FUNC_START;
+}
+
+void DirectoryPreloader::SetProgressHandler(ProgressHandler handler) {
+  this->progressHandler_ = handler;
+}
+
+DirectoryPreloader::Progress DirectoryPreloader::Preload(const string& dirPath) {
+  DEBUG_FUNC_START;
+  if (Util::File::IsDirectoryExisting(dirPath) == false) {
+    DEBUG_cerr << "Not a directory: " << dirPath << endl;
+    throw Exception(ExceptionType::NOT_DIRECTORY);
+  }
+
+  typedef std::chrono::steady_clock Clock;
+  const Clock::time_point start = Clock::now();
+  auto getElapsedMs = [&start]() -> uint64_t {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - start).count();
+  };
+
+  std::vector<string> filePaths;
+  const size_t numSkipped = this->walk(dirPath, filePaths);
+  const uint64_t walkMs = getElapsedMs();
+
+  std::atomic<size_t> nextFile(0);
+  std::atomic<size_t> numLoaded(0);
+  std::atomic<size_t> numFailed(0);
+  std::atomic<uint64_t> numBytes(0);
+
+  std::mutex mutex;
+  std::condition_variable finished;
+  const size_t numThreads = std::min(this->config_.numThreads, filePaths.size());
+  size_t numRunning = numThreads; // Guarded by mutex.
+
+  auto worker = [&]() {
+    size_t i = 0;
+    while ((i = nextFile.fetch_add(1)) < filePaths.size()) {
+      FileCache::Handle handle = this->cache_->Get(filePaths[i]);
+      if (handle == nullptr) {
+        numFailed.fetch_add(1);
+        continue;
+      }
+      numBytes.fetch_add(handle->data.length);
+      numLoaded.fetch_add(1);
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    numRunning -= 1;
+    finished.notify_one();
+  };
+
+  auto getProgress = [&]() {
+    Progress progress;
+    progress.numFiles = filePaths.size();
+    progress.numLoaded = numLoaded.load();
+    progress.numFailed = numFailed.load();
+    progress.numSkipped = numSkipped;
+    progress.numBytes = numBytes.load();
+    progress.walkMs = walkMs;
+    progress.elapsedMs = getElapsedMs();
+    return progress;
+  };
+
+  std::vector<std::thread> threads;
+  for (size_t i = 0; numThreads > i; ++i) {
+    threads.emplace_back(worker);
+  }
+
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    const std::chrono::milliseconds interval(this->config_.progressIntervalMs);
+    while (numRunning > 0) {
+      if (finished.wait_for(lock, interval, [&]() { return numRunning == 0; }) == true) {
+        break;
+      }
+      if (this->progressHandler_) {
+        lock.unlock();
+        this->progressHandler_(getProgress());
+        lock.lock();
+      }
+    }
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+
+  Progress progress = getProgress();
+  DEBUG_cout << "Preloaded " << progress.numLoaded << " files, " << progress.numBytes
+             << " bytes in " << progress.elapsedMs << "ms." << endl;
+  if (this->progressHandler_) {
+    this->progressHandler_(progress);
+  }
+  return progress;
+}
+
+size_t DirectoryPreloader::walk(const string& dirPath, std::vector<string>& filePaths) const {
+  size_t numSkipped = 0;
+  std::vector<string> dirs(1, dirPath);
+  while (dirs.empty() == false) {
+    const string dir = dirs.back();
+    dirs.pop_back();
+
+    DIR* dirStream = opendir(dir.c_str());
+    if (dirStream == nullptr) {
+      DEBUG_cerr << "Could not open directory: " << dir << endl;
+      continue;
+    }
+    struct dirent* entry = nullptr;
+    while ((entry = readdir(dirStream)) != nullptr) {
+      if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0 ||
+          (this->config_.isHiddenSkipped == true && entry->d_name[0] == '.')) {
+        continue;
+      }
+      string entryPath = dir;
+      if (entryPath.back() != '/') {
+        entryPath.push_back('/');
+      }
+      entryPath.append(entry->d_name);
+
+      // lstat() so that symbolic links are not followed into loops.
+      struct stat entryStat;
+      if (lstat(entryPath.c_str(), &entryStat) != 0) {
+        continue;
+      }
+      if (S_ISDIR(entryStat.st_mode)) {
+        dirs.push_back(entryPath);
+      } else if (S_ISREG(entryStat.st_mode)) {
+        if ((size_t) entryStat.st_size > this->config_.maxFileSize) {
+          numSkipped += 1;
+          continue;
+        }
+        filePaths.push_back(entryPath);
+      }
+    }
+    closedir(dirStream);
+  }
+  return numSkipped;
+}
+
+}
+
+#if _UNIT_TEST
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include <fstream>
+#include <string>
+
+using namespace lio;
+using std::string;
+
+class DirectoryPreloaderTest : public ::testing::Test {
+protected:
+  void SetUp() {
+    char dirTemplate[] = "/tmp/DirectoryPreloaderTestXXXXXX";
+    this->dir = mkdtemp(dirTemplate);
+  }
+
+  void TearDown() {
+    string command = "rm -rf " + this->dir;
+    EXPECT_EQ(system(command.c_str()), 0);
+  }
+
+  // numDirs directories with numFiles files each.
+  void makeTree(size_t numDirs, size_t numFiles, size_t fileSize) {
+    for (size_t i = 0; numDirs > i; ++i) {
+      const string subDir = this->dir + "/d" + std::to_string(i) + "/sub";
+      string command = "mkdir -p " + subDir;
+      ASSERT_EQ(system(command.c_str()), 0);
+      for (size_t j = 0; numFiles > j; ++j) {
+        std::ofstream file(subDir + "/f" + std::to_string(j) + ".html");
+        file << string(fileSize, 'a' + (j % 26));
+      }
+    }
+  }
+
+  string dir;
+};
+
+TEST_F(DirectoryPreloaderTest, Preload) {
+  this->makeTree(5, 20, 2048);
+  std::ofstream(this->dir + "/big.js") << string(1024 * 64, 'x');
+  ASSERT_EQ(mkdir((this->dir + "/.git").c_str(), 0755), 0);
+  std::ofstream(this->dir + "/.git/HEAD") << "ref";
+
+  FileCache cache;
+  DirectoryPreloader::Config config;
+  config.numThreads = 4;
+  config.maxFileSize = 1024 * 16;
+  DirectoryPreloader preloader(&cache, config);
+  size_t numCalls = 0;
+  preloader.SetProgressHandler([&](const DirectoryPreloader::Progress&) { numCalls += 1; });
+
+  DirectoryPreloader::Progress progress = preloader.Preload(this->dir);
+  EXPECT_EQ(progress.numFiles, 100);
+  EXPECT_EQ(progress.numLoaded, 100);
+  EXPECT_EQ(progress.numFailed, 0);
+  EXPECT_EQ(progress.numSkipped, 1);
+  EXPECT_EQ(progress.numBytes, 100 * 2048);
+  EXPECT_GE(numCalls, 1);
+
+  // Warm. Variants and ETags are ready.
+  FileCache::Stats stats = cache.GetStats();
+  EXPECT_EQ(stats.numEntries, 100);
+  FileCache::Handle handle = cache.Get(this->dir + "/d3/sub/f7.html");
+  ASSERT_NE(handle, nullptr);
+  EXPECT_EQ(handle->etag.empty(), false);
+  EXPECT_NE(handle->GetEncodingMask(), 0);
+  EXPECT_EQ(cache.GetStats().numHits, stats.numHits + 1);
+
+  EXPECT_THROW(preloader.Preload(this->dir + "/missing"), DirectoryPreloader::Exception);
+}
+
+TEST_F(DirectoryPreloaderTest, Benchmark) {
+  PERFTEST {
+    this->makeTree(20, 100, 8 * 1024);
+    const size_t threadCounts[] = { 1, 4, 16 };
+    for (size_t numThreads : threadCounts) {
+      // Drop page cache for cold disk numbers: echo 3 > /proc/sys/vm/drop_caches
+      FileCache cache;
+      DirectoryPreloader::Config config;
+      config.numThreads = numThreads;
+      DirectoryPreloader preloader(&cache, config);
+      DirectoryPreloader::Progress progress = preloader.Preload(this->dir);
+      std::cout << numThreads << " threads: " << progress.numLoaded << " files in "
+                << progress.elapsedMs << "ms (walk " << progress.walkMs << "ms)" << endl;
+    }
+  }
+}
+
+int main (int argc, char** argv) {
+  ::testing::InitGoogleMock(&argc, argv);
+  return RUN_ALL_TESTS();
+}
+
+#else
+// Executable File's Main Comes here.
+
+
+#endif
+
+#undef _UNIT_TEST
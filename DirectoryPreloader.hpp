@@ -0,0 +1,130 @@
+#ifndef _DIRECTORYPRELOADER_HPP_
+#define _DIRECTORYPRELOADER_HPP_
+/*
+  Name
+    DirectoryPreloader
+      Warms FileCache with a whole directory tree at startup.
+
+  Description
+    Loading static files one by one with FileLoader::LoadFile() waits on
+    the disk for each file in turn. Preload() walks the tree once, then
+    numThreads workers call FileCache::Get() on the files, so reads are in
+    flight in parallel. Each entry gets its ETag and compressed variants
+    from FileCache, so the compression cost is spread over the workers too.
+
+    The calling thread waits and calls the progress handler every
+    progressIntervalMs and once at the end.
+
+  Last Modified Date
+    Oct 19, 2026
+
+  History
+    October 19, 2026
+      Created
+
+  ToDos
+
+
+  Milestones
+    1.0
+
+
+  Learning Resources
+
+
+  Copyright (c) All rights reserved to LIFEINO.
+*/
+
+#ifdef _DEBUG
+  #undef _DEBUG
+#endif
+#define _DEBUG false
+
+#include "liolib/Debug.hpp"
+
+#include <string>
+#include <vector>
+#include <functional> // function
+
+#include <cstdint>
+
+#include "liolib/FileCache.hpp"
+
+namespace lio {
+
+using std::string;
+
+
+class DirectoryPreloader {
+public:
+
+// ******** Exception Declaration *********
+enum class ExceptionType : std::uint8_t {
+  GENERAL,
+  NOT_DIRECTORY
+};
+#define DIRECTORYPRELOADER_EXCEPTION_MESSAGES \
+  "DirectoryPreloader Exception has been thrown.", \
+  "Path is not a directory."
+
+class Exception : public std::exception {
+public:
+  Exception (ExceptionType exceptionType = ExceptionType::GENERAL);
+
+  virtual const char*         what() const noexcept;
+  virtual const               ExceptionType type() const noexcept;
+
+private:
+  const ExceptionType         exceptionType_;
+  static const char* const    exceptionMessages_[];
+};
+// ******** Exception Declaration END*********
+
+  struct Config {
+    Config() :
+      numThreads(8),
+      maxFileSize(1024 * 1024 * 4),
+      isHiddenSkipped(true),
+      progressIntervalMs(1000)
+    { }
+    size_t numThreads; // 0 for number of cores. Disk queue depth, mostly.
+    size_t maxFileSize; // Bigger files are left to load on demand.
+    bool isHiddenSkipped; // ".git" and such.
+    uint32_t progressIntervalMs;
+  };
+
+  struct Progress {
+    size_t numFiles; // Found by the walk.
+    size_t numLoaded;
+    size_t numFailed; // Could not be loaded.
+    size_t numSkipped; // Bigger than maxFileSize.
+    uint64_t numBytes; // Of files loaded.
+    uint64_t walkMs;
+    uint64_t elapsedMs; // Walk and load.
+  };
+
+  typedef std::function<void(const Progress& progress)> ProgressHandler;
+
+  DirectoryPreloader(FileCache* cache, Config config = Config());
+  ~DirectoryPreloader();
+
+  void            SetProgressHandler(ProgressHandler handler);
+
+  // Blocks until every file is loaded. Throws NOT_DIRECTORY.
+  Progress        Preload(const string& dirPath);
+
+private:
+  FileCache*      cache_;
+  Config          config_;
+  ProgressHandler progressHandler_;
+
+  // Appends regular files under dirPath. Returns number of skipped files.
+  size_t          walk(const string& dirPath, std::vector<string>& filePaths) const;
+
+  DirectoryPreloader(const DirectoryPreloader&) = delete;
+  DirectoryPreloader& operator=(const DirectoryPreloader&) = delete;
+};
+
+}
+
+#endif
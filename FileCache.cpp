@@ -0,0 +1,698 @@
+#include "FileCache.hpp"
+
+#define _UNIT_TEST false
+#include "liolib/Test.hpp"
+
+#include <functional> // hash
+
+#include <cstdio> // snprintf()
+#include <cstdlib> // free()
+
+#include <sys/stat.h> // stat()
+
+#include "liolib/Util.hpp"
+
+
+namespace lio {
+
+// ===== Exception Implementation =====
+const char* const
+FileCache::Exception::exceptionMessages_[] = {
+  FILECACHE_EXCEPTION_MESSAGES
+};
+#undef FILECACHE_EXCEPTION_MESSAGES // undef helps reducing unnecessary preprocessing work.
+
+
+FileCache::Exception::Exception(ExceptionType exceptionType) :
+  exceptionType_(exceptionType) { }
+
+const char*
+FileCache::Exception::what() const noexcept {
+  return this->exceptionMessages_[(int) this->exceptionType_];
+}
+
+const FileCache::ExceptionType
+FileCache::Exception::type() const noexcept {
+  return this->exceptionType_;
+}
+// ===== Exception Implementation End =====
+
+static string makeEtag(const DataBlock<>& data) {
+  char etag[24];
+  int length = snprintf(etag, sizeof(etag), "\"%016llx\"",
+                        (unsigned long long) Util::Hash::Xxh64(data.object, data.length));
+  return string(etag, length);
+}
+
+// "./a//b" and "a/b" are the same file. Keys and inotify paths ("./name"
+// for a file in the working directory) both go through this. filePath
+// itself is returned when it is already normal, which is the usual case.
+static const string& normalizePath(const string& filePath, string& normalized) {
+  if (filePath.compare(0, 2, "./") != 0 && filePath.find("//") == string::npos &&
+      filePath.find("/./") == string::npos) {
+    return filePath;
+  }
+  normalized.clear();
+  normalized.reserve(filePath.length());
+  size_t i = 0;
+  while (filePath.length() > i) {
+    const bool isComponentStart = normalized.empty() == true || normalized.back() == '/';
+    if (isComponentStart == true && normalized.empty() == false && filePath[i] == '/') {
+      i += 1;
+    } else if (isComponentStart == true && filePath.compare(i, 2, "./") == 0) {
+      i += 2;
+    } else {
+      normalized.push_back(filePath[i]);
+      i += 1;
+    }
+  }
+  return normalized;
+}
+
+FileCache::Entry::Entry(const string& filePath, DataBlock<> fileData, time_t modifiedTime) :
+  path(filePath),
+  data(fileData),
+  mtime(modifiedTime),
+  etag(makeEtag(fileData))
+{ }
+
+FileCache::Entry::~Entry() {
+  free(this->data.object);
+}
+
+size_t FileCache::Entry::GetSize() const {
+  size_t size = this->data.length;
+  for (size_t i = 0; Precompressor::NUM_ENCODINGS > i; ++i) {
+    size += this->encodedData[i].length();
+  }
+  return size;
+}
+
+uint8_t FileCache::Entry::GetEncodingMask() const {
+  uint8_t mask = 0;
+  for (size_t i = 0; Precompressor::NUM_ENCODINGS > i; ++i) {
+    if (this->encodedData[i].empty() == false) {
+      mask |= Precompressor::GetMask(static_cast<Precompressor::Encoding>(i));
+    }
+  }
+  return mask;
+}
+
+DataBlock<> FileCache::Entry::GetDataBlock(Precompressor::Encoding encoding) const {
+  const string& encoded = this->encodedData[static_cast<int>(encoding)];
+  if (encoded.empty() == true) {
+    return this->data;
+  }
+  return DataBlock<>((void*) encoded.data(), 0, encoded.length());
+}
+
+const string& FileCache::Entry::GetEtag(Precompressor::Encoding encoding) const {
+  const string& encodedEtag = this->encodedEtag[static_cast<int>(encoding)];
+  if (encodedEtag.empty() == true) {
+    return this->etag;
+  }
+  return encodedEtag;
+}
+
+FileCache::FileCache(Config config) :
+  config_(config),
+  maxShardSize_(0),
+  inotify_(nullptr),
+  numHits_(0),
+  numMisses_(0),
+  numEvictions_(0),
+  numInvalidations_(0)
+{
+  DEBUG_FUNC_START;
+  if (this->config_.numShards == 0) {
+    this->config_.numShards = 1;
+  }
+  this->maxShardSize_ = this->config_.maxSize / this->config_.numShards;
+  this->shards_.reset(new Shard[this->config_.numShards]);
+  for (size_t i = 0; this->config_.numShards > i; ++i) {
+    this->shards_[i].hand = 0;
+    this->shards_[i].size = 0;
+    this->shards_[i].generation = 0;
+  }
+}
+
+FileCache::~FileCache() {
+  DEBUG_FUNC_START;
+  this->WatchWith(nullptr);
+}
+
+FileCache::Handle FileCache::Get(const string& path) {
+  string buffer;
+  const string& filePath = normalizePath(path, buffer);
+  Shard& shard = this->getShard(filePath);
+  uint64_t generation = 0;
+  {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.index.find(filePath);
+    if (it != shard.index.end()) {
+      Slot& slot = shard.slots[it->second];
+      slot.isReferenced = true;
+      this->numHits_.fetch_add(1, std::memory_order_relaxed);
+      return slot.entry;
+    }
+    generation = shard.generation;
+  }
+  this->numMisses_.fetch_add(1, std::memory_order_relaxed);
+
+  // Watch before loading so a change during the load is not missed.
+  this->watchDirectory(filePath);
+
+  std::shared_ptr<Entry> entry = this->load(filePath);
+  if (entry == nullptr) {
+    return nullptr;
+  }
+  this->insert(shard, entry, generation);
+  return entry;
+}
+
+void FileCache::Invalidate(const string& path) {
+  string buffer;
+  const string& filePath = normalizePath(path, buffer);
+  DEBUG_cout << "Invalidate: " << filePath << endl;
+  Shard& shard = this->getShard(filePath);
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  shard.generation += 1;
+  auto it = shard.index.find(filePath);
+  if (it != shard.index.end()) {
+    this->removeSlot(shard, it->second);
+    this->numInvalidations_.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+void FileCache::Clear() {
+  for (size_t i = 0; this->config_.numShards > i; ++i) {
+    Shard& shard = this->shards_[i];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    shard.generation += 1;
+    shard.index.clear();
+    shard.slots.clear();
+    shard.freeSlots.clear();
+    shard.hand = 0;
+    shard.size = 0;
+  }
+}
+
+void FileCache::WatchWith(Inotify* inotify) {
+  std::lock_guard<std::mutex> lock(this->watchMutex_);
+  if (this->inotify_ != nullptr) {
+    this->setHandlers(this->inotify_, false);
+  }
+  this->inotify_ = inotify;
+  this->watchingDirs_.clear();
+  if (this->inotify_ != nullptr) {
+    this->setHandlers(this->inotify_, true);
+  }
+}
+
+// Inotify waits for a running handler before replacing it, so no handler
+// holding this is left running once this returns.
+void FileCache::setHandlers(Inotify* inotify, bool isEnabled) {
+  std::function<void(const string&)> handler = [](const string&) { };
+  if (isEnabled == true) {
+    handler = [this](const string& filePath) {
+      this->Invalidate(filePath);
+      // "name.gz" changed. Entry of "name" holds its data.
+      for (size_t i = 0; Precompressor::NUM_ENCODINGS > i; ++i) {
+        const string& suffix =
+          Precompressor::GetFileSuffix(static_cast<Precompressor::Encoding>(i));
+        if (suffix.empty() == false && filePath.length() > suffix.length() &&
+            filePath.compare(filePath.length() - suffix.length(), suffix.length(), suffix) == 0) {
+          this->Invalidate(filePath.substr(0, filePath.length() - suffix.length()));
+        }
+      }
+    };
+  }
+  inotify->SetFileCreateHandler(handler);
+  inotify->SetFileModifyHandler(handler);
+  inotify->SetFileDeleteHandler(handler);
+}
+
+FileCache::Stats FileCache::GetStats() const {
+  Stats stats;
+  stats.numHits = this->numHits_.load(std::memory_order_relaxed);
+  stats.numMisses = this->numMisses_.load(std::memory_order_relaxed);
+  stats.numEvictions = this->numEvictions_.load(std::memory_order_relaxed);
+  stats.numInvalidations = this->numInvalidations_.load(std::memory_order_relaxed);
+  stats.numEntries = 0;
+  stats.size = 0;
+  for (size_t i = 0; this->config_.numShards > i; ++i) {
+    Shard& shard = this->shards_[i];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    stats.numEntries += shard.index.size();
+    stats.size += shard.size;
+  }
+  return stats;
+}
+
+FileCache::Shard& FileCache::getShard(const string& filePath) {
+  const size_t hash = std::hash<string>()(filePath);
+  return this->shards_[hash % this->config_.numShards];
+}
+
+std::shared_ptr<FileCache::Entry> FileCache::load(const string& filePath) {
+  struct stat fileStat;
+  if (stat(filePath.c_str(), &fileStat) != 0 || S_ISREG(fileStat.st_mode) == false) {
+    DEBUG_cerr << "Not a regular file: " << filePath << endl;
+    return nullptr;
+  }
+
+  DataBlock<> fileData = FileLoader::LoadFile(filePath);
+  if (fileData.IsNull() == true) {
+    return nullptr;
+  }
+
+  std::shared_ptr<Entry> entry = std::make_shared<Entry>(filePath, fileData, fileStat.st_mtime);
+  const Precompressor::Config& precompress = this->config_.precompress;
+  const bool isCompressible = entry->data.length >= precompress.minFileSize &&
+                              Precompressor::IsCompressible(precompress, filePath) == true;
+  const Precompressor::Encoding encodings[] = {
+    Precompressor::Encoding::GZIP, Precompressor::Encoding::BROTLI, Precompressor::Encoding::ZSTD
+  };
+  for (Precompressor::Encoding encoding : encodings) {
+    if (Precompressor::IsEnabled(precompress, encoding) == false) {
+      continue;
+    }
+    if (this->config_.isPrecompressedFileUsed == true &&
+        this->loadVariant(entry.get(), encoding) == true) {
+      continue;
+    }
+    if (isCompressible == true) {
+      this->compress(entry.get(), encoding);
+    }
+  }
+  return entry;
+}
+
+bool FileCache::loadVariant(Entry* entry, Precompressor::Encoding encoding) {
+  const string variantPath = entry->path + Precompressor::GetFileSuffix(encoding);
+  struct stat variantStat;
+  if (stat(variantPath.c_str(), &variantStat) != 0 ||
+      S_ISREG(variantStat.st_mode) == false ||
+      variantStat.st_mtime < entry->mtime) {
+    return false;
+  }
+
+  FileLoader::MappedFile variant = FileLoader::MapFile(variantPath);
+  if (variant.IsNull() == true) {
+    return false;
+  }
+  string encoded(static_cast<const char*>(variant.GetData()), variant.GetLength());
+  setVariant(entry, encoding, encoded);
+  return true;
+}
+
+void FileCache::compress(Entry* entry, Precompressor::Encoding encoding) {
+  string compressed;
+  try {
+    Precompressor::Compress(encoding, entry->data.object, entry->data.length, compressed);
+  } catch (Precompressor::Exception& e) {
+    DEBUG_cerr << "Failed to compress " << entry->path << ". " << e.what() << endl;
+    return;
+  }
+
+  if (Precompressor::IsWorthKeeping(entry->data.length, compressed.length()) == true) {
+    setVariant(entry, encoding, compressed);
+  }
+}
+
+void FileCache::setVariant(Entry* entry, Precompressor::Encoding encoding, string& encoded) {
+  const int index = static_cast<int>(encoding);
+  entry->encodedData[index].swap(encoded);
+  string& encodedEtag = entry->encodedEtag[index];
+  encodedEtag.assign(entry->etag, 0, entry->etag.length() - 1); // Without closing quote.
+  encodedEtag.push_back('-');
+  encodedEtag.append(Precompressor::GetName(encoding));
+  encodedEtag.push_back('"');
+}
+
+void FileCache::insert(Shard& shard, const Handle& entry, uint64_t generation) {
+  const size_t entrySize = entry->GetSize();
+  if (entrySize > this->maxShardSize_) {
+    DEBUG_cout << "Too big to cache: " << entry->path << endl;
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  if (shard.generation != generation) {
+    // Invalidated while loading. Data may be stale.
+    return;
+  }
+  if (shard.index.find(entry->path) != shard.index.end()) {
+    // Loaded by another thread meanwhile.
+    return;
+  }
+
+  this->evict(shard, entrySize);
+
+  size_t slot = shard.slots.size();
+  if (shard.freeSlots.empty() == false) {
+    slot = shard.freeSlots.back();
+    shard.freeSlots.pop_back();
+  } else {
+    shard.slots.emplace_back();
+  }
+  shard.slots[slot].entry = entry;
+  shard.slots[slot].isReferenced = false;
+  shard.index[entry->path] = slot;
+  shard.size += entrySize;
+}
+
+void FileCache::evict(Shard& shard, size_t requiredSize) {
+  while (shard.size + requiredSize > this->maxShardSize_ && shard.index.empty() == false) {
+    if (shard.hand >= shard.slots.size()) {
+      shard.hand = 0;
+    }
+    Slot& slot = shard.slots[shard.hand];
+    if (slot.entry != nullptr) {
+      if (slot.isReferenced == true) {
+        slot.isReferenced = false;
+      } else {
+        this->removeSlot(shard, shard.hand);
+        this->numEvictions_.fetch_add(1, std::memory_order_relaxed);
+      }
+    }
+    shard.hand += 1;
+  }
+}
+
+void FileCache::removeSlot(Shard& shard, size_t slot) {
+  Slot& target = shard.slots[slot];
+  shard.size -= target.entry->GetSize();
+  shard.index.erase(target.entry->path);
+  target.entry.reset();
+  target.isReferenced = false;
+  shard.freeSlots.push_back(slot);
+}
+
+void FileCache::watchDirectory(const string& filePath) {
+  std::lock_guard<std::mutex> lock(this->watchMutex_);
+  if (this->inotify_ == nullptr) {
+    return;
+  }
+  size_t slashPos = filePath.rfind('/');
+  string dirPath = ".";
+  if (slashPos == 0) {
+    dirPath = "/";
+  } else if (slashPos != string::npos) {
+    dirPath = filePath.substr(0, slashPos);
+  }
+  if (this->watchingDirs_.insert(dirPath).second == true) {
+    this->inotify_->AddToWatch(dirPath);
+  }
+}
+
+//FileCache::
+
+}
+
+#if _UNIT_TEST
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <thread>
+
+#include <climits> // PATH_MAX
+
+#include <unistd.h>
+#include <sys/stat.h> // mkdir()
+
+using namespace lio;
+using std::string;
+
+class FileCacheTest : public ::testing::Test {
+protected:
+  void SetUp() {
+    char dirTemplate[] = "/tmp/FileCacheTestXXXXXX";
+    this->dir = mkdtemp(dirTemplate);
+  }
+
+  void TearDown() {
+    string command = "rm -rf " + this->dir;
+    EXPECT_EQ(system(command.c_str()), 0);
+  }
+
+  string writeFile(const string& name, const string& content) {
+    string filePath = this->dir + "/" + name;
+    std::ofstream file(filePath, std::ios::binary | std::ios::trunc);
+    file << content;
+    return filePath;
+  }
+
+  string dir;
+};
+
+TEST_F(FileCacheTest, HitAndMiss) {
+  const string text(4096, 'a');
+  const string filePath = this->writeFile("index.html", text);
+
+  FileCache cache;
+  FileCache::Handle first = cache.Get(filePath);
+  ASSERT_NE(first, nullptr);
+  EXPECT_EQ(string((char*) first->data.object, first->data.length), text);
+  char expectedEtag[24];
+  snprintf(expectedEtag, sizeof(expectedEtag), "\"%016llx\"",
+           (unsigned long long) Util::Hash::Xxh64(text.data(), text.length()));
+  EXPECT_EQ(first->etag, expectedEtag);
+  const Precompressor::Encoding gzip = Precompressor::Encoding::GZIP;
+  EXPECT_EQ(first->GetEncodingMask(), Precompressor::GetMask(gzip));
+  EXPECT_LT(first->GetDataBlock(gzip).length, text.length());
+  EXPECT_EQ(first->GetEtag(gzip), first->etag.substr(0, 17) + "-gzip\"");
+  EXPECT_EQ(first->GetEtag(Precompressor::Encoding::BROTLI), first->etag);
+
+  FileCache::Handle second = cache.Get(filePath);
+  EXPECT_EQ(second.get(), first.get()); // Same bytes, not a copy.
+  EXPECT_EQ(second->GetDataBlock(Precompressor::Encoding::IDENTITY).object, first->data.object);
+
+  EXPECT_EQ(cache.Get(this->dir + "/missing.html"), nullptr);
+  EXPECT_EQ(cache.Get(this->dir), nullptr);
+
+  FileCache::Stats stats = cache.GetStats();
+  EXPECT_EQ(stats.numHits, 1);
+  EXPECT_EQ(stats.numMisses, 3);
+  EXPECT_EQ(stats.numEntries, 1);
+  EXPECT_EQ(stats.size, first->GetSize());
+}
+
+TEST_F(FileCacheTest, Xxh64) {
+  // Reference values of the XXH64 spec.
+  EXPECT_EQ(Util::Hash::Xxh64("", 0), 0xEF46DB3751D8E999ULL);
+  EXPECT_EQ(Util::Hash::Xxh64("abc", 3), 0x44BC2CF5AD770999ULL);
+  const string text = "Nobody inspects the spammish repetition";
+  EXPECT_EQ(Util::Hash::Xxh64(text.data(), text.length()), 0xFBCEA83C8A378BF1ULL);
+}
+
+TEST_F(FileCacheTest, Eviction) {
+  FileCache::Config config;
+  config.numShards = 1;
+  config.maxSize = 1000;
+  config.precompress.isGzipEnabled = false;
+  FileCache cache(config);
+
+  std::vector<string> paths;
+  for (int i = 0; 4 > i; ++i) {
+    paths.push_back(this->writeFile("file" + std::to_string(i), string(300, 'a' + i)));
+  }
+
+  FileCache::Handle kept = cache.Get(paths[0]);
+  cache.Get(paths[1]);
+  cache.Get(paths[2]);
+  cache.Get(paths[0]); // Referenced. Survives the next sweep.
+  cache.Get(paths[3]);
+
+  FileCache::Stats stats = cache.GetStats();
+  EXPECT_EQ(stats.numEvictions, 1);
+  EXPECT_EQ(stats.numEntries, 3);
+  EXPECT_LE(stats.size, config.maxSize);
+
+  cache.Get(paths[0]);
+  EXPECT_EQ(cache.GetStats().numHits, 2);
+
+  // Evicted entries stay valid while handles exist.
+  cache.Clear();
+  EXPECT_EQ(string((char*) kept->data.object, kept->data.length), string(300, 'a'));
+  EXPECT_EQ(cache.GetStats().numEntries, 0);
+}
+
+TEST_F(FileCacheTest, PrecompressedFile) {
+  const string text(4096, 'a');
+  const string filePath = this->writeFile("main.css", text);
+  this->writeFile("photo.jpg", text);
+  Precompressor::PrecompressDirectory(this->dir);
+
+  // Served as written, not compressed again.
+  string compressed;
+  Precompressor::Compress(Precompressor::Encoding::GZIP, "x", 1, compressed);
+  this->writeFile("main.css.gz", compressed);
+
+  Inotify inotify;
+  FileCache cache;
+  cache.WatchWith(&inotify);
+  FileCache::Handle handle = cache.Get(filePath);
+  ASSERT_NE(handle, nullptr);
+  DataBlock<> variant = handle->GetDataBlock(Precompressor::Encoding::GZIP);
+  EXPECT_EQ(string((char*) variant.object, variant.length), compressed);
+  EXPECT_EQ(cache.Get(this->dir + "/photo.jpg")->GetEncodingMask(), 0);
+
+  // Changing the variant drops the entry of the file.
+  unlink((filePath + ".gz").c_str());
+  inotify.HandleInotifyEvent(inotify.GetInotifyFd());
+  FileCache::Handle reloaded = cache.Get(filePath);
+  ASSERT_NE(reloaded, nullptr);
+  EXPECT_NE(reloaded.get(), handle.get());
+  EXPECT_NE(reloaded->GetDataBlock(Precompressor::Encoding::GZIP).length, compressed.length());
+}
+
+TEST_F(FileCacheTest, InotifyInvalidation) {
+  const string filePath = this->writeFile("app.js", "var a = 1;");
+
+  Inotify inotify;
+  FileCache cache;
+  cache.WatchWith(&inotify);
+
+  FileCache::Handle before = cache.Get(filePath);
+  ASSERT_NE(before, nullptr);
+  EXPECT_EQ(cache.Get(filePath).get(), before.get());
+
+  this->writeFile("app.js", "var a = 2;");
+  inotify.HandleInotifyEvent(inotify.GetInotifyFd());
+
+  FileCache::Handle after = cache.Get(filePath);
+  ASSERT_NE(after, nullptr);
+  EXPECT_NE(after.get(), before.get());
+  EXPECT_EQ(string((char*) after->data.object, after->data.length), "var a = 2;");
+  EXPECT_EQ(string((char*) before->data.object, before->data.length), "var a = 1;");
+
+  unlink(filePath.c_str());
+  inotify.HandleInotifyEvent(inotify.GetInotifyFd());
+  EXPECT_EQ(cache.Get(filePath), nullptr);
+  EXPECT_GE(cache.GetStats().numInvalidations, 2);
+}
+
+TEST_F(FileCacheTest, RelativePath) {
+  this->writeFile("app.js", "var a = 1;");
+  char cwd[PATH_MAX];
+  ASSERT_NE(getcwd(cwd, sizeof(cwd)), nullptr);
+  ASSERT_EQ(chdir(this->dir.c_str()), 0);
+
+  Inotify inotify;
+  FileCache cache;
+  cache.WatchWith(&inotify);
+  FileCache::Handle before = cache.Get("app.js");
+  ASSERT_NE(before, nullptr);
+  EXPECT_EQ(cache.Get("./app.js").get(), before.get());
+  FileCache unwatched;
+  EXPECT_EQ(unwatched.Get(this->dir + "//app.js").get(),
+            unwatched.Get(this->dir + "/./app.js").get());
+
+  // Event comes as "./app.js".
+  this->writeFile("app.js", "var a = 2;");
+  inotify.HandleInotifyEvent(inotify.GetInotifyFd());
+  FileCache::Handle after = cache.Get("app.js");
+  ASSERT_NE(after, nullptr);
+  EXPECT_NE(after.get(), before.get());
+  EXPECT_EQ(string((char*) after->data.object, after->data.length), "var a = 2;");
+
+  EXPECT_EQ(chdir(cwd), 0);
+}
+
+TEST_F(FileCacheTest, ConcurrentWatch) {
+  const size_t NUM_DIRS = 32;
+  const size_t NUM_THREADS = 8;
+  std::vector<string> paths;
+  for (size_t i = 0; NUM_DIRS > i; ++i) {
+    const string name = "d" + std::to_string(i);
+    ASSERT_EQ(mkdir((this->dir + "/" + name).c_str(), 0755), 0);
+    paths.push_back(this->writeFile(name + "/f.css", "a"));
+  }
+
+  Inotify inotify;
+  std::atomic<bool> isDone(false);
+  // Event thread keeps running handlers while watches and handlers change.
+  std::thread eventThread([&inotify, &isDone]() {
+      while (isDone.load() == false) {
+        inotify.HandleInotifyEvent(inotify.GetInotifyFd());
+      }
+  });
+
+  for (int round = 0; 5 > round; ++round) {
+    FileCache* cache = new FileCache();
+    cache->WatchWith(&inotify);
+    std::vector<std::thread> threads;
+    for (size_t t = 0; NUM_THREADS > t; ++t) {
+      threads.emplace_back([cache, &paths, t]() {
+          for (size_t i = 0; paths.size() > i; ++i) {
+            EXPECT_NE(cache->Get(paths[(i + t) % paths.size()]), nullptr);
+          }
+      });
+    }
+    for (size_t i = 0; NUM_DIRS > i; ++i) {
+      this->writeFile("d" + std::to_string(i) + "/f.css", "b");
+    }
+    for (std::thread& thread : threads) {
+      thread.join();
+    }
+    // Handlers point at the cache until here.
+    delete cache;
+  }
+  isDone.store(true);
+  eventThread.join();
+  EXPECT_EQ(inotify.GetWatchingDirs().size(), NUM_DIRS);
+}
+
+TEST_F(FileCacheTest, Benchmark) {
+  PERFTEST {
+    const size_t NUM_FILES = 64;
+    const size_t NUM_REQUESTS = 100000;
+    std::vector<string> paths;
+    for (size_t i = 0; NUM_FILES > i; ++i) {
+      paths.push_back(this->writeFile("f" + std::to_string(i) + ".css", string(16 * 1024, 'x')));
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    size_t numBytes = 0;
+    for (size_t i = 0; NUM_REQUESTS > i; ++i) {
+      DataBlock<> data = FileLoader::LoadFile(paths[i % NUM_FILES]);
+      numBytes += data.length;
+      free(data.object);
+    }
+    double seconds = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+    std::cout << "FileLoader::LoadFile: " << (size_t) (NUM_REQUESTS / seconds)
+              << " files/sec" << endl;
+
+    FileCache cache;
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; NUM_REQUESTS > i; ++i) {
+      FileCache::Handle handle = cache.Get(paths[i % NUM_FILES]);
+      numBytes += handle->data.length;
+    }
+    seconds = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+    std::cout << "FileCache::Get      : " << (size_t) (NUM_REQUESTS / seconds)
+              << " files/sec" << endl;
+    EXPECT_EQ(numBytes, NUM_REQUESTS * 2 * 16 * 1024);
+  }
+}
+
+int main (int argc, char** argv) {
+  ::testing::InitGoogleMock(&argc, argv);
+  return RUN_ALL_TESTS();
+}
+
+#else
+// Executable File's Main Comes here.
+
+
+#endif
+
+#undef _UNIT_TEST
@@ -0,0 +1,231 @@
+#ifndef _FILECACHE_HPP_
+#define _FILECACHE_HPP_
+/*
+  Name
+    FileCache
+      Keeps static files in memory for FileLoader users.
+
+  Description
+    Files are loaded with FileLoader::LoadFile() on first use and kept with
+    their mtime, a strong ETag and compressed variants (gzip, and brotli and zstd
+    when built in and enabled). A variant is read from the "name.gz",
+    "name.br" or "name.zst" file written by Precompressor when it is not
+    older than the file, and compressed in memory otherwise. Variants that
+    do not save enough are not kept. HttpRequest::SelectEncoding() picks
+    one of GetEncodingMask().
+
+    The ETag is the XXH64 of the content, hashed once per load, so a file
+    rewritten with the same bytes keeps its ETag. Each variant has its own
+    ETag, since a strong validator names exactly one representation.
+
+    Get() returns a Handle, which shares the cached entry. Data is never
+    copied on a hit. An entry that is evicted or invalidated stays alive
+    until the last Handle to it is gone.
+
+    Entries are split into shards by path hash. Each shard has its own lock
+    and its own share of maxSize. When a shard is full, entries are evicted
+    with CLOCK: a hit sets the referenced bit, and the hand clears it or
+    evicts the entry when it is already clear.
+
+    Invalidation
+      WatchWith() sets the file handlers of an Inotify and adds the
+      directory of every loaded file to its watch list. Created, modified,
+      deleted and renamed files are dropped from the cache, and so is the
+      file of a changed variant. A file that changes while it is being
+      loaded is not inserted. Get() may add a watch from any thread, as
+      Inotify guards its watch list and handlers.
+
+    Paths
+      "./a//b" and "a/b" are the same key. A file in the working directory
+      is watched through "." and its events come as "./name".
+
+  Last Modified Date
+    Oct 19, 2026
+
+  History
+    October 19, 2026
+      Created
+      Variants of each Precompressor encoding replace the gzip copy.
+      ETags from content hash, one per variant.
+      Keys and inotify paths are normalized alike.
+
+  ToDos
+
+
+  Milestones
+    1.0
+
+
+  Learning Resources
+    CLOCK page replacement
+      https://en.wikipedia.org/wiki/Page_replacement_algorithm#Clock
+
+  Copyright (c) All rights reserved to LIFEINO.
+*/
+
+#ifdef _DEBUG
+  #undef _DEBUG
+#endif
+#define _DEBUG false
+
+#include "liolib/Debug.hpp"
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <set>
+#include <memory> // shared_ptr
+#include <mutex> // mutex
+#include <atomic>
+
+#include <cstdint>
+#include <ctime> // time_t
+
+#include "liolib/DataBlock.hpp"
+#include "liolib/FileLoader.hpp"
+#include "liolib/Inotify.hpp"
+#include "liolib/Precompressor.hpp"
+
+namespace lio {
+
+using std::string;
+
+
+class FileCache {
+public:
+
+// ******** Exception Declaration *********
+enum class ExceptionType : std::uint8_t {
+  GENERAL
+};
+#define FILECACHE_EXCEPTION_MESSAGES \
+  "FileCache Exception has been thrown."
+
+class Exception : public std::exception {
+public:
+  Exception (ExceptionType exceptionType = ExceptionType::GENERAL);
+
+  virtual const char*         what() const noexcept;
+  virtual const               ExceptionType type() const noexcept;
+
+private:
+  const ExceptionType         exceptionType_;
+  static const char* const    exceptionMessages_[];
+};
+// ******** Exception Declaration END*********
+
+  struct Config {
+    Config() :
+      numShards(8),
+      maxSize(1024 * 1024 * 64),
+      precompress(),
+      isPrecompressedFileUsed(true)
+    { }
+    size_t numShards;
+    size_t maxSize; // Bytes of file data and variants of all shards.
+    Precompressor::Config precompress; // Encodings, extensions, min size.
+    bool isPrecompressedFileUsed; // Read up to date variant files.
+  };
+
+  struct Stats {
+    uint64_t numHits;
+    uint64_t numMisses;
+    uint64_t numEvictions;
+    uint64_t numInvalidations;
+    size_t numEntries;
+    size_t size;
+  };
+
+  class Entry {
+  public:
+    Entry(const string& filePath, DataBlock<> fileData, time_t modifiedTime);
+    ~Entry();
+
+    const string      path;
+    const DataBlock<> data; // malloc()'d by FileLoader. Freed with the entry.
+    const time_t      mtime;
+    const string      etag; // Quoted XXH64 of data in hex.
+    // Indexed by Precompressor::Encoding. Empty when not kept.
+    string            encodedData[Precompressor::NUM_ENCODINGS];
+    string            encodedEtag[Precompressor::NUM_ENCODINGS]; // etag with "-br" and such.
+
+    size_t            GetSize() const;
+    // Bits of Precompressor::GetMask() for the variants kept.
+    uint8_t           GetEncodingMask() const;
+    // data itself for IDENTITY or when the variant is not kept.
+    DataBlock<>       GetDataBlock(Precompressor::Encoding encoding) const;
+    // ETag of what GetDataBlock() returns for the encoding.
+    const string&     GetEtag(Precompressor::Encoding encoding) const;
+
+  private:
+    Entry(const Entry&) = delete;
+    Entry& operator=(const Entry&) = delete;
+  };
+
+  typedef std::shared_ptr<const Entry> Handle;
+
+  FileCache(Config config = Config());
+  ~FileCache();
+
+  // nullptr when the file cannot be loaded.
+  Handle          Get(const string& filePath);
+  // Drops the entry. Handles already returned stay valid.
+  void            Invalidate(const string& filePath);
+  void            Clear();
+
+  // Handlers of inotify are set to no-ops by WatchWith(nullptr) and by
+  // the destructor, so inotify may outlive the cache.
+  void            WatchWith(Inotify* inotify);
+
+  Stats           GetStats() const;
+
+private:
+  struct Slot {
+    Handle          entry;
+    bool            isReferenced;
+  };
+
+  struct Shard {
+    std::mutex      mutex;
+    std::unordered_map<string, size_t> index; // Path to slot.
+    std::vector<Slot> slots;
+    std::vector<size_t> freeSlots;
+    size_t          hand;
+    size_t          size;
+    uint64_t        generation; // Increased on invalidation.
+  };
+
+  Config          config_;
+  size_t          maxShardSize_;
+  std::unique_ptr<Shard[]> shards_;
+
+  std::mutex      watchMutex_;
+  Inotify*        inotify_;
+  std::set<string> watchingDirs_;
+
+  std::atomic<uint64_t> numHits_;
+  std::atomic<uint64_t> numMisses_;
+  std::atomic<uint64_t> numEvictions_;
+  std::atomic<uint64_t> numInvalidations_;
+
+  Shard&          getShard(const string& filePath);
+  std::shared_ptr<Entry> load(const string& filePath);
+  bool            loadVariant(Entry* entry, Precompressor::Encoding encoding);
+  void            compress(Entry* entry, Precompressor::Encoding encoding);
+  // Keeps encoded as the variant and sets its ETag.
+  static
+  void            setVariant(Entry* entry, Precompressor::Encoding encoding, string& encoded);
+  void            insert(Shard& shard, const Handle& entry, uint64_t generation);
+  void            evict(Shard& shard, size_t requiredSize);
+  void            removeSlot(Shard& shard, size_t slot);
+  void            watchDirectory(const string& filePath);
+  void            setHandlers(Inotify* inotify, bool isEnabled);
+
+  FileCache(const FileCache&) = delete;
+  FileCache& operator=(const FileCache&) = delete;
+};
+
+}
+
+#endif
+
@@ -8,11 +8,13 @@
     [ETL] Eun T. Leem (eunleem@gmail.com)
 
   Last Modified Date
-    Apr 10, 2014
+    Oct 19, 2026
   
   History
     April 10, 2014
       Created
+    October 19, 2026
+      MapFile() added. Maps a file read-only instead of copying it.
 
   ToDos
     Apr 10, 2014
@@ -45,6 +47,8 @@
 #include <string>
 #include <map>
 
+#include <sys/mman.h> // mmap() madvise()
+
 #include "liolib/DataBlock.hpp"
 
 namespace lio {
@@ -77,6 +81,47 @@ private:
 };
 // ******** Exception Declaration END*********
 
+  struct MapOptions {
+    MapOptions() :
+      isSequential(true),
+      isWillNeed(true),
+      isHugePage(false),
+      isPopulate(false),
+      numPrefaultThreads(0)
+    { }
+    bool isSequential; // MADV_SEQUENTIAL. More read-ahead, pages dropped sooner.
+    bool isWillNeed; // MADV_WILLNEED. Starts reading in the background.
+    bool isHugePage; // MADV_HUGEPAGE. Only when the kernel supports it for files.
+    bool isPopulate; // MAP_POPULATE. mmap() returns after everything is read.
+    size_t numPrefaultThreads; // Touches every page with this many threads before returning.
+  };
+
+  // Owns a read-only mapping. Unmapped on destruction. Move only.
+  class MappedFile {
+  public:
+    MappedFile();
+    MappedFile(MappedFile&& other);
+    MappedFile& operator=(MappedFile&& other);
+    ~MappedFile();
+
+    // Valid while this object is alive.
+    DataBlock<>     GetDataBlock() const;
+    const char*     GetData() const;
+    size_t          GetLength() const;
+    bool            IsNull() const;
+
+  private:
+    friend class FileLoader;
+
+    void*           address_;
+    size_t          length_;
+
+    void            unmap();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+  };
+
 private:
 
 public:
@@ -86,6 +131,14 @@ public:
 
   static
   DataBlock<void*> LoadFile(const string& filePath);
+
+  // No size limit and no copy. Null MappedFile on failure or empty file.
+  static
+  MappedFile      MapFile(const string& filePath, MapOptions options = MapOptions());
+
+  // Reads one byte of every page with numThreads threads. Does nothing when length or numThreads is 0.
+  static
+  void            Prefault(const void* address, size_t length, size_t numThreads);
   //bool RemoveFileFromCache(const string& filePath);
 protected:
 
@@ -5,6 +5,10 @@
   #include "liolib/Test.hpp"
 #endif
 
+#include <atomic>
+#include <thread>
+#include <vector>
+
 namespace lio {
 
 // ===== Exception Implementation =====
@@ -32,6 +36,7 @@ Gzip::Exception::type() const noexcept {
 const size_t Gzip::CHUNK_SIZE = 1024 * 1024;
 const int Gzip::WINDOWS_BITS = 15;
 const int Gzip::GZIP_ENCODING = 16;
+const size_t Gzip::DICTIONARY_SIZE = 32 * 1024; // Deflate window.
 
 Gzip::Gzip(Config config) :
   config_(config),
@@ -50,6 +55,7 @@ Gzip::~Gzip() {
 
 DataBlock<> Gzip::Compress(const void* source, size_t length, int level) {
   DEBUG_FUNC_START;
+  Trace::Span span("gzip.compress");
   if (this->config_.useMemoryPool == false) {
     DEBUG_cerr <<
       "This function requires use of MemoryPool but Gzip is not set to use MP." << endl; 
@@ -174,6 +180,7 @@ DataBlock<> Gzip::Decompress(const void* source, size_t length) {
 
 ssize_t Gzip::Compress(const void* source, size_t length, char* dest, size_t maxSize, int level) {
   DEBUG_FUNC_START;
+  Trace::Span span("gzip.compress");
   DEBUG_cout << "Original size: " << length << endl;
   int ret, flush;
   unsigned have;
@@ -279,19 +286,196 @@ ssize_t Gzip::Decompress(const void* source, size_t length, char* dest, size_t m
 
   return have;
 }
-//Gzip::
-//Gzip::
+size_t Gzip::CompressParallel(const void* source, size_t length, std::string& out, int level) {
+  DEBUG_FUNC_START;
+  const unsigned char* in = (const unsigned char*) source;
+  const size_t blockSize =
+    (this->config_.blockSize > DICTIONARY_SIZE) ? this->config_.blockSize : DICTIONARY_SIZE;
+  const size_t numBlocks = (length == 0) ? 1 : (length + blockSize - 1) / blockSize;
+
+  size_t numThreads = this->config_.numThreads;
+  if (numThreads == 0) {
+    numThreads = std::thread::hardware_concurrency();
+  }
+  if (numThreads == 0) {
+    numThreads = 1;
+  }
+  if (numThreads > numBlocks) {
+    numThreads = numBlocks;
+  }
+
+  struct Block {
+    std::string data;
+    uLong crc;
+    bool isCompressed;
+  };
+  std::vector<Block> blocks(numBlocks);
+  std::atomic<size_t> nextBlock(0);
+
+  auto worker = [&]() {
+    size_t i = 0;
+    while ((i = nextBlock.fetch_add(1)) < numBlocks) {
+      const size_t offset = i * blockSize;
+      const size_t blockLength = (length - offset < blockSize) ? length - offset : blockSize;
+      const size_t dictionaryLength = (offset < DICTIONARY_SIZE) ? offset : DICTIONARY_SIZE;
+      Block& block = blocks[i];
+      block.crc = crc32(crc32(0L, Z_NULL, 0), in + offset, blockLength);
+      block.isCompressed = compressBlock(in + offset, blockLength,
+                                         in + offset - dictionaryLength, dictionaryLength,
+                                         i + 1 == numBlocks, level, block.data);
+    }
+  };
+
+  std::vector<std::thread> threads;
+  // Started threads are joined even when starting another one throws.
+  struct JoinGuard {
+    std::vector<std::thread>& threads;
+    ~JoinGuard() {
+      for (std::thread& thread : this->threads) {
+        if (thread.joinable() == true) {
+          thread.join();
+        }
+      }
+    }
+  } joinGuard = { threads };
+
+  for (size_t i = 1; numThreads > i; ++i) {
+    threads.emplace_back(worker);
+  }
+  worker(); // Calling thread takes blocks too.
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+
+  const size_t startSize = out.length();
+  // ID1 ID2 CM FLG MTIME(4) XFL OS(Unix). RFC 1952
+  static const char HEADER[] = { 0x1f, (char) 0x8b, 8, 0, 0, 0, 0, 0, 0, 3 };
+  out.append(HEADER, sizeof(HEADER));
+
+  uLong crc = crc32(0L, Z_NULL, 0);
+  for (size_t i = 0; numBlocks > i; ++i) {
+    if (blocks[i].isCompressed == false) {
+      out.resize(startSize);
+      DEBUG_cerr << "Block " << i << " failed." << endl;
+      throw Exception(ExceptionType::COMPRESSION_FAIL);
+    }
+    const size_t offset = i * blockSize;
+    const size_t blockLength = (length - offset < blockSize) ? length - offset : blockSize;
+    crc = crc32_combine(crc, blocks[i].crc, blockLength);
+    out.append(blocks[i].data);
+    std::string().swap(blocks[i].data); // Keeps peak memory near one copy.
+  }
+
+  // CRC32 and ISIZE, little endian.
+  const uint32_t trailer[2] = { (uint32_t) crc, (uint32_t) length };
+  for (uint32_t value : trailer) {
+    for (int shift = 0; 32 > shift; shift += 8) {
+      out.push_back((char) ((value >> shift) & 0xff));
+    }
+  }
+  return out.length() - startSize;
+}
+
+bool Gzip::compressBlock(const unsigned char* data, size_t length,
+    const unsigned char* dictionary, size_t dictionaryLength,
+    bool isLast, int level, std::string& out) {
+  z_stream strm;
+  memset(&strm, 0, sizeof(strm));
+  if (deflateInit2(&strm, level, Z_DEFLATED, -WINDOWS_BITS, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+    return false;
+  }
+  if (dictionaryLength > 0 &&
+      deflateSetDictionary(&strm, dictionary, dictionaryLength) != Z_OK) {
+    (void) deflateEnd(&strm);
+    return false;
+  }
+
+  // Bound is for Z_FINISH. Sync flush adds an empty stored block.
+  out.resize(deflateBound(&strm, length) + 16);
+  strm.next_in = (Bytef*) data;
+  strm.avail_in = length;
+  strm.next_out = (Bytef*) &out[0];
+  strm.avail_out = out.length();
+
+  int ret = deflate(&strm, (isLast == true) ? Z_FINISH : Z_SYNC_FLUSH);
+  bool isDone = (isLast == true) ? (ret == Z_STREAM_END) :
+                (ret == Z_OK && strm.avail_in == 0 && strm.avail_out != 0);
+  out.resize(strm.total_out);
+  (void) deflateEnd(&strm);
+  return isDone;
+}
 
 }
 
 #if _UNIT_TEST
 
 
+#include <chrono>
 #include <iostream>
+#include <random>
 
 using namespace lio;
 
+// Text like input. About 3:1 with deflate.
+static string makeText(size_t length) {
+  static const char* WORDS[] = {
+    "server", "request", "response", "header", "the", "of", "cache", "file",
+    "gzip", "block", "thread", "connection", "keep-alive", "GET", "200", "\n"
+  };
+  std::mt19937 random(7);
+  string text;
+  text.reserve(length + 16);
+  while (length > text.length()) {
+    text.append(WORDS[random() % 16]);
+    text.push_back((random() % 8 == 0) ? '\n' : ' ');
+    text.append(std::to_string(random() % 1000));
+  }
+  text.resize(length);
+  return text;
+}
+
+static bool check(bool isPassed, const string& testName) {
+  std::cout << (isPassed ? "PASSED: " : "FAILED: ") << testName << endl;
+  return isPassed;
+}
+
+static bool testCompressParallel() {
+  const string text = makeText(3 * 1024 * 1024 + 12345);
+
+  Gzip::Config config;
+  config.numThreads = 4;
+  config.useMemoryPool = false;
+  Gzip gzip(config);
+
+  bool isPassed = true;
+  string compressed = "prefix";
+  size_t compressedSize = gzip.CompressParallel(text.data(), text.length(), compressed);
+  isPassed &= check(compressed.length() == compressedSize + 6, "CompressParallel appends");
+  compressed.erase(0, 6);
+
+  std::vector<char> decompressed(text.length() + 1);
+  ssize_t decompressedSize = gzip.Decompress(compressed.data(), compressed.length(),
+                                             decompressed.data(), decompressed.size());
+  isPassed &= check(decompressedSize == (ssize_t) text.length() &&
+                    string(decompressed.data(), decompressedSize) == text,
+                    "CompressParallel round trip");
+
+  // Priming keeps the ratio within a few percent of one stream.
+  std::vector<char> single(text.length());
+  ssize_t singleSize = gzip.Compress(text.data(), text.length(), single.data(), single.size());
+  isPassed &= check(singleSize > 0 && (size_t) singleSize * 103 / 100 > compressed.length(),
+                    "CompressParallel ratio");
+
+  string empty;
+  gzip.CompressParallel("", 0, empty);
+  isPassed &= check(gzip.Decompress(empty.data(), empty.length(), decompressed.data(), 1) == 0,
+                    "CompressParallel empty");
+  return isPassed;
+}
+
 int main() {
+  bool isPassed = testCompressParallel();
+
   Gzip gzip;
   string t = "Text to compreesdgsgdsgsss is here. I'm gonna make this string much longer to see how the compression rates differ. Now it only ssaves abodut 3~5% but I expect it tos be way ways way shigher compression rate. :) hehe let's sdgsee how much it will compress the data. :)";
   t += "Text to empress is here. I'm gonna make this string much longer to see how the comvpression rates difefer. xNowe it odasgnly seaves aboutd 3~5% buvt I expesgsgcadfvsadft it to be way way wday hvsigher compression rate. :) hehes let'ds seex how msuch it will compress the data. :)\0";
@@ -300,8 +484,28 @@ int main() {
   
   char* org = (char*)decompressed.object;
   std::cout << org << endl;
-  return 0;
+
+  PERFTEST {
+    const string text = makeText(100 * 1024 * 1024);
+    size_t maxThreads = std::thread::hardware_concurrency();
+    if (maxThreads < 8) {
+      maxThreads = 8;
+    }
+    for (size_t numThreads = 1; maxThreads >= numThreads; numThreads *= 2) {
+      Gzip::Config config;
+      config.numThreads = numThreads;
+      config.useMemoryPool = false;
+      Gzip parallel(config);
+      string out;
+      auto start = std::chrono::steady_clock::now();
+      parallel.CompressParallel(text.data(), text.length(), out);
+      double seconds = std::chrono::duration<double>(
+          std::chrono::steady_clock::now() - start).count();
+      std::cout << numThreads << " threads: " << (size_t) (text.length() / seconds / 1024 / 1024)
+                << " MB/s, " << out.length() << " bytes" << endl;
+    }
+  }
+  return isPassed ? 0 : 1;
 }
 #endif
 #undef _UNIT_TEST
-
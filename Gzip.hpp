@@ -8,13 +8,23 @@
     [ETL] Eun T. Leem (eunleem@gmail.com)
 
   Description
+    CompressParallel() splits input into blocks of config.blockSize and
+    compresses them on config.numThreads threads, the way pigz does. Each
+    block is primed with the last 32KB of the block before it, so the ratio
+    stays close to single threaded deflate. Blocks end on a byte boundary
+    and are joined into one gzip member whose CRC32 is combined from the
+    CRC32 of each block.
 
   Last Modified Date
-    Feb 19, 2015
+    Oct 19, 2026
   
   History
     November 23, 2013
       Created
+    October 19, 2026
+      CompressParallel() added.
+      Trace spans of Compress().
+      CompressParallel() joins started threads when one fails to start.
 
   ToDos
     02-19-2015
@@ -38,6 +48,7 @@
 #include "liolib/Debug.hpp"
 
 #include <iostream>
+#include <string>
 
 #include <cstdio>
 #include <cstring>
@@ -46,6 +57,7 @@
 #include "liolib/MemoryPool.hpp"
 
 #include "liolib/DataBlock.hpp" // DataBlock
+#include "liolib/Trace.hpp"
 
 #include "include/zlib.h"
 
@@ -88,12 +100,16 @@ private:
   struct Config {
     Config() :
       useMemoryPool(false),
-      memoryPoolSize(1024 * 1024 * 3)
+      memoryPoolSize(1024 * 1024 * 3),
+      numThreads(0),
+      blockSize(128 * 1024)
     {
 
     }
     bool useMemoryPool;
     size_t memoryPoolSize;
+    size_t numThreads; // CompressParallel(). 0 for number of cores.
+    size_t blockSize; // CompressParallel(). At least 32KB.
   };
 
   Gzip(Config config = Config());
@@ -106,6 +122,11 @@ private:
       int level = Z_DEFAULT_COMPRESSION);
   ssize_t Decompress(const void* source, size_t length, char* dest, size_t maxSize);
 
+  // One gzip member made of blocks compressed in parallel. Appends to out.
+  // Returns compressed size.
+  size_t CompressParallel(const void* source, size_t length, std::string& out,
+      int level = Z_DEFAULT_COMPRESSION);
+
 
 
 protected:
@@ -123,6 +144,15 @@ private:
 
   static
   const int GZIP_ENCODING;
+
+  static
+  const size_t DICTIONARY_SIZE;
+
+  // Raw deflate of one block. Ends byte aligned unless isLast.
+  static
+  bool compressBlock(const unsigned char* data, size_t length,
+      const unsigned char* dictionary, size_t dictionaryLength,
+      bool isLast, int level, std::string& out);
   
 };
 
@@ -0,0 +1,710 @@
+#include "GzipStream.hpp"
+
+#define _UNIT_TEST false
+#include "liolib/Test.hpp"
+
+#include <algorithm> // max() min()
+#include <limits> // numeric_limits
+
+#include <cstring> // memset()
+
+
+namespace lio {
+
+// ===== Exception Implementation =====
+const char* const
+GzipStream::Exception::exceptionMessages_[] = {
+  GZIPSTREAM_EXCEPTION_MESSAGES
+};
+#undef GZIPSTREAM_EXCEPTION_MESSAGES // undef helps reducing unnecessary preprocessing work.
+
+
+GzipStream::Exception::Exception(ExceptionType exceptionType) :
+  exceptionType_(exceptionType) { }
+
+const char*
+GzipStream::Exception::what() const noexcept {
+  return this->exceptionMessages_[(int) this->exceptionType_];
+}
+
+const GzipStream::ExceptionType
+GzipStream::Exception::type() const noexcept {
+  return this->exceptionType_;
+}
+// ===== Exception Implementation End =====
+
+const size_t GzipStream::MAX_POOLED_STREAMS;
+const size_t GzipStream::CHUNK_SIZE;
+
+thread_local GzipStream::Pool GzipStream::pool_;
+
+// avail_in and avail_out of z_stream are 32 bits.
+static const size_t MAX_PIECE_SIZE = std::numeric_limits<uInt>::max();
+// First output chunk of the string Write(). Grows when it fills up.
+static const size_t MAX_FIRST_CHUNK_SIZE = 1024 * 1024 * 64;
+
+GzipStream::Pool::~Pool() {
+  for (Context* context : this->contexts_) {
+    GzipStream::endContext(context);
+  }
+}
+
+GzipStream::Context* GzipStream::Pool::Acquire(Mode mode, int level) {
+  for (size_t i = this->contexts_.size(); i > 0; --i) {
+    Context* context = this->contexts_[i - 1];
+    if (context->mode == mode &&
+        (mode == Mode::DECOMPRESS || context->level == level)) {
+      this->contexts_.erase(this->contexts_.begin() + (i - 1));
+      return context;
+    }
+  }
+
+  Context* context = new Context();
+  memset(&context->stream, 0, sizeof(context->stream));
+  context->mode = mode;
+  context->level = level;
+
+  int ret = Z_OK;
+  if (mode == Mode::COMPRESS) {
+    // 16 makes zlib write a gzip header and trailer.
+    ret = deflateInit2(&context->stream, level, Z_DEFLATED, 15 | 16, 8, Z_DEFAULT_STRATEGY);
+  } else {
+    // 32 detects gzip or zlib header.
+    ret = inflateInit2(&context->stream, 15 | 32);
+  }
+  if (ret != Z_OK) {
+    DEBUG_cerr << "zlib init failed. ret: " << ret << endl;
+    delete context;
+    throw Exception(ExceptionType::INIT_FAIL);
+  }
+  return context;
+}
+
+void GzipStream::Pool::Release(Context* context) {
+  int ret = Z_OK;
+  if (context->mode == Mode::COMPRESS) {
+    ret = deflateReset(&context->stream);
+  } else {
+    ret = inflateReset(&context->stream);
+  }
+  if (ret != Z_OK || this->contexts_.size() >= MAX_POOLED_STREAMS) {
+    GzipStream::endContext(context);
+    return;
+  }
+  this->contexts_.push_back(context);
+}
+
+size_t GzipStream::Pool::GetSize() const {
+  return this->contexts_.size();
+}
+
+char* GzipStream::Pool::GetChunk() {
+  if (this->chunk_ == nullptr) {
+    this->chunk_.reset(new char[CHUNK_SIZE]);
+  }
+  return this->chunk_.get();
+}
+
+void GzipStream::endContext(Context* context) {
+  if (context->mode == Mode::COMPRESS) {
+    deflateEnd(&context->stream);
+  } else {
+    inflateEnd(&context->stream);
+  }
+  delete context;
+}
+
+GzipStream::GzipStream(Mode mode, int level) :
+  context_(pool_.Acquire(mode, level)),
+  isFinished_(false),
+  limits_(),
+  previousTotalIn_(0),
+  previousTotalOut_(0)
+{ }
+
+GzipStream::~GzipStream() {
+  pool_.Release(this->context_);
+}
+
+void GzipStream::step(Flush flush) {
+  static const int ZLIB_FLUSH[] = { Z_NO_FLUSH, Z_SYNC_FLUSH, Z_FINISH };
+
+  z_stream& stream = this->context_->stream;
+  int ret = Z_OK;
+  if (this->context_->mode == Mode::COMPRESS) {
+    ret = deflate(&stream, ZLIB_FLUSH[(int) flush]);
+    if (ret == Z_STREAM_ERROR) {
+      DEBUG_cerr << "deflate failed." << endl;
+      throw Exception(ExceptionType::COMPRESSION_FAIL);
+    }
+  } else {
+    ret = inflate(&stream, Z_NO_FLUSH);
+    if (ret == Z_NEED_DICT || ret == Z_DATA_ERROR ||
+        ret == Z_MEM_ERROR || ret == Z_STREAM_ERROR) {
+      DEBUG_cerr << "inflate failed. ret: " << ret << endl;
+      throw Exception(ExceptionType::DECOMPRESSION_FAIL);
+    }
+    this->checkLimits();
+  }
+  // Z_BUF_ERROR only means no progress was possible.
+  if (ret == Z_STREAM_END) {
+    this->isFinished_ = true;
+  }
+}
+
+void GzipStream::feed(size_t& numPending) {
+  z_stream& stream = this->context_->stream;
+  if (stream.avail_in == 0 && numPending > 0) {
+    // next_in has been moved past what zlib used, so it points at the rest.
+    const size_t pieceSize = std::min(numPending, MAX_PIECE_SIZE);
+    stream.avail_in = (uInt) pieceSize;
+    numPending -= pieceSize;
+  }
+}
+
+bool GzipStream::hasNextMember(size_t numPending) const {
+  return this->context_->mode == Mode::DECOMPRESS &&
+         (this->context_->stream.avail_in > 0 || numPending > 0);
+}
+
+size_t GzipStream::Write(const void* data, size_t length, string& out, Flush flush) {
+  const size_t initialLength = out.length();
+  z_stream& stream = this->context_->stream;
+  stream.next_in = (Bytef*) data;
+  stream.avail_in = 0;
+  size_t numPending = length;
+
+  size_t chunkSize = 0;
+  if (this->context_->mode == Mode::COMPRESS) {
+    chunkSize = deflateBound(&stream, length) + 16;
+  } else {
+    chunkSize = std::max<size_t>(length * 4, 1024);
+  }
+  chunkSize = std::min(chunkSize, MAX_FIRST_CHUNK_SIZE);
+
+  while (true) {
+    if (this->isFinished_ == true) {
+      if (this->hasNextMember(numPending) == false) {
+        break;
+      }
+      this->startNextMember();
+    }
+    this->feed(numPending);
+    const size_t offset = out.length();
+    out.resize(offset + chunkSize);
+    stream.next_out = (Bytef*) &out[offset];
+    stream.avail_out = (uInt) chunkSize;
+    // Flush applies once the last piece of input is in.
+    this->step(numPending > 0 ? Flush::NONE : flush);
+    out.resize(offset + chunkSize - stream.avail_out);
+    if (stream.avail_out != 0) {
+      if (numPending == 0 && this->isFinished_ == false) {
+        // Input is used up and the flush is complete.
+        break;
+      }
+      continue;
+    }
+    chunkSize = std::min(chunkSize * 2, MAX_PIECE_SIZE);
+  }
+  return out.length() - initialLength;
+}
+
+size_t GzipStream::Write(const void* data, size_t length, char* dest, size_t maxSize,
+                         size_t& numConsumed, Flush flush) {
+  const struct iovec iov = { dest, maxSize };
+  return this->Write(data, length, &iov, 1, numConsumed, flush);
+}
+
+size_t GzipStream::Write(const void* data, size_t length,
+                         const struct iovec* iov, size_t iovCount,
+                         size_t& numConsumed, Flush flush) {
+  z_stream& stream = this->context_->stream;
+  stream.next_in = (Bytef*) data;
+  stream.avail_in = 0;
+  size_t numPending = length;
+
+  size_t numWritten = 0;
+  size_t i = 0;
+  size_t iovOffset = 0; // Written to iov[i].
+  while (iovCount > i) {
+    if (this->isFinished_ == true) {
+      if (this->hasNextMember(numPending) == false) {
+        break;
+      }
+      this->startNextMember();
+    }
+    if (iov[i].iov_len == iovOffset) {
+      i += 1;
+      iovOffset = 0;
+      continue;
+    }
+    this->feed(numPending);
+    const size_t space = std::min(iov[i].iov_len - iovOffset, MAX_PIECE_SIZE);
+    stream.next_out = (Bytef*) iov[i].iov_base + iovOffset;
+    stream.avail_out = (uInt) space;
+    this->step(numPending > 0 ? Flush::NONE : flush);
+    numWritten += space - stream.avail_out;
+    iovOffset += space - stream.avail_out;
+    if (stream.avail_out != 0 && numPending == 0 && this->isFinished_ == false) {
+      break;
+    }
+  }
+  numConsumed = length - numPending - stream.avail_in;
+  return numWritten;
+}
+
+size_t GzipStream::Write(const void* data, size_t length, const Consumer& consumer,
+                         Flush flush) {
+  z_stream& stream = this->context_->stream;
+  stream.next_in = (Bytef*) data;
+  stream.avail_in = 0;
+  size_t numPending = length;
+  char* chunk = pool_.GetChunk();
+
+  size_t numWritten = 0;
+  while (true) {
+    if (this->isFinished_ == true) {
+      if (this->hasNextMember(numPending) == false) {
+        break;
+      }
+      this->startNextMember();
+    }
+    this->feed(numPending);
+    stream.next_out = (Bytef*) chunk;
+    stream.avail_out = CHUNK_SIZE;
+    this->step(numPending > 0 ? Flush::NONE : flush);
+    const size_t chunkLength = CHUNK_SIZE - stream.avail_out;
+    if (chunkLength > 0) {
+      consumer(chunk, chunkLength);
+      numWritten += chunkLength;
+    }
+    if (stream.avail_out != 0 && numPending == 0 && this->isFinished_ == false) {
+      // Input is used up and the flush is complete.
+      break;
+    }
+  }
+  return numWritten;
+}
+
+void GzipStream::SetLimits(const Limits& limits) {
+  this->limits_ = limits;
+}
+
+void GzipStream::checkLimits() const {
+  const uint64_t totalOut = this->GetTotalOut();
+  if (this->limits_.maxOutputSize != 0 && totalOut > this->limits_.maxOutputSize) {
+    DEBUG_cerr << "Output " << totalOut << " exceeds " << this->limits_.maxOutputSize << endl;
+    throw Exception(ExceptionType::LIMIT_EXCEEDED);
+  }
+  // A chunk of output is let through. Short input may expand a lot legitimately.
+  if (this->limits_.maxRatio != 0 && totalOut > CHUNK_SIZE &&
+      totalOut > this->GetTotalIn() * this->limits_.maxRatio) {
+    DEBUG_cerr << "Ratio exceeds " << this->limits_.maxRatio << ". in: "
+               << this->GetTotalIn() << " out: " << totalOut << endl;
+    throw Exception(ExceptionType::LIMIT_EXCEEDED);
+  }
+}
+
+void GzipStream::startNextMember() {
+  z_stream& stream = this->context_->stream;
+  this->previousTotalIn_ += stream.total_in;
+  this->previousTotalOut_ += stream.total_out;
+  // Keeps next_in and avail_in.
+  inflateReset(&stream);
+  this->isFinished_ = false;
+}
+
+bool GzipStream::IsFinished() const {
+  return this->isFinished_;
+}
+
+uint64_t GzipStream::GetTotalIn() const {
+  return this->previousTotalIn_ + this->context_->stream.total_in;
+}
+
+uint64_t GzipStream::GetTotalOut() const {
+  return this->previousTotalOut_ + this->context_->stream.total_out;
+}
+
+void GzipStream::Reset() {
+  if (this->context_->mode == Mode::COMPRESS) {
+    deflateReset(&this->context_->stream);
+  } else {
+    inflateReset(&this->context_->stream);
+  }
+  this->isFinished_ = false;
+  this->previousTotalIn_ = 0;
+  this->previousTotalOut_ = 0;
+}
+
+void GzipStream::Compress(const void* data, size_t length, string& out, int level) {
+  GzipStream stream(Mode::COMPRESS, level);
+  stream.Write(data, length, out, Flush::FINISH);
+}
+
+void GzipStream::Decompress(const void* data, size_t length, string& out) {
+  GzipStream stream(Mode::DECOMPRESS);
+  stream.Write(data, length, out);
+  if (stream.IsFinished() == false) {
+    DEBUG_cerr << "Compressed data is truncated." << endl;
+    throw Exception(ExceptionType::DECOMPRESSION_FAIL);
+  }
+}
+
+size_t GzipStream::GetNumPooledStreams() {
+  return pool_.GetSize();
+}
+
+//GzipStream::
+
+}
+
+#if _UNIT_TEST
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include <sys/mman.h> // mmap()
+
+#include "liolib/Gzip.hpp"
+
+using namespace lio;
+using std::string;
+
+static string makeJson(size_t numItems) {
+  string json = "[";
+  for (size_t i = 0; numItems > i; ++i) {
+    json.append("{\"id\":" + std::to_string(i) + ",\"name\":\"item" + std::to_string(i) +
+                "\",\"tags\":[\"a\",\"b\"],\"active\":true},");
+  }
+  json.back() = ']';
+  return json;
+}
+
+TEST(GzipStream, OneShot) {
+  const string json = makeJson(100);
+  string compressed;
+  GzipStream::Compress(json.data(), json.length(), compressed);
+  EXPECT_LT(compressed.length(), json.length() / 4);
+  EXPECT_EQ((uint8_t) compressed[0], 0x1f); // gzip magic
+  EXPECT_EQ((uint8_t) compressed[1], 0x8b);
+
+  string decompressed;
+  GzipStream::Decompress(compressed.data(), compressed.length(), decompressed);
+  EXPECT_EQ(decompressed, json);
+
+  // Gzip and GzipStream read each other's output.
+  char buffer[1024 * 64];
+  Gzip gzip;
+  ssize_t length = gzip.Compress(json.data(), json.length(), buffer, sizeof(buffer));
+  ASSERT_GT(length, 0);
+  decompressed.clear();
+  GzipStream::Decompress(buffer, length, decompressed);
+  EXPECT_EQ(decompressed, json);
+
+  EXPECT_THROW(GzipStream::Decompress(compressed.data(), compressed.length() / 2, decompressed),
+               GzipStream::Exception);
+  string corrupted = compressed;
+  corrupted[12] ^= 0xff;
+  corrupted[13] ^= 0xff;
+  EXPECT_THROW(GzipStream::Decompress(corrupted.data(), corrupted.length(), decompressed),
+               GzipStream::Exception);
+}
+
+TEST(GzipStream, Pool) {
+  const string json = makeJson(10);
+  string compressed;
+  GzipStream::Compress(json.data(), json.length(), compressed);
+  const size_t numPooled = GzipStream::GetNumPooledStreams();
+  EXPECT_GE(numPooled, 1);
+
+  // Same level reuses the pooled stream.
+  for (int i = 0; 10 > i; ++i) {
+    string again;
+    GzipStream::Compress(json.data(), json.length(), again);
+    EXPECT_EQ(again, compressed);
+  }
+  EXPECT_EQ(GzipStream::GetNumPooledStreams(), numPooled);
+
+  {
+    GzipStream streams[GzipStream::MAX_POOLED_STREAMS + 4];
+  }
+  EXPECT_EQ(GzipStream::GetNumPooledStreams(), GzipStream::MAX_POOLED_STREAMS);
+}
+
+TEST(GzipStream, SyncFlush) {
+  GzipStream compressor;
+  GzipStream decompressor(GzipStream::Mode::DECOMPRESS);
+  string received;
+
+  for (int i = 0; 5 > i; ++i) {
+    const string event = "data: {\"tick\":" + std::to_string(i) + "}\n\n";
+    string chunk;
+    compressor.Write(event.data(), event.length(), chunk, GzipStream::Flush::SYNC);
+    ASSERT_GT(chunk.length(), 0);
+    // Client decodes each chunk as soon as it arrives.
+    const size_t before = received.length();
+    decompressor.Write(chunk.data(), chunk.length(), received);
+    EXPECT_EQ(received.substr(before), event);
+  }
+
+  string trailer;
+  compressor.Write(nullptr, 0, trailer, GzipStream::Flush::FINISH);
+  EXPECT_EQ(compressor.IsFinished(), true);
+  decompressor.Write(trailer.data(), trailer.length(), received);
+  EXPECT_EQ(decompressor.IsFinished(), true);
+
+  compressor.Reset();
+  EXPECT_EQ(compressor.IsFinished(), false);
+  EXPECT_EQ(compressor.GetTotalIn(), 0);
+}
+
+TEST(GzipStream, CallerBuffers) {
+  const string json = makeJson(2000);
+
+  // Small buffer. Caller keeps going until less than the buffer is written.
+  GzipStream stream(GzipStream::Mode::COMPRESS, 6);
+  string compressed;
+  char buffer[512];
+  size_t offset = 0;
+  size_t numWritten = 0;
+  do {
+    size_t numConsumed = 0;
+    numWritten = stream.Write(json.data() + offset, json.length() - offset,
+                              buffer, sizeof(buffer), numConsumed,
+                              GzipStream::Flush::FINISH);
+    offset += numConsumed;
+    compressed.append(buffer, numWritten);
+  } while (numWritten == sizeof(buffer));
+  EXPECT_EQ(offset, json.length());
+  EXPECT_EQ(stream.IsFinished(), true);
+  EXPECT_EQ(stream.GetTotalIn(), json.length());
+  EXPECT_EQ(stream.GetTotalOut(), compressed.length());
+
+  string decompressed;
+  GzipStream::Decompress(compressed.data(), compressed.length(), decompressed);
+  EXPECT_EQ(decompressed, json);
+
+  // iovec
+  stream.Reset();
+  char first[100];
+  char second[1024 * 64];
+  struct iovec iov[2] = { { first, sizeof(first) }, { second, sizeof(second) } };
+  size_t numConsumed = 0;
+  numWritten = stream.Write(json.data(), json.length(), iov, 2, numConsumed,
+                            GzipStream::Flush::FINISH);
+  EXPECT_EQ(numConsumed, json.length());
+  EXPECT_EQ(stream.IsFinished(), true);
+  ASSERT_GT(numWritten, sizeof(first));
+  string joined = string(first, sizeof(first)) + string(second, numWritten - sizeof(first));
+  EXPECT_EQ(joined, compressed);
+}
+
+TEST(GzipStream, Consumer) {
+  const string first = makeJson(3000);
+  const string second = makeJson(50);
+  string members;
+  GzipStream::Compress(first.data(), first.length(), members);
+  GzipStream::Compress(second.data(), second.length(), members);
+
+  // Arrives in pieces. Members are joined.
+  GzipStream stream(GzipStream::Mode::DECOMPRESS);
+  string received;
+  size_t maxChunkLength = 0;
+  auto consumer = [&](const char* data, size_t length) {
+    received.append(data, length);
+    maxChunkLength = std::max(maxChunkLength, length);
+  };
+  for (size_t offset = 0; members.length() > offset; offset += 1000) {
+    stream.Write(members.data() + offset, std::min<size_t>(1000, members.length() - offset),
+                 consumer);
+  }
+  EXPECT_EQ(stream.IsFinished(), true);
+  EXPECT_EQ(received, first + second);
+  EXPECT_EQ(stream.GetTotalIn(), members.length());
+  EXPECT_EQ(stream.GetTotalOut(), received.length());
+  EXPECT_LE(maxChunkLength, GzipStream::CHUNK_SIZE);
+
+  // Not followed by a member.
+  stream.Reset();
+  string garbage = members + "garbage!";
+  EXPECT_THROW(stream.Write(garbage.data(), garbage.length(), consumer),
+               GzipStream::Exception);
+
+  // Other outputs read members the same way.
+  string decompressed;
+  GzipStream::Decompress(members.data(), members.length(), decompressed);
+  EXPECT_EQ(decompressed, first + second);
+  EXPECT_THROW(GzipStream::Decompress(garbage.data(), garbage.length(), decompressed),
+               GzipStream::Exception);
+
+  GzipStream toBuffer(GzipStream::Mode::DECOMPRESS);
+  std::vector<char> buffer(first.length() + second.length() + 1);
+  size_t numConsumed = 0;
+  const size_t numWritten = toBuffer.Write(members.data(), members.length(),
+                                           buffer.data(), buffer.size(), numConsumed);
+  EXPECT_EQ(numConsumed, members.length());
+  EXPECT_EQ(string(buffer.data(), numWritten), first + second);
+}
+
+TEST(GzipStream, LargeInput) {
+  // 4GB and a bit of zeros. Pages are not touched until read.
+  const size_t length = ((size_t) 1 << 32) + 10;
+  void* zeros = mmap(nullptr, length, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE,
+                     -1, 0);
+  ASSERT_NE(zeros, MAP_FAILED);
+
+  string compressed;
+  GzipStream compressor(GzipStream::Mode::COMPRESS, Z_BEST_SPEED);
+  compressor.Write(zeros, length, compressed, GzipStream::Flush::FINISH);
+  munmap(zeros, length);
+  EXPECT_EQ(compressor.GetTotalIn(), length);
+
+  uint64_t numReceived = 0;
+  GzipStream decompressor(GzipStream::Mode::DECOMPRESS);
+  decompressor.Write(compressed.data(), compressed.length(),
+                     [&numReceived](const char*, size_t chunkLength) {
+      numReceived += chunkLength;
+  });
+  EXPECT_EQ(decompressor.IsFinished(), true);
+  EXPECT_EQ(numReceived, length);
+}
+
+TEST(GzipStream, Limits) {
+  // 64MB of zeros is about 64KB compressed.
+  string bomb;
+  {
+    GzipStream compressor(GzipStream::Mode::COMPRESS, 9);
+    const string zeros(1024 * 1024, '\0');
+    for (int i = 0; 63 > i; ++i) {
+      compressor.Write(zeros.data(), zeros.length(), bomb);
+    }
+    compressor.Write(zeros.data(), zeros.length(), bomb, GzipStream::Flush::FINISH);
+  }
+
+  size_t numReceived = 0;
+  auto consumer = [&](const char*, size_t length) { numReceived += length; };
+
+  GzipStream::Limits limits;
+  limits.maxRatio = 100;
+  GzipStream byRatio(GzipStream::Mode::DECOMPRESS);
+  byRatio.SetLimits(limits);
+  try {
+    byRatio.Write(bomb.data(), bomb.length(), consumer);
+    ADD_FAILURE() << "Not stopped.";
+  } catch (GzipStream::Exception& e) {
+    EXPECT_EQ(e.type(), GzipStream::ExceptionType::LIMIT_EXCEEDED);
+  }
+  // Stopped early, not after inflating everything.
+  EXPECT_LE(numReceived, 2 * GzipStream::CHUNK_SIZE);
+
+  limits.maxRatio = 0;
+  limits.maxOutputSize = 1024 * 1024;
+  GzipStream bySize(GzipStream::Mode::DECOMPRESS);
+  bySize.SetLimits(limits);
+  numReceived = 0;
+  EXPECT_THROW(bySize.Write(bomb.data(), bomb.length(), consumer), GzipStream::Exception);
+  EXPECT_LE(numReceived, limits.maxOutputSize);
+
+  // Applies to string output too.
+  string out;
+  GzipStream toString(GzipStream::Mode::DECOMPRESS);
+  toString.SetLimits(limits);
+  EXPECT_THROW(toString.Write(bomb.data(), bomb.length(), out), GzipStream::Exception);
+
+  // Normal data passes.
+  const string json = makeJson(3000);
+  string compressed;
+  GzipStream::Compress(json.data(), json.length(), compressed);
+  limits.maxRatio = 100;
+  GzipStream normal(GzipStream::Mode::DECOMPRESS);
+  normal.SetLimits(limits);
+  numReceived = 0;
+  normal.Write(compressed.data(), compressed.length(), consumer);
+  EXPECT_EQ(numReceived, json.length());
+}
+
+TEST(GzipStream, ConsumerBenchmark) {
+  PERFTEST {
+    const string json = makeJson(200000); // About 13MB
+    string compressed;
+    GzipStream::Compress(json.data(), json.length(), compressed);
+    const size_t NUM_ROUNDS = 10;
+
+    auto report = [&](const char* name, std::chrono::steady_clock::time_point start) {
+      double seconds = std::chrono::duration<double>(
+          std::chrono::steady_clock::now() - start).count();
+      std::cout << name << ": " << (size_t) (NUM_ROUNDS * json.length() / seconds / 1024 / 1024)
+                << " MB/s" << endl;
+    };
+
+    size_t numBytes = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; NUM_ROUNDS > i; ++i) {
+      string out;
+      GzipStream::Decompress(compressed.data(), compressed.length(), out);
+      numBytes += out.length();
+    }
+    report("To string", start);
+
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; NUM_ROUNDS > i; ++i) {
+      GzipStream stream(GzipStream::Mode::DECOMPRESS);
+      stream.Write(compressed.data(), compressed.length(),
+                   [&](const char*, size_t length) { numBytes += length; });
+    }
+    report("Consumer ", start);
+    EXPECT_EQ(numBytes, 2 * NUM_ROUNDS * json.length());
+  }
+}
+
+TEST(GzipStream, SmallResponseBenchmark) {
+  PERFTEST {
+    const size_t NUM_RESPONSES = 20000;
+    const string json = makeJson(20); // About 1.2KB
+    std::cout << "Response size: " << json.length() << " bytes" << endl;
+
+    auto report = [](const char* name, std::chrono::steady_clock::time_point start) {
+      double seconds = std::chrono::duration<double>(
+          std::chrono::steady_clock::now() - start).count();
+      std::cout << name << ": " << (size_t) (NUM_RESPONSES / seconds)
+                << " responses/sec" << endl;
+    };
+
+    size_t numBytes = 0;
+    Gzip gzip;
+    char buffer[1024 * 64];
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; NUM_RESPONSES > i; ++i) {
+      numBytes += gzip.Compress(json.data(), json.length(), buffer, sizeof(buffer));
+    }
+    report("Gzip::Compress      ", start);
+
+    string out;
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; NUM_RESPONSES > i; ++i) {
+      out.clear();
+      GzipStream::Compress(json.data(), json.length(), out);
+      numBytes += out.length();
+    }
+    report("GzipStream::Compress", start);
+    EXPECT_GT(numBytes, 0);
+  }
+}
+
+int main (int argc, char** argv) {
+  ::testing::InitGoogleMock(&argc, argv);
+  return RUN_ALL_TESTS();
+}
+
+#else
+// Executable File's Main Comes here.
+
+
+#endif
+
+#undef _UNIT_TEST
@@ -0,0 +1,237 @@
+#ifndef _GZIPSTREAM_HPP_
+#define _GZIPSTREAM_HPP_
+/*
+  Name
+    GzipStream
+      Incremental gzip compression and decompression with pooled zlib state.
+
+  Description
+    deflateInit2() allocates about 256KB of zlib state, and Gzip does it on
+    every call. GzipStream takes an initialized z_stream from a per-thread
+    pool instead and puts it back, reset with deflateReset() or
+    inflateReset(), when it is destroyed or Reset(). Pooled streams are
+    kept per level.
+
+    Write() takes input piece by piece and writes output into a string, a
+    caller buffer or an iovec array. Flush::SYNC ends the output on a byte
+    boundary so the client can decode everything sent so far, which long
+    lived streams (chunked responses, server-sent events) need.
+    Flush::FINISH writes the gzip trailer.
+
+    With a caller buffer or iovec, output may not fit. Keep calling Write()
+    with the rest of the input (or none) and the same flush until it
+    returns less than the space given.
+
+    Decompression accepts both gzip and zlib headers.
+
+    Untrusted input
+      Gzip request bodies can expand a thousand times. Write() with a
+      Consumer inflates into a pooled chunk of CHUNK_SIZE and hands each
+      chunk over, so nothing grows with the output. SetLimits() caps the
+      output and its ratio to the input. Every decompressing Write() checks
+      them after each chunk, and throws LIMIT_EXCEEDED before more than a
+      chunk goes past them. Concatenated gzip members (RFC 1952 2.2) are
+      read as one stream by every decompressing Write() and Decompress().
+      Bytes after the end of a member that do not start another member
+      throw DECOMPRESSION_FAIL.
+
+    Large input
+      z_stream counts input and output in 32 bits. Input and output space
+      of 4GB or more are handed to zlib in pieces.
+
+  Last Modified Date
+    Oct 19, 2026
+
+  History
+    October 19, 2026
+      Created
+      Consumer Write(), Limits and multiple members added.
+      Input of 4GB or more. Every decompressing Write() reads on members.
+
+  ToDos
+
+
+  Milestones
+    1.0
+
+
+  Learning Resources
+    zlib Manual
+      http://www.zlib.net/manual.html
+
+  Copyright (c) All rights reserved to LIFEINO.
+*/
+
+#ifdef _DEBUG
+  #undef _DEBUG
+#endif
+#define _DEBUG false
+
+#include "liolib/Debug.hpp"
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <memory> // unique_ptr
+
+#include <cstdint>
+
+#include <sys/uio.h> // iovec
+
+#include "include/zlib.h"
+
+namespace lio {
+
+using std::string;
+
+
+class GzipStream {
+public:
+
+// ******** Exception Declaration *********
+enum class ExceptionType : std::uint8_t {
+  GENERAL,
+  INIT_FAIL,
+  COMPRESSION_FAIL,
+  DECOMPRESSION_FAIL,
+  LIMIT_EXCEEDED
+};
+#define GZIPSTREAM_EXCEPTION_MESSAGES \
+  "GzipStream Exception has been thrown.", \
+  "Failed to initialize zlib stream.", \
+  "Failed to compress.", \
+  "Failed to decompress. Data is corrupted.", \
+  "Decompressed data exceeds the limit."
+
+class Exception : public std::exception {
+public:
+  Exception (ExceptionType exceptionType = ExceptionType::GENERAL);
+
+  virtual const char*         what() const noexcept;
+  virtual const               ExceptionType type() const noexcept;
+
+private:
+  const ExceptionType         exceptionType_;
+  static const char* const    exceptionMessages_[];
+};
+// ******** Exception Declaration END*********
+
+  enum class Mode : uint8_t {
+    COMPRESS,
+    DECOMPRESS
+  };
+
+  enum class Flush : uint8_t {
+    NONE, // zlib decides when to emit output.
+    SYNC, // Everything written so far can be decoded.
+    FINISH // Ends the stream.
+  };
+
+  // Decompression limits. 0 for no limit.
+  struct Limits {
+    Limits() :
+      maxOutputSize(0),
+      maxRatio(0)
+    { }
+    uint64_t maxOutputSize; // Bytes of all output.
+    uint32_t maxRatio; // Output bytes per input byte. Checked past a chunk.
+  };
+
+  // Called for each chunk of output. Data is only valid during the call.
+  typedef std::function<void(const char* data, size_t length)> Consumer;
+
+  // Streams kept in each thread's pool.
+  static const size_t MAX_POOLED_STREAMS = 16;
+  // Output chunk given to a Consumer.
+  static const size_t CHUNK_SIZE = 64 * 1024;
+
+  GzipStream(Mode mode = Mode::COMPRESS, int level = Z_DEFAULT_COMPRESSION);
+  ~GzipStream();
+
+  // Appends output to out. Consumes all input.
+  size_t          Write(const void* data, size_t length, string& out,
+                        Flush flush = Flush::NONE);
+  // Returns bytes written to dest. numConsumed is set to input bytes used.
+  size_t          Write(const void* data, size_t length, char* dest, size_t maxSize,
+                        size_t& numConsumed, Flush flush = Flush::NONE);
+  // Fills iov buffers in order. Returns total bytes written.
+  size_t          Write(const void* data, size_t length,
+                        const struct iovec* iov, size_t iovCount,
+                        size_t& numConsumed, Flush flush = Flush::NONE);
+  // Consumes all input. Returns bytes handed to consumer.
+  size_t          Write(const void* data, size_t length, const Consumer& consumer,
+                        Flush flush = Flush::NONE);
+
+  void            SetLimits(const Limits& limits);
+
+  // End of stream has been written (compress) or read (decompress).
+  bool            IsFinished() const;
+  // Of all members.
+  uint64_t        GetTotalIn() const;
+  uint64_t        GetTotalOut() const;
+
+  // Starts a new stream on the same zlib state.
+  void            Reset();
+
+  // One shot. Appends to out.
+  static
+  void            Compress(const void* data, size_t length, string& out,
+                           int level = Z_DEFAULT_COMPRESSION);
+  static
+  void            Decompress(const void* data, size_t length, string& out);
+
+  // Streams in the calling thread's pool.
+  static
+  size_t          GetNumPooledStreams();
+
+private:
+  struct Context {
+    z_stream        stream;
+    Mode            mode;
+    int             level;
+  };
+
+  class Pool {
+  public:
+    ~Pool();
+
+    Context*        Acquire(Mode mode, int level);
+    void            Release(Context* context);
+    size_t          GetSize() const;
+    // CHUNK_SIZE bytes. Shared by streams of the thread.
+    char*           GetChunk();
+
+  private:
+    std::vector<Context*> contexts_;
+    std::unique_ptr<char[]> chunk_;
+  };
+
+  static thread_local Pool pool_;
+
+  Context*        context_;
+  bool            isFinished_;
+  Limits          limits_;
+  uint64_t        previousTotalIn_; // Of finished members.
+  uint64_t        previousTotalOut_;
+
+  // Runs zlib once over the buffers set on the stream.
+  void            step(Flush flush);
+  // Gives zlib the next piece of input once avail_in is used up.
+  void            feed(size_t& numPending);
+  // Input is left after the end of a member when decompressing.
+  bool            hasNextMember(size_t numPending) const;
+  void            checkLimits() const;
+  // Keeps totals and starts reading the next gzip member.
+  void            startNextMember();
+
+  static
+  void            endContext(Context* context);
+
+  GzipStream(const GzipStream&) = delete;
+  GzipStream& operator=(const GzipStream&) = delete;
+};
+
+}
+
+#endif
+
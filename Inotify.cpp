@@ -52,6 +52,7 @@ Inotify::Inotify() :
 
 Inotify::Inotify(int epollFd) :
   numMaxEvent_(50),
+  events_(nullptr),
   inotiFd_(inotify_init()),
   epollFd_(epollFd),
   isEpollInternal_(false)
@@ -70,12 +71,16 @@ Inotify::Inotify(int epollFd) :
 Inotify::~Inotify() {
   DEBUG_FUNC_START;
 
-  for (auto& path : this->watchingDirPaths_) {
-    this->RemoveFromWatch(path.first);
-  } 
+  {
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    for (auto& path : this->watchingDirPaths_) {
+      inotify_rm_watch(this->inotiFd_, path.first);
+    }
+    this->watchingDirPaths_.clear();
+  }
 
   if (this->events_ != nullptr) {
-    delete this->events_;
+    free(this->events_); // calloc()ed.
   } 
   if (this->isEpollInternal_) {
     // Epoll is created by this module. So close it.
@@ -91,10 +96,13 @@ int Inotify::GetInotifyFd() const {
   return this->inotiFd_;
 }
 
-const map<int, string>& Inotify::GetWatchingDirs() const {
+map<int, string> Inotify::GetWatchingDirs() const {
+  std::lock_guard<std::mutex> lock(this->mutex_);
   return this->watchingDirPaths_;
 }
 void Inotify::AddToWatch(const string& targetPath, uint32_t watchEvent) {
+  // Held across inotify_add_watch() so an event of the new wd finds its path.
+  std::lock_guard<std::mutex> lock(this->mutex_);
   int wd = inotify_add_watch(this->inotiFd_, targetPath.c_str(), watchEvent);
 
   if (wd < 0) {
@@ -108,11 +116,12 @@ void Inotify::AddToWatch(const string& targetPath, uint32_t watchEvent) {
 }
 
 void Inotify::RemoveFromWatch(int wd) {
+  std::lock_guard<std::mutex> lock(this->mutex_);
   auto it = this->watchingDirPaths_.find(wd);
   if (it != this->watchingDirPaths_.end()) {
     inotify_rm_watch(this->inotiFd_, (*it).first);
+    DEBUG_cout << "Removed inotify watch for " << (*it).second << endl; 
     this->watchingDirPaths_.erase(it);
-    DEBUG_cout << "Removed inotify watch for " << this->watchingDirPaths_[wd] << endl; 
   } else {
     DEBUG_cerr << "Tried to remove inotify watch but it did not exist." << endl; 
   }
@@ -120,29 +129,33 @@ void Inotify::RemoveFromWatch(int wd) {
 }
 
 void Inotify::SetFileCreateHandler(std::function<void(const string&)> handler) {
+  std::lock_guard<std::mutex> lock(this->mutex_);
   if (handler != nullptr) {
     this->fileCreateHandler_ = handler;
   } 
 }
 void Inotify::SetFileModifyHandler(std::function<void(const string&)> handler) {
+  std::lock_guard<std::mutex> lock(this->mutex_);
   if (handler != nullptr) {
     this->fileModifyHandler_ = handler;
   } 
 }
 void Inotify::SetFileDeleteHandler(std::function<void(const string&)> handler) {
+  std::lock_guard<std::mutex> lock(this->mutex_);
   if (handler != nullptr) {
     this->fileDeleteHandler_ = handler;
   } 
 }
 
 void Inotify::StartWatching() {
-  if (this->watchingDirPaths_.empty()) {
+  const std::map<int, string> dirs = this->GetWatchingDirs();
+  if (dirs.empty()) {
     DEBUG_cerr << "Nothing is added to watching list. Doing nothing." << endl; 
     return;
   } 
   DEBUG {
     DEBUG_cout << "Now Watching directories." << endl; 
-    for (auto& dir : this->watchingDirPaths_) {
+    for (auto& dir : dirs) {
       DEBUG_cout << dir.second << endl; 
     } 
   }
@@ -202,7 +215,9 @@ ssize_t Inotify::processEvent(int fd) {
       if (event->len) {
         DEBUG_cout << "Name: " << event->name << endl; 
 
-        const std::map<int, string>& dirs = this->GetWatchingDirs();
+        // Until the handler returns. Setters wait for it.
+        std::lock_guard<std::mutex> lock(this->mutex_);
+        const std::map<int, string>& dirs = this->watchingDirPaths_;
 
         auto it = dirs.find(event->wd);
         if (it == dirs.end()) {
@@ -260,17 +275,25 @@ ssize_t Inotify::processEvent(int fd) {
             DEBUG_cout << "Directory Renamed from." << endl; 
           } else {
             DEBUG_cout << "File Renamed from." << endl; 
+            // Same as deleted for whoever holds the old path.
+            if (this->fileDeleteHandler_) {
+              this->fileDeleteHandler_(filePath);
+            }
           }
         } else if (event->mask & IN_MOVED_TO) {
           if (event->mask & IN_ISDIR) {
             DEBUG_cout << "Directory Renamed to." << endl; 
           } else {
             DEBUG_cout << "File Renamed to." << endl; 
+            // Editors and deploy scripts replace files this way.
+            if (this->fileCreateHandler_) {
+              this->fileCreateHandler_(filePath);
+            }
           }
         } 
       } 
 NOTISKIP:
-      index += sizeof(struct inotify_event);
+      index += sizeof(struct inotify_event) + event->len;
     }
   } 
 
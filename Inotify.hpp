@@ -5,6 +5,12 @@
     Inotify
       Detects file changes in a directory.
 
+  Description
+    AddToWatch(), RemoveFromWatch() and the handler setters may be called
+    from any thread while another thread handles events. Handlers run with
+    the lock held, so once a setter returns the old handler is not running
+    anymore. Handlers must not call back into the same Inotify.
+
   Authors
     [ETL] Eun T. Leem (eunleem@gmail.com)
 
@@ -14,6 +20,8 @@
   History
     Mar 25, 2014
       Created
+    October 19, 2026
+      Watch list and handlers are guarded for use from several threads.
 
   ToDos
     
@@ -40,6 +48,7 @@
 #include <list> // list
 #include <map>
 #include <functional> // function
+#include <mutex> // mutex
 
 #include <sys/types.h>
 #include <sys/inotify.h> // inotify_init()
@@ -92,7 +101,8 @@ private:
   ~Inotify();
 
   int GetInotifyFd() const;
-  const std::map<int, string>& GetWatchingDirs() const;
+  // Copy, as the list may change on other threads.
+  std::map<int, string> GetWatchingDirs() const;
 
   void AddToWatch(const string& dirPath,
       uint32_t watchEvent = IN_MOVE | IN_MODIFY | IN_CREATE | IN_DELETE);
@@ -129,6 +139,8 @@ private:
 
   bool isEpollInternal_;
 
+  mutable
+  std::mutex mutex_; // Guards watchingDirPaths_ and the handlers.
   std::map<int, string> watchingDirPaths_;
 
   std::function<void(const string&)> fileCreateHandler_;
@@ -1,6 +1,7 @@
 #ifndef _LOG_HPP_
 #define _LOG_HPP_
 
+#include <atomic>
 #include <chrono>
 #include <iostream>
 #include <iomanip>
@@ -9,6 +10,7 @@
 
 #include <cassert>
 #include <cstring>
+#include <ctime> // clock_gettime() gmtime_r()
 
 #include <sys/types.h> // pid_t
 #include <unistd.h> // getpid();
@@ -17,7 +19,18 @@
 
 #include "liolib/Colors.hpp"
 
+// Lowest Logger::Type compiled in, e.g. -DLOG_MIN_LEVEL=WARNING. Calls
+// below it are removed by the compiler with their arguments. LOG is never
+// filtered.
+#ifndef LOG_MIN_LEVEL
+  #define LOG_MIN_LEVEL INFO
+#endif
+
 namespace lio {
+
+class AsyncLogger;
+class LogSink;
+
 /*
  *  LOG: Need to be printed no matter the situation.
  *  LOG_INFO: Function return result, status,
@@ -41,14 +54,24 @@ namespace lio {
       FATAL
     };
 
+    // Stream of a log backend such as AsyncLogger, which formats the
+    // prefix itself. nullptr writes to std streams right away.
+    typedef std::ostream& (*StreamHook)(Type type);
+
     static
     std::ostream& Log(Type type = Type::INFO) {
+      StreamHook hook = streamHook().load(std::memory_order_acquire);
+      if (hook != nullptr) {
+        return hook(type);
+      }
       return getStream(type) << getColor(type) << Logger::toString(type)
                              << TCOLOR::RESET << TCOLOR::BLUE << " "
-                             << Logger::Timestamp("%F %T %Z", false)
+                             << Logger::cachedTimestamp()
                              << std::setw(6) << std::right << getpid() << " ";
     }
 
+    // #DEPRECATED: use LogSink::RedirectLogger(). Swapping rdbuf is not
+    // thread safe and records split where the ofstream buffer fills up.
     static
     bool RedirecTo(const std::string& filePath) {
       Logger::file.open(filePath);
@@ -73,10 +96,67 @@ namespace lio {
       return true;
     }
 
+    static
+    void SetStreamHook(StreamHook hook) {
+      streamHook().store(hook, std::memory_order_release);
+    }
+
+    static constexpr
+    bool IsCompiledIn(Type type) {
+      return type == Type::LOG || (int) type >= (int) Type::LOG_MIN_LEVEL;
+    }
+
+    // Runtime level, on top of LOG_MIN_LEVEL. A relaxed load per call.
+    static
+    bool IsEnabled(Type type) {
+      return type == Type::LOG || (int) type >= level().load(std::memory_order_relaxed);
+    }
+
+    static
+    void SetLevel(Type type) {
+      level().store((int) type, std::memory_order_relaxed);
+    }
+
+    static
+    Type GetLevel() {
+      return (Type) level().load(std::memory_order_relaxed);
+    }
+
   private:
+    friend class AsyncLogger;
+    friend class LogSink;
+
     static
     std::ofstream file;
 
+    inline static
+    std::atomic<StreamHook>& streamHook() {
+      static std::atomic<StreamHook> hook(nullptr);
+      return hook;
+    }
+
+    // "%F %T %Z" in GMT, formatted once per second per thread.
+    inline static
+    const char* cachedTimestamp() {
+      static thread_local time_t cachedSecond = -1;
+      static thread_local char cachedValue[32];
+      struct timespec now;
+      clock_gettime(CLOCK_REALTIME_COARSE, &now);
+      if (now.tv_sec != cachedSecond) {
+        struct tm time;
+        gmtime_r(&now.tv_sec, &time);
+        strftime(cachedValue, sizeof(cachedValue), "%F %T %Z", &time);
+        cachedSecond = now.tv_sec;
+      }
+      return cachedValue;
+    }
+
+    inline static
+    std::atomic<int>& level() {
+      static std::atomic<int> level((int) Type::LOG_MIN_LEVEL);
+      return level;
+    }
+
     inline static
     std::ostream& getStream(Type type) {
        switch (type) {
@@ -133,6 +213,10 @@ namespace lio {
   public:
     static
     std::string Timestamp(const std::string& format = "%F %T %Z", bool in_localtime = false) {
+      if (in_localtime == false && format == "%F %T %Z") {
+        return Logger::cachedTimestamp();
+      }
+
       std::chrono::system_clock::time_point now = std::chrono::system_clock::now();
       std::time_t rawTime = std::chrono::system_clock::to_time_t(now);
 
@@ -158,6 +242,12 @@ namespace lio {
       return buffer;
     }
   };
+
+  // Turns the stream of a LOG_* line into void for _LOGIF. & binds looser
+  // than << and tighter than ?:.
+  struct LogVoidify {
+    void operator&(std::ostream&) const { }
+  };
 }
 
 
@@ -169,22 +259,35 @@ namespace lio {
 
 #define _LOGFUNC(x) lio::Logger::Log(x)
 
+// Nothing right of the macro is evaluated when the type is filtered. An
+// expression, not an if, so an else after the line binds as before.
+#define _LOGIF(x)                                                              \
+  (lio::Logger::IsCompiledIn(x) == false || lio::Logger::IsEnabled(x) == false) \
+    ? (void) 0 : lio::LogVoidify() &
+
 #define LOG_log _LOGFUNC(lio::Logger::Type::LOG) << _FILE_LINE_INFO
 
-#define LOG_info _LOGFUNC(lio::Logger::Type::INFO) << _FILE_LINE_INFO
+#define LOG_info                                                               \
+  _LOGIF(lio::Logger::Type::INFO) _LOGFUNC(lio::Logger::Type::INFO) << _FILE_LINE_INFO
 
-#define LOG_secinfo _LOGFUNC(lio::Logger::Type::SECURITY_INFO) << _FILE_LINE_INFO
+#define LOG_secinfo                                                            \
+  _LOGIF(lio::Logger::Type::SECURITY_INFO)                                     \
+  _LOGFUNC(lio::Logger::Type::SECURITY_INFO) << _FILE_LINE_INFO
 
-#define LOG_warn _LOGFUNC(lio::Logger::Type::WARNING) << _FILE_LINE_INFO
+#define LOG_warn                                                               \
+  _LOGIF(lio::Logger::Type::WARNING) _LOGFUNC(lio::Logger::Type::WARNING) << _FILE_LINE_INFO
 
 #define LOG_secwarn                                                            \
+  _LOGIF(lio::Logger::Type::SECURITY_WARNING)                                  \
   _LOGFUNC(lio::Logger::Type::SECURITY_WARNING) << _FILE_LINE_INFO
 
-#define LOG_err _LOGFUNC(lio::Logger::Type::ERROR) << _FILE_LINE_INFO
-
-#define LOG_alert _LOGFUNC(lio::Logger::Type::ALERT) << _FILE_LINE_INFO
+#define LOG_err                                                                \
+  _LOGIF(lio::Logger::Type::ERROR) _LOGFUNC(lio::Logger::Type::ERROR) << _FILE_LINE_INFO
 
-#define LOG_fatal _LOGFUNC(lio::Logger::Type::FATAL) << _FILE_LINE_INFO
+#define LOG_alert                                                              \
+  _LOGIF(lio::Logger::Type::ALERT) _LOGFUNC(lio::Logger::Type::ALERT) << _FILE_LINE_INFO
 
+#define LOG_fatal                                                              \
+  _LOGIF(lio::Logger::Type::FATAL) _LOGFUNC(lio::Logger::Type::FATAL) << _FILE_LINE_INFO
 
 #endif
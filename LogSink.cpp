@@ -0,0 +1,866 @@
+#include "LogSink.hpp"
+
+#define _UNIT_TEST false
+#include "liolib/Test.hpp"
+
+#include <iomanip> // setw()
+#include <ostream>
+#include <streambuf>
+#include <vector>
+
+#include <cerrno>
+#include <climits> // IOV_MAX
+#include <cstring> // memset()
+
+#include <fcntl.h> // open()
+#include <sys/file.h> // flock()
+#include <sys/stat.h> // fstat()
+#include <unistd.h> // close(), read(), unlink()
+
+#include "liolib/GzipStream.hpp"
+#include "liolib/Util.hpp" // Util::Time
+
+namespace lio {
+
+// ===== Exception Implementation =====
+const char* const
+LogSink::Exception::exceptionMessages_[] = {
+  LOGSINK_EXCEPTION_MESSAGES
+};
+#undef LOGSINK_EXCEPTION_MESSAGES // undef helps reducing unnecessary preprocessing work.
+
+
+LogSink::Exception::Exception(ExceptionType exceptionType) :
+  exceptionType_(exceptionType) { }
+
+const char*
+LogSink::Exception::what() const noexcept {
+  return this->exceptionMessages_[(int) this->exceptionType_];
+}
+
+const LogSink::ExceptionType
+LogSink::Exception::type() const noexcept {
+  return this->exceptionType_;
+}
+// ===== Exception Implementation End =====
+
+
+// Collects a LOG_* line and hands it to the sink on std::endl.
+class LogSink::LineBuffer : public std::streambuf {
+public:
+  LineBuffer() : type_(Logger::Type::INFO) { }
+
+  void            SetType(Logger::Type type) {
+    this->type_ = type;
+  }
+
+protected:
+  int_type        overflow(int_type c) override {
+    if (traits_type::eq_int_type(c, traits_type::eof()) == false) {
+      this->line_ += traits_type::to_char_type(c);
+    }
+    return traits_type::not_eof(c);
+  }
+
+  std::streamsize xsputn(const char* data, std::streamsize length) override {
+    this->line_.append(data, length);
+    return length;
+  }
+
+  int             sync() override {
+    LogSink* sink = LogSink::loggerSink_.load(std::memory_order_acquire);
+    if (this->line_.empty() == true || sink == nullptr) {
+      return 0;
+    }
+    if ((int) this->type_ >= (int) Logger::Type::ERROR) {
+      sink->Write(this->line_.data(), this->line_.length());
+    } else {
+      sink->Append(this->line_.data(), this->line_.length());
+    }
+    this->line_.clear();
+    return 0;
+  }
+
+private:
+  Logger::Type    type_;
+  string          line_;
+};
+
+std::atomic<uint32_t> LogSink::lastReopenGeneration_(0);
+std::atomic<LogSink*> LogSink::loggerSink_(nullptr);
+
+namespace {
+
+bool writeFully(int fd, const char* data, size_t length) {
+  while (length > 0) {
+    const ssize_t written = write(fd, data, length);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    data += written;
+    length -= written;
+  }
+  return true;
+}
+
+}
+
+LogSink::LogSink(const Config& config) :
+  config_(config),
+  fdLock_(1),
+  fd_(-1),
+  inode_(0),
+  fileSize_(0),
+  period_(0),
+  isStopping_(false),
+  isRotating_(false),
+  reopenGeneration_(LogSink::lastReopenGeneration_.load()),
+  isCompressStopping_(false),
+  numWrites_(0),
+  numBytes_(0),
+  numFailedWrites_(0),
+  numRotations_(0),
+  numReopens_(0)
+{
+  DEBUG_FUNC_START;
+
+  if (this->open() == false) {
+    throw Exception(ExceptionType::OPEN_FAILED);
+  }
+  this->batch_.reserve(this->config_.batchSize);
+  this->thread_ = std::thread(&LogSink::run, this);
+  if (this->config_.isCompressed == true) {
+    this->compressThread_ = std::thread(&LogSink::runCompress, this);
+  }
+}
+
+LogSink::~LogSink() {
+  DEBUG_FUNC_START;
+
+  if (LogSink::loggerSink_.load() == this) {
+    LogSink::RedirectLogger(nullptr);
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    this->isStopping_ = true;
+  }
+  this->wakeCv_.notify_one();
+  this->thread_.join();
+  this->Flush();
+
+  if (this->compressThread_.joinable() == true) {
+    {
+      std::lock_guard<std::mutex> lock(this->compressMutex_);
+      this->isCompressStopping_ = true;
+    }
+    this->compressCv_.notify_one();
+    this->compressThread_.join();
+  }
+
+  close(this->fd_);
+}
+
+bool LogSink::Write(const void* data, size_t length) {
+  struct iovec iov = { (void*) data, length };
+  bool isWritten = false;
+  {
+    ReadWriteLock::ReadGuard guard(this->fdLock_);
+    isWritten = this->writeAll(&iov, 1, length);
+  }
+  this->afterWrite(length);
+  return isWritten;
+}
+
+bool LogSink::Write(const struct iovec* iov, int iovCount) {
+  size_t length = 0;
+  for (int i = 0; iovCount > i; ++i) {
+    length += iov[i].iov_len;
+  }
+
+  if (iovCount > IOV_MAX) {
+    // One record still goes out in one write().
+    string record;
+    record.reserve(length);
+    for (int i = 0; iovCount > i; ++i) {
+      record.append((const char*) iov[i].iov_base, iov[i].iov_len);
+    }
+    return this->Write(record.data(), record.length());
+  }
+
+  std::vector<struct iovec> iovecs(iov, iov + iovCount);
+  bool isWritten = false;
+  {
+    ReadWriteLock::ReadGuard guard(this->fdLock_);
+    isWritten = this->writeAll(iovecs.data(), iovCount, length);
+  }
+  this->afterWrite(length);
+  return isWritten;
+}
+
+void LogSink::Append(const void* data, size_t length) {
+  std::lock_guard<std::mutex> lock(this->batchMutex_);
+  if (this->batch_.empty() == false &&
+      this->batch_.length() + length > this->config_.batchSize)
+  {
+    this->Write(this->batch_.data(), this->batch_.length());
+    this->batch_.clear();
+  }
+  this->batch_.append((const char*) data, length);
+  if (this->batch_.length() >= this->config_.batchSize) {
+    this->Write(this->batch_.data(), this->batch_.length());
+    this->batch_.clear();
+  }
+}
+
+bool LogSink::Flush() {
+  std::lock_guard<std::mutex> lock(this->batchMutex_);
+  if (this->batch_.empty() == true) {
+    return true;
+  }
+  const bool isWritten = this->Write(this->batch_.data(), this->batch_.length());
+  this->batch_.clear();
+  return isWritten;
+}
+
+bool LogSink::Reopen() {
+  std::lock_guard<ReadWriteLock> lock(this->fdLock_);
+  this->numReopens_.fetch_add(1, std::memory_order_relaxed);
+  return this->open();
+}
+
+bool LogSink::Rotate() {
+  this->Flush();
+  return this->rotate(true);
+}
+
+const string& LogSink::GetPath() const {
+  return this->config_.path;
+}
+
+LogSink::Stats LogSink::GetStats() const {
+  Stats stats;
+  stats.numWrites = this->numWrites_.load(std::memory_order_relaxed);
+  stats.numBytes = this->numBytes_.load(std::memory_order_relaxed);
+  stats.numFailedWrites = this->numFailedWrites_.load(std::memory_order_relaxed);
+  stats.numRotations = this->numRotations_.load(std::memory_order_relaxed);
+  stats.numReopens = this->numReopens_.load(std::memory_order_relaxed);
+  return stats;
+}
+
+void LogSink::SetReopenSignal(int signalNumber) {
+  struct sigaction action;
+  memset(&action, 0, sizeof(action));
+  action.sa_handler = &LogSink::onReopenSignal;
+  action.sa_flags = SA_RESTART;
+  sigemptyset(&action.sa_mask);
+  sigaction(signalNumber, &action, nullptr);
+}
+
+void LogSink::RedirectLogger(LogSink* sink) {
+  LogSink::loggerSink_.store(sink, std::memory_order_release);
+  Logger::SetStreamHook((sink != nullptr) ? &LogSink::getLoggerStream : nullptr);
+}
+
+bool LogSink::open() {
+  // Read as well, as a read lock needs it.
+  const int fd = ::open(this->config_.path.c_str(),
+                        O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC,
+                        this->config_.permission);
+  if (fd < 0) {
+    DEBUG_cerr << "Failed to open " << this->config_.path << ". errno: " << errno << endl;
+    return false;
+  }
+  // Held until the fd is closed. Compression of the file waits for it.
+  struct flock readLock;
+  memset(&readLock, 0, sizeof(readLock));
+  readLock.l_type = F_RDLCK;
+  readLock.l_whence = SEEK_SET;
+  if (fcntl(fd, F_OFD_SETLK, &readLock) != 0) {
+    DEBUG_cerr << "Failed to lock " << this->config_.path << ". errno: " << errno << endl;
+  }
+  struct stat fileStat;
+  fstat(fd, &fileStat);
+
+  if (this->fd_ >= 0) {
+    close(this->fd_);
+  }
+  this->fd_ = fd;
+  this->inode_ = fileStat.st_ino;
+  this->fileSize_.store(fileStat.st_size, std::memory_order_relaxed);
+  // A file left from an earlier period is rotated on the first check.
+  const time_t lastTime = (fileStat.st_size > 0) ? fileStat.st_mtime : time(nullptr);
+  this->period_ = (this->config_.rotateIntervalSeconds > 0) ?
+                  lastTime / this->config_.rotateIntervalSeconds : 0;
+  return true;
+}
+
+bool LogSink::writeAll(struct iovec* iov, int iovCount, size_t length) {
+  while (iovCount > 0) {
+    const ssize_t written = writev(this->fd_, iov, iovCount);
+    this->numWrites_.fetch_add(1, std::memory_order_relaxed);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      this->numFailedWrites_.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+
+    // Cut short, as on a full disk. The rest goes in another write.
+    size_t remaining = written;
+    while (iovCount > 0 && remaining >= iov->iov_len) {
+      remaining -= iov->iov_len;
+      ++iov;
+      --iovCount;
+    }
+    if (iovCount > 0) {
+      iov->iov_base = (char*) iov->iov_base + remaining;
+      iov->iov_len -= remaining;
+    }
+  }
+  this->numBytes_.fetch_add(length, std::memory_order_relaxed);
+  return true;
+}
+
+void LogSink::afterWrite(size_t length) {
+  const uint64_t fileSize = this->fileSize_.fetch_add(length, std::memory_order_relaxed) + length;
+  // The writer that reaches maxFileSize rotates. Writers of other threads
+  // wait on fdLock_ meanwhile.
+  if (this->config_.maxFileSize > 0 && fileSize >= this->config_.maxFileSize &&
+      this->isRotating_.exchange(true) == false)
+  {
+    this->rotate(false);
+    this->isRotating_.store(false);
+  }
+}
+
+bool LogSink::isRotationDue(uint64_t fileSize) const {
+  if (this->config_.maxFileSize > 0 && fileSize >= this->config_.maxFileSize) {
+    return true;
+  }
+  return this->config_.rotateIntervalSeconds > 0 &&
+         Util::Time::GetSecondsCoarse() / this->config_.rotateIntervalSeconds != this->period_;
+}
+
+bool LogSink::rotate(bool isForced) {
+  std::lock_guard<ReadWriteLock> lock(this->fdLock_);
+  // Other processes sharing the file wait here, and then see the new file.
+  if (flock(this->fd_, LOCK_EX) != 0) {
+    return false;
+  }
+
+  struct stat pathStat;
+  if (stat(this->config_.path.c_str(), &pathStat) != 0 || pathStat.st_ino != this->inode_) {
+    // Rotated by another process. Closing the fd releases the flock.
+    this->numReopens_.fetch_add(1, std::memory_order_relaxed);
+    this->open();
+    return false;
+  }
+  if (isForced == false && this->isRotationDue(pathStat.st_size) == false) {
+    this->fileSize_.store(pathStat.st_size, std::memory_order_relaxed);
+    flock(this->fd_, LOCK_UN);
+    return false;
+  }
+
+  const string rotatedPath = this->getRotatedPath();
+  if (rename(this->config_.path.c_str(), rotatedPath.c_str()) != 0) {
+    DEBUG_cerr << "Failed to rename " << this->config_.path << ". errno: " << errno << endl;
+    flock(this->fd_, LOCK_UN);
+    return false;
+  }
+  if (this->open() == false) {
+    flock(this->fd_, LOCK_UN);
+    return false;
+  }
+  this->numRotations_.fetch_add(1, std::memory_order_relaxed);
+
+  if (this->config_.isCompressed == true) {
+    {
+      std::lock_guard<std::mutex> compressLock(this->compressMutex_);
+      this->compressJobs_.push_back(CompressJob{ rotatedPath, time(nullptr) });
+    }
+    this->compressCv_.notify_one();
+  }
+  return true;
+}
+
+void LogSink::checkFile() {
+  struct stat pathStat;
+  ino_t inode = 0;
+  {
+    ReadWriteLock::ReadGuard guard(this->fdLock_);
+    inode = this->inode_;
+  }
+  if (stat(this->config_.path.c_str(), &pathStat) != 0 || pathStat.st_ino != inode) {
+    this->Reopen();
+    return;
+  }
+  this->fileSize_.store(pathStat.st_size, std::memory_order_relaxed);
+}
+
+string LogSink::getRotatedPath() const {
+  const string basePath = this->config_.path + "." +
+    Util::Time::ToString(time(nullptr), "%Y%m%d-%H%M%S", false);
+  string rotatedPath = basePath;
+  struct stat pathStat;
+  for (size_t i = 1;
+       stat(rotatedPath.c_str(), &pathStat) == 0 ||
+       stat((rotatedPath + ".gz").c_str(), &pathStat) == 0;
+       ++i)
+  {
+    rotatedPath = basePath + "." + std::to_string(i);
+  }
+  return rotatedPath;
+}
+
+void LogSink::run() {
+  std::unique_lock<std::mutex> lock(this->mutex_);
+  while (true) {
+    this->wakeCv_.wait_for(lock, std::chrono::milliseconds(this->config_.flushIntervalMs),
+                           [this] { return this->isStopping_ == true; });
+    const bool isStopping = this->isStopping_;
+    lock.unlock();
+
+    this->Flush();
+    const uint32_t generation = LogSink::lastReopenGeneration_.load();
+    if (generation != this->reopenGeneration_) {
+      this->reopenGeneration_ = generation;
+      this->Reopen();
+    } else {
+      this->checkFile();
+    }
+    if (this->isRotationDue(this->fileSize_.load(std::memory_order_relaxed)) == true) {
+      this->rotate(false);
+    }
+
+    lock.lock();
+    if (isStopping == true) {
+      break;
+    }
+  }
+}
+
+void LogSink::runCompress() {
+  std::unique_lock<std::mutex> lock(this->compressMutex_);
+  while (true) {
+    if (this->compressJobs_.empty() == true) {
+      if (this->isCompressStopping_ == true) {
+        break;
+      }
+      this->compressCv_.wait(lock);
+      continue;
+    }
+
+    const time_t now = time(nullptr);
+    const CompressJob& job = this->compressJobs_.front();
+    if (job.dueTime > now && this->isCompressStopping_ == false) {
+      this->compressCv_.wait_for(lock, std::chrono::seconds(job.dueTime - now));
+      continue;
+    }
+    const string path = job.path;
+    this->compressJobs_.pop_front();
+    lock.unlock();
+    const bool isCompressed = this->compress(path);
+    lock.lock();
+    if (isCompressed == false) {
+      if (this->isCompressStopping_ == true) {
+        DEBUG_cerr << "Left uncompressed, still written to. " << path << endl;
+      } else {
+        this->compressJobs_.push_back(CompressJob{ path, time(nullptr) + 1 });
+      }
+    }
+  }
+}
+
+bool LogSink::compress(const string& path) {
+  // Write access, as a write lock needs it.
+  const int inFd = ::open(path.c_str(), O_RDWR | O_CLOEXEC);
+  if (inFd < 0) {
+    return true;
+  }
+  // Sinks of other processes hold a read lock on the file until they
+  // reopen. Compressing before that would drop their last records.
+  struct flock writeLock;
+  memset(&writeLock, 0, sizeof(writeLock));
+  writeLock.l_type = F_WRLCK;
+  writeLock.l_whence = SEEK_SET;
+  if (fcntl(inFd, F_OFD_SETLK, &writeLock) != 0 && (errno == EAGAIN || errno == EACCES)) {
+    close(inFd);
+    return false;
+  }
+  const string gzPath = path + ".gz";
+  const int outFd = ::open(gzPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+                           this->config_.permission);
+  if (outFd < 0) {
+    close(inFd);
+    return true;
+  }
+
+  bool isDone = false;
+  try {
+    GzipStream gzip(GzipStream::Mode::COMPRESS);
+    std::vector<char> buffer(GzipStream::CHUNK_SIZE);
+    string compressed;
+    while (true) {
+      const ssize_t numRead = read(inFd, buffer.data(), buffer.size());
+      if (numRead < 0 && errno == EINTR) {
+        continue;
+      }
+      if (numRead < 0) {
+        break;
+      }
+      gzip.Write(buffer.data(), numRead, compressed,
+                 (numRead == 0) ? GzipStream::Flush::FINISH : GzipStream::Flush::NONE);
+      if (writeFully(outFd, compressed.data(), compressed.length()) == false) {
+        break;
+      }
+      compressed.clear();
+      if (numRead == 0) {
+        isDone = true;
+        break;
+      }
+    }
+  } catch (GzipStream::Exception& e) {
+    DEBUG_cerr << "Failed to compress " << path << ". " << e.what() << endl;
+  }
+
+  close(inFd);
+  close(outFd);
+  unlink((isDone == true) ? path.c_str() : gzPath.c_str());
+  return true;
+}
+
+void LogSink::onReopenSignal(int signalNumber) {
+  LogSink::lastReopenGeneration_.fetch_add(1, std::memory_order_relaxed);
+}
+
+std::ostream& LogSink::getLoggerStream(Logger::Type type) {
+  static thread_local LineBuffer buffer;
+  static thread_local std::ostream stream(&buffer);
+  buffer.SetType(type);
+  return stream << Logger::toString(type) << " " << Logger::cachedTimestamp()
+                << std::setw(6) << std::right << getpid() << " ";
+}
+
+}
+
+
+#if _UNIT_TEST
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include <dirent.h> // opendir()
+#include <sys/wait.h> // waitpid()
+
+using namespace lio;
+using std::string;
+
+namespace {
+
+const string TEST_DIR = "./logsink_test";
+
+string readFile(const string& path) {
+  std::ifstream file(path);
+  std::stringstream content;
+  content << file.rdbuf();
+  return content.str();
+}
+
+// Names in TEST_DIR, sorted.
+std::vector<string> listFiles() {
+  std::vector<string> names;
+  DIR* dir = opendir(TEST_DIR.c_str());
+  if (dir == nullptr) {
+    return names;
+  }
+  while (struct dirent* entry = readdir(dir)) {
+    const string name = entry->d_name;
+    if (name != "." && name != "..") {
+      names.push_back(name);
+    }
+  }
+  closedir(dir);
+  std::sort(names.begin(), names.end());
+  return names;
+}
+
+void clearDir() {
+  for (const string& name : listFiles()) {
+    unlink((TEST_DIR + "/" + name).c_str());
+  }
+  mkdir(TEST_DIR.c_str(), 0755);
+}
+
+}
+
+TEST(LogSinkTest, WriteAndAppend) {
+  clearDir();
+  LogSink::Config config(TEST_DIR + "/log.txt");
+  config.flushIntervalMs = 10000;
+  config.batchSize = 64;
+  LogSink sink(config);
+
+  sink.Write("first\n", 6);
+  struct iovec iov[2] = { { (void*) "sec", 3 }, { (void*) "ond\n", 4 } };
+  sink.Write(iov, 2);
+  EXPECT_EQ("first\nsecond\n", readFile(config.path));
+
+  sink.Append("third\n", 6);
+  EXPECT_EQ("first\nsecond\n", readFile(config.path));
+  sink.Flush();
+  EXPECT_EQ("first\nsecond\nthird\n", readFile(config.path));
+
+  // Past batchSize.
+  const string record(40, 'x');
+  sink.Append(record.data(), record.length());
+  sink.Append(record.data(), record.length());
+  EXPECT_EQ(13 + 6 + 40, readFile(config.path).length());
+
+  const LogSink::Stats stats = sink.GetStats();
+  EXPECT_EQ(4, stats.numWrites);
+  EXPECT_EQ(0, stats.numFailedWrites);
+
+  EXPECT_THROW(LogSink(LogSink::Config(TEST_DIR + "/none/log.txt")), LogSink::Exception);
+}
+
+TEST(LogSinkTest, FlushInterval) {
+  clearDir();
+  LogSink::Config config(TEST_DIR + "/log.txt");
+  config.flushIntervalMs = 10;
+  LogSink sink(config);
+  sink.Append("line\n", 5);
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  EXPECT_EQ("line\n", readFile(config.path));
+}
+
+TEST(LogSinkTest, RotateBySize) {
+  clearDir();
+  LogSink::Config config(TEST_DIR + "/log.txt");
+  config.flushIntervalMs = 10;
+  config.maxFileSize = 100;
+  {
+    LogSink sink(config);
+    const string record(60, 'a');
+    sink.Write(record.data(), record.length());
+    sink.Write(record.data(), record.length());
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    sink.Write("b\n", 2);
+    EXPECT_EQ(1, sink.GetStats().numRotations);
+  }
+
+  const std::vector<string> files = listFiles();
+  ASSERT_EQ(2, files.size());
+  EXPECT_EQ("log.txt", files[0]);
+  EXPECT_EQ(0, files[1].find("log.txt."));
+  EXPECT_EQ("b\n", readFile(config.path));
+  EXPECT_EQ(120, readFile(TEST_DIR + "/" + files[1]).length());
+}
+
+TEST(LogSinkTest, Compress) {
+  clearDir();
+  LogSink::Config config(TEST_DIR + "/log.txt");
+  config.isCompressed = true;
+  const string record = "GET /index.html 200\n";
+  {
+    LogSink sink(config);
+    for (size_t i = 0; 1000 > i; ++i) {
+      sink.Append(record.data(), record.length());
+    }
+    EXPECT_TRUE(sink.Rotate());
+    sink.Write("after\n", 6);
+  }
+
+  const std::vector<string> files = listFiles();
+  ASSERT_EQ(2, files.size());
+  EXPECT_EQ("log.txt", files[0]);
+  ASSERT_EQ(".gz", files[1].substr(files[1].length() - 3));
+
+  GzipStream gzip(GzipStream::Mode::DECOMPRESS);
+  string decompressed;
+  const string compressed = readFile(TEST_DIR + "/" + files[1]);
+  gzip.Write(compressed.data(), compressed.length(), decompressed);
+  EXPECT_EQ(1000 * record.length(), decompressed.length());
+  EXPECT_EQ("after\n", readFile(config.path));
+}
+
+TEST(LogSinkTest, CompressWaitsForWriters) {
+  // Another process appends to the rotated file long after the rotation.
+  clearDir();
+  LogSink::Config config(TEST_DIR + "/log.txt");
+  config.isCompressed = true;
+  int readyFds[2];
+  int goFds[2];
+  ASSERT_EQ(pipe(readyFds), 0);
+  ASSERT_EQ(pipe(goFds), 0);
+  {
+    LogSink sink(config);
+    const pid_t pid = fork();
+    if (pid == 0) {
+      LogSink::Config childConfig = config;
+      childConfig.isCompressed = false;
+      childConfig.flushIntervalMs = 10000; // Does not see the rotation.
+      {
+        LogSink childSink(childConfig);
+        childSink.Write("before\n", 7);
+        write(readyFds[1], "R", 1);
+        char c;
+        read(goFds[0], &c, 1);
+        std::this_thread::sleep_for(std::chrono::milliseconds(1500));
+        childSink.Write("late\n", 5);
+      }
+      _exit(0);
+    }
+    char c;
+    ASSERT_EQ(read(readyFds[0], &c, 1), 1);
+    sink.Write("parent\n", 7);
+    EXPECT_TRUE(sink.Rotate());
+    write(goFds[1], "G", 1);
+    waitpid(pid, nullptr, 0);
+  }
+  close(readyFds[0]);
+  close(readyFds[1]);
+  close(goFds[0]);
+  close(goFds[1]);
+
+  const std::vector<string> files = listFiles();
+  ASSERT_EQ(2, files.size());
+  ASSERT_EQ(".gz", files[1].substr(files[1].length() - 3));
+  GzipStream gzip(GzipStream::Mode::DECOMPRESS);
+  string decompressed;
+  const string compressed = readFile(TEST_DIR + "/" + files[1]);
+  gzip.Write(compressed.data(), compressed.length(), decompressed);
+  EXPECT_EQ("before\nparent\nlate\n", decompressed);
+}
+
+TEST(LogSinkTest, ReopenSignal) {
+  clearDir();
+  LogSink::Config config(TEST_DIR + "/log.txt");
+  config.flushIntervalMs = 10;
+  LogSink sink(config);
+  LogSink::SetReopenSignal();
+
+  sink.Write("old\n", 4);
+  rename(config.path.c_str(), (TEST_DIR + "/moved.txt").c_str());
+  raise(SIGHUP);
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  sink.Write("new\n", 4);
+
+  EXPECT_EQ("old\n", readFile(TEST_DIR + "/moved.txt"));
+  EXPECT_EQ("new\n", readFile(config.path));
+  EXPECT_LE(1, sink.GetStats().numReopens);
+  signal(SIGHUP, SIG_DFL);
+}
+
+TEST(LogSinkTest, Processes) {
+  // Records of processes sharing the file stay whole, across rotations.
+  clearDir();
+  LogSink::Config config(TEST_DIR + "/log.txt");
+  config.flushIntervalMs = 10;
+  config.maxFileSize = 256 * 1024;
+  const size_t numProcesses = 4;
+  const size_t numRecords = 2000;
+
+  for (size_t i = 0; numProcesses > i; ++i) {
+    if (fork() == 0) {
+      int result = 0;
+      {
+        LogSink sink(config);
+        const string record = "process " + std::to_string(i) + " " + string(200, 'a' + i) + "\n";
+        for (size_t j = 0; numRecords > j; ++j) {
+          if (j % 2 == 0) {
+            result |= (sink.Write(record.data(), record.length()) == false);
+          } else {
+            sink.Append(record.data(), record.length());
+          }
+        }
+      }
+      _exit(result);
+    }
+  }
+  for (size_t i = 0; numProcesses > i; ++i) {
+    int status = 0;
+    wait(&status);
+    EXPECT_EQ(0, WEXITSTATUS(status));
+  }
+
+  size_t numLines = 0;
+  size_t numTorn = 0;
+  for (const string& name : listFiles()) {
+    std::ifstream file(TEST_DIR + "/" + name);
+    string line;
+    while (std::getline(file, line)) {
+      ++numLines;
+      const char c = line.back();
+      if (line.length() != 210 || line.find_first_not_of(c, 10) != string::npos) {
+        ++numTorn;
+      }
+    }
+  }
+  EXPECT_EQ(numProcesses * numRecords, numLines);
+  EXPECT_EQ(0, numTorn);
+  EXPECT_LE(3, listFiles().size());
+}
+
+TEST(LogSinkTest, RedirectLogger) {
+  clearDir();
+  LogSink::Config config(TEST_DIR + "/log.txt");
+  {
+    LogSink sink(config);
+    LogSink::RedirectLogger(&sink);
+    LOG_warn << "to the file" << endl;
+    LOG_err << "right away" << endl;
+    EXPECT_NE(string::npos, readFile(config.path).find("right away"));
+  }
+  // ERROR and above are written right away, ahead of buffered lines.
+  const string content = readFile(config.path);
+  EXPECT_EQ(0, content.find("ERR "));
+  EXPECT_NE(string::npos, content.find("\nWRN "));
+  EXPECT_NE(string::npos, content.find("to the file"));
+}
+
+TEST(LogSinkTest, Benchmark) {
+  PERFTEST {
+    clearDir();
+    LogSink::Config config(TEST_DIR + "/log.txt");
+    LogSink sink(config);
+    const string record = "INF 2026-10-19 12:34:56 GMT   1234 GET /index.html 200 1234 bytes\n";
+    const size_t numRecords = 200 * 1000;
+
+    lio::Test::Measure("Write", 1, numRecords, [&](size_t) {
+      sink.Write(record.data(), record.length());
+    });
+    lio::Test::Measure("Append", 1, numRecords, [&](size_t) {
+      sink.Append(record.data(), record.length());
+    });
+    sink.Flush();
+
+    std::ofstream file(TEST_DIR + "/ofstream.txt");
+    lio::Test::Measure("ofstream and std::endl, as RedirecTo()", 1, numRecords, [&](size_t) {
+      file << record << std::endl;
+    });
+  }
+  clearDir();
+  rmdir(TEST_DIR.c_str());
+}
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleMock(&argc, argv);
+  return RUN_ALL_TESTS();
+}
+
+#else
+// Executable File's Main Comes here.
+
+
+#endif
+
+#undef _UNIT_TEST
@@ -0,0 +1,243 @@
+#ifndef _LOGSINK_HPP_
+#define _LOGSINK_HPP_
+/*
+  Name
+    LogSink
+      Log file writer with batching, rotation and reopen.
+
+  Description
+    The file is opened with O_APPEND and every record goes out with one
+    write() or writev(). Appends of other threads and of other processes
+    sharing the file, such as prefork workers, never land inside a record.
+    Logger::RedirecTo() swapped the rdbuf of std streams to an ofstream,
+    which was not thread safe and flushed when the buffer filled up.
+
+    Write() writes a record right away. Append() buffers records and writes
+    them together once batchSize bytes are buffered, or flushIntervalMs
+    after, from a background thread. Records are never split between
+    writes.
+
+    The file is rotated by the write that takes it past maxFileSize, or
+    when a period of rotateIntervalSeconds starts, counted from the epoch.
+    Rotation renames it to path.YYYYMMDD-HHMMSS in GMT and opens a new one.
+    Processes sharing the file take flock() on it to rotate, so only one
+    renames. The others see the path is another file and reopen it within
+    flushIntervalMs, or at their next rotation by size.
+
+    With isCompressed, rotated files are gzipped to path.YYYYMMDD-HHMMSS.gz
+    by another background thread. Every sink holds an open file description
+    read lock on the file it writes, so the file is compressed only after
+    all of them reopened, and no record is lost. A file still written to
+    when the sink is destroyed is left uncompressed. A process forked while
+    a sink was open shares its fd, and the lock, until it exits.
+
+    The background threads do not survive fork(), so each process creates
+    its own LogSink after it.
+
+    SetReopenSignal() makes every LogSink reopen its path on SIGHUP, for
+    logrotate and such. RedirectLogger() sends LOG_* lines to a sink, one
+    record per line. AsyncLogger writes to a sink when Config::sink is set.
+
+  Last Modified Date
+    Oct 19, 2026
+
+  History
+    October 19, 2026
+      Created
+      Rotation by size on the write path. Compression waits for writers.
+
+  ToDos
+
+
+
+  Milestones
+    1.0
+
+
+  Learning Resources
+    write(2), O_APPEND
+      http://man7.org/linux/man-pages/man2/write.2.html
+
+  Copyright (c) All rights reserved to LIFEINO.
+*/
+
+#ifdef _DEBUG
+  #undef _DEBUG
+#endif
+#define _DEBUG false
+
+#include "liolib/Debug.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include <csignal> // SIGHUP
+#include <cstdint>
+
+#include <sys/types.h>
+#include <sys/uio.h> // iovec
+
+#include "liolib/Log.hpp"
+#include "liolib/ReadWriteLock.hpp"
+
+namespace lio {
+
+using std::string;
+
+
+class LogSink {
+public:
+
+// ******** Exception Declaration *********
+enum class ExceptionType : std::uint8_t {
+  GENERAL,
+  OPEN_FAILED
+};
+#define LOGSINK_EXCEPTION_MESSAGES \
+  "LogSink Exception has been thrown.", \
+  "Failed to open the log file."
+
+class Exception : public std::exception {
+public:
+  Exception (ExceptionType exceptionType = ExceptionType::GENERAL);
+
+  virtual const char*         what() const noexcept;
+  virtual const               ExceptionType type() const noexcept;
+
+private:
+  const ExceptionType         exceptionType_;
+  static const char* const    exceptionMessages_[];
+};
+// ******** Exception Declaration END*********
+
+  struct Config {
+    Config(const string& path = "./log.txt") :
+      path(path),
+      permission(0644),
+      batchSize(64 * 1024),
+      flushIntervalMs(100),
+      maxFileSize(0),
+      rotateIntervalSeconds(0),
+      isCompressed(false)
+    { }
+    string path;
+    int permission;
+    size_t batchSize; // Buffered bytes that make Append() write.
+    uint32_t flushIntervalMs; // Longest time a record waits in the buffer.
+    uint64_t maxFileSize; // 0 for no rotation by size.
+    uint32_t rotateIntervalSeconds; // 86400 for daily. 0 for no rotation by time.
+    bool isCompressed; // Gzip rotated files.
+  };
+
+  struct Stats {
+    uint64_t numWrites; // write() and writev() calls.
+    uint64_t numBytes;
+    uint64_t numFailedWrites;
+    uint64_t numRotations; // By this sink.
+    uint64_t numReopens;
+  };
+
+  // Opens the file and starts the background thread. Throws OPEN_FAILED.
+  explicit LogSink(const Config& config);
+  // Writes what is buffered and waits for compression.
+  ~LogSink();
+
+  // One record, in one write(). False when it failed.
+  bool            Write(const void* data, size_t length);
+  bool            Write(const struct iovec* iov, int iovCount);
+
+  // Buffers a record.
+  void            Append(const void* data, size_t length);
+  bool            Flush();
+
+  // Closes the file and opens path again.
+  bool            Reopen();
+  // Rotates now.
+  bool            Rotate();
+
+  const string&   GetPath() const;
+  Stats           GetStats() const;
+
+  // Every LogSink reopens its path at the signal.
+  static
+  void            SetReopenSignal(int signalNumber = SIGHUP);
+
+  // LOG_* lines go to sink, or back to std streams with nullptr. The sink
+  // has to outlive the redirection.
+  static
+  void            RedirectLogger(LogSink* sink);
+
+private:
+  struct CompressJob {
+    string        path;
+    time_t        dueTime; // Retried a second later while still written to.
+  };
+  class LineBuffer;
+
+  Config          config_;
+
+  // Taken shared to write to fd_, and exclusive to replace it.
+  mutable ReadWriteLock fdLock_;
+  int             fd_;
+  ino_t           inode_;
+  std::atomic<uint64_t> fileSize_; // Of this and the other processes, as of the last check.
+  time_t          period_; // Of rotateIntervalSeconds, the file was opened in.
+
+  std::mutex      batchMutex_;
+  string          batch_;
+
+  std::mutex      mutex_; // Of the ones below.
+  std::condition_variable wakeCv_;
+  bool            isStopping_;
+  std::atomic<bool> isRotating_; // By size, on the write path.
+  uint32_t        reopenGeneration_;
+  std::thread     thread_;
+
+  std::mutex      compressMutex_; // Of the ones below.
+  std::condition_variable compressCv_;
+  std::deque<CompressJob> compressJobs_;
+  bool            isCompressStopping_;
+  std::thread     compressThread_;
+
+  std::atomic<uint64_t> numWrites_;
+  std::atomic<uint64_t> numBytes_;
+  std::atomic<uint64_t> numFailedWrites_;
+  std::atomic<uint64_t> numRotations_;
+  std::atomic<uint64_t> numReopens_;
+
+  static std::atomic<uint32_t> lastReopenGeneration_;
+  static std::atomic<LogSink*> loggerSink_;
+
+  // Opens path. fdLock_ has to be held exclusively, or the sink not shared yet.
+  bool            open();
+  // Writes the whole of iov. fdLock_ has to be held shared.
+  bool            writeAll(struct iovec* iov, int iovCount, size_t length);
+  void            afterWrite(size_t length);
+  bool            isRotationDue(uint64_t fileSize) const;
+  // Rotates if due or forced. False when it did not rotate.
+  bool            rotate(bool isForced);
+  // Reopens when the path is another file, and reads its size.
+  void            checkFile();
+  string          getRotatedPath() const;
+
+  void            run();
+  void            runCompress();
+  // False when a sink still writes to path.
+  bool            compress(const string& path);
+
+  static
+  void            onReopenSignal(int signalNumber);
+  static
+  std::ostream&   getLoggerStream(Logger::Type type);
+
+  LogSink(const LogSink&) = delete;
+  LogSink& operator=(const LogSink&) = delete;
+};
+
+}
+
+#endif
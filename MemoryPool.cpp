@@ -31,6 +31,17 @@ MemoryPool::Exception::type() const noexcept {
 const bool TOZERO = true;
 const char MemoryPool::MAGIC_CHAR = 'C';
 
+Statistics::Counter MemoryPool::numAllocs_ =
+    Statistics::GetCounter("memorypool_allocs_total", "Successful Mpalloc() calls.");
+Statistics::Counter MemoryPool::numAllocBytes_ =
+    Statistics::GetCounter("memorypool_alloc_bytes_total", "Bytes requested by Mpalloc().");
+Statistics::Counter MemoryPool::numAllocFails_ =
+    Statistics::GetCounter("memorypool_alloc_failures_total", "Mpalloc() calls that threw.");
+Statistics::Counter MemoryPool::numFrees_ =
+    Statistics::GetCounter("memorypool_frees_total", "Mpfree() calls.");
+Statistics::Counter MemoryPool::numPoolsChained_ =
+    Statistics::GetCounter("memorypool_pools_chained_total", "Pools created when a pool was full.");
+
 
 MemoryPool::MemoryPool (size_t poolSize, size_t blockSize, MemoryPool* prev) :
   prev_(prev),
@@ -105,6 +116,7 @@ void* const MemoryPool::Mpalloc(size_t allocSize) {
   DEBUG_cout << "AllocSize: " << allocSize << endl;
   if (this->poolHeader_->poolHeaderAddress == nullptr) {
     // ERROR
+    MemoryPool::numAllocFails_.Add();
     throw MemoryPool::Exception(ExceptionType::NOT_INITIALIZED);
   }
   // 0. Add header size to to toAllocSize
@@ -112,6 +124,7 @@ void* const MemoryPool::Mpalloc(size_t allocSize) {
 
   if (this->poolHeader_->poolSize < allocSize) {
     // TOO BIG and it is never possible to allocate memory.
+    MemoryPool::numAllocFails_.Add();
     throw MemoryPool::Exception(ExceptionType::ALLOC_FAIL_NOT_ENOUGH_SPACE);
   } 
 
@@ -119,7 +132,9 @@ void* const MemoryPool::Mpalloc(size_t allocSize) {
   if (this->poolHeader_->freeSize < allocSize) {
     if (this->next_ == nullptr) {
       this->next_ = this->createNextMp();
+      MemoryPool::numPoolsChained_.Add();
     } 
+    // Counted by the pool that allocates.
     return this->next_->Mpalloc(allocSize);
     throw MemoryPool::Exception(ExceptionType::ALLOC_FAIL_NOT_ENOUGH_SPACE);
   }
@@ -135,6 +150,7 @@ void* const MemoryPool::Mpalloc(size_t allocSize) {
   ssize_t blockStartIndex = this->findSpaceForChunk(numBlocksNeeded);
   if (blockStartIndex == NOT_FOUND) {
     DEBUG_cout << "Alloc Fail" << endl; 
+    MemoryPool::numAllocFails_.Add();
     throw MemoryPool::Exception(ExceptionType::ALLOC_FAIL_NO_CHUNK);
   }
   
@@ -146,6 +162,7 @@ void* const MemoryPool::Mpalloc(size_t allocSize) {
     // Marking Block map failed. Try to undo marking.
     DEBUG_cerr << "Marking Bitmap has failed. Reverting marking." << endl; 
     this->markBlockMap(blockStartIndex, numBlocksNeeded, TOZERO);
+    MemoryPool::numAllocFails_.Add();
     throw MemoryPool::Exception(ExceptionType::ALLOC_FAIL);
   }
 
@@ -169,6 +186,9 @@ void* const MemoryPool::Mpalloc(size_t allocSize) {
   // Move Ptr by Chunk Header Size
   allocatedMemPtr += sizeof(ChunkHeader);
 
+  MemoryPool::numAllocs_.Add();
+  MemoryPool::numAllocBytes_.Add(chunkHeader.contentSize);
+
   return (void*) allocatedMemPtr;
 }
 
@@ -361,6 +381,7 @@ size_t MemoryPool::Mpfree(const void* freePtr) {
   this->poolHeader_->freeSize += freedSize;
   // #MAYBE: Check FreeSize. If freesize is bigger than mempoolsize, it's an obvious error.
 
+  MemoryPool::numFrees_.Add();
   return freedSize;
 }
 
@@ -15,9 +15,12 @@
       It reduces memory leaks.
 
   Last Modified Date
-    Nov 13, 2014
+    Oct 19, 2026
 
   History
+    Oct 19, 2026
+      Statistics counters of allocs, frees, failures and chained pools.
+
     Mar 28, 2014 - [ETL]
       Implemented lastOperationBlockAddress for faster allocation.
       It improved performance about 8 to 10%.
@@ -72,6 +75,7 @@
 #include <cstring> // memcpy
 
 #include "liolib/Util.hpp"
+#include "liolib/Statistics.hpp"
 
 
 namespace lio {
@@ -220,7 +224,12 @@ private:
                                   const bool isMarkingToZero = false);
 
   ChunkHeader*      getChunkHeader(const void* chunkLocation) const;
-  
+
+  static Statistics::Counter  numAllocs_;
+  static Statistics::Counter  numAllocBytes_;
+  static Statistics::Counter  numAllocFails_;
+  static Statistics::Counter  numFrees_;
+  static Statistics::Counter  numPoolsChained_;
 };
 
 }
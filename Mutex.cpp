@@ -1,5 +1,18 @@
 #include "Mutex.hpp"
 
+#define _UNIT_TEST false
+#include "liolib/Test.hpp"
+
+#include <algorithm> // min()
+
+#include <cerrno>
+#include <csignal> // kill()
+#include <ctime> // clock_gettime()
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h> // syscall()
+
 namespace lio {
 
 // ===== Exception Implementation =====
@@ -24,40 +37,366 @@ Mutex::Exception::type() const noexcept {
 }
 // ===== Exception Implementation End =====
 
-ddf
+namespace {
+
+// Time a robust waiter sleeps before it checks the owner again.
+const long ROBUST_CHECK_NANOSECONDS = 100 * 1000 * 1000;
 
+inline void pause() {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#elif defined(__aarch64__)
+  asm volatile("yield");
+#endif
+}
 
-Mutex::Mutex() {
-  DEBUG_FUNC_START; // Prints out function name in yellow
+inline uint64_t getNanoseconds() {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint64_t) now.tv_sec * 1000 * 1000 * 1000 + now.tv_nsec;
+}
 
 }
 
-Mutex::~Mutex() {
-  DEBUG_FUNC_START;
 
+Mutex::Mutex(const Config& config) :
+  state_(0),
+  isProcessShared_(config.isProcessShared),
+  isRobust_(config.isRobust),
+  maxSpins_(config.maxSpins),
+  spinAverage_(0),
+  numAcquisitions_(0),
+  numContended_(0),
+  numSleeps_(0),
+  waitNanoseconds_(0),
+  numOwnerDied_(0)
+{
+  if (config.isRobust == true && config.isProcessShared == false) {
+    throw Exception(ExceptionType::NOT_SHARED);
+  }
 }
 
-void Mutex::sampleFunc() {
-  DEBUG_POINT; // prints out LINE NUMBER and a messaage "POINT REACHED" in GREEN.
+Mutex::Stats Mutex::GetStats() const {
+  Stats stats;
+  stats.numAcquisitions = this->numAcquisitions_.load(std::memory_order_relaxed);
+  stats.numContended = this->numContended_.load(std::memory_order_relaxed);
+  stats.numSleeps = this->numSleeps_.load(std::memory_order_relaxed);
+  stats.waitNanoseconds = this->waitNanoseconds_.load(std::memory_order_relaxed);
+  stats.numOwnerDied = this->numOwnerDied_.load(std::memory_order_relaxed);
+  return stats;
 }
 
-//Mutex::
+
+// ***************** Private Functions *********************
+
+Mutex::Status Mutex::lockContended() {
+  const uint64_t startTime = getNanoseconds();
+  const uint32_t owner = this->getOwner();
+  Status status = Status::LOCKED;
+
+  const int32_t spinAverage = this->spinAverage_.load(std::memory_order_relaxed);
+  const int32_t maxSpins = std::min<int32_t>(this->maxSpins_, spinAverage * 2 + 10);
+  int32_t numSpins = 0;
+  bool isLocked = false;
+  for (; maxSpins > numSpins; ++numSpins) {
+    pause();
+    uint32_t state = this->state_.load(std::memory_order_relaxed);
+    if (state == 0 &&
+        this->state_.compare_exchange_weak(state, owner, std::memory_order_acquire) == true)
+    {
+      isLocked = true;
+      break;
+    }
+  }
+
+  // Others may sleep as well, so the lock is taken with WAITERS_BIT from here.
+  uint64_t numSleeps = 0;
+  bool isTimedOut = false;
+  while (isLocked == false) {
+    uint32_t state = this->state_.load(std::memory_order_relaxed);
+    if (state == 0) {
+      isLocked = this->state_.compare_exchange_weak(state, owner | WAITERS_BIT,
+                                                    std::memory_order_acquire);
+      continue;
+    }
+    if (this->isRobust_ == true && this->isOwnerAlive(state & OWNER_MASK, isTimedOut) == false) {
+      if (this->state_.compare_exchange_strong(state, owner | WAITERS_BIT,
+                                               std::memory_order_acquire) == true)
+      {
+        LOG_warn << "Owner " << (state & OWNER_MASK) << " of Mutex died holding it." << endl;
+        status = Status::OWNER_DIED;
+        isLocked = true;
+      }
+      continue;
+    }
+    if ((state & WAITERS_BIT) == 0) {
+      if (this->state_.compare_exchange_weak(state, state | WAITERS_BIT,
+                                             std::memory_order_relaxed) == false)
+      {
+        continue;
+      }
+      state |= WAITERS_BIT;
+    }
+    ++numSleeps;
+    isTimedOut = (this->wait(state) == false);
+  }
+
+  this->spinAverage_.store(spinAverage + (numSpins - spinAverage) / 8,
+                           std::memory_order_relaxed);
+  Mutex::increase(this->numAcquisitions_);
+  Mutex::increase(this->numContended_);
+  Mutex::increase(this->numSleeps_, numSleeps);
+  Mutex::increase(this->waitNanoseconds_, getNanoseconds() - startTime);
+  if (status == Status::OWNER_DIED) {
+    Mutex::increase(this->numOwnerDied_);
+  }
+  return status;
+}
+
+bool Mutex::isOwnerAlive(uint32_t owner, bool isThorough) const {
+  if (owner == this->getOwner()) {
+    return true;
+  }
+  if (kill(owner, 0) == -1 && errno == ESRCH) {
+    return false;
+  }
+  // A zombie still takes signals. Only /proc tells it apart, so it is read
+  // when a sleep timed out rather than before every one.
+  if (isThorough == false) {
+    return true;
+  }
+  return Util::Process::IsAlive(owner);
+}
+
+bool Mutex::wait(uint32_t expected) {
+  const int op = (this->isProcessShared_ == true) ? FUTEX_WAIT : FUTEX_WAIT_PRIVATE;
+  struct timespec timeout = { 0, ROBUST_CHECK_NANOSECONDS };
+  const long result = syscall(SYS_futex, &this->state_, op, expected,
+                              (this->isRobust_ == true) ? &timeout : nullptr, nullptr, 0);
+  return result == 0 || errno != ETIMEDOUT;
+}
+
+void Mutex::wake() {
+  const int op = (this->isProcessShared_ == true) ? FUTEX_WAKE : FUTEX_WAKE_PRIVATE;
+  syscall(SYS_futex, &this->state_, op, 1, nullptr, nullptr, 0);
+}
 
 }
 
-#define _UNIT_TEST false
 #if _UNIT_TEST
 
-#include "Test.hpp"
-//#include "liolib/Test.hpp"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include <mutex>
+#include <new>
+#include <thread>
+#include <vector>
 
-#include <iostream>
+#include <sys/ipc.h>
+#include <sys/sem.h> // semop()
+#include <sys/wait.h> // waitpid()
+
+#include "liolib/SharedMemory.hpp"
 
 using namespace lio;
+using std::string;
+
+namespace {
+
+// Mutex and a counter it protects, for shared memory.
+struct SharedCounter {
+  SharedCounter(const Mutex::Config& config) : mutex(config), value(0) { }
+  Mutex         mutex;
+  uint64_t      value;
+};
+
+SharedMemory::Config getShmConfig() {
+  SharedMemory::Config config;
+  config.key = IPC_PRIVATE;
+  config.size = sizeof(SharedCounter);
+  config.mode = SharedMemory::Mode::CREATE;
+  return config;
+}
+
+}
+
+TEST(MutexTest, Basic) {
+  Mutex mutex;
+  EXPECT_EQ(mutex.Lock(), Mutex::Status::LOCKED);
+  EXPECT_EQ(mutex.TryLock(), false);
+  mutex.Unlock();
+  EXPECT_EQ(mutex.TryLock(), true);
+  mutex.Unlock();
+  {
+    std::lock_guard<Mutex> lock(mutex);
+    EXPECT_EQ(mutex.TryLock(), false);
+  }
+  EXPECT_EQ(mutex.TryLock(), true);
+  mutex.Unlock();
+
+  const Mutex::Stats stats = mutex.GetStats();
+  EXPECT_EQ(stats.numAcquisitions, 4);
+  EXPECT_EQ(stats.numContended, 0);
+
+  Mutex::Config config;
+  config.isRobust = true;
+  EXPECT_THROW(Mutex robustPrivate(config), Mutex::Exception);
+}
+
+TEST(MutexTest, Threads) {
+  Mutex mutex;
+  uint64_t value = 0;
+  const size_t numThreads = 4;
+  const size_t numLocks = 200000;
+
+  std::vector<std::thread> threads;
+  for (size_t i = 0; numThreads > i; ++i) {
+    threads.emplace_back([&mutex, &value, numLocks] {
+      for (size_t j = 0; numLocks > j; ++j) {
+        std::lock_guard<Mutex> lock(mutex);
+        ++value;
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(value, numThreads * numLocks);
+
+  const Mutex::Stats stats = mutex.GetStats();
+  EXPECT_EQ(stats.numAcquisitions, numThreads * numLocks);
+  EXPECT_LE(stats.numContended, stats.numAcquisitions);
+  EXPECT_EQ(stats.numOwnerDied, 0);
+}
+
+TEST(MutexTest, ProcessShared) {
+  SharedMemory shm(getShmConfig());
+  shm.SetToRemoveOnDelete();
+  Mutex::Config config;
+  config.isProcessShared = true;
+  SharedCounter* counter =
+      new (const_cast<void*>(shm.GetShmAddress())) SharedCounter(config);
+
+  const size_t numProcesses = 4;
+  const size_t numLocks = 100000;
+  std::vector<pid_t> pids;
+  for (size_t i = 0; numProcesses > i; ++i) {
+    const pid_t pid = fork();
+    if (pid == 0) {
+      for (size_t j = 0; numLocks > j; ++j) {
+        counter->mutex.Lock();
+        ++counter->value;
+        counter->mutex.Unlock();
+      }
+      _exit(0);
+    }
+    pids.push_back(pid);
+  }
+  for (pid_t pid : pids) {
+    waitpid(pid, nullptr, 0);
+  }
+  EXPECT_EQ(counter->value, numProcesses * numLocks);
+  EXPECT_EQ(counter->mutex.GetStats().numAcquisitions, numProcesses * numLocks);
+}
 
-int main() {
-  return 0;
+TEST(MutexTest, OwnerDied) {
+  SharedMemory shm(getShmConfig());
+  shm.SetToRemoveOnDelete();
+  Mutex::Config config;
+  config.isProcessShared = true;
+  config.isRobust = true;
+  SharedCounter* counter =
+      new (const_cast<void*>(shm.GetShmAddress())) SharedCounter(config);
+
+  // Child dies holding the lock. Parent sleeps on it meanwhile.
+  int pipeFds[2];
+  ASSERT_EQ(pipe(pipeFds), 0);
+  const pid_t pid = fork();
+  if (pid == 0) {
+    counter->mutex.Lock();
+    counter->value = 1;
+    write(pipeFds[1], "L", 1);
+    usleep(50 * 1000);
+    _exit(0);
+  }
+  char c;
+  ASSERT_EQ(read(pipeFds[0], &c, 1), 1);
+  EXPECT_EQ(counter->mutex.Lock(), Mutex::Status::OWNER_DIED);
+  EXPECT_EQ(counter->value, 1);
+  counter->mutex.Unlock();
+  waitpid(pid, nullptr, 0);
+
+  EXPECT_EQ(counter->mutex.Lock(), Mutex::Status::LOCKED);
+  counter->mutex.Unlock();
+  EXPECT_EQ(counter->mutex.GetStats().numOwnerDied, 1);
+  close(pipeFds[0]);
+  close(pipeFds[1]);
+}
+
+TEST(MutexTest, Benchmark) {
+  PERFTEST {
+    Mutex mutex;
+    std::mutex stdMutex;
+    Mutex::Config sharedConfig;
+    sharedConfig.isProcessShared = true;
+    sharedConfig.isRobust = true;
+    Mutex robustMutex(sharedConfig);
+    uint64_t value = 0;
+
+    // What Semaphore::Lock() and Release() do.
+    const int semId = semget(IPC_PRIVATE, 1, 0600);
+    ASSERT_GE(semId, 0);
+    struct sembuf release = { 0, 1, SEM_UNDO };
+    semop(semId, &release, 1);
+
+    const size_t numCalls = 10 * 1000 * 1000;
+    for (size_t numThreads : { 1, 4 }) {
+      std::cout << numThreads << " thread(s)" << endl;
+      lio::Test::Measure("  Mutex", numThreads, numCalls / numThreads, [&](size_t) {
+        mutex.Lock();
+        ++value;
+        mutex.Unlock();
+      });
+      lio::Test::Measure("  Mutex, shared and robust", numThreads, numCalls / numThreads,
+                         [&](size_t) {
+        robustMutex.Lock();
+        ++value;
+        robustMutex.Unlock();
+      });
+      lio::Test::Measure("  std::mutex", numThreads, numCalls / numThreads, [&](size_t) {
+        stdMutex.lock();
+        ++value;
+        stdMutex.unlock();
+      });
+      lio::Test::Measure("  SysV semop, as Semaphore::Lock", numThreads,
+                         numCalls / numThreads / 10, [&](size_t) {
+        struct sembuf lock = { 0, -1, SEM_UNDO };
+        struct sembuf unlock = { 0, 1, SEM_UNDO };
+        semop(semId, &lock, 1);
+        ++value;
+        semop(semId, &unlock, 1);
+      });
+    }
+    semctl(semId, 0, IPC_RMID);
+
+    const Mutex::Stats stats = mutex.GetStats();
+    std::cout << "Mutex acquisitions " << stats.numAcquisitions
+              << ", contended " << stats.numContended
+              << ", sleeps " << stats.numSleeps
+              << ", waited " << stats.waitNanoseconds / 1000 << " us" << endl;
+  }
 }
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleMock(&argc, argv);
+  return RUN_ALL_TESTS();
+}
+
+#else
+// Executable File's Main Comes here.
+
+
 #endif
-#undef _UNIT_TEST
 
+#undef _UNIT_TEST
@@ -8,37 +8,71 @@
     [ETL] Eun T. Leem (eunleem@gmail.com)
 
   Description
+    Futex based mutex that spins before it sleeps.
+
+    Unlocked is 0. Locked holds the owner, with WAITERS_BIT set when
+    someone sleeps on it. Uncontended Lock() and Unlock() are one atomic
+    each and never enter the kernel.
+
+    A contended Lock() spins with a pause instruction for up to twice the
+    spins recent acquisitions needed, like PTHREAD_MUTEX_ADAPTIVE_NP, then
+    sleeps in futex wait.
+
+    With Config::isProcessShared it can be constructed inside a
+    SharedMemory segment with placement new. It has no pointers and waits
+    on shared futexes.
+
+    With Config::isRobust the owner is the pid of the locking process.
+    A waiter checks the owner is alive with kill() before it sleeps, and
+    also reads /proc for zombies each time a sleep times out. It takes over
+    the lock of a dead one. Lock() returns OWNER_DIED then and
+    the data the lock protects may be half updated.
+
+    Counters of acquisitions, contended acquisitions and time waited are
+    written by the holder of the lock, so they need no atomic add.
 
   Last Modified Date
-    February 12, 2014
-  
+    Oct 19, 2026
+
   History
     February 12, 2014
       Created
+    October 19, 2026
+      Adaptive futex mutex, process shared and robust modes, statistics.
+      Owner pid and liveness from Util::Process.
 
   ToDos
-    
+
 
 
   Milestones
     1.0
-      
+
 
   Learning Resources
-    http://
-  
+    Futexes Are Tricky, Ulrich Drepper
+      https://www.akkadia.org/drepper/futex.pdf
+    futex
+      http://man7.org/linux/man-pages/man2/futex.2.html
+
   Copyright (c) All rights reserved to LIFEINO.
 */
 
 #ifdef _DEBUG
   #undef _DEBUG
 #endif
-#define _DEBUG true
+#define _DEBUG false
+
+#include "liolib/Debug.hpp"
+
+#include <atomic>
+#include <exception>
 
-#include "Debug.hpp"
-//#include "liolib/Debug.hpp"
+#include <cstdint>
 
-#include <iostream>
+#include <sys/types.h> // pid_t
+
+#include "liolib/Util.hpp"
 
 namespace lio {
 
@@ -48,10 +82,12 @@ public:
 
 // ******** Exception Declaration *********
 enum class ExceptionType : std::uint8_t {
-  GENERAL
+  GENERAL,
+  NOT_SHARED
 };
 #define MUTEX_EXCEPTION_MESSAGES \
-  "Mutex Exception has been thrown."
+  "Mutex Exception has been thrown.", \
+  "Robust Mutex has to be process shared."
 
 class Exception : public std::exception {
 public:
@@ -60,38 +96,112 @@ public:
   virtual const char*         what() const noexcept;
   virtual const               ExceptionType type() const noexcept;
 
-  
 private:
   const ExceptionType         exceptionType_;
   static const char* const    exceptionMessages_[];
 };
 // ******** Exception Declaration END*********
 
+  enum class Status : uint8_t {
+    LOCKED,
+    OWNER_DIED // Locked. Previous owner died holding it.
+  };
+
+  struct Config {
+    Config() :
+      isProcessShared(false),
+      isRobust(false),
+      maxSpins(100) { }
+
+    bool          isProcessShared;
+    bool          isRobust; // Needs isProcessShared.
+    uint32_t      maxSpins;
+  };
+
+  struct Stats {
+    uint64_t      numAcquisitions;
+    uint64_t      numContended; // Fast path failed. Spun or slept.
+    uint64_t      numSleeps;
+    uint64_t      waitNanoseconds; // Of contended acquisitions.
+    uint64_t      numOwnerDied;
+  };
+
+  Mutex(const Config& config = Config());
+
+  Status          Lock() {
+    uint32_t expected = 0;
+    if (this->state_.compare_exchange_strong(expected, this->getOwner(),
+                                             std::memory_order_acquire) == true)
+    {
+      Mutex::increase(this->numAcquisitions_);
+      return Status::LOCKED;
+    }
+    return this->lockContended();
+  }
+
+  bool            TryLock() {
+    uint32_t expected = 0;
+    if (this->state_.compare_exchange_strong(expected, this->getOwner(),
+                                             std::memory_order_acquire) == true)
+    {
+      Mutex::increase(this->numAcquisitions_);
+      return true;
+    }
+    return false;
+  }
+
+  void            Unlock() {
+    if (this->state_.exchange(0, std::memory_order_release) & WAITERS_BIT) {
+      this->wake();
+    }
+  }
+
+  // BasicLockable and Lockable, for std::lock_guard and std::unique_lock.
+  void            lock() { this->Lock(); }
+  bool            try_lock() { return this->TryLock(); }
+  void            unlock() { this->Unlock(); }
+
+  // Not a consistent snapshot. Counters are read while others update them.
+  Stats           GetStats() const;
 
-  Mutex();
-  ~Mutex();
-protected:
-  
 private:
-
-  /* Name
-   *  sampleFunc
-   * Description
-   *  Description of the function here.
-   * Input
-   *  description about parameters
-   * Output
-   *  Returns
-        void NOTHING
-   *  Changes
-   *    variables or things that this function changes 
-   *     
-   */
-  void sampleFunc();
-
+  static const uint32_t WAITERS_BIT = 1U << 31;
+  static const uint32_t OWNER_MASK = WAITERS_BIT - 1;
+  static const uint32_t ANONYMOUS_OWNER = 1;
+
+  std::atomic<uint32_t> state_;
+  const bool      isProcessShared_;
+  const bool      isRobust_;
+  const uint32_t  maxSpins_;
+  std::atomic<int32_t> spinAverage_; // Written by the holder only.
+
+  std::atomic<uint64_t> numAcquisitions_;
+  std::atomic<uint64_t> numContended_;
+  std::atomic<uint64_t> numSleeps_;
+  std::atomic<uint64_t> waitNanoseconds_;
+  std::atomic<uint64_t> numOwnerDied_;
+
+  static
+  void            increase(std::atomic<uint64_t>& counter, uint64_t value = 1) {
+    counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+  }
+
+  uint32_t        getOwner() const {
+    if (this->isRobust_ == false) {
+      return ANONYMOUS_OWNER;
+    }
+    return Util::Process::GetPid();
+  }
+
+  Status          lockContended();
+  bool            isOwnerAlive(uint32_t owner, bool isThorough) const;
+  bool            wait(uint32_t expected); // false when it timed out.
+  void            wake();
+
+  Mutex(const Mutex&) = delete;
+  Mutex& operator=(const Mutex&) = delete;
 };
 
 }
 
 #endif
-
@@ -0,0 +1,342 @@
+#include "Precompressor.hpp"
+
+#define _UNIT_TEST false
+#include "liolib/Test.hpp"
+
+#include <cstdio> // rename()
+#include <cstring> // strcmp()
+
+#include <dirent.h> // opendir()
+#include <fcntl.h> // open()
+#include <sys/stat.h> // stat()
+#include <unistd.h> // write() unlink()
+
+#if LIO_WITH_BROTLI
+  #include <brotli/encode.h>
+#endif
+#if LIO_WITH_ZSTD
+  #include <zstd.h>
+#endif
+
+#include "liolib/FileLoader.hpp"
+#include "liolib/GzipStream.hpp"
+#include "liolib/Util.hpp"
+
+
+namespace lio {
+
+// ===== Exception Implementation =====
+const char* const
+Precompressor::Exception::exceptionMessages_[] = {
+  PRECOMPRESSOR_EXCEPTION_MESSAGES
+};
+#undef PRECOMPRESSOR_EXCEPTION_MESSAGES // undef helps reducing unnecessary preprocessing work.
+
+
+Precompressor::Exception::Exception(ExceptionType exceptionType) :
+  exceptionType_(exceptionType) { }
+
+const char*
+Precompressor::Exception::what() const noexcept {
+  return this->exceptionMessages_[(int) this->exceptionType_];
+}
+
+const Precompressor::ExceptionType
+Precompressor::Exception::type() const noexcept {
+  return this->exceptionType_;
+}
+// ===== Exception Implementation End =====
+
+const size_t Precompressor::NUM_ENCODINGS;
+
+uint8_t Precompressor::GetMask(Encoding encoding) {
+  return 1 << static_cast<int>(encoding);
+}
+
+const string& Precompressor::GetName(Encoding encoding) {
+  static const string NAMES[NUM_ENCODINGS] = { "br", "zstd", "gzip", "identity" };
+  return NAMES[static_cast<int>(encoding)];
+}
+
+const string& Precompressor::GetFileSuffix(Encoding encoding) {
+  static const string SUFFIXES[NUM_ENCODINGS] = { ".br", ".zst", ".gz", "" };
+  return SUFFIXES[static_cast<int>(encoding)];
+}
+
+bool Precompressor::IsAvailable(Encoding encoding) {
+  switch (encoding) {
+  case Encoding::BROTLI:
+    return LIO_WITH_BROTLI;
+  case Encoding::ZSTD:
+    return LIO_WITH_ZSTD;
+  default:
+    return true;
+  }
+}
+
+bool Precompressor::IsEnabled(const Config& config, Encoding encoding) {
+  switch (encoding) {
+  case Encoding::BROTLI:
+    return config.isBrotliEnabled == true && IsAvailable(encoding) == true;
+  case Encoding::ZSTD:
+    return config.isZstdEnabled == true && IsAvailable(encoding) == true;
+  case Encoding::GZIP:
+    return config.isGzipEnabled;
+  default:
+    return false;
+  }
+}
+
+void Precompressor::Compress(Encoding encoding, const void* data, size_t length, string& out) {
+  switch (encoding) {
+  case Encoding::GZIP:
+    try {
+      GzipStream::Compress(data, length, out, Z_BEST_COMPRESSION);
+    } catch (GzipStream::Exception& e) {
+      DEBUG_cerr << "gzip failed. " << e.what() << endl;
+      throw Exception(ExceptionType::COMPRESSION_FAIL);
+    }
+    return;
+
+  case Encoding::BROTLI: {
+#if LIO_WITH_BROTLI
+    const size_t offset = out.length();
+    size_t encodedSize = BrotliEncoderMaxCompressedSize(length);
+    out.resize(offset + encodedSize);
+    if (BrotliEncoderCompress(BROTLI_MAX_QUALITY, BROTLI_DEFAULT_WINDOW, BROTLI_MODE_GENERIC,
+                              length, (const uint8_t*) data, &encodedSize,
+                              (uint8_t*) &out[offset]) == BROTLI_FALSE) {
+      out.resize(offset);
+      throw Exception(ExceptionType::COMPRESSION_FAIL);
+    }
+    out.resize(offset + encodedSize);
+    return;
+#else
+    break;
+#endif
+  }
+
+  case Encoding::ZSTD: {
+#if LIO_WITH_ZSTD
+    const size_t offset = out.length();
+    out.resize(offset + ZSTD_compressBound(length));
+    size_t encodedSize = ZSTD_compress(&out[offset], out.length() - offset,
+                                       data, length, 19); // Highest level without ultra windows.
+    if (ZSTD_isError(encodedSize)) {
+      DEBUG_cerr << "zstd failed. " << ZSTD_getErrorName(encodedSize) << endl;
+      out.resize(offset);
+      throw Exception(ExceptionType::COMPRESSION_FAIL);
+    }
+    out.resize(offset + encodedSize);
+    return;
+#else
+    break;
+#endif
+  }
+
+  default:
+    break;
+  }
+  throw Exception(ExceptionType::NOT_AVAILABLE);
+}
+
+bool Precompressor::IsWorthKeeping(size_t originalLength, size_t compressedLength) {
+  return compressedLength < originalLength - originalLength / 8;
+}
+
+bool Precompressor::IsCompressible(const Config& config, const string& filePath) {
+  const size_t dotPos = filePath.rfind('.');
+  const size_t slashPos = filePath.rfind('/');
+  if (dotPos == string::npos || (slashPos != string::npos && slashPos > dotPos)) {
+    return false;
+  }
+  const string extension = Util::String::ToLower(filePath.substr(dotPos + 1));
+  for (const string& compressible : config.extensions) {
+    if (extension == compressible) {
+      return true;
+    }
+  }
+  return false;
+}
+
+size_t Precompressor::PrecompressDirectory(const string& dirPath, const Config& config) {
+  DEBUG_FUNC_START;
+  DIR* dir = opendir(dirPath.c_str());
+  if (dir == nullptr) {
+    DEBUG_cerr << "Could not open directory: " << dirPath << endl;
+    return 0;
+  }
+
+  size_t numWritten = 0;
+  struct dirent* dirEntry = nullptr;
+  while ((dirEntry = readdir(dir)) != nullptr) {
+    if (strcmp(dirEntry->d_name, ".") == 0 || strcmp(dirEntry->d_name, "..") == 0) {
+      continue;
+    }
+    string entryPath = dirPath;
+    if (entryPath.back() != '/') {
+      entryPath.push_back('/');
+    }
+    entryPath.append(dirEntry->d_name);
+
+    // lstat() so that symbolic links are not followed into loops.
+    struct stat entryStat;
+    if (lstat(entryPath.c_str(), &entryStat) != 0) {
+      continue;
+    }
+    if (S_ISDIR(entryStat.st_mode)) {
+      numWritten += PrecompressDirectory(entryPath, config);
+    } else if (S_ISREG(entryStat.st_mode) &&
+               (size_t) entryStat.st_size >= config.minFileSize &&
+               IsCompressible(config, entryPath) == true) {
+      numWritten += precompressFile(entryPath, config);
+    }
+  }
+  closedir(dir);
+  return numWritten;
+}
+
+size_t Precompressor::precompressFile(const string& filePath, const Config& config) {
+  struct stat fileStat;
+  if (stat(filePath.c_str(), &fileStat) != 0) {
+    return 0;
+  }
+
+  FileLoader::MapOptions mapOptions;
+  FileLoader::MappedFile file;
+
+  size_t numWritten = 0;
+  const Encoding encodings[] = { Encoding::GZIP, Encoding::BROTLI, Encoding::ZSTD };
+  for (Encoding encoding : encodings) {
+    if (IsEnabled(config, encoding) == false) {
+      continue;
+    }
+
+    const string variantPath = filePath + GetFileSuffix(encoding);
+    struct stat variantStat;
+    if (stat(variantPath.c_str(), &variantStat) == 0 &&
+        variantStat.st_mtime >= fileStat.st_mtime) {
+      // Up to date.
+      continue;
+    }
+
+    if (file.IsNull() == true) {
+      file = FileLoader::MapFile(filePath, mapOptions);
+      if (file.IsNull() == true) {
+        return numWritten;
+      }
+    }
+
+    string compressed;
+    Compress(encoding, file.GetData(), file.GetLength(), compressed);
+    if (IsWorthKeeping(file.GetLength(), compressed.length()) == false) {
+      unlink(variantPath.c_str()); // Stale one, if any.
+      continue;
+    }
+
+    // Written aside and renamed, so readers never see a partial file.
+    const string tempPath = variantPath + ".tmp";
+    int fd = open(tempPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+      DEBUG_cerr << "Could not create " << tempPath << ". errno: " << errno << endl;
+      continue;
+    }
+    bool isWritten = write(fd, compressed.data(), compressed.length()) ==
+                     (ssize_t) compressed.length();
+    close(fd);
+    if (isWritten == false || rename(tempPath.c_str(), variantPath.c_str()) != 0) {
+      DEBUG_cerr << "Could not write " << variantPath << endl;
+      unlink(tempPath.c_str());
+      continue;
+    }
+    numWritten += 1;
+  }
+  return numWritten;
+}
+
+}
+
+#if _UNIT_TEST
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include <fstream>
+#include <string>
+
+using namespace lio;
+using std::string;
+
+TEST(Precompressor, Compress) {
+  string text;
+  for (int i = 0; 200 > i; ++i) {
+    text.append("<div class=\"item\">Item " + std::to_string(i) + "</div>\n");
+  }
+
+  const Precompressor::Encoding encodings[] = {
+    Precompressor::Encoding::GZIP, Precompressor::Encoding::BROTLI, Precompressor::Encoding::ZSTD
+  };
+  for (Precompressor::Encoding encoding : encodings) {
+    string compressed;
+    if (Precompressor::IsAvailable(encoding) == false) {
+      EXPECT_THROW(Precompressor::Compress(encoding, text.data(), text.length(), compressed),
+                   Precompressor::Exception);
+      continue;
+    }
+    Precompressor::Compress(encoding, text.data(), text.length(), compressed);
+    EXPECT_EQ(Precompressor::IsWorthKeeping(text.length(), compressed.length()), true);
+    std::cout << Precompressor::GetName(encoding) << ": " << text.length()
+              << " -> " << compressed.length() << endl;
+  }
+
+  string compressed;
+  Precompressor::Compress(Precompressor::Encoding::GZIP, text.data(), text.length(), compressed);
+  string decompressed;
+  GzipStream::Decompress(compressed.data(), compressed.length(), decompressed);
+  EXPECT_EQ(decompressed, text);
+}
+
+TEST(Precompressor, Directory) {
+  char dirTemplate[] = "/tmp/PrecompressorTestXXXXXX";
+  const string dir = mkdtemp(dirTemplate);
+  ASSERT_EQ(mkdir((dir + "/css").c_str(), 0755), 0);
+
+  const string text(4096, 'a');
+  std::ofstream(dir + "/index.html") << text;
+  std::ofstream(dir + "/css/main.css") << text;
+  std::ofstream(dir + "/photo.jpg") << text;
+  std::ofstream(dir + "/small.js") << "var a;";
+
+  Precompressor::Config config;
+  config.isBrotliEnabled = true;
+  const size_t numVariants = 1 + (Precompressor::IsAvailable(Precompressor::Encoding::BROTLI) ? 1 : 0);
+
+  EXPECT_EQ(Precompressor::PrecompressDirectory(dir, config), 2 * numVariants);
+  struct stat variantStat;
+  EXPECT_EQ(stat((dir + "/index.html.gz").c_str(), &variantStat), 0);
+  EXPECT_EQ(stat((dir + "/css/main.css.gz").c_str(), &variantStat), 0);
+  EXPECT_NE(stat((dir + "/photo.jpg.gz").c_str(), &variantStat), 0);
+  EXPECT_NE(stat((dir + "/small.js.gz").c_str(), &variantStat), 0);
+
+  // Up to date. Nothing is written again.
+  EXPECT_EQ(Precompressor::PrecompressDirectory(dir, config), 0);
+
+  EXPECT_EQ(Precompressor::IsCompressible(config, "/a.b/file"), false);
+  EXPECT_EQ(Precompressor::IsCompressible(config, "/a/APP.JS"), true);
+
+  string command = "rm -rf " + dir;
+  EXPECT_EQ(system(command.c_str()), 0);
+}
+
+int main (int argc, char** argv) {
+  ::testing::InitGoogleMock(&argc, argv);
+  return RUN_ALL_TESTS();
+}
+
+#else
+// Executable File's Main Comes here.
+
+
+#endif
+
+#undef _UNIT_TEST
@@ -0,0 +1,162 @@
+#ifndef _PRECOMPRESSOR_HPP_
+#define _PRECOMPRESSOR_HPP_
+/*
+  Name
+    Precompressor
+      Makes gzip, brotli and zstd variants of static files ahead of time.
+
+  Description
+    Static content should not be compressed while serving. Variants are
+    made once, either offline by PrecompressDirectory() or at startup by
+    FileCache, at the highest level of each format, and only kept when
+    they save at least an eighth.
+
+    PrecompressDirectory() writes variants next to the original, as
+    "name.gz", "name.br" and "name.zst". A variant is rewritten only when
+    it is older than the original. FileCache picks them up and falls back
+    to compressing in memory.
+
+    gzip is always available. brotli needs LIO_WITH_BROTLI (libbrotlienc)
+    and zstd needs LIO_WITH_ZSTD (libzstd) at build time. IsAvailable()
+    tells which ones were built in.
+
+  Last Modified Date
+    Oct 19, 2026
+
+  History
+    October 19, 2026
+      Created
+      Encoding moved to http::ContentEncoding.
+
+  ToDos
+
+
+  Milestones
+    1.0
+
+
+  Learning Resources
+    Brotli Compressed Data Format
+      https://tools.ietf.org/html/rfc7932
+    Zstandard Compression and the application/zstd Media Type
+      https://tools.ietf.org/html/rfc8478
+
+  Copyright (c) All rights reserved to LIFEINO.
+*/
+
+#ifdef _DEBUG
+  #undef _DEBUG
+#endif
+#define _DEBUG false
+
+#include "liolib/Debug.hpp"
+
+// Set to 1 by the build when the libraries are linked.
+#ifndef LIO_WITH_BROTLI
+  #define LIO_WITH_BROTLI 0
+#endif
+#ifndef LIO_WITH_ZSTD
+  #define LIO_WITH_ZSTD 0
+#endif
+
+#include <string>
+#include <vector>
+
+#include <cstdint>
+
+#include "liolib/http/Http.hpp" // ContentEncoding
+
+namespace lio {
+
+using std::string;
+
+
+class Precompressor {
+public:
+
+// ******** Exception Declaration *********
+enum class ExceptionType : std::uint8_t {
+  GENERAL,
+  NOT_AVAILABLE,
+  COMPRESSION_FAIL
+};
+#define PRECOMPRESSOR_EXCEPTION_MESSAGES \
+  "Precompressor Exception has been thrown.", \
+  "Encoding is not built in.", \
+  "Failed to compress."
+
+class Exception : public std::exception {
+public:
+  Exception (ExceptionType exceptionType = ExceptionType::GENERAL);
+
+  virtual const char*         what() const noexcept;
+  virtual const               ExceptionType type() const noexcept;
+
+private:
+  const ExceptionType         exceptionType_;
+  static const char* const    exceptionMessages_[];
+};
+// ******** Exception Declaration END*********
+
+  // Defined in Http.hpp so HTTP headers do not need this one.
+  typedef http::ContentEncoding Encoding;
+  static const size_t NUM_ENCODINGS = http::NUM_CONTENT_ENCODINGS;
+
+  struct Config {
+    Config() :
+      isGzipEnabled(true),
+      isBrotliEnabled(false),
+      isZstdEnabled(false),
+      minFileSize(256),
+      extensions({ "html", "htm", "css", "js", "mjs", "json", "svg", "xml",
+                   "txt", "map", "wasm", "ico" })
+    { }
+    bool isGzipEnabled;
+    bool isBrotliEnabled;
+    bool isZstdEnabled;
+    size_t minFileSize;
+    std::vector<string> extensions; // Others are already compressed or tiny.
+  };
+
+  // Bit of each encoding, for masks of available variants.
+  static
+  uint8_t         GetMask(Encoding encoding);
+  // Content-Encoding token. "gzip", "br", "zstd", "identity".
+  static
+  const string&   GetName(Encoding encoding);
+  // ".gz", ".br", ".zst". Empty for IDENTITY.
+  static
+  const string&   GetFileSuffix(Encoding encoding);
+  static
+  bool            IsAvailable(Encoding encoding);
+  // Enabled in config and built in.
+  static
+  bool            IsEnabled(const Config& config, Encoding encoding);
+
+  // Max level of the encoding. Appends to out. Throws NOT_AVAILABLE.
+  static
+  void            Compress(Encoding encoding, const void* data, size_t length, string& out);
+
+  // True when the variant saves enough to be worth keeping.
+  static
+  bool            IsWorthKeeping(size_t originalLength, size_t compressedLength);
+
+  static
+  bool            IsCompressible(const Config& config, const string& filePath);
+
+  // Walks dirPath recursively. Returns number of variant files written.
+  static
+  size_t          PrecompressDirectory(const string& dirPath, const Config& config = Config());
+
+private:
+  // Returns number of variant files written.
+  static
+  size_t          precompressFile(const string& filePath, const Config& config);
+
+  Precompressor() = delete;
+};
+
+}
+
+#endif
+
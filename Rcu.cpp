@@ -0,0 +1,364 @@
+#include "Rcu.hpp"
+
+#define _UNIT_TEST false
+#include "liolib/Test.hpp"
+
+#include <new> // bad_alloc, placement new
+#include <thread> // yield()
+
+#include <cstdlib> // posix_memalign()
+
+namespace lio {
+
+// ===== Exception Implementation =====
+const char* const
+Rcu::Exception::exceptionMessages_[] = {
+  RCU_EXCEPTION_MESSAGES
+};
+#undef RCU_EXCEPTION_MESSAGES // undef helps reducing unnecessary preprocessing work.
+
+
+Rcu::Exception::Exception(ExceptionType exceptionType) :
+  exceptionType_(exceptionType) { }
+
+const char*
+Rcu::Exception::what() const noexcept {
+  return this->exceptionMessages_[(int) this->exceptionType_];
+}
+
+const Rcu::ExceptionType
+Rcu::Exception::type() const noexcept {
+  return this->exceptionType_;
+}
+// ===== Exception Implementation End =====
+
+
+struct Rcu::Domain {
+  struct Retired {
+    uint64_t      epoch;
+    std::function<void()> deleter;
+  };
+
+  std::mutex      mutex;
+  std::vector<Record*> records; // All of them, in use or free.
+  std::vector<Record*> freeRecords;
+  std::vector<Retired> retired; // Oldest first.
+  size_t          numRetiredSinceReclaim;
+};
+
+// Gives the record back when its thread exits.
+struct Rcu::RecordOwner {
+  RecordOwner() :
+    record(nullptr)
+  { }
+
+  ~RecordOwner() {
+    if (this->record == nullptr) {
+      return;
+    }
+    Domain& domain = Rcu::getDomain();
+    std::lock_guard<std::mutex> lock(domain.mutex);
+    domain.freeRecords.push_back(this->record);
+    Rcu::record_ = nullptr;
+  }
+
+  Record*         record;
+};
+
+std::atomic<uint64_t> Rcu::epoch_(0);
+thread_local Rcu::Record* Rcu::record_ = nullptr;
+
+void Rcu::Retire(std::function<void()> deleter) {
+  Domain& domain = Rcu::getDomain();
+  std::vector<std::function<void()>> deleters;
+  {
+    std::lock_guard<std::mutex> lock(domain.mutex);
+    domain.retired.push_back({ Rcu::epoch_.load(std::memory_order_relaxed), std::move(deleter) });
+    if (++domain.numRetiredSinceReclaim >= RECLAIM_EVERY) {
+      domain.numRetiredSinceReclaim = 0;
+      Rcu::tryAdvance(domain);
+      Rcu::takeReclaimable(domain, deleters);
+    }
+  }
+  for (std::function<void()>& reclaim : deleters) {
+    reclaim();
+  }
+}
+
+void Rcu::Synchronize() {
+  const Record* record = Rcu::record_;
+  if (record != nullptr && record->nesting > 0) {
+    throw Exception(ExceptionType::IN_READ_SECTION);
+  }
+
+  // Two advances: readers of the epoch before this one are gone as well.
+  Domain& domain = Rcu::getDomain();
+  const uint64_t target = Rcu::epoch_.load() + 2;
+  while (true) {
+    {
+      std::lock_guard<std::mutex> lock(domain.mutex);
+      if (Rcu::epoch_.load(std::memory_order_relaxed) >= target ||
+          (Rcu::tryAdvance(domain) == true &&
+           Rcu::epoch_.load(std::memory_order_relaxed) >= target))
+      {
+        break;
+      }
+    }
+    std::this_thread::yield();
+  }
+  Rcu::Reclaim();
+}
+
+size_t Rcu::Reclaim() {
+  Domain& domain = Rcu::getDomain();
+  std::vector<std::function<void()>> deleters;
+  {
+    std::lock_guard<std::mutex> lock(domain.mutex);
+    Rcu::tryAdvance(domain);
+    Rcu::takeReclaimable(domain, deleters);
+  }
+  for (std::function<void()>& reclaim : deleters) {
+    reclaim();
+  }
+  return deleters.size();
+}
+
+size_t Rcu::GetNumRetired() {
+  Domain& domain = Rcu::getDomain();
+  std::lock_guard<std::mutex> lock(domain.mutex);
+  return domain.retired.size();
+}
+
+Rcu::Domain& Rcu::getDomain() {
+  // Never destroyed. Threads may give records back after main() returns.
+  static Domain* domain = new Domain();
+  return *domain;
+}
+
+Rcu::Record* Rcu::acquireRecord() {
+  static thread_local RecordOwner owner;
+
+  Domain& domain = Rcu::getDomain();
+  std::lock_guard<std::mutex> lock(domain.mutex);
+  Record* record = nullptr;
+  if (domain.freeRecords.empty() == false) {
+    record = domain.freeRecords.back();
+    domain.freeRecords.pop_back();
+  } else {
+    // new Record() is only aligned to 16 bytes before C++17. Never freed.
+    void* memory = nullptr;
+    if (posix_memalign(&memory, alignof(Record), sizeof(Record)) != 0) {
+      throw std::bad_alloc();
+    }
+    record = new (memory) Record();
+    record->epoch.store(0, std::memory_order_relaxed);
+    domain.records.push_back(record);
+  }
+  record->nesting = 0;
+  owner.record = record;
+  Rcu::record_ = record;
+  return record;
+}
+
+bool Rcu::tryAdvance(Domain& domain) {
+  // Pairs with the fence in ReadLock(). Either the reader is seen here, or
+  // the reader sees what was unlinked before.
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  const uint64_t epoch = Rcu::epoch_.load(std::memory_order_relaxed);
+  for (const Record* record : domain.records) {
+    const uint64_t readerEpoch = record->epoch.load(std::memory_order_acquire);
+    if ((readerEpoch & ACTIVE) != 0 && (readerEpoch >> 1) != epoch) {
+      return false;
+    }
+  }
+  Rcu::epoch_.store(epoch + 1, std::memory_order_release);
+  return true;
+}
+
+void Rcu::takeReclaimable(Domain& domain, std::vector<std::function<void()>>& deleters) {
+  const uint64_t epoch = Rcu::epoch_.load(std::memory_order_relaxed);
+  size_t numReclaimable = 0;
+  while (domain.retired.size() > numReclaimable &&
+         domain.retired[numReclaimable].epoch + 2 <= epoch)
+  {
+    deleters.push_back(std::move(domain.retired[numReclaimable].deleter));
+    ++numReclaimable;
+  }
+  domain.retired.erase(domain.retired.begin(), domain.retired.begin() + numReclaimable);
+}
+
+}
+
+
+#if _UNIT_TEST
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include <iostream>
+#include <map>
+#include <memory> // shared_ptr
+#include <string>
+#include <vector>
+
+#include <pthread.h>
+
+using namespace lio;
+using std::string;
+
+namespace {
+
+// Counts live instances, and fails readers that see a deleted one.
+struct Table {
+  Table() : isAlive(true) { ++numAlive; }
+  Table(const Table& other) : routes(other.routes), isAlive(true) { ++numAlive; }
+  ~Table() { isAlive = false; --numAlive; }
+
+  std::map<string, int> routes;
+  volatile bool isAlive;
+
+  static std::atomic<int> numAlive;
+};
+
+std::atomic<int> Table::numAlive(0);
+
+thread_local uint64_t readSum = 0;
+
+}
+
+TEST(RcuTest, Basic) {
+  {
+    RcuPointer<Table> table(new Table());
+    {
+      Rcu::ReadGuard guard;
+      EXPECT_TRUE(table.Get()->routes.empty());
+    }
+
+    table.Update([](Table& copy) { copy.routes["/index"] = 1; });
+    {
+      Rcu::ReadGuard guard;
+      Rcu::ReadGuard nested;
+      EXPECT_EQ(1, table.Get()->routes.at("/index"));
+    }
+    EXPECT_LE(1, Rcu::GetNumRetired());
+
+    Rcu::Synchronize();
+    EXPECT_EQ(0, Rcu::GetNumRetired());
+    EXPECT_EQ(1, Table::numAlive);
+  }
+  EXPECT_EQ(0, Table::numAlive);
+
+  Rcu::ReadGuard guard;
+  EXPECT_THROW(Rcu::Synchronize(), Rcu::Exception);
+}
+
+TEST(RcuTest, ReaderHoldsBack) {
+  RcuPointer<Table> table(new Table());
+  std::atomic<bool> isReading(false);
+  std::atomic<bool> isDone(false);
+
+  std::thread reader([&] {
+    Rcu::ReadGuard guard;
+    const Table* current = table.Get();
+    isReading = true;
+    while (isDone == false) {
+      EXPECT_TRUE(current->isAlive);
+      std::this_thread::yield();
+    }
+  });
+  while (isReading == false) {
+    std::this_thread::yield();
+  }
+
+  table.Reset(new Table());
+  for (size_t i = 0; 10 > i; ++i) {
+    Rcu::Reclaim();
+  }
+  EXPECT_EQ(2, Table::numAlive);
+
+  isDone = true;
+  reader.join();
+  Rcu::Synchronize();
+  EXPECT_EQ(1, Table::numAlive);
+}
+
+TEST(RcuTest, Threads) {
+  std::atomic<int> numAlive(Table::numAlive.load());
+  {
+    RcuPointer<Table> table(new Table());
+    std::atomic<bool> isDone(false);
+    std::atomic<size_t> numDeleted(0);
+
+    std::vector<std::thread> readers;
+    for (size_t i = 0; 4 > i; ++i) {
+      readers.emplace_back([&] {
+        while (isDone == false) {
+          Rcu::ReadGuard guard;
+          if (table.Get()->isAlive == false) {
+            ++numDeleted;
+          }
+        }
+      });
+    }
+    for (int i = 0; 10 * 1000 > i; ++i) {
+      table.Update([i](Table& copy) { copy.routes["/count"] = i; });
+    }
+    isDone = true;
+    for (std::thread& reader : readers) {
+      reader.join();
+    }
+    Rcu::Synchronize();
+    EXPECT_EQ(0, numDeleted);
+    EXPECT_EQ(9999, table.Get()->routes.at("/count"));
+    EXPECT_EQ(numAlive + 1, Table::numAlive);
+  }
+  EXPECT_EQ(numAlive, Table::numAlive);
+}
+
+TEST(RcuTest, Benchmark) {
+  PERFTEST {
+    Table* initial = new Table();
+    initial->routes["/index"] = 1;
+    RcuPointer<Table> table(new Table(*initial));
+    std::shared_ptr<Table> sharedTable(initial);
+    pthread_rwlock_t rwlock = PTHREAD_RWLOCK_INITIALIZER;
+
+    const size_t numCalls = 10 * 1000 * 1000;
+    for (size_t numThreads : { 1, 2, 4, 8 }) {
+      std::cout << numThreads << " reader(s)" << endl;
+      lio::Test::Measure("  Rcu::ReadGuard and Get", numThreads, numCalls / numThreads,
+                         [&](size_t) {
+        Rcu::ReadGuard guard;
+        readSum += table.Get()->routes.size();
+      });
+      lio::Test::Measure("  std::atomic_load of shared_ptr", numThreads, numCalls / numThreads,
+                         [&](size_t) {
+        std::shared_ptr<Table> current = std::atomic_load(&sharedTable);
+        readSum += current->routes.size();
+      });
+      lio::Test::Measure("  pthread_rwlock", numThreads, numCalls / numThreads, [&](size_t) {
+        pthread_rwlock_rdlock(&rwlock);
+        readSum += sharedTable->routes.size();
+        pthread_rwlock_unlock(&rwlock);
+      });
+    }
+    std::cout << "1 writer" << endl;
+    lio::Test::Measure("  RcuPointer::Update", 1, numCalls / 100, [&](size_t) {
+      table.Update([](Table& copy) { ++copy.routes["/index"]; });
+    });
+    Rcu::Synchronize();
+  }
+}
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleMock(&argc, argv);
+  return RUN_ALL_TESTS();
+}
+
+#else
+// Executable File's Main Comes here.
+
+
+#endif
+
+#undef _UNIT_TEST
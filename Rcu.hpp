@@ -0,0 +1,235 @@
+#ifndef _RCU_HPP_
+#define _RCU_HPP_
+/*
+  Name
+    Rcu
+
+  Description
+    Epoch based reclamation, to swap whole read mostly structures such as
+    routing tables and config maps while threads read them.
+
+    A writer builds a new copy, publishes it with one atomic store and
+    Retire()s the old one. Readers take the pointer within a ReadGuard and
+    never wait for a writer. The old copy is deleted once every reader
+    that could have seen it has left its ReadGuard.
+
+    A ReadGuard writes the current epoch to a record of its own thread,
+    on a cache line of its own. Retire() tags the pointer with the epoch.
+    The epoch advances when every thread in a ReadGuard has seen it, and
+    pointers two epochs old are deleted. A reader that stays in a
+    ReadGuard holds back every Retire() after it, so keep them short.
+
+    RcuPointer<T> wraps it:
+
+      RcuPointer<std::map<string, string>> config(new std::map<string, string>());
+      ...
+      std::map<string, string>* newConfig = new std::map<string, string>();
+      lio::loadMap<string, string>(newConfig, "./config.data");
+      config.Reset(newConfig);
+      ...
+      Rcu::ReadGuard guard;
+      const std::map<string, string>* current = config.Get();
+
+  Last Modified Date
+    Oct 19, 2026
+
+  History
+    October 19, 2026
+      Created
+
+  ToDos
+
+
+
+  Milestones
+    1.0
+
+
+  Learning Resources
+    Practical lock-freedom, Keir Fraser
+      https://www.cl.cam.ac.uk/techreports/UCAM-CL-TR-579.pdf
+    What is RCU, Fundamentally?
+      https://lwn.net/Articles/262464/
+
+  Copyright (c) All rights reserved to LIFEINO.
+*/
+
+#ifdef _DEBUG
+  #undef _DEBUG
+#endif
+#define _DEBUG false
+
+#include "liolib/Debug.hpp"
+
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+#include <cstdint>
+
+namespace lio {
+
+
+class Rcu {
+public:
+
+enum class ExceptionType : std::uint8_t {
+  GENERAL,
+  IN_READ_SECTION
+};
+
+#define RCU_EXCEPTION_MESSAGES \
+  "Rcu Exception has been thrown.", \
+  "Synchronize() within a ReadGuard would wait for itself."
+
+class Exception : public std::exception {
+public:
+  Exception (ExceptionType exceptionType = ExceptionType::GENERAL);
+
+  virtual const char*         what() const noexcept;
+  virtual const               ExceptionType type() const noexcept;
+
+private:
+  const ExceptionType         exceptionType_;
+  static const char* const    exceptionMessages_[];
+};
+
+  // ReadGuards nest.
+  class ReadGuard {
+  public:
+    ReadGuard() { Rcu::ReadLock(); }
+    ~ReadGuard() { Rcu::ReadUnlock(); }
+
+  private:
+    ReadGuard(const ReadGuard&) = delete;
+    ReadGuard& operator=(const ReadGuard&) = delete;
+  };
+
+  static
+  void            ReadLock() {
+    Record* record = Rcu::record_;
+    if (record == nullptr) {
+      record = Rcu::acquireRecord();
+    }
+    if (record->nesting++ == 0) {
+      const uint64_t epoch = Rcu::epoch_.load(std::memory_order_acquire);
+      record->epoch.store((epoch << 1) | ACTIVE, std::memory_order_relaxed);
+      // Record is visible before the reader loads any pointer.
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+  }
+
+  static
+  void            ReadUnlock() {
+    Record* record = Rcu::record_;
+    if (--record->nesting == 0) {
+      record->epoch.store(0, std::memory_order_release);
+    }
+  }
+
+  // Calls deleter once no reader can still see what it frees.
+  static
+  void            Retire(std::function<void()> deleter);
+
+  template <typename T>
+  static
+  void            Retire(T* ptr) {
+    Rcu::Retire([ptr] { delete ptr; });
+  }
+
+  // Waits until readers in a ReadGuard have left it, and deletes what was
+  // retired before. Throws IN_READ_SECTION within a ReadGuard.
+  static
+  void            Synchronize();
+
+  // Deletes what is safe to. Returns how many. Retire() calls it too.
+  static
+  size_t          Reclaim();
+
+  static
+  size_t          GetNumRetired();
+
+private:
+  static const uint64_t ACTIVE = 1;
+  // Retire() tries to reclaim every this many pointers.
+  static const size_t RECLAIM_EVERY = 64;
+
+  // Written by its thread. epoch is (epoch << 1) | ACTIVE in a ReadGuard.
+  struct alignas(64) Record {
+    std::atomic<uint64_t> epoch;
+    uint32_t      nesting;
+  };
+  struct Domain;
+  struct RecordOwner;
+
+  static std::atomic<uint64_t> epoch_;
+  static thread_local Record* record_;
+
+  static
+  Domain&         getDomain();
+  // Record of the calling thread. Given back when the thread exits.
+  static
+  Record*         acquireRecord();
+  // Domain mutex has to be held.
+  static
+  bool            tryAdvance(Domain& domain);
+  // Moves deleters that are safe to call. Domain mutex has to be held.
+  static
+  void            takeReclaimable(Domain& domain, std::vector<std::function<void()>>& deleters);
+
+  Rcu() = delete;
+};
+
+
+// Pointer to a whole structure, replaced under readers.
+template <typename T>
+class RcuPointer {
+public:
+  explicit RcuPointer(T* value = nullptr) : value_(value) { }
+
+  // No reader may be left.
+  ~RcuPointer() {
+    delete this->value_.load(std::memory_order_relaxed);
+  }
+
+  // Only within a Rcu::ReadGuard. Valid until it ends.
+  T*              Get() const {
+    return this->value_.load(std::memory_order_acquire);
+  }
+
+  // Old value is deleted once readers are done with it.
+  void            Reset(T* value) {
+    std::lock_guard<std::mutex> lock(this->writerMutex_);
+    this->swap(value);
+  }
+
+  // Copies the current value, modifies the copy and swaps it in.
+  template <typename Modify>
+  void            Update(Modify modify) {
+    std::lock_guard<std::mutex> lock(this->writerMutex_);
+    const T* current = this->value_.load(std::memory_order_relaxed);
+    T* copy = (current != nullptr) ? new T(*current) : new T();
+    modify(*copy);
+    this->swap(copy);
+  }
+
+private:
+  std::atomic<T*> value_;
+  std::mutex      writerMutex_;
+
+  void            swap(T* value) {
+    T* old = this->value_.exchange(value, std::memory_order_acq_rel);
+    if (old != nullptr) {
+      Rcu::Retire(old);
+    }
+  }
+
+  RcuPointer(const RcuPointer&) = delete;
+  RcuPointer& operator=(const RcuPointer&) = delete;
+};
+
+}
+
+#endif
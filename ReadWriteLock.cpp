@@ -0,0 +1,217 @@
+#include "ReadWriteLock.hpp"
+
+#define _UNIT_TEST false
+#include "liolib/Test.hpp"
+
+#include <new> // bad_alloc, placement new
+#include <thread> // yield()
+
+#include <cstdlib> // posix_memalign()
+
+#include <linux/futex.h>
+#include <sched.h> // sched_getcpu()
+#include <sys/syscall.h>
+#include <unistd.h> // syscall(), sysconf()
+
+namespace lio {
+
+namespace {
+
+size_t getNumCpus() {
+  const long numCpus = sysconf(_SC_NPROCESSORS_CONF);
+  return (numCpus > 0) ? numCpus : 1;
+}
+
+}
+
+ReadWriteLock::ReadWriteLock(size_t numSlots) :
+  numSlots_((numSlots > 0) ? numSlots : getNumCpus()),
+  slots_(ReadWriteLock::newSlots(this->numSlots_), free),
+  isWriting_(0)
+{
+  for (size_t i = 0; this->numSlots_ > i; ++i) {
+    this->slots_[i].numReaders.store(0, std::memory_order_relaxed);
+  }
+}
+
+void ReadWriteLock::WriteLock() {
+  this->writerMutex_.Lock();
+  this->isWriting_.store(WRITING);
+  for (size_t i = 0; this->numSlots_ > i; ++i) {
+    while (this->slots_[i].numReaders.load(std::memory_order_acquire) != 0) {
+      std::this_thread::yield();
+    }
+  }
+}
+
+void ReadWriteLock::WriteUnlock() {
+  if (this->isWriting_.exchange(0, std::memory_order_release) == READERS_WAITING) {
+    syscall(SYS_futex, &this->isWriting_, FUTEX_WAKE_PRIVATE, INT32_MAX,
+            nullptr, nullptr, 0);
+  }
+  this->writerMutex_.Unlock();
+}
+
+ReadWriteLock::Slot* ReadWriteLock::newSlots(size_t numSlots) {
+  void* memory = nullptr;
+  if (posix_memalign(&memory, alignof(Slot), numSlots * sizeof(Slot)) != 0) {
+    throw std::bad_alloc();
+  }
+  Slot* slots = static_cast<Slot*>(memory);
+  for (size_t i = 0; numSlots > i; ++i) {
+    new (&slots[i]) Slot(); // Trivially destructible, so free() is enough.
+  }
+  return slots;
+}
+
+size_t ReadWriteLock::getSlot() const {
+  const int cpu = sched_getcpu();
+  return (cpu >= 0) ? cpu % this->numSlots_ : 0;
+}
+
+void ReadWriteLock::waitWriter() {
+  uint32_t isWriting = this->isWriting_.load(std::memory_order_acquire);
+  while (isWriting != 0) {
+    if (isWriting == READERS_WAITING ||
+        this->isWriting_.compare_exchange_weak(isWriting, READERS_WAITING) == true)
+    {
+      syscall(SYS_futex, &this->isWriting_, FUTEX_WAIT_PRIVATE, READERS_WAITING,
+              nullptr, nullptr, 0);
+      isWriting = this->isWriting_.load(std::memory_order_acquire);
+    }
+  }
+}
+
+}
+
+
+#if _UNIT_TEST
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include <iostream>
+#include <mutex>
+#include <vector>
+
+#include <pthread.h>
+
+using namespace lio;
+using std::string;
+
+namespace {
+
+// What readers read, in the benchmark. Per thread, not to share a cache line.
+thread_local uint64_t readSum = 0;
+
+}
+
+TEST(ReadWriteLockTest, Basic) {
+  ReadWriteLock lock(4);
+
+  const size_t first = lock.ReadLock();
+  const size_t second = lock.ReadLock();
+  EXPECT_GT(4, first);
+  lock.ReadUnlock(second);
+  lock.ReadUnlock(first);
+
+  {
+    std::lock_guard<ReadWriteLock> guard(lock);
+  }
+  {
+    ReadWriteLock::ReadGuard guard(lock);
+  }
+}
+
+TEST(ReadWriteLockTest, WriterWaitsReaders) {
+  ReadWriteLock lock;
+  std::atomic<bool> isWritten(false);
+
+  const size_t slot = lock.ReadLock();
+  std::thread writer([&] {
+    lock.WriteLock();
+    isWritten = true;
+    lock.WriteUnlock();
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_FALSE(isWritten);
+  lock.ReadUnlock(slot);
+  writer.join();
+  EXPECT_TRUE(isWritten);
+}
+
+TEST(ReadWriteLockTest, Threads) {
+  // Writers keep both values equal. Readers must never see them differ.
+  ReadWriteLock lock;
+  uint64_t values[2] = { 0, 0 };
+  std::atomic<bool> isDone(false);
+  std::atomic<size_t> numTorn(0);
+
+  std::vector<std::thread> readers;
+  for (size_t i = 0; 4 > i; ++i) {
+    readers.emplace_back([&] {
+      while (isDone == false) {
+        ReadWriteLock::ReadGuard guard(lock);
+        if (values[0] != values[1]) {
+          ++numTorn;
+        }
+      }
+    });
+  }
+  for (size_t i = 0; 2000 > i; ++i) {
+    std::lock_guard<ReadWriteLock> guard(lock);
+    ++values[0];
+    ++values[1];
+  }
+  isDone = true;
+  for (std::thread& reader : readers) {
+    reader.join();
+  }
+  EXPECT_EQ(0, numTorn);
+  EXPECT_EQ(2000, values[0]);
+}
+
+TEST(ReadWriteLockTest, Benchmark) {
+  PERFTEST {
+    ReadWriteLock lock;
+    pthread_rwlock_t rwlock = PTHREAD_RWLOCK_INITIALIZER;
+    uint64_t value = 1;
+
+    const size_t numCalls = 10 * 1000 * 1000;
+    for (size_t numThreads : { 1, 2, 4, 8 }) {
+      std::cout << numThreads << " reader(s)" << endl;
+      lio::Test::Measure("  ReadWriteLock", numThreads, numCalls / numThreads, [&](size_t) {
+        ReadWriteLock::ReadGuard guard(lock);
+        readSum += value;
+      });
+      lio::Test::Measure("  pthread_rwlock", numThreads, numCalls / numThreads, [&](size_t) {
+        pthread_rwlock_rdlock(&rwlock);
+        readSum += value;
+        pthread_rwlock_unlock(&rwlock);
+      });
+    }
+    std::cout << "1 writer" << endl;
+    lio::Test::Measure("  ReadWriteLock", 1, numCalls / 10, [&](size_t) {
+      std::lock_guard<ReadWriteLock> guard(lock);
+      ++value;
+    });
+    lio::Test::Measure("  pthread_rwlock", 1, numCalls / 10, [&](size_t) {
+      pthread_rwlock_wrlock(&rwlock);
+      ++value;
+      pthread_rwlock_unlock(&rwlock);
+    });
+  }
+}
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleMock(&argc, argv);
+  return RUN_ALL_TESTS();
+}
+
+#else
+// Executable File's Main Comes here.
+
+
+#endif
+
+#undef _UNIT_TEST
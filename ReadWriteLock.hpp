@@ -0,0 +1,135 @@
+#ifndef _READWRITELOCK_HPP_
+#define _READWRITELOCK_HPP_
+/*
+  Name
+    ReadWriteLock
+
+  Description
+    Reader-writer lock for read mostly structures, with a reader counter
+    per CPU.
+
+    A reader increments the counter of the CPU it runs on, on a cache line
+    of its own, and checks there is no writer. Readers on different CPUs
+    share no cache lines, where the single counter of pthread_rwlock moves
+    between all of them on every lock.
+
+    ReadLock() returns the counter it used. Pass it to ReadUnlock(), the
+    thread may be on another CPU by then. ReadGuard does that.
+
+    A writer takes the writer Mutex, marks itself and waits for all
+    counters to drain. Readers that come meanwhile back off and sleep on a
+    futex until it is done, so writers are not starved. Writes are slower
+    than with a single counter, more so with many CPUs. Use it where
+    writes are rare, such as routing tables and config maps.
+
+  Last Modified Date
+    Oct 19, 2026
+
+  History
+    October 19, 2026
+      Created
+
+  ToDos
+
+
+
+  Milestones
+    1.0
+
+
+  Learning Resources
+    Big reader locks
+      https://lwn.net/Articles/378911/
+
+  Copyright (c) All rights reserved to LIFEINO.
+*/
+
+#ifdef _DEBUG
+  #undef _DEBUG
+#endif
+#define _DEBUG false
+
+#include "liolib/Debug.hpp"
+
+#include <atomic>
+#include <memory> // unique_ptr
+
+#include <cstdlib> // free()
+
+#include <cstdint>
+
+#include "liolib/Mutex.hpp"
+
+namespace lio {
+
+
+class ReadWriteLock {
+public:
+  class ReadGuard {
+  public:
+    explicit ReadGuard(ReadWriteLock& lock) : lock_(lock), slot_(lock.ReadLock()) { }
+    ~ReadGuard() { this->lock_.ReadUnlock(this->slot_); }
+
+  private:
+    ReadWriteLock& lock_;
+    const size_t  slot_;
+
+    ReadGuard(const ReadGuard&) = delete;
+    ReadGuard& operator=(const ReadGuard&) = delete;
+  };
+
+  // numSlots 0 is one per configured CPU.
+  explicit ReadWriteLock(size_t numSlots = 0);
+
+  size_t          ReadLock() {
+    while (true) {
+      const size_t slot = this->getSlot();
+      // Increment, then check the writer. WriteLock() does it the other way.
+      this->slots_[slot].numReaders.fetch_add(1);
+      if (this->isWriting_.load() == 0) {
+        return slot;
+      }
+      this->slots_[slot].numReaders.fetch_sub(1, std::memory_order_release);
+      this->waitWriter();
+    }
+  }
+
+  void            ReadUnlock(size_t slot) {
+    this->slots_[slot].numReaders.fetch_sub(1, std::memory_order_release);
+  }
+
+  void            WriteLock();
+  void            WriteUnlock();
+
+  // Lockable, for std::lock_guard on the write side.
+  void            lock() { this->WriteLock(); }
+  void            unlock() { this->WriteUnlock(); }
+
+private:
+  // Values of isWriting_. WriteUnlock() only wakes readers that are waiting.
+  static const uint32_t WRITING = 1;
+  static const uint32_t READERS_WAITING = 2;
+
+  struct alignas(64) Slot {
+    std::atomic<int64_t> numReaders;
+  };
+
+  const size_t    numSlots_;
+  std::unique_ptr<Slot[], void (*)(void*)> slots_; // From newSlots(), freed with free().
+  std::atomic<uint32_t> isWriting_; // Futex readers wait on.
+  Mutex           writerMutex_;
+
+  // new Slot[] is only aligned to 16 bytes before C++17.
+  static
+  Slot*           newSlots(size_t numSlots);
+
+  size_t          getSlot() const;
+  void            waitWriter();
+
+  ReadWriteLock(const ReadWriteLock&) = delete;
+  ReadWriteLock& operator=(const ReadWriteLock&) = delete;
+};
+
+}
+
+#endif
@@ -1,5 +1,15 @@
 #include "Semaphore.hpp"
 
+#define _UNIT_TEST false
+#include "liolib/Test.hpp"
+
+#include <ctime> // timespec
+
+#include <linux/futex.h>
+#include <sched.h> // sched_yield()
+#include <sys/syscall.h>
+#include <unistd.h> // syscall()
+
 namespace lio {
 
 
@@ -24,115 +34,141 @@ const Semaphore::ExceptionType Semaphore::Exception::type() const throw() {
 }
 // ===== Exception Implementation End =====
 
+// Time a waiter sleeps before it looks for dead holders.
+static const long RECOVER_CHECK_NANOSECONDS = 100 * 1000 * 1000;
+// Spins on a change in flight before yielding and checking its process.
+static const size_t MAX_IN_FLIGHT_SPINS = 1024;
+
+static inline uint64_t packCounts(int32_t count, int32_t pending) {
+  return ((uint64_t) (uint32_t) pending << 32) | (uint32_t) count;
+}
+
+static inline int32_t getCount(uint64_t counts) {
+  return (int32_t) (uint32_t) counts;
+}
+
+static inline int32_t getPending(uint64_t counts) {
+  return (int32_t) (uint32_t) (counts >> 32);
+}
+
+static inline void pause() {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#elif defined(__aarch64__)
+  asm volatile("yield");
+#endif
+}
 
 
 Semaphore::Semaphore(Config& config)
-  : config_(config) {
+  : config_(config),
+    semKey_(-1),
+    header_(nullptr),
+    sems_(nullptr),
+    semSize_(0),
+    isSetToDestroySem_(false) {
 
   DEBUG_FUNC_START;
 
-  // #TODO: Check max number of semaphores.
-  if (this->config_.semCount < SEMMSL) {
-    DEBUG_cerr << "semCount exceeds limit." << endl; 
+  if (this->config_.semCount == 0) {
+    DEBUG_cerr << "semCount has to be at least 1." << endl;
     throw Exception(ExceptionType::SEM_INIT_FAILED);
   }
+  if (this->config_.maxProcesses == 0) {
+    DEBUG_cerr << "maxProcesses has to be at least 1." << endl;
+    throw Exception(ExceptionType::SEM_INIT_FAILED);
+  }
+  const size_t undoSize = this->config_.maxProcesses * sizeof(UndoEntry);
+  this->semSize_ = (sizeof(Sem) + undoSize + alignof(Sem) - 1) / alignof(Sem) * alignof(Sem);
 
-  this->isSetToDestroySem_ = false;
-  
   string keyPath = this->config_.semKeyDir + this->config_.semKeyName;
+  this->semKey_ = GenerateUniqueKey(keyPath, KEY_PROJ_ID);
+  if (this->semKey_ == -1) {
+    DEBUG_cerr << "Failed to generate key from " << keyPath << endl;
+    throw Exception(ExceptionType::INVALID_KEY);
+  }
 
-  this->semKey_ = GenerateUniqueKey(keyPath);
-  
+  SharedMemory::Config shmConfig;
+  shmConfig.key = this->semKey_;
+  shmConfig.size = sizeof(Header) + this->config_.semCount * this->semSize_;
+  shmConfig.permission = this->config_.semPermission;
   switch (this->config_.semMode) {
     case Mode::AUTO:
-      try {
-        this->createSem();
-      } catch(Exception& ex) {
-        if (ex.type() == ExceptionType::SEM_EXISTS) {
-          this->loadSem();
-        } else {
-          throw Exception(ex.type());
-        }
-      }
+      shmConfig.mode = SharedMemory::Mode::AUTO;
       break;
     case Mode::CREATE:
-      this->createSem();
+      shmConfig.mode = SharedMemory::Mode::CREATE;
       break;
     case Mode::LOAD:
-      this->loadSem();
+      shmConfig.mode = SharedMemory::Mode::LOAD;
       break;
     default:
-      DEBUG_cerr << "Invalid Semaphore Mode." << endl; 
+      DEBUG_cerr << "Invalid Semaphore Mode." << endl;
       throw Exception(ExceptionType::SEM_INIT_FAILED);
       break;
   }
+
+  try {
+    this->shm_.reset(new SharedMemory(shmConfig));
+  } catch (SharedMemoryException& ex) {
+    switch (ex.type()) {
+      case SharedMemoryExceptionType::SHM_EXISTS:
+        throw Exception(ExceptionType::SEM_EXISTS);
+      case SharedMemoryExceptionType::SHM_ACCESS_DENIED:
+        throw Exception(ExceptionType::SEM_ACCESS_DENIED);
+      default:
+        throw Exception((this->config_.semMode == Mode::LOAD) ?
+                        ExceptionType::SEM_GET_FAILED : ExceptionType::SEM_INIT_FAILED);
+    }
+  }
+  this->header_ = static_cast<Header*>(const_cast<void*>(this->shm_->GetShmAddress()));
+  this->sems_ = reinterpret_cast<Sem*>(this->header_ + 1);
+
+  uint32_t state = EMPTY;
+  if (this->config_.semMode != Mode::LOAD &&
+      this->header_->state.compare_exchange_strong(state, INITIALIZING) == true)
+  {
+    this->initSem();
+  } else {
+    this->loadSem();
+  }
 }
 
 
 Semaphore::~Semaphore() {
   DEBUG_FUNC_START;
-  //#TODO: Gotta release all the Sem?? Not sure. Nothing will be done yet.
   if (this->isSetToDestroySem_) {
     DEBUG_cout << "Semaphore is set to be destroyed!\n";
-    union semun arg;
-    /* remove it: */
-    if (semctl(this->semId_, 0, IPC_RMID, arg) == -1) {
-      // ERROR
-      // #TODO: check if this exception must be handled.
-      throw Semaphore::Exception(Semaphore::ExceptionType::SEM_UNSET_FAILED);
-    }
+    this->shm_->SetToRemoveOnDelete();
   }
 }
 
 bool Semaphore::Lock(int semNum) {
-
-  const int ERROR = -1;
-
-  if (semNum >= this->config_.semCount) {
-    //ERROR
-    DEBUG_cerr << "Lock: Sem Number out of range." << endl; 
-    throw Exception(ExceptionType::GENERAL);
+  Sem& sem = this->getSem(semNum);
+  if (this->change(sem, -1) == false) {
+    this->lockContended(sem);
   }
-  struct sembuf sb;
-  
-  sb.sem_num = semNum;
-  sb.sem_op = -1; // LOCK
-  sb.sem_flg = SEM_UNDO;
-  
-  int semOpResult = 0;
-  semOpResult = semop (this->semId_, &sb, 1);
-  if (semOpResult == ERROR) { // Error!
-    DEBUG_cerr << "semop has failed. Errno: " << errno << endl; 
-    return false;
-  }
-  
   return true;
 }
 
-bool Semaphore::Release(int semNum) {
-
-  const int ERROR = -1;
+bool Semaphore::TryLock(int semNum) {
+  return this->change(this->getSem(semNum), -1);
+}
 
-  if (semNum >= this->config_.semCount) {
-    //ERROR
-    DEBUG_cerr << "Release: Sem Number out of range." << endl; 
-    throw Exception(ExceptionType::GENERAL);
-  }
-  struct sembuf sb;
-  
-  sb.sem_num = semNum;
-  sb.sem_op = 1; // RELEASE
-  sb.sem_flg = SEM_UNDO;
-  
-  int semOpResult = 0;
-  semOpResult = semop (this->semId_, &sb, 1);
-  if (semOpResult == ERROR) { // Error!
-    DEBUG_cerr << "semop has failed. Errno: " << errno << endl; 
+bool Semaphore::Release(int semNum) {
+  Sem& sem = this->getSem(semNum);
+  if (this->change(sem, 1) == false) {
+    DEBUG_cerr << "Semaphore value is at its maximum." << endl;
     return false;
   }
-  
-  return true;  
-  
+  if (sem.numWaiters.load() > 0) {
+    this->wake(sem, 1);
+  }
+  return true;
+}
+
+int Semaphore::GetValue(int semNum) const {
+  return this->getSem(semNum).value.load(std::memory_order_relaxed) & VALUE_MASK;
 }
 
 void Semaphore::SetToDestroySemOnDelete() {
@@ -146,92 +182,409 @@ int Semaphore::DestroySem() {
 }
 
 
-void Semaphore::createSem() {
-  struct sembuf sb;
-
-  // #TODO:Check if all the arguments are not empty.
-  
-  semId_ = semget(this->semKey_,
-                  this->config_.semCount,
-                  this->config_.semPermission | IPC_CREAT | IPC_EXCL);
-  
-  if (this->semId_ >= 0) { // Succesfully Created Semaphore
-    sb.sem_op = 1;
-    sb.sem_flg = 0;
-    for (sb.sem_num = 0; sb.sem_num < this->config_.semCount; sb.sem_num++) {
-      int semOpResult = 0;
-      semOpResult = semop (this->semId_, &sb, 1);
-      if (semOpResult == -1) { // ERROR with SemOp
-        semctl(this->semId_, 0, IPC_RMID);
-        DEBUG_cerr << "semop has failed." << endl;
-        throw Semaphore::Exception(Semaphore::ExceptionType::SEM_INIT_FAILED);
+Semaphore::Sem& Semaphore::getSem(int semNum) const {
+  if (semNum < 0 || semNum >= (int) this->header_->semCount) {
+    DEBUG_cerr << "Sem Number out of range." << endl;
+    throw Exception(ExceptionType::GENERAL);
+  }
+  return *reinterpret_cast<Sem*>(reinterpret_cast<char*>(this->sems_) + semNum * this->semSize_);
+}
+
+Semaphore::UndoEntry* Semaphore::getUndoTable(Sem& sem) const {
+  return reinterpret_cast<UndoEntry*>(&sem + 1);
+}
+
+void Semaphore::initSem() {
+  this->header_->semCount = this->config_.semCount;
+  this->header_->maxProcesses = this->config_.maxProcesses;
+  for (size_t i = 0; this->config_.semCount > i; ++i) {
+    this->getSem(i).value.store(1, std::memory_order_relaxed);
+  }
+  this->header_->magic = MAGIC;
+  this->header_->state.store(READY, std::memory_order_release);
+}
+
+void Semaphore::loadSem() {
+  // Creator may still be initializing.
+  uint32_t state = this->header_->state.load(std::memory_order_acquire);
+  for (size_t i = 0; 100000 > i && state != READY; ++i) {
+    sched_yield();
+    state = this->header_->state.load(std::memory_order_acquire);
+  }
+  if (state != READY || this->header_->magic != MAGIC ||
+      this->header_->semCount != this->config_.semCount ||
+      this->header_->maxProcesses != this->config_.maxProcesses)
+  {
+    DEBUG_cerr << "Failed to load Semaphore." << endl;
+    throw Semaphore::Exception(Semaphore::ExceptionType::SEM_GET_FAILED);
+  }
+}
+
+bool Semaphore::change(Sem& sem, int32_t count) {
+  UndoEntry& entry = this->getUndo(sem);
+  uint32_t word = sem.value.load(std::memory_order_relaxed);
+  const uint32_t inFlight = (uint32_t) (&entry - this->getUndoTable(sem) + 1) << IN_FLIGHT_SHIFT;
+  // The entry counts units held, so it changes the other way.
+  const int32_t held = getCount(entry.counts.load(std::memory_order_relaxed));
+  entry.counts.store(packCounts(held, -count), std::memory_order_relaxed);
+  size_t numSpins = 0;
+  while (true) {
+    if ((word & ~VALUE_MASK) != 0) {
+      // Another change is in flight for a few instructions, unless its process died.
+      if (MAX_IN_FLIGHT_SPINS > ++numSpins) {
+        pause();
+      } else {
+        numSpins = 0;
+        sched_yield();
+        const pid_t pid = this->getUndoTable(sem)[(word >> IN_FLIGHT_SHIFT) - 1].pid.load();
+        if (pid > 0 && Util::Process::IsAlive(pid) == false) {
+          this->recoverDead(sem);
+        }
       }
+      word = sem.value.load(std::memory_order_relaxed);
+      continue;
+    }
+    const int64_t value = (int64_t) word + count;
+    if (value < 0 || value > VALUE_MASK) {
+      entry.counts.store(packCounts(held, 0), std::memory_order_relaxed);
+      return false;
+    }
+    // Release orders the pending change before the value word naming it.
+    if (sem.value.compare_exchange_weak(word, inFlight | (word + count),
+                                        std::memory_order_acq_rel) == true)
+    {
+      break;
     }
-  } else if (errno == EEXIST) { // Semaphore already exists
-    DEBUG_cerr << "Semaphore: SEM already Exists." << endl; 
-    throw Semaphore::Exception(Semaphore::ExceptionType::SEM_EXISTS);
-  } else {
-    DEBUG_cerr << "Semaphore: SEM Initialization failed." << endl; 
-    throw Semaphore::Exception(Semaphore::ExceptionType::SEM_INIT_FAILED);
   }
+  entry.counts.store(packCounts(held - count, 0), std::memory_order_relaxed);
+  sem.value.fetch_and(VALUE_MASK, std::memory_order_release);
+  return true;
 }
 
-void Semaphore::loadSem() {
-  //struct sembuf sb;
-
-  // #TODO:Check if all the arguments are not empty.
-  
-  semId_ = semget(this->semKey_, this->config_.semCount, 0);
-  
-  if (this->semId_ >= 0) { // Succesfully Loaded Existing Semaphore
-    return;
-  } else {
-    DEBUG_cerr << "Failed to load Semaphore." << endl; 
-    throw Semaphore::Exception(Semaphore::ExceptionType::SEM_INIT_FAILED);
+void Semaphore::lockContended(Sem& sem) {
+  while (this->change(sem, -1) == false) {
+    // numWaiters before value, Release() does it the other way around.
+    sem.numWaiters.fetch_add(1);
+    long result = 0;
+    const uint32_t word = sem.value.load();
+    if ((word & VALUE_MASK) == 0) {
+      struct timespec timeout = { 0, RECOVER_CHECK_NANOSECONDS };
+      result = syscall(SYS_futex, &sem.value, FUTEX_WAIT, word, &timeout, nullptr, 0);
+    }
+    sem.numWaiters.fetch_sub(1);
+    if (result == -1 && errno == ETIMEDOUT) {
+      this->recoverDead(sem);
+    }
+  }
+}
+
+Semaphore::UndoEntry& Semaphore::getUndo(Sem& sem) {
+  const pid_t self = Util::Process::GetPid();
+  UndoEntry* undo = this->getUndoTable(sem);
+  const size_t numEntries = this->config_.maxProcesses;
+  for (size_t round = 0; 2 > round; ++round) {
+    for (size_t i = 0; numEntries > i; ++i) {
+      if (undo[i].pid.load(std::memory_order_relaxed) == self) {
+        return undo[i];
+      }
+    }
+    for (size_t i = 0; numEntries > i; ++i) {
+      pid_t expected = 0;
+      if (undo[i].pid.compare_exchange_strong(expected, self) == true) {
+        return undo[i];
+      }
+    }
+    this->recoverDead(sem);
+  }
+  LOG_err << "Undo table of Semaphore is full. maxProcesses: " << numEntries << endl;
+  throw Exception(ExceptionType::UNDO_TABLE_FULL);
+}
+
+bool Semaphore::recoverDead(Sem& sem) {
+  const pid_t self = Util::Process::GetPid();
+  bool isRecovered = false;
+  UndoEntry* undo = this->getUndoTable(sem);
+  for (size_t i = 0; this->config_.maxProcesses > i; ++i) {
+    UndoEntry& entry = undo[i];
+    pid_t pid = entry.pid.load(std::memory_order_relaxed);
+    if (pid <= 0 || pid == self || Util::Process::IsAlive(pid) == true) {
+      continue;
+    }
+    if (entry.pid.compare_exchange_strong(pid, RECOVERING) == false) {
+      continue;
+    }
+    // Its pending change reached the value if the value word still names
+    // the entry. Finish it then, and roll it back otherwise.
+    const uint64_t counts = entry.counts.exchange(0);
+    int32_t count = getCount(counts);
+    const uint32_t inFlight = (uint32_t) (i + 1) << IN_FLIGHT_SHIFT;
+    if ((sem.value.load(std::memory_order_acquire) & ~VALUE_MASK) == inFlight) {
+      count += getPending(counts);
+      sem.value.fetch_and(VALUE_MASK);
+      this->wake(sem, this->config_.maxProcesses);
+    }
+    entry.pid.store(0, std::memory_order_release);
+    if (count > 0) {
+      LOG_warn << "Process " << pid << " died holding " << count
+               << " of a Semaphore. Given back." << endl;
+      sem.value.fetch_add(count);
+      this->wake(sem, count);
+      isRecovered = true;
+    } else if (count < 0) {
+      // Released more than it took. Undo those, down to 0.
+      uint32_t word = sem.value.load();
+      uint32_t newWord = 0;
+      do {
+        const uint32_t value = word & VALUE_MASK;
+        newWord = (word & ~VALUE_MASK) | ((value > (uint32_t) -count) ? value + count : 0);
+      } while (sem.value.compare_exchange_weak(word, newWord) == false);
+    }
   }
+  return isRecovered;
+}
+
+void Semaphore::wake(Sem& sem, int numWaiters) {
+  syscall(SYS_futex, &sem.value, FUTEX_WAKE, numWaiters, nullptr, nullptr, 0);
 }
 
 
 }
 
-#define _UNIT_TEST true
 #if _UNIT_TEST
 
-// TEST
-#include <iostream>
-#include <unistd.h>
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include <fstream>
+
+#include <csignal> // kill()
+
+#include <sys/ipc.h>
+#include <sys/sem.h> // semop()
+#include <sys/wait.h> // waitpid()
+
+using namespace lio;
+using std::string;
+
+namespace {
+
+const string KEY_DIR = "/tmp/";
+const string KEY_NAME = "SemaphoreTest.key";
+
+Semaphore::Config getTestConfig(Semaphore::Mode mode = Semaphore::Mode::CREATE) {
+  std::ofstream(KEY_DIR + KEY_NAME).close();
+  return Semaphore::Config(KEY_DIR, KEY_NAME, mode, 0600, 2);
+}
+
+}
+
+TEST(SemaphoreTest, Basic) {
+  Semaphore::Config config = getTestConfig();
+  Semaphore sem(config);
+  sem.SetToDestroySemOnDelete();
+
+  EXPECT_EQ(sem.GetValue(0), 1);
+  EXPECT_EQ(sem.Lock(0), true);
+  EXPECT_EQ(sem.GetValue(0), 0);
+  EXPECT_EQ(sem.TryLock(0), false);
+  EXPECT_EQ(sem.TryLock(1), true);
+  EXPECT_EQ(sem.Release(0), true);
+  EXPECT_EQ(sem.Release(1), true);
+  EXPECT_EQ(sem.GetValue(0), 1);
+  EXPECT_THROW(sem.Lock(2), Semaphore::Exception);
+
+  Semaphore::Config existing = getTestConfig();
+  EXPECT_THROW(Semaphore again(existing), Semaphore::Exception);
+
+  Semaphore::Config loadConfig = getTestConfig(Semaphore::Mode::LOAD);
+  Semaphore loaded(loadConfig);
+  EXPECT_EQ(loaded.TryLock(0), true);
+  EXPECT_EQ(sem.GetValue(0), 0);
+  loaded.Release(0);
+
+  Semaphore::Config badKey("/tmp/", "SemaphoreTest.missing", Semaphore::Mode::AUTO);
+  EXPECT_THROW(Semaphore missing(badKey), Semaphore::Exception);
+}
+
+TEST(SemaphoreTest, Processes) {
+  Semaphore::Config config = getTestConfig();
+  Semaphore sem(config);
+  sem.SetToDestroySemOnDelete();
+
+  SharedMemory::Config shmConfig;
+  shmConfig.key = IPC_PRIVATE;
+  shmConfig.size = sizeof(uint64_t);
+  shmConfig.mode = SharedMemory::Mode::CREATE;
+  SharedMemory shm(shmConfig);
+  shm.SetToRemoveOnDelete();
+  uint64_t* value = static_cast<uint64_t*>(const_cast<void*>(shm.GetShmAddress()));
+
+  const size_t numProcesses = 4;
+  const size_t numLocks = 50000;
+  std::vector<pid_t> pids;
+  for (size_t i = 0; numProcesses > i; ++i) {
+    const pid_t pid = fork();
+    if (pid == 0) {
+      for (size_t j = 0; numLocks > j; ++j) {
+        sem.Lock(0);
+        ++*value;
+        sem.Release(0);
+      }
+      _exit(0);
+    }
+    pids.push_back(pid);
+  }
+  for (pid_t pid : pids) {
+    waitpid(pid, nullptr, 0);
+  }
+  EXPECT_EQ(*value, numProcesses * numLocks);
+  EXPECT_EQ(sem.GetValue(0), 1);
+}
 
-using std::cout;
-using std::endl;
+TEST(SemaphoreTest, Undo) {
+  Semaphore::Config config = getTestConfig();
+  Semaphore sem(config);
+  sem.SetToDestroySemOnDelete();
+
+  // Child dies holding semaphore 0. Parent waits on it meanwhile.
+  int pipeFds[2];
+  ASSERT_EQ(pipe(pipeFds), 0);
+  const pid_t pid = fork();
+  if (pid == 0) {
+    sem.Lock(0);
+    write(pipeFds[1], "L", 1);
+    usleep(50 * 1000);
+    _exit(0);
+  }
+  char c;
+  ASSERT_EQ(read(pipeFds[0], &c, 1), 1);
+  EXPECT_EQ(sem.TryLock(0), false);
+  EXPECT_EQ(sem.Lock(0), true);
+  sem.Release(0);
+  waitpid(pid, nullptr, 0);
+  EXPECT_EQ(sem.GetValue(0), 1);
+  close(pipeFds[0]);
+  close(pipeFds[1]);
+}
 
-using lio::Semaphore;
-void Semaphore::_PrintKey() {
-  cout << "SemKey: " << semKey_ << endl;
-  
+TEST(SemaphoreTest, KilledInFlight) {
+  Semaphore::Config config = getTestConfig();
+  Semaphore sem(config);
+  sem.SetToDestroySemOnDelete();
+
+  // Children are killed anywhere in Lock() and Release(), also between the
+  // value and their undo entry.
+  for (size_t round = 0; 20 > round; ++round) {
+    std::vector<pid_t> pids;
+    for (size_t i = 0; 4 > i; ++i) {
+      const pid_t pid = fork();
+      if (pid == 0) {
+        while (true) {
+          sem.Lock(0);
+          sem.Release(0);
+        }
+      }
+      pids.push_back(pid);
+    }
+    usleep(5 * 1000);
+    for (pid_t pid : pids) {
+      kill(pid, SIGKILL);
+      waitpid(pid, nullptr, 0);
+    }
+    EXPECT_EQ(sem.Lock(0), true);
+    EXPECT_EQ(sem.GetValue(0), 0);
+    sem.Release(0);
+    EXPECT_EQ(sem.GetValue(0), 1);
+  }
 }
 
-void Semaphore::_PrintSemId() {
-  cout << "SemId: " << semId_ << endl;
+TEST(SemaphoreTest, UndoTableFull) {
+  std::ofstream(KEY_DIR + KEY_NAME).close();
+  Semaphore::Config config(KEY_DIR, KEY_NAME, Semaphore::Mode::CREATE, 0600, 1, 2);
+  Semaphore sem(config);
+  sem.SetToDestroySemOnDelete();
+
+  Semaphore::Config mismatch(KEY_DIR, KEY_NAME, Semaphore::Mode::LOAD, 0600, 1, 3);
+  EXPECT_THROW(Semaphore loaded(mismatch), Semaphore::Exception);
+  Semaphore::Config zero(KEY_DIR, KEY_NAME, Semaphore::Mode::LOAD, 0600, 1, 0);
+  EXPECT_THROW(Semaphore loaded(zero), Semaphore::Exception);
+
+  // Two live children take both entries.
+  int readyFds[2];
+  int exitFds[2];
+  ASSERT_EQ(pipe(readyFds), 0);
+  ASSERT_EQ(pipe(exitFds), 0);
+  std::vector<pid_t> pids;
+  for (size_t i = 0; 2 > i; ++i) {
+    const pid_t pid = fork();
+    if (pid == 0) {
+      close(exitFds[1]);
+      sem.Lock(0);
+      sem.Release(0);
+      write(readyFds[1], "R", 1);
+      char c;
+      read(exitFds[0], &c, 1);
+      _exit(0);
+    }
+    pids.push_back(pid);
+  }
+  char c;
+  ASSERT_EQ(read(readyFds[0], &c, 1), 1);
+  ASSERT_EQ(read(readyFds[0], &c, 1), 1);
+  try {
+    sem.TryLock(0);
+    ADD_FAILURE() << "TryLock() with a full undo table did not throw.";
+  } catch (Semaphore::Exception& e) {
+    EXPECT_EQ(e.type(), Semaphore::ExceptionType::UNDO_TABLE_FULL);
+  }
+  EXPECT_EQ(sem.GetValue(0), 1);
+
+  // Entries of exited children are taken over.
+  close(exitFds[1]);
+  for (pid_t pid : pids) {
+    waitpid(pid, nullptr, 0);
+  }
+  EXPECT_EQ(sem.TryLock(0), true);
+  EXPECT_EQ(sem.Release(0), true);
+  close(exitFds[0]);
+  close(readyFds[0]);
+  close(readyFds[1]);
 }
 
-int main () {
-  Semaphore::Config config;
+TEST(SemaphoreTest, Benchmark) {
+  PERFTEST {
+    Semaphore::Config config = getTestConfig();
+    Semaphore sem(config);
+    sem.SetToDestroySemOnDelete();
+
+    const int semId = semget(IPC_PRIVATE, 1, 0600);
+    ASSERT_GE(semId, 0);
+    struct sembuf release = { 0, 1, SEM_UNDO };
+    semop(semId, &release, 1);
+
+    lio::Test::Measure("Semaphore Lock() Release()", 1, 10 * 1000 * 1000, [&sem](size_t) {
+      sem.Lock(0);
+      sem.Release(0);
+    });
+    lio::Test::Measure("SysV semop() with SEM_UNDO", 1, 1000 * 1000, [semId](size_t) {
+      struct sembuf lock = { 0, -1, SEM_UNDO };
+      struct sembuf unlock = { 0, 1, SEM_UNDO };
+      semop(semId, &lock, 1);
+      semop(semId, &unlock, 1);
+    });
+    semctl(semId, 0, IPC_RMID);
+  }
+}
 
-  Semaphore* sem = new Semaphore(config);
-  
-  sem->_PrintKey();
-  sem->_PrintSemId();
-  cout << "LOCKING" << endl;
-  sem->Lock(0);
-  cout << "LOCKED" << endl;
-  cout << getpid() << endl;
-  sleep(2);
-  
-  sem->Release(0);
-  cout << "RELEASED" << endl;
-  
-  delete sem;
+int main(int argc, char** argv) {
+  ::testing::InitGoogleMock(&argc, argv);
+  return RUN_ALL_TESTS();
 }
+
+#else
+// Executable File's Main Comes here.
+
+
 #endif
 
 #undef _UNIT_TEST
@@ -9,17 +9,46 @@
     [ETL] Eun T. Leem (eunleem@gmail.com)
 
   Description
+    Process shared semaphores on futexes in a SharedMemory segment.
 
+    Lock() and Release() are atomic operations on the segment and only
+    call futex wait and wake under contention. A SysV semop() with
+    SEM_UNDO was a system call every time.
+
+    Every semaphore keeps a table of processes and how much each took,
+    like the undo list of SEM_UNDO. A Lock() that has waited 100ms gives
+    the units of dead processes back, and again every 100ms after.
+
+    Like list_op_pending of robust futexes, a process records the change
+    it is about to make in its entry first, and the value word names that
+    entry until the entry is updated. Recovery finishes a change that
+    reached the value and rolls back one that did not. Values are 24 bits.
+
+    The table has Config::maxProcesses entries, at most 255 because the
+    value word names an entry in its top 8 bits. A process that finds the
+    table full of live processes gets UNDO_TABLE_FULL instead of taking
+    units nobody could give back.
+
+    The segment key is ftok() of semKeyDir + semKeyName with projId
+    KEY_PROJ_ID, so a SharedMemory on the same key file does not collide.
 
   Last Modified Date
-    Mar 2, 2013
+    Oct 19, 2026
+
+  History
+    October 19, 2026
+      Futexes in shared memory instead of SysV semaphores. Dead processes
+      are undone like SEM_UNDO.
+      Undo table sized by Config::maxProcesses. Full table throws.
 
   Learning Resources
     Semaphores Tutorial
       http://beej.us/guide/bgipc/output/html/multipage/semaphores.html
     semget
       http://linux.die.net/man/2/semget
-  
+    Futexes Are Tricky, Ulrich Drepper
+      https://www.akkadia.org/drepper/futex.pdf
+
   Copyright (c) All Rights reserved to LIFEINO.
 */
 
@@ -28,16 +57,17 @@
 #endif
 #define _DEBUG false
 
-#include "Debug.hpp" //DEBUG_cout
+#include "liolib/Debug.hpp" //DEBUG_cout
+
+#include <atomic>
+#include <memory> // unique_ptr
+#include <string>
+
 #include <errno.h> // errno
 #include <sys/types.h>
 
-#include <sys/ipc.h> // ftok()
-#include <linux/sem.h> // semun SEMMSL
-#include <sys/sem.h> // semget() semctl() semop()
-
-#include <string>
-#include "Util.hpp"
+#include "liolib/SharedMemory.hpp"
+#include "liolib/Util.hpp"
 
 
 namespace lio {
@@ -45,15 +75,6 @@ namespace lio {
 using std::string;
 
 
-/*union semun {
-  int val;         // used for SETVAL only 
-  struct semid_ds *buf;   used for IPC_STAT and IPC_SET 
-  ushort *array;      used for GETALL and SETALL
-};
-*/
-
-
-
 class Semaphore {
 public:
 
@@ -64,7 +85,8 @@ enum class ExceptionType {
   SEM_EXISTS,
   SEM_ACCESS_DENIED,
   SEM_GET_FAILED,
-  SEM_UNSET_FAILED
+  SEM_UNSET_FAILED,
+  UNDO_TABLE_FULL
 };
 
 #define SEMAPHORE_EXCEPTION_MESSAGES \
@@ -74,7 +96,8 @@ enum class ExceptionType {
   "Semaphore already exists.", \
   "Access to the semaphore is denied.", \
   "Failed to get semaphore.", \
-  "Unset Semaphore has failed."
+  "Unset Semaphore has failed.", \
+  "Undo table of Semaphore is full. Raise Config::maxProcesses."
 
 class Exception : public std::exception {
 public:
@@ -98,58 +121,110 @@ struct Config {
          string semKeyName = "semKey",
          Mode semMode = Mode::AUTO,
          int semPermission = 0666,
-         uint8_t semCount = 5
-         ) 
+         uint8_t semCount = 5,
+         uint8_t maxProcesses = 32
+         )
     : semKeyDir(semKeyDir),
-      semKeyName(semKeyName), 
+      semKeyName(semKeyName),
       semMode (semMode),
       semPermission(semPermission),
-      semCount (semCount) {}
+      semCount (semCount),
+      maxProcesses (maxProcesses) {}
   string semKeyDir;
   string semKeyName;
   Mode semMode;
   int semPermission;
   uint8_t semCount;
+  uint8_t maxProcesses; // Processes using one semaphore at the same time. 1 to 255.
 };
 
+  static const int KEY_PROJ_ID = 'S';
+
   /**
-   * semCount: total number of semaphores to create. Multiple semaphores are created using one key. Determine how many you need. Max Number is Defined in SEMMSL
+   * semCount: total number of semaphores to create. Multiple semaphores are created using one key. Determine how many you need. Each starts at 1.
+   * maxProcesses: size of the undo table of each semaphore. Every process that loads the semaphore has to use the same value.
    *
    */
   Semaphore (Config& config);
 
   virtual
   ~Semaphore();
-  
+
+  // Blocks until the semaphore is above 0 and takes one.
+  // Lock(), TryLock() and Release() throw UNDO_TABLE_FULL when maxProcesses
+  // live processes already have an entry on the semaphore.
   bool          Lock(int semNum = 0);
+  bool          TryLock(int semNum = 0);
   bool          Release(int semNum = 0);
-  
+
+  int           GetValue(int semNum = 0) const;
+
   // When set to destroy, Semaphore will be delete when desctructor is called. (Semaphore is shared between processes and if not set to destroy, Semaphore will continue.)
   void          SetToDestroySemOnDelete();
-   
+
   // #DEPRECATED: use SetToDestroySemOnDelete
   int           DestroySem();
-  
-  // Test Functions
-  void          _PrintKey();
-  void          _PrintSemId();
+
 protected:
 private:
+  static const uint64_t MAGIC = 0x4c494f53454d3032ULL; // "LIOSEM02"
+  static const pid_t RECOVERING = -1;
+  // Bits of the value word above the value name the entry in flight.
+  static const int      IN_FLIGHT_SHIFT = 24;
+  static const uint32_t VALUE_MASK = (1U << IN_FLIGHT_SHIFT) - 1;
+
+  enum State : uint32_t {
+    EMPTY,
+    INITIALIZING,
+    READY
+  };
+
+  struct alignas(64) Header {
+    std::atomic<uint32_t> state;
+    uint32_t      semCount;
+    uint64_t      magic;
+    uint32_t      maxProcesses;
+  };
+
+  // Units a process holds and the change it is making to them. Given back
+  // when it dies.
+  struct UndoEntry {
+    std::atomic<pid_t>    pid;
+    std::atomic<uint64_t> counts; // Held count in the low half, pending change in the high.
+  };
+
+  // Followed by maxProcesses UndoEntry. See getUndoTable().
+  struct alignas(64) Sem {
+    std::atomic<uint32_t> value;
+    std::atomic<uint32_t> numWaiters;
+  };
+
   Config        config_;
 
   key_t         semKey_;
 
-  int           semId_;
-  
+  std::unique_ptr<SharedMemory> shm_;
+  Header*       header_;
+  Sem*          sems_;
+  size_t        semSize_; // Sem and its undo table, rounded up to alignof(Sem).
+
   bool          isSetToDestroySem_;
 
-   
-  // Initiate Semaphores
-  int           initSem();
+  Sem&          getSem(int semNum) const;
+  UndoEntry*    getUndoTable(Sem& sem) const;
 
-  void          createSem();
+  void          initSem();
   void          loadSem();
-  
+
+  // Adds count to the value and to the entry of this process. False if
+  // the value would go below 0 or above VALUE_MASK.
+  bool          change(Sem& sem, int32_t count);
+  void          lockContended(Sem& sem);
+  // Entry of this process. Throws UNDO_TABLE_FULL if the table is full.
+  UndoEntry&    getUndo(Sem& sem);
+  // Gives back the units of dead processes. True if there were any.
+  bool          recoverDead(Sem& sem);
+  void          wake(Sem& sem, int numWaiters);
 };
 
 }
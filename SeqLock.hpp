@@ -0,0 +1,132 @@
+#ifndef _SEQLOCK_HPP_
+#define _SEQLOCK_HPP_
+/*
+  Name
+    SeqLock
+
+  Description
+    Sequence lock for small trivially copyable values, such as a config
+    struct or counters read together.
+
+    Load() never writes shared memory. It copies the value between two
+    reads of a sequence number, and copies again if a Store() ran in
+    between. Readers cost a copy and scale with any number of threads,
+    where a mutex or RW lock bounces its cache line between them.
+
+    Store() makes the sequence odd, writes and makes it even again.
+    Writers are serialized by a Mutex. Keep values small. A reader
+    retries as long as writes keep coming.
+
+    The value is kept as relaxed atomic words, so a torn copy is never
+    a data race and never returned.
+
+  Last Modified Date
+    Oct 19, 2026
+
+  History
+    October 19, 2026
+      Created
+
+  ToDos
+
+
+
+  Milestones
+    1.0
+
+
+  Learning Resources
+    Can Seqlocks Get Along With Programming Language Memory Models?
+      http://www.hpl.hp.com/techreports/2012/HPL-2012-68.pdf
+
+  Copyright (c) All rights reserved to LIFEINO.
+*/
+
+#ifdef _DEBUG
+  #undef _DEBUG
+#endif
+#define _DEBUG false
+
+#include "liolib/Debug.hpp"
+
+#include <atomic>
+#include <mutex> // lock_guard
+#include <type_traits>
+
+#include <cstdint>
+#include <cstring> // memcpy()
+
+#include "liolib/Mutex.hpp"
+
+namespace lio {
+
+
+template <typename T>
+class SeqLock {
+  static_assert(std::is_trivially_copyable<T>::value,
+                "SeqLock copies values word by word.");
+public:
+  SeqLock(const T& value = T()) : sequence_(0) {
+    this->write(value);
+  }
+
+  T               Load() const {
+    uint64_t words[NUM_WORDS];
+    uint32_t sequence = 0;
+    do {
+      sequence = this->sequence_.load(std::memory_order_acquire);
+      while (sequence & 1) {
+        sequence = this->sequence_.load(std::memory_order_acquire);
+      }
+      for (size_t i = 0; NUM_WORDS > i; ++i) {
+        words[i] = this->words_[i].load(std::memory_order_relaxed);
+      }
+      std::atomic_thread_fence(std::memory_order_acquire);
+    } while (this->sequence_.load(std::memory_order_relaxed) != sequence);
+
+    T value;
+    memcpy(&value, words, sizeof(T));
+    return value;
+  }
+
+  void            Store(const T& value) {
+    std::lock_guard<Mutex> lock(this->writerMutex_);
+    this->write(value);
+  }
+
+  // Read, modify and store, with no other Store() in between.
+  template <typename Modify>
+  void            Update(Modify modify) {
+    std::lock_guard<Mutex> lock(this->writerMutex_);
+    T value = this->Load();
+    modify(value);
+    this->write(value);
+  }
+
+private:
+  static const size_t NUM_WORDS = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+  std::atomic<uint32_t> sequence_;
+  std::atomic<uint64_t> words_[NUM_WORDS];
+  Mutex           writerMutex_;
+
+  void            write(const T& value) {
+    uint64_t words[NUM_WORDS] = { };
+    memcpy(words, &value, sizeof(T));
+
+    const uint32_t sequence = this->sequence_.load(std::memory_order_relaxed);
+    this->sequence_.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (size_t i = 0; NUM_WORDS > i; ++i) {
+      this->words_[i].store(words[i], std::memory_order_relaxed);
+    }
+    this->sequence_.store(sequence + 2, std::memory_order_release);
+  }
+
+  SeqLock(const SeqLock&) = delete;
+  SeqLock& operator=(const SeqLock&) = delete;
+};
+
+}
+
+#endif
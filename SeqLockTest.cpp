@@ -0,0 +1,147 @@
+#include "SeqLock.hpp"
+
+#define _UNIT_TEST false
+#include "liolib/Test.hpp"
+
+
+namespace lio {
+
+}
+
+#if _UNIT_TEST
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace lio;
+using std::string;
+
+namespace {
+
+// Writers keep all fields equal.
+struct Snapshot {
+  uint64_t      version;
+  uint32_t      numRoutes;
+  uint16_t      port;
+  uint8_t       flags[10];
+};
+
+Snapshot makeSnapshot(uint64_t n) {
+  Snapshot snapshot;
+  snapshot.version = n;
+  snapshot.numRoutes = (uint32_t) n;
+  snapshot.port = (uint16_t) n;
+  memset(snapshot.flags, (uint8_t) n, sizeof(snapshot.flags));
+  return snapshot;
+}
+
+bool isConsistent(const Snapshot& snapshot) {
+  for (size_t i = 0; sizeof(snapshot.flags) > i; ++i) {
+    if (snapshot.flags[i] != (uint8_t) snapshot.version) {
+      return false;
+    }
+  }
+  return snapshot.numRoutes == (uint32_t) snapshot.version &&
+         snapshot.port == (uint16_t) snapshot.version;
+}
+
+thread_local uint64_t readSum = 0;
+
+}
+
+TEST(SeqLockTest, Basic) {
+  SeqLock<Snapshot> lock(makeSnapshot(7));
+  EXPECT_EQ(7, lock.Load().version);
+
+  lock.Store(makeSnapshot(8));
+  EXPECT_TRUE(isConsistent(lock.Load()));
+  EXPECT_EQ(8, lock.Load().version);
+
+  lock.Update([](Snapshot& snapshot) { snapshot = makeSnapshot(snapshot.version + 1); });
+  EXPECT_EQ(9, lock.Load().version);
+
+  SeqLock<uint8_t> small;
+  EXPECT_EQ(0, small.Load());
+  small.Store(200);
+  EXPECT_EQ(200, small.Load());
+}
+
+TEST(SeqLockTest, Threads) {
+  SeqLock<Snapshot> lock(makeSnapshot(0));
+  std::atomic<bool> isDone(false);
+  std::atomic<size_t> numTorn(0);
+
+  std::vector<std::thread> readers;
+  for (size_t i = 0; 4 > i; ++i) {
+    readers.emplace_back([&] {
+      uint64_t lastVersion = 0;
+      while (isDone == false) {
+        const Snapshot snapshot = lock.Load();
+        if (isConsistent(snapshot) == false || snapshot.version < lastVersion) {
+          ++numTorn;
+        }
+        lastVersion = snapshot.version;
+      }
+    });
+  }
+  std::vector<std::thread> writers;
+  for (size_t i = 0; 2 > i; ++i) {
+    writers.emplace_back([&] {
+      for (size_t j = 0; 100 * 1000 > j; ++j) {
+        lock.Update([](Snapshot& snapshot) { snapshot = makeSnapshot(snapshot.version + 1); });
+      }
+    });
+  }
+  for (std::thread& writer : writers) {
+    writer.join();
+  }
+  isDone = true;
+  for (std::thread& reader : readers) {
+    reader.join();
+  }
+  EXPECT_EQ(0, numTorn);
+  EXPECT_EQ(200 * 1000, lock.Load().version);
+}
+
+TEST(SeqLockTest, Benchmark) {
+  PERFTEST {
+    SeqLock<Snapshot> lock(makeSnapshot(1));
+    std::mutex mutex;
+    Snapshot snapshot = makeSnapshot(1);
+
+    const size_t numCalls = 10 * 1000 * 1000;
+    for (size_t numThreads : { 1, 2, 4, 8 }) {
+      std::cout << numThreads << " reader(s)" << endl;
+      lio::Test::Measure("  SeqLock::Load", numThreads, numCalls / numThreads, [&](size_t) {
+        readSum += lock.Load().version;
+      });
+      lio::Test::Measure("  std::mutex and copy", numThreads, numCalls / numThreads,
+                         [&](size_t) {
+        std::lock_guard<std::mutex> guard(mutex);
+        readSum += snapshot.version;
+      });
+    }
+    std::cout << "1 writer" << endl;
+    lio::Test::Measure("  SeqLock::Store", 1, numCalls / 10, [&](size_t) {
+      lock.Store(snapshot);
+    });
+  }
+}
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleMock(&argc, argv);
+  return RUN_ALL_TESTS();
+}
+
+#else
+// Executable File's Main Comes here.
+
+
+#endif
+
+#undef _UNIT_TEST
@@ -11,7 +11,11 @@
     Shared Memory
 
   Last Modified Date
-    Mar 2, 2013
+    Oct 19, 2026
+
+  History
+    October 19, 2026
+      Debug output off. Tools on SharedMemory print to stdout.
 
   Learning Resources
     Tutorial
@@ -29,7 +33,7 @@
 #ifdef _DEBUG
   #undef _DEBUG
 #endif
-#define _DEBUG true
+#define _DEBUG false
 
 #include "Debug.hpp"
 
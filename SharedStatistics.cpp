@@ -0,0 +1,529 @@
+#include "SharedStatistics.hpp"
+
+#define _UNIT_TEST false
+#include "liolib/Test.hpp"
+
+#include <algorithm> // max()
+
+#include <cerrno>
+#include <cstdlib> // atoi()
+#include <cstring> // strncpy(), strncmp()
+
+#include <sched.h> // sched_yield()
+#include <signal.h> // kill()
+
+namespace lio {
+
+// ===== Exception Implementation =====
+const char* const
+SharedStatistics::Exception::exceptionMessages_[] = {
+  SHAREDSTATISTICS_EXCEPTION_MESSAGES
+};
+#undef SHAREDSTATISTICS_EXCEPTION_MESSAGES
+
+SharedStatistics::Exception::Exception(ExceptionType exceptionType) :
+  exceptionType_(exceptionType) { }
+
+const char*
+SharedStatistics::Exception::what() const noexcept {
+  return this->exceptionMessages_[(int) this->exceptionType_];
+}
+
+const SharedStatistics::ExceptionType
+SharedStatistics::Exception::type() const noexcept {
+  return this->exceptionType_;
+}
+// ===== Exception Implementation End =====
+
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2,
+              "Values in shared memory have to be lock free atomics.");
+
+static std::atomic<uint64_t> unusedValues[Statistics::NUM_BUCKETS + 2];
+std::atomic<uint64_t>* SharedStatistics::unused_ = unusedValues;
+
+
+void SharedStatistics::Histogram::Record(uint64_t value) const {
+  std::atomic<uint64_t>* values = *this->values_ + this->index_;
+  SharedStatistics::add(values[Statistics::GetBucket(value)], 1);
+  SharedStatistics::add(values[Statistics::NUM_BUCKETS], value);
+  std::atomic<uint64_t>& max = values[Statistics::NUM_BUCKETS + 1];
+  if (value > max.load(std::memory_order_relaxed)) {
+    max.store(value, std::memory_order_relaxed);
+  }
+}
+
+
+SharedStatistics::SharedStatistics(const Config& config) :
+  shm_(SharedStatistics::getShmConfig(config)),
+  header_(static_cast<Header*>(const_cast<void*>(this->shm_.GetShmAddress()))),
+  slots_(reinterpret_cast<char*>(this->header_) + sizeof(Header)),
+  numValues_(0),
+  values_(nullptr),
+  pid_(0),
+  slot_(nullptr)
+{
+  uint32_t state = EMPTY;
+  if (config.mode != SharedMemory::Mode::LOAD &&
+      this->header_->state.compare_exchange_strong(state, INITIALIZING) == true)
+  {
+    this->initHeader(config);
+  } else {
+    // Another process is writing the header. Only at attach time.
+    for (size_t i = 0; 100000 > i && state != READY; ++i) {
+      sched_yield();
+      state = this->header_->state.load(std::memory_order_acquire);
+    }
+    if (state != READY || this->header_->magic != MAGIC) {
+      throw Exception(ExceptionType::BAD_SEGMENT);
+    }
+    if (config.mode != SharedMemory::Mode::LOAD) {
+      this->checkHeader(config);
+    }
+  }
+
+  this->numValues_ = this->header_->numCounters +
+                     this->header_->numHistograms * HISTOGRAM_VALUES;
+  this->scratch_.reset(new std::atomic<uint64_t>[this->numValues_]());
+  this->values_ = this->scratch_.get();
+}
+
+SharedStatistics::~SharedStatistics() {
+  this->Leave();
+}
+
+void SharedStatistics::Join() {
+  const pid_t self = getpid();
+  if (this->slot_ != nullptr && this->pid_ == self) {
+    return;
+  }
+  // A slot copied over fork belongs to the parent.
+  this->slot_ = nullptr;
+  this->values_ = this->scratch_.get();
+
+  for (uint32_t i = 0; this->header_->maxWorkers > i; ++i) {
+    if (this->claimSlot(this->getSlot(i), 0) == true) {
+      return;
+    }
+  }
+  for (uint32_t i = 0; this->header_->maxWorkers > i; ++i) {
+    SlotHeader* slot = this->getSlot(i);
+    const pid_t owner = slot->pid.load(std::memory_order_relaxed);
+    if (kill(owner, 0) == -1 && errno == ESRCH &&
+        this->claimSlot(slot, owner) == true)
+    {
+      LOG_info << "Took over the slot of dead worker " << owner << "." << endl;
+      return;
+    }
+  }
+  throw Exception(ExceptionType::NO_FREE_SLOT);
+}
+
+void SharedStatistics::Leave() {
+  if (this->slot_ == nullptr || this->pid_ != getpid()) {
+    return;
+  }
+  this->slot_->pid.store(0, std::memory_order_release);
+  this->slot_ = nullptr;
+  this->values_ = this->scratch_.get();
+}
+
+SharedStatistics::Counter SharedStatistics::GetCounter(const string& name) const {
+  const uint32_t index = this->findMetric(name, 0, this->header_->numCounters);
+  return Counter(&this->values_, index);
+}
+
+SharedStatistics::Histogram SharedStatistics::GetHistogram(const string& name) const {
+  const uint32_t numCounters = this->header_->numCounters;
+  const uint32_t index = this->findMetric(name, numCounters,
+                                          numCounters + this->header_->numHistograms);
+  return Histogram(&this->values_, numCounters + (index - numCounters) * HISTOGRAM_VALUES);
+}
+
+std::vector<Statistics::Sample> SharedStatistics::Snapshot() const {
+  const uint32_t numCounters = this->header_->numCounters;
+  const uint32_t numHistograms = this->header_->numHistograms;
+  std::vector<Statistics::Sample> samples(numCounters + numHistograms);
+
+  for (uint32_t i = 0; samples.size() > i; ++i) {
+    Statistics::Sample& sample = samples[i];
+    sample.name = this->header_->names[i];
+    sample.value = 0;
+    if (numCounters > i) {
+      sample.kind = Statistics::Kind::COUNTER;
+    } else {
+      sample.kind = Statistics::Kind::HISTOGRAM;
+      sample.histogram.buckets.assign(Statistics::NUM_BUCKETS, 0);
+    }
+  }
+
+  for (uint32_t i = 0; this->header_->maxWorkers > i; ++i) {
+    const std::atomic<uint64_t>* values = this->getValues(this->getSlot(i));
+    for (uint32_t j = 0; numCounters > j; ++j) {
+      samples[j].value += values[j].load(std::memory_order_relaxed);
+    }
+    for (uint32_t j = 0; numHistograms > j; ++j) {
+      const std::atomic<uint64_t>* histogramValues =
+          values + numCounters + j * HISTOGRAM_VALUES;
+      Statistics::HistogramSnapshot& histogram = samples[numCounters + j].histogram;
+      for (size_t k = 0; Statistics::NUM_BUCKETS > k; ++k) {
+        const uint64_t count = histogramValues[k].load(std::memory_order_relaxed);
+        histogram.buckets[k] += count;
+        histogram.count += count;
+      }
+      histogram.sum += histogramValues[Statistics::NUM_BUCKETS].load(std::memory_order_relaxed);
+      histogram.max = std::max(histogram.max,
+          histogramValues[Statistics::NUM_BUCKETS + 1].load(std::memory_order_relaxed));
+    }
+  }
+  return samples;
+}
+
+std::vector<pid_t> SharedStatistics::GetWorkers() const {
+  std::vector<pid_t> workers;
+  for (uint32_t i = 0; this->header_->maxWorkers > i; ++i) {
+    const pid_t owner = this->getSlot(i)->pid.load(std::memory_order_relaxed);
+    if (owner != 0 && (kill(owner, 0) == 0 || errno != ESRCH)) {
+      workers.push_back(owner);
+    }
+  }
+  return workers;
+}
+
+void SharedStatistics::SetToRemoveOnDelete() {
+  this->shm_.SetToRemoveOnDelete();
+}
+
+
+// ***************** Private Functions *********************
+
+SharedMemory::Config SharedStatistics::getShmConfig(const Config& config) {
+  SharedMemory::Config shmConfig;
+  shmConfig.key = config.key;
+  shmConfig.mode = config.mode;
+  shmConfig.permission = config.permission;
+  shmConfig.size = sizeof(Header);
+  if (config.mode == SharedMemory::Mode::LOAD) {
+    return shmConfig;
+  }
+
+  const size_t numMetrics = config.counters.size() + config.histograms.size();
+  if (numMetrics > MAX_METRICS) {
+    throw Exception(ExceptionType::TOO_MANY_METRICS);
+  }
+  for (const std::vector<string>* names : { &config.counters, &config.histograms }) {
+    for (const string& name : *names) {
+      if (name.size() >= NAME_LENGTH) {
+        throw Exception(ExceptionType::NAME_TOO_LONG);
+      }
+    }
+  }
+  const size_t numValues = config.counters.size() +
+                           config.histograms.size() * HISTOGRAM_VALUES;
+  shmConfig.size += config.maxWorkers * SharedStatistics::getSlotSize(numValues);
+  return shmConfig;
+}
+
+size_t SharedStatistics::getSlotSize(size_t numValues) {
+  const size_t size = sizeof(SlotHeader) + numValues * sizeof(uint64_t);
+  return (size + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE * CACHE_LINE_SIZE;
+}
+
+void SharedStatistics::initHeader(const Config& config) {
+  Header* header = this->header_;
+  header->maxWorkers = config.maxWorkers;
+  header->numCounters = config.counters.size();
+  header->numHistograms = config.histograms.size();
+  header->slotSize = SharedStatistics::getSlotSize(
+      config.counters.size() + config.histograms.size() * HISTOGRAM_VALUES);
+
+  uint32_t index = 0;
+  for (const std::vector<string>* names : { &config.counters, &config.histograms }) {
+    for (const string& name : *names) {
+      strncpy(header->names[index++], name.c_str(), NAME_LENGTH);
+    }
+  }
+  header->magic = MAGIC;
+  header->state.store(READY, std::memory_order_release);
+}
+
+void SharedStatistics::checkHeader(const Config& config) const {
+  const Header* header = this->header_;
+  if (header->maxWorkers != config.maxWorkers ||
+      header->numCounters != config.counters.size() ||
+      header->numHistograms != config.histograms.size())
+  {
+    throw Exception(ExceptionType::LAYOUT_MISMATCH);
+  }
+  uint32_t index = 0;
+  for (const std::vector<string>* names : { &config.counters, &config.histograms }) {
+    for (const string& name : *names) {
+      if (strncmp(header->names[index++], name.c_str(), NAME_LENGTH) != 0) {
+        throw Exception(ExceptionType::LAYOUT_MISMATCH);
+      }
+    }
+  }
+}
+
+uint32_t SharedStatistics::findMetric(const string& name, uint32_t begin, uint32_t end) const {
+  for (uint32_t i = begin; end > i; ++i) {
+    if (strncmp(this->header_->names[i], name.c_str(), NAME_LENGTH) == 0) {
+      return i;
+    }
+  }
+  throw Exception(ExceptionType::NOT_FOUND);
+}
+
+SharedStatistics::SlotHeader* SharedStatistics::getSlot(uint32_t index) const {
+  return reinterpret_cast<SlotHeader*>(this->slots_ + index * this->header_->slotSize);
+}
+
+std::atomic<uint64_t>* SharedStatistics::getValues(SlotHeader* slot) const {
+  return reinterpret_cast<std::atomic<uint64_t>*>(slot + 1);
+}
+
+bool SharedStatistics::claimSlot(SlotHeader* slot, pid_t owner) {
+  const pid_t self = getpid();
+  if (slot->pid.compare_exchange_strong(owner, self, std::memory_order_acquire) == false) {
+    return false;
+  }
+  this->slot_ = slot;
+  this->pid_ = self;
+  this->values_ = this->getValues(slot);
+  return true;
+}
+
+}
+
+#if _UNIT_TEST
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include <fstream>
+
+#include <sys/wait.h> // waitpid()
+
+using namespace lio;
+using std::string;
+
+namespace {
+
+SharedStatistics::Config getTestConfig() {
+  SharedStatistics::Config config;
+  config.key = IPC_PRIVATE;
+  config.mode = SharedMemory::Mode::CREATE;
+  config.maxWorkers = 4;
+  config.counters = { "requests_total", "bytes_total" };
+  config.histograms = { "latency_ns" };
+  return config;
+}
+
+// Runs work in numWorkers forked children and waits for them.
+template<typename Work>
+void runWorkers(size_t numWorkers, Work work) {
+  std::vector<pid_t> pids;
+  for (size_t i = 0; numWorkers > i; ++i) {
+    const pid_t pid = fork();
+    if (pid == 0) {
+      int status = 0;
+      try {
+        work(i);
+      } catch (...) {
+        status = 1;
+      }
+      _exit(status);
+    }
+    pids.push_back(pid);
+  }
+  for (pid_t pid : pids) {
+    int status = -1;
+    waitpid(pid, &status, 0);
+    EXPECT_EQ(WEXITSTATUS(status), 0);
+  }
+}
+
+}
+
+TEST(SharedStatisticsTest, Layout) {
+  SharedStatistics stats(getTestConfig());
+  stats.SetToRemoveOnDelete();
+
+  EXPECT_THROW(stats.GetCounter("latency_ns"), SharedStatistics::Exception);
+  EXPECT_THROW(stats.GetHistogram("missing"), SharedStatistics::Exception);
+
+  SharedStatistics::Counter requests = stats.GetCounter("requests_total");
+  SharedStatistics::Counter bytes = stats.GetCounter("bytes_total");
+  SharedStatistics::Histogram latency = stats.GetHistogram("latency_ns");
+
+  // Not joined yet.
+  requests.Add();
+  SharedStatistics::Counter unbound;
+  unbound.Add();
+  SharedStatistics::Histogram unboundHistogram;
+  unboundHistogram.Record(1000);
+  EXPECT_EQ(stats.Snapshot()[0].value, 0);
+
+  stats.Join();
+  requests.Add();
+  bytes.Add(1500);
+  latency.Record(100);
+  latency.Record(300);
+
+  std::vector<Statistics::Sample> samples = stats.Snapshot();
+  ASSERT_EQ(samples.size(), 3);
+  EXPECT_EQ(samples[0].name, "requests_total");
+  EXPECT_EQ(samples[0].value, 1);
+  EXPECT_EQ(samples[1].value, 1500);
+  EXPECT_EQ(samples[2].kind, Statistics::Kind::HISTOGRAM);
+  EXPECT_EQ(samples[2].histogram.count, 2);
+  EXPECT_EQ(samples[2].histogram.sum, 400);
+  EXPECT_EQ(samples[2].histogram.max, 300);
+  EXPECT_EQ(stats.GetWorkers(), std::vector<pid_t>{ getpid() });
+
+  stats.Leave();
+  EXPECT_EQ(stats.GetWorkers().size(), 0);
+  EXPECT_EQ(stats.Snapshot()[0].value, 1);
+
+  SharedStatistics::Config config = getTestConfig();
+  config.counters.resize(SharedStatistics::MAX_METRICS);
+  EXPECT_THROW(SharedStatistics tooMany(config), SharedStatistics::Exception);
+  config = getTestConfig();
+  config.counters.push_back(string(SharedStatistics::NAME_LENGTH, 'a'));
+  EXPECT_THROW(SharedStatistics tooLong(config), SharedStatistics::Exception);
+}
+
+TEST(SharedStatisticsTest, Workers) {
+  SharedStatistics stats(getTestConfig());
+  stats.SetToRemoveOnDelete();
+  SharedStatistics::Counter requests = stats.GetCounter("requests_total");
+  SharedStatistics::Histogram latency = stats.GetHistogram("latency_ns");
+  const size_t numAdds = 100000;
+
+  // Second round takes over the slots of the dead first round.
+  for (size_t round = 0; 2 > round; ++round) {
+    runWorkers(4, [&](size_t worker) {
+      stats.Join();
+      for (size_t i = 0; numAdds > i; ++i) {
+        requests.Add();
+        latency.Record(worker * 1000 + i % 100);
+      }
+    });
+  }
+  EXPECT_EQ(stats.GetWorkers().size(), 0);
+
+  std::vector<Statistics::Sample> samples = stats.Snapshot();
+  EXPECT_EQ(samples[0].value, 2 * 4 * numAdds);
+  EXPECT_EQ(samples[2].histogram.count, 2 * 4 * numAdds);
+  EXPECT_EQ(samples[2].histogram.max, 3099);
+
+  // All slots are held by live processes.
+  int pipeFds[2];
+  ASSERT_EQ(pipe(pipeFds), 0);
+  std::vector<pid_t> holders;
+  for (size_t i = 0; 4 > i; ++i) {
+    const pid_t pid = fork();
+    if (pid == 0) {
+      close(pipeFds[1]);
+      stats.Join();
+      char c;
+      read(pipeFds[0], &c, 1);
+      _exit(0);
+    }
+    holders.push_back(pid);
+  }
+  while (stats.GetWorkers().size() < 4) {
+    sched_yield();
+  }
+  EXPECT_THROW(stats.Join(), SharedStatistics::Exception);
+  close(pipeFds[1]);
+  for (pid_t pid : holders) {
+    waitpid(pid, nullptr, 0);
+  }
+  close(pipeFds[0]);
+}
+
+TEST(SharedStatisticsTest, Reader) {
+  const string keyFile = "/tmp/SharedStatisticsTest.key";
+  std::ofstream(keyFile).close();
+
+  SharedStatistics::Config config = getTestConfig();
+  config.key = SharedMemory::GenerateKey(keyFile);
+  config.mode = SharedMemory::Mode::AUTO;
+  SharedStatistics master(config);
+  master.SetToRemoveOnDelete();
+
+  runWorkers(2, [&master](size_t) {
+    master.Join();
+    master.GetCounter("bytes_total").Add(10);
+    master.GetHistogram("latency_ns").Record(5000);
+  });
+
+  // A worker restarted with the same config attaches to the segment.
+  SharedStatistics again(config);
+  config.maxWorkers = 8;
+  EXPECT_THROW(SharedStatistics mismatch(config), SharedStatistics::Exception);
+
+  SharedStatistics::Config readerConfig;
+  readerConfig.key = config.key;
+  readerConfig.mode = SharedMemory::Mode::LOAD;
+  SharedStatistics reader(readerConfig);
+  const string text = Statistics::ToText(reader.Snapshot());
+  EXPECT_NE(text.find("# TYPE bytes_total counter\nbytes_total 20\n"), string::npos);
+  EXPECT_NE(text.find("latency_ns_count 2\n"), string::npos);
+  EXPECT_NE(text.find("latency_ns_sum 10000\n"), string::npos);
+
+  unlink(keyFile.c_str());
+}
+
+TEST(SharedStatisticsTest, Benchmark) {
+  PERFTEST {
+    SharedStatistics stats(getTestConfig());
+    stats.SetToRemoveOnDelete();
+    stats.Join();
+    SharedStatistics::Counter requests = stats.GetCounter("requests_total");
+    SharedStatistics::Histogram latency = stats.GetHistogram("latency_ns");
+
+    lio::Test::Measure("Counter::Add()", 1, 100 * 1000 * 1000, [&requests](size_t) {
+      requests.Add();
+    });
+    lio::Test::Measure("Histogram::Record()", 1, 100 * 1000 * 1000, [&latency](size_t i) {
+      latency.Record(i & 0xFFFF);
+    });
+    lio::Test::Measure("Snapshot(), 4 slots", 1, 1000, [&stats](size_t) { stats.Snapshot(); });
+  }
+}
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleMock(&argc, argv);
+  return RUN_ALL_TESTS();
+}
+
+#else
+// Executable File's Main Comes here.
+// Reader tool. Prints the sums of all workers in Prometheus text format.
+
+using namespace lio;
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    std::cerr << "Usage: " << argv[0] << " <keyFile> [projId]" << endl;
+    return 1;
+  }
+
+  SharedStatistics::Config config;
+  config.key = SharedMemory::GenerateKey(argv[1], argc > 2 ? atoi(argv[2]) : 1);
+  config.mode = SharedMemory::Mode::LOAD;
+  try {
+    SharedStatistics stats(config);
+    std::cout << "# workers " << stats.GetWorkers().size() << "\n"
+              << Statistics::ToText(stats.Snapshot());
+  } catch (std::exception& ex) {
+    std::cerr << ex.what() << endl;
+    return 1;
+  }
+  return 0;
+}
+
+#endif
+
+#undef _UNIT_TEST
@@ -0,0 +1,244 @@
+#ifndef _SHAREDSTATISTICS_HPP_
+#define _SHAREDSTATISTICS_HPP_
+/*
+  Name
+    SharedStatistics
+
+  Description
+    Counters and histograms of prefork workers in a SharedMemory segment.
+
+    The master creates the segment with the names of its metrics before
+    forking. Every worker calls Join() after fork and gets a slot of its
+    own, aligned to cache lines. Workers update their slot with relaxed
+    loads and stores and never take a lock. A reader attaches to the same
+    key, reads the names from the segment header and sums the slots. It
+    only loads, so it never stalls a worker.
+
+    A slot of a dead worker is taken by the next worker that joins. Its
+    values are kept, so totals stay monotonic over worker restarts.
+
+    Histograms use the buckets of Statistics and Snapshot() gives
+    Statistics::Sample, so Statistics::ToText() prints the segment too.
+
+    Run as an executable, it is the reader tool.
+      SharedStatistics <keyFile> [projId]
+
+  Last Modified Date
+    Oct 19, 2026
+
+  History
+    October 19, 2026
+      Created
+
+  ToDos
+
+
+
+  Milestones
+    1.0
+
+
+  Learning Resources
+    shmget
+      http://linux.die.net/man/2/shmget
+
+  Copyright (c) All rights reserved to LIFEINO.
+*/
+
+#ifdef _DEBUG
+  #undef _DEBUG
+#endif
+#define _DEBUG false
+
+#include "liolib/Debug.hpp"
+
+#include <atomic>
+#include <memory> // unique_ptr
+#include <string>
+#include <vector>
+
+#include <cstdint>
+
+#include <sys/types.h> // key_t, pid_t
+
+#include "liolib/SharedMemory.hpp"
+#include "liolib/Statistics.hpp"
+
+namespace lio {
+
+using std::string;
+
+
+class SharedStatistics {
+public:
+
+// ******** Exception Declaration *********
+enum class ExceptionType : std::uint8_t {
+  GENERAL,
+  BAD_SEGMENT,
+  LAYOUT_MISMATCH,
+  TOO_MANY_METRICS,
+  NAME_TOO_LONG,
+  NOT_FOUND,
+  NO_FREE_SLOT
+};
+#define SHAREDSTATISTICS_EXCEPTION_MESSAGES \
+  "SharedStatistics Exception has been thrown.", \
+  "Segment is not a SharedStatistics segment.", \
+  "Segment has other metrics or number of workers.", \
+  "Too many metrics for a segment.", \
+  "Metric name is too long.", \
+  "Metric is not in the segment.", \
+  "All worker slots are taken by live processes."
+
+class Exception : public std::exception {
+public:
+  Exception (ExceptionType exceptionType = ExceptionType::GENERAL);
+
+  virtual const char*         what() const noexcept;
+  virtual const               ExceptionType type() const noexcept;
+
+private:
+  const ExceptionType         exceptionType_;
+  static const char* const    exceptionMessages_[];
+};
+// ******** Exception Declaration END*********
+
+  static const uint32_t MAX_METRICS = 64;
+  static const size_t NAME_LENGTH = 64; // With the terminating NUL.
+  static const size_t CACHE_LINE_SIZE = 64;
+
+  struct Config {
+    Config() :
+      key(0),
+      mode(SharedMemory::Mode::AUTO),
+      permission(0640),
+      maxWorkers(64) { }
+
+    key_t               key;
+    SharedMemory::Mode  mode;
+    int                 permission;
+
+    // Ignored on LOAD, read from the segment.
+    uint32_t            maxWorkers;
+    std::vector<string> counters;
+    std::vector<string> histograms;
+  };
+
+  // Handles follow the slot of their SharedStatistics, also over Join().
+  class Counter {
+  public:
+    Counter() : values_(&SharedStatistics::unused_), index_(0) { }
+
+    void          Add(uint64_t value = 1) const {
+      SharedStatistics::add((*this->values_)[this->index_], value);
+    }
+
+  private:
+    friend class SharedStatistics;
+    Counter(std::atomic<uint64_t>* const* values, uint32_t index) :
+      values_(values), index_(index) { }
+    std::atomic<uint64_t>* const* values_;
+    uint32_t      index_;
+  };
+
+  class Histogram {
+  public:
+    Histogram() : values_(&SharedStatistics::unused_), index_(0) { }
+
+    void          Record(uint64_t value) const;
+
+  private:
+    friend class SharedStatistics;
+    Histogram(std::atomic<uint64_t>* const* values, uint32_t index) :
+      values_(values), index_(index) { }
+    std::atomic<uint64_t>* const* values_;
+    uint32_t      index_; // Buckets, then sum and max.
+  };
+
+  SharedStatistics(const Config& config);
+  ~SharedStatistics();
+
+  // Takes a slot for the calling process. Call it in each worker right
+  // after fork, before any Add(). Updates before Join() are dropped.
+  void            Join();
+  // Gives the slot back. Values stay in the totals.
+  void            Leave();
+
+  // Throws NOT_FOUND when the name was not given to the segment.
+  Counter         GetCounter(const string& name) const;
+  Histogram       GetHistogram(const string& name) const;
+
+  // Summed over all slots, counters then histograms.
+  std::vector<Statistics::Sample> Snapshot() const;
+  // Live processes holding a slot.
+  std::vector<pid_t> GetWorkers() const;
+
+  // Only in the master. A forked copy would remove the segment as well
+  // when it is destroyed.
+  void            SetToRemoveOnDelete();
+
+private:
+  static const uint64_t MAGIC = 0x4c494f5354415431ULL; // "LIOSTAT1"
+
+  enum State : uint32_t {
+    EMPTY,
+    INITIALIZING,
+    READY
+  };
+
+  struct alignas(CACHE_LINE_SIZE) Header {
+    std::atomic<uint32_t> state;
+    uint32_t      maxWorkers;
+    uint32_t      numCounters;
+    uint32_t      numHistograms;
+    uint64_t      magic;
+    uint64_t      slotSize;
+    char          names[MAX_METRICS][NAME_LENGTH];
+  };
+
+  struct alignas(CACHE_LINE_SIZE) SlotHeader {
+    std::atomic<pid_t> pid;
+  };
+
+  static const size_t HISTOGRAM_VALUES = Statistics::NUM_BUCKETS + 2;
+
+  // Values of default handles. Nobody reads them.
+  static std::atomic<uint64_t>* unused_;
+
+  SharedMemory    shm_;
+  Header*         header_;
+  char*           slots_;
+  size_t          numValues_;
+
+  std::atomic<uint64_t>* values_; // Of the joined slot, or scratch_.
+  pid_t           pid_;
+  SlotHeader*     slot_;
+  std::unique_ptr<std::atomic<uint64_t>[]> scratch_;
+
+  // Only the owner of a slot writes it. No lock prefix needed.
+  static
+  void            add(std::atomic<uint64_t>& value, uint64_t amount) {
+    value.store(value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+  }
+
+  static
+  SharedMemory::Config getShmConfig(const Config& config);
+  static
+  size_t          getSlotSize(size_t numValues);
+
+  void            initHeader(const Config& config);
+  void            checkHeader(const Config& config) const;
+  uint32_t        findMetric(const string& name, uint32_t begin, uint32_t end) const;
+
+  SlotHeader*     getSlot(uint32_t index) const;
+  std::atomic<uint64_t>* getValues(SlotHeader* slot) const;
+  bool            claimSlot(SlotHeader* slot, pid_t owner);
+
+  SharedStatistics(const SharedStatistics&) = delete;
+  SharedStatistics& operator=(const SharedStatistics&) = delete;
+};
+
+}
+
+#endif
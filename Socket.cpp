@@ -272,6 +272,7 @@ void Socket::ReportStatus() const {
 
 int Socket::Write(const void* dataLocation, size_t length) {
   DEPRECATED_FUNC("unspecified");
+  Trace::Span span("socket.write");
   if (this->sockStatus_ != SocketStatus::CONNECTED) {
     LOG_err << "Socket is not connected and tried to write.";
     return -1;
@@ -289,6 +290,7 @@ int Socket::Write(const void* dataLocation, size_t length) {
 
 int Socket::Write(const std::string& content) {
   DEPRECATED_FUNC("unspecified");
+  Trace::Span span("socket.write");
   if (this->sockStatus_ != SocketStatus::CONNECTED) {
     LOG_err << "Socket is not connected and tried to write.";
     return -1;
@@ -15,9 +15,11 @@
   History
     July 13, 2013
       Major Refactoring
+    October 19, 2026
+      Trace spans of Write().
 
   Last Modified Date
-    Sep 29, 2015
+    Oct 19, 2026
 
   Learning Resources
     NonBlocking Concept
@@ -82,6 +84,7 @@
 #include <fcntl.h> // fcntl()
 
 #include "liolib/Util.hpp" // String::ToUInt()
+#include "liolib/Trace.hpp"
 
 namespace lio {
 
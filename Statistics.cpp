@@ -3,10 +3,19 @@
 #define _UNIT_TEST false
 #include "liolib/Test.hpp"
 
+#include <algorithm> // max()
+#include <memory> // unique_ptr
+#include <mutex>
+#include <sstream> // ostringstream
+#include <unordered_map>
+
+#include <cmath> // ceil()
+#include <ctime> // clock_gettime()
+
 
 namespace lio {
 
-// ===== Exception Implementation ===== 
+// ===== Exception Implementation =====
 const char* const
 Statistics::Exception::exceptionMessages_[] = {
   STATISTICS_EXCEPTION_MESSAGES
@@ -26,31 +35,301 @@ const Statistics::ExceptionType
 Statistics::Exception::type() const noexcept {
   return this->exceptionType_;
 }
-// ===== Exception Implementation End ===== 
+// ===== Exception Implementation End =====
+
+
+struct Statistics::Metric {
+  string          name;
+  string          help;
+  Kind            kind;
+  uint32_t        slot; // First slot of COUNTER and HISTOGRAM.
+  std::atomic<int64_t> gauge;
+};
+
+struct Statistics::Registry {
+  // Default handles write the first slots, which are never read.
+  Registry() :
+    nextSlot(NUM_BUCKETS + 2)
+  { }
+
+  std::mutex      mutex;
+  std::vector<std::unique_ptr<Metric>> metrics;
+  std::unordered_map<string, Metric*> metricsByName;
+  std::vector<Shard*> shards; // All of them, in use or free.
+  std::vector<Shard*> freeShards;
+  uint32_t        nextSlot;
+};
+
+// Gives the shard back when its thread exits.
+struct Statistics::ShardOwner {
+  ShardOwner() :
+    shard(nullptr)
+  { }
+
+  ~ShardOwner() {
+    if (this->shard == nullptr) {
+      return;
+    }
+    Registry& registry = Statistics::getRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    registry.freeShards.push_back(this->shard);
+    Statistics::shard_ = nullptr;
+  }
+
+  Shard*          shard;
+};
+
+thread_local Statistics::Shard* Statistics::shard_ = nullptr;
+
+Statistics::Gauge::Gauge() {
+  static std::atomic<int64_t> unused(0);
+  this->value_ = &unused;
+}
+
+uint64_t Statistics::Counter::Get() const {
+  Registry& registry = Statistics::getRegistry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  return Statistics::sumSlot(registry, this->slot_);
+}
+
+void Statistics::Histogram::Record(uint64_t value) const {
+  Statistics::add(this->slot_ + Statistics::GetBucket(value), 1);
+  Statistics::add(this->slot_ + NUM_BUCKETS, value);
+  std::atomic<uint64_t>& max = Statistics::getSlot(this->slot_ + NUM_BUCKETS + 1);
+  if (value > max.load(std::memory_order_relaxed)) {
+    max.store(value, std::memory_order_relaxed);
+  }
+}
+
+uint64_t Statistics::HistogramSnapshot::GetPercentile(double percentile) const {
+  if (this->count == 0) {
+    return 0;
+  }
+  uint64_t rank = std::ceil(percentile * this->count);
+  if (rank == 0) {
+    rank = 1;
+  }
+
+  uint64_t numValues = 0;
+  for (size_t i = 0; this->buckets.size() > i; ++i) {
+    numValues += this->buckets[i];
+    if (numValues >= rank) {
+      return std::min(Statistics::GetBucketUpperBound(i), this->max);
+    }
+  }
+  return this->max;
+}
+
+double Statistics::HistogramSnapshot::GetMean() const {
+  if (this->count == 0) {
+    return 0;
+  }
+  return (double) this->sum / this->count;
+}
+
+Statistics::Counter Statistics::GetCounter(const string& name, const string& help) {
+  return Counter(Statistics::registerMetric(name, help, Kind::COUNTER)->slot);
+}
+
+Statistics::Gauge Statistics::GetGauge(const string& name, const string& help) {
+  return Gauge(&Statistics::registerMetric(name, help, Kind::GAUGE)->gauge);
+}
+
+Statistics::Histogram Statistics::GetHistogram(const string& name, const string& help) {
+  return Histogram(Statistics::registerMetric(name, help, Kind::HISTOGRAM)->slot);
+}
+
+std::vector<Statistics::Sample> Statistics::Snapshot() {
+  Registry& registry = Statistics::getRegistry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  std::vector<Sample> samples(registry.metrics.size());
+  for (size_t i = 0; registry.metrics.size() > i; ++i) {
+    Statistics::fillSample(registry, *registry.metrics[i], samples[i]);
+  }
+  return samples;
+}
+
+bool Statistics::GetSample(const string& name, Sample& sample) {
+  Registry& registry = Statistics::getRegistry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  auto itr = registry.metricsByName.find(name);
+  if (itr == registry.metricsByName.end()) {
+    return false;
+  }
+  Statistics::fillSample(registry, *itr->second, sample);
+  return true;
+}
+
+string Statistics::ToText() {
+  return Statistics::ToText(Statistics::Snapshot());
+}
+
+string Statistics::ToText(const std::vector<Sample>& samples) {
+  static const double quantiles[] = { 0.5, 0.9, 0.99, 0.999 };
+
+  std::ostringstream text;
+  for (const Sample& sample : samples) {
+    if (sample.help.empty() == false) {
+      text << "# HELP " << sample.name << " " << sample.help << "\n";
+    }
+    switch (sample.kind) {
+      case Kind::COUNTER:
+        text << "# TYPE " << sample.name << " counter\n"
+             << sample.name << " " << (uint64_t) sample.value << "\n";
+        break;
+      case Kind::GAUGE:
+        text << "# TYPE " << sample.name << " gauge\n"
+             << sample.name << " " << sample.value << "\n";
+        break;
+      case Kind::HISTOGRAM:
+        text << "# TYPE " << sample.name << " summary\n";
+        for (double quantile : quantiles) {
+          text << sample.name << "{quantile=\"" << quantile << "\"} "
+               << sample.histogram.GetPercentile(quantile) << "\n";
+        }
+        text << sample.name << "_sum " << sample.histogram.sum << "\n"
+             << sample.name << "_count " << sample.histogram.count << "\n";
+        break;
+    }
+  }
+  return text.str();
+}
 
+uint64_t Statistics::GetBucketUpperBound(size_t bucket) {
+  if (bucket < (1 << SUB_BUCKET_BITS)) {
+    return bucket;
+  }
+  if (bucket >= NUM_BUCKETS - 1) {
+    return UINT64_MAX;
+  }
+  const size_t exponent = (bucket >> SUB_BUCKET_BITS) + SUB_BUCKET_BITS - 1;
+  const uint64_t subBucket = bucket & ((1 << SUB_BUCKET_BITS) - 1);
+  const size_t shift = exponent - SUB_BUCKET_BITS;
+  return (((1 << SUB_BUCKET_BITS) + subBucket + 1) << shift) - 1;
+}
 
-Statistics::Statistics() {
-  DEBUG_FUNC_START; // Prints out function name in yellow
+uint64_t Statistics::GetNanoseconds() {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint64_t) now.tv_sec * 1000 * 1000 * 1000 + now.tv_nsec;
+}
 
+Statistics::Registry& Statistics::getRegistry() {
+  // Never destroyed. Threads may exit after static destructors ran.
+  static Registry* registry = new Registry();
+  return *registry;
 }
 
-Statistics::~Statistics() {
-  DEBUG_FUNC_START;
+Statistics::Metric* Statistics::registerMetric(const string& name, const string& help,
+                                               Kind kind) {
+  Registry& registry = Statistics::getRegistry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  auto itr = registry.metricsByName.find(name);
+  if (itr != registry.metricsByName.end()) {
+    if (itr->second->kind != kind) {
+      throw Exception(ExceptionType::KIND_MISMATCH);
+    }
+    return itr->second;
+  }
+
+  size_t numSlots = 0;
+  if (kind == Kind::COUNTER) {
+    numSlots = 1;
+  } else if (kind == Kind::HISTOGRAM) {
+    numSlots = NUM_BUCKETS + 2;
+  }
+  if (registry.nextSlot + numSlots > PAGE_SLOTS * MAX_PAGES) {
+    throw Exception(ExceptionType::TOO_MANY_METRICS);
+  }
+
+  std::unique_ptr<Metric> metric(new Metric());
+  metric->name = name;
+  metric->help = help;
+  metric->kind = kind;
+  metric->slot = registry.nextSlot;
+  metric->gauge.store(0, std::memory_order_relaxed);
+  registry.nextSlot += numSlots;
 
+  Metric* registered = metric.get();
+  registry.metrics.push_back(std::move(metric));
+  registry.metricsByName[name] = registered;
+  return registered;
 }
 
-void Statistics::sampleFunc() {
-  DEBUG_POINT; // prints out LINE NUMBER and a messaage "POINT REACHED" in GREEN.
-  DEBUG_cout << "Prints out Debug message with Pid, FileName, and LineNumber in Blue" << endl;
-  DEBUG_cout << "This line is removed when _DEBUG is false." << endl;
-  
-  DEBUG_cerr << "Prints out error message in Red." << endl; 
-  DEBUG_cerr << "This line persists even if DEBUG mode is off. When Debug mode is on, it prints more information with color." << endl; 
+Statistics::Shard* Statistics::acquireShard() {
+  static thread_local ShardOwner owner;
 
-  DEBUG_clog << "Prints out log" << endl;
+  Registry& registry = Statistics::getRegistry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  Shard* shard = nullptr;
+  if (registry.freeShards.empty() == false) {
+    shard = registry.freeShards.back();
+    registry.freeShards.pop_back();
+  } else {
+    shard = new Shard();
+    registry.shards.push_back(shard);
+  }
+  owner.shard = shard;
+  Statistics::shard_ = shard;
+  return shard;
 }
 
-//Statistics::
+std::atomic<uint64_t>* Statistics::allocatePage(Shard* shard, size_t pageIndex) {
+  std::atomic<uint64_t>* page = new std::atomic<uint64_t>[PAGE_SLOTS];
+  for (size_t i = 0; PAGE_SLOTS > i; ++i) {
+    page[i].store(0, std::memory_order_relaxed);
+  }
+  shard->pages[pageIndex].store(page, std::memory_order_release);
+  return page;
+}
+
+uint64_t Statistics::sumSlot(const Registry& registry, uint32_t slot) {
+  uint64_t sum = 0;
+  for (const Shard* shard : registry.shards) {
+    const std::atomic<uint64_t>* page =
+        shard->pages[slot / PAGE_SLOTS].load(std::memory_order_acquire);
+    if (page != nullptr) {
+      sum += page[slot % PAGE_SLOTS].load(std::memory_order_relaxed);
+    }
+  }
+  return sum;
+}
+
+void Statistics::fillSample(const Registry& registry, const Metric& metric, Sample& sample) {
+  sample.name = metric.name;
+  sample.help = metric.help;
+  sample.kind = metric.kind;
+  sample.value = 0;
+  switch (metric.kind) {
+    case Kind::COUNTER:
+      sample.value = Statistics::sumSlot(registry, metric.slot);
+      break;
+    case Kind::GAUGE:
+      sample.value = metric.gauge.load(std::memory_order_relaxed);
+      break;
+    case Kind::HISTOGRAM: {
+      HistogramSnapshot& histogram = sample.histogram;
+      histogram.buckets.assign(NUM_BUCKETS, 0);
+      histogram.count = 0;
+      for (size_t i = 0; NUM_BUCKETS > i; ++i) {
+        histogram.buckets[i] = Statistics::sumSlot(registry, metric.slot + i);
+        histogram.count += histogram.buckets[i];
+      }
+      histogram.sum = Statistics::sumSlot(registry, metric.slot + NUM_BUCKETS);
+      histogram.max = 0;
+      const uint32_t maxSlot = metric.slot + NUM_BUCKETS + 1;
+      for (const Shard* shard : registry.shards) {
+        const std::atomic<uint64_t>* page =
+            shard->pages[maxSlot / PAGE_SLOTS].load(std::memory_order_acquire);
+        if (page != nullptr) {
+          histogram.max = std::max(histogram.max,
+                                   page[maxSlot % PAGE_SLOTS].load(std::memory_order_relaxed));
+        }
+      }
+      break;
+    }
+  }
+}
 
 }
 
@@ -59,18 +338,125 @@ void Statistics::sampleFunc() {
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 
+#include <thread>
+
 using namespace lio;
+using std::string;
 
-class MockStatistics : public Statistics {
-public:
-  MOCK_METHOD0(Test, void());
+TEST(StatisticsTest, Register) {
+  Statistics::Counter counter = Statistics::GetCounter("test_requests_total", "Requests.");
+  Statistics::Counter same = Statistics::GetCounter("test_requests_total");
+  counter.Add();
+  same.Add(2);
+  EXPECT_EQ(counter.Get(), 3);
+  EXPECT_THROW(Statistics::GetGauge("test_requests_total"), Statistics::Exception);
 
-};
+  // Default handles do nothing harmful.
+  Statistics::Counter unregistered;
+  unregistered.Add();
+  Statistics::Gauge unregisteredGauge;
+  unregisteredGauge.Add(1);
+  Statistics::Histogram unregisteredHistogram;
+  unregisteredHistogram.Record(1000);
+  EXPECT_EQ(counter.Get(), 3);
+
+  Statistics::Gauge gauge = Statistics::GetGauge("test_connections");
+  gauge.Set(10);
+  gauge.Add(-3);
+  EXPECT_EQ(gauge.Get(), 7);
 
-using ::testing::AtLeast;
+  Statistics::Sample sample;
+  EXPECT_EQ(Statistics::GetSample("test_connections", sample), true);
+  EXPECT_EQ(sample.kind, Statistics::Kind::GAUGE);
+  EXPECT_EQ(sample.value, 7);
+  EXPECT_EQ(Statistics::GetSample("test_missing", sample), false);
+}
+
+TEST(StatisticsTest, Threads) {
+  Statistics::Counter counter = Statistics::GetCounter("test_thread_adds_total");
+  Statistics::Histogram histogram = Statistics::GetHistogram("test_thread_values");
+  const size_t numThreads = 8;
+  const size_t numAdds = 100000;
 
-TEST(Statistics, TESTNAME) {
-  MockStatistics mockStatistics;
+  // Threads exit, later ones reuse their shards.
+  for (size_t round = 0; 2 > round; ++round) {
+    std::vector<std::thread> threads;
+    for (size_t i = 0; numThreads > i; ++i) {
+      threads.emplace_back([counter, histogram, numAdds] {
+        for (size_t j = 0; numAdds > j; ++j) {
+          counter.Add();
+          histogram.Record(j % 100);
+        }
+      });
+    }
+    for (std::thread& thread : threads) {
+      thread.join();
+    }
+  }
+  EXPECT_EQ(counter.Get(), 2 * numThreads * numAdds);
+
+  Statistics::Sample sample;
+  ASSERT_EQ(Statistics::GetSample("test_thread_values", sample), true);
+  EXPECT_EQ(sample.histogram.count, 2 * numThreads * numAdds);
+  EXPECT_EQ(sample.histogram.sum, 2 * numThreads * (numAdds / 100) * 4950);
+  EXPECT_EQ(sample.histogram.max, 99);
+}
+
+TEST(StatisticsTest, Histogram) {
+  // Buckets are contiguous and within 1/16 of their values.
+  uint64_t lowerBound = 0;
+  for (size_t i = 0; Statistics::NUM_BUCKETS - 1 > i; ++i) {
+    const uint64_t upperBound = Statistics::GetBucketUpperBound(i);
+    ASSERT_EQ(Statistics::GetBucket(lowerBound), i);
+    ASSERT_EQ(Statistics::GetBucket(upperBound), i);
+    ASSERT_LE((upperBound - lowerBound) * 16, lowerBound);
+    lowerBound = upperBound + 1;
+  }
+  // Last bucket is the top one of 2^39 and everything above.
+  EXPECT_EQ(lowerBound, 31ULL << (Statistics::MAX_VALUE_BITS - 5));
+  EXPECT_EQ(Statistics::GetBucket(1ULL << Statistics::MAX_VALUE_BITS), Statistics::NUM_BUCKETS - 1);
+  EXPECT_EQ(Statistics::GetBucket(UINT64_MAX), Statistics::NUM_BUCKETS - 1);
+
+  Statistics::Histogram histogram = Statistics::GetHistogram("test_latency_ns", "Latency.");
+  for (uint64_t i = 1; 10000 >= i; ++i) {
+    histogram.Record(i * 1000);
+  }
+  Statistics::Sample sample;
+  ASSERT_EQ(Statistics::GetSample("test_latency_ns", sample), true);
+  const Statistics::HistogramSnapshot& snapshot = sample.histogram;
+  EXPECT_EQ(snapshot.count, 10000);
+  EXPECT_EQ(snapshot.max, 10000 * 1000);
+  EXPECT_DOUBLE_EQ(snapshot.GetMean(), 5000.5 * 1000);
+  EXPECT_NEAR(snapshot.GetPercentile(0.5), 5000 * 1000, 5000 * 1000 / 16);
+  EXPECT_NEAR(snapshot.GetPercentile(0.99), 9900 * 1000, 9900 * 1000 / 16);
+  EXPECT_EQ(snapshot.GetPercentile(1.0), 10000 * 1000);
+
+  const string text = Statistics::ToText();
+  EXPECT_NE(text.find("# HELP test_requests_total Requests.\n"
+                      "# TYPE test_requests_total counter\n"
+                      "test_requests_total 3\n"), string::npos);
+  EXPECT_NE(text.find("# TYPE test_connections gauge\ntest_connections 7\n"), string::npos);
+  EXPECT_NE(text.find("# TYPE test_latency_ns summary\n"), string::npos);
+  EXPECT_NE(text.find("test_latency_ns{quantile=\"0.99\"} "), string::npos);
+  EXPECT_NE(text.find("test_latency_ns_count 10000\n"), string::npos);
+}
+
+TEST(StatisticsTest, Benchmark) {
+  PERFTEST {
+    const size_t numAdds = 100 * 1000 * 1000;
+    Statistics::Counter counter = Statistics::GetCounter("bench_adds_total");
+    std::atomic<uint64_t> shared(0);
+    Statistics::Histogram histogram = Statistics::GetHistogram("bench_values");
+
+    lio::Test::Measure("Counter::Add()", 1, numAdds, [&counter](size_t) { counter.Add(); });
+    lio::Test::Measure("atomic fetch_add()", 1, numAdds, [&shared](size_t) {
+      shared.fetch_add(1, std::memory_order_relaxed);
+    });
+    lio::Test::Measure("Histogram::Record()", 1, numAdds, [&histogram](size_t i) {
+      histogram.Record(i & 0xFFFF);
+    });
+    EXPECT_EQ(counter.Get(), numAdds);
+  }
 }
 
 int main (int argc, char** argv) {
@@ -85,4 +471,3 @@ int main (int argc, char** argv) {
 #endif
 
 #undef _UNIT_TEST
-
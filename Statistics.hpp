@@ -7,49 +7,83 @@
   Authors
     [ETL] Eun T. Leem (eunleem@gmail.com)
 
+  Description
+    Process wide registry of counters, gauges and latency histograms.
+
+    Metrics are registered by name once, usually into static members, and
+    the handles are used on hot paths. Counters and histograms live in
+    slots of a shard per thread. Add() is a load and a store to a slot
+    only the calling thread writes, without a lock prefix or shared cache
+    lines. Readers sum the shards. A shard of a finished thread is kept
+    for the next thread, so its counts stay in the totals.
+
+    Gauges are a single atomic, since Set() can not be split over shards.
+
+    Histograms are log linear like HdrHistogram. Values below 16 have a
+    bucket each. Above, every power of 2 is split into 16 buckets, so a
+    percentile is off by less than 1/16. Values from 31 * 2^35, just
+    under 2^40, share the last bucket. Units are up to the metric, nanoseconds usually.
+
+    Snapshot() gives the merged values and ToText() the Prometheus text
+    format, with histograms as summaries.
+
   Last Modified Date
-    November 14, 2014
-  
+    Oct 19, 2026
+
   History
     November 14, 2014
       Created
+    October 19, 2026
+      Sharded counters, gauges, histograms and text exposition.
 
   ToDos
-    
+
 
 
   Milestones
     1.0
-      
+
 
   Learning Resources
-    http://
-  
+    HdrHistogram
+      http://hdrhistogram.org/
+    Prometheus text format
+      https://prometheus.io/docs/instrumenting/exposition_formats/
+
   Copyright (c) All rights reserved to LIFEINO.
 */
 
 #ifdef _DEBUG
   #undef _DEBUG
 #endif
-#define _DEBUG true
+#define _DEBUG false
 
 #include "liolib/Debug.hpp"
 
+#include <atomic>
+#include <string>
+#include <vector>
 
-//#include "liolib/DataBlock.hpp"
+#include <cstdint>
 
 namespace lio {
 
+using std::string;
+
 
 class Statistics {
 public:
 
 // ******** Exception Declaration *********
 enum class ExceptionType : std::uint8_t {
-  GENERAL
+  GENERAL,
+  KIND_MISMATCH,
+  TOO_MANY_METRICS
 };
 #define STATISTICS_EXCEPTION_MESSAGES \
-  "Statistics Exception has been thrown."
+  "Statistics Exception has been thrown.", \
+  "Metric has been registered as another kind.", \
+  "No slot left for the metric."
 
 class Exception : public std::exception {
 public:
@@ -57,32 +91,184 @@ public:
 
   virtual const char*         what() const noexcept;
   virtual const               ExceptionType type() const noexcept;
-  
+
 private:
   const ExceptionType         exceptionType_;
   static const char* const    exceptionMessages_[];
 };
 // ******** Exception Declaration END*********
 
+  enum class Kind : uint8_t {
+    COUNTER,
+    GAUGE,
+    HISTOGRAM
+  };
+
+  static const size_t SUB_BUCKET_BITS = 4;
+  static const size_t MAX_VALUE_BITS = 40;
+  static const size_t NUM_BUCKETS =
+      (1 << SUB_BUCKET_BITS) * (MAX_VALUE_BITS - SUB_BUCKET_BITS + 1);
+
+  class Counter {
+  public:
+    Counter() : slot_(0) { } // Writes a slot nobody reads.
+
+    void          Add(uint64_t value = 1) const {
+      Statistics::add(this->slot_, value);
+    }
+    uint64_t      Get() const;
+
+  private:
+    friend class Statistics;
+    explicit Counter(uint32_t slot) : slot_(slot) { }
+    uint32_t      slot_;
+  };
+
+  class Gauge {
+  public:
+    Gauge();
+
+    void          Set(int64_t value) const {
+      this->value_->store(value, std::memory_order_relaxed);
+    }
+    void          Add(int64_t value) const {
+      this->value_->fetch_add(value, std::memory_order_relaxed);
+    }
+    int64_t       Get() const {
+      return this->value_->load(std::memory_order_relaxed);
+    }
+
+  private:
+    friend class Statistics;
+    explicit Gauge(std::atomic<int64_t>* value) : value_(value) { }
+    std::atomic<int64_t>* value_;
+  };
+
+  class Histogram {
+  public:
+    Histogram() : slot_(0) { }
+
+    void          Record(uint64_t value) const;
+
+  private:
+    friend class Statistics;
+    explicit Histogram(uint32_t slot) : slot_(slot) { }
+    uint32_t      slot_; // Buckets, then sum and max.
+  };
+
+  struct HistogramSnapshot {
+    HistogramSnapshot() : count(0), sum(0), max(0) { }
+
+    // Upper bound of the bucket of the percentile, 0.0 to 1.0.
+    uint64_t      GetPercentile(double percentile) const;
+    double        GetMean() const;
+
+    uint64_t      count;
+    uint64_t      sum;
+    uint64_t      max;
+    std::vector<uint64_t> buckets; // NUM_BUCKETS
+  };
+
+  struct Sample {
+    string        name;
+    string        help;
+    Kind          kind;
+    int64_t       value; // Of COUNTER and GAUGE.
+    HistogramSnapshot histogram;
+  };
+
+  // Same name gives the same metric. Throws KIND_MISMATCH when the name
+  // is taken by another kind.
+  static
+  Counter         GetCounter(const string& name, const string& help = "");
+  static
+  Gauge           GetGauge(const string& name, const string& help = "");
+  static
+  Histogram       GetHistogram(const string& name, const string& help = "");
+
+  // Merged over threads, in order of registration.
+  static
+  std::vector<Sample> Snapshot();
+  static
+  bool            GetSample(const string& name, Sample& sample);
+  // Prometheus text format.
+  static
+  string          ToText();
+  static
+  string          ToText(const std::vector<Sample>& samples);
+
+  static
+  size_t          GetBucket(uint64_t value) {
+    if (value < (1 << SUB_BUCKET_BITS)) {
+      return value;
+    }
+    const size_t exponent = 63 - __builtin_clzll(value);
+    if (exponent >= MAX_VALUE_BITS) {
+      return NUM_BUCKETS - 1;
+    }
+    const size_t subBucket = (value >> (exponent - SUB_BUCKET_BITS)) &
+                             ((1 << SUB_BUCKET_BITS) - 1);
+    return ((exponent - SUB_BUCKET_BITS + 1) << SUB_BUCKET_BITS) + subBucket;
+  }
+  // Largest value of the bucket.
+  static
+  uint64_t        GetBucketUpperBound(size_t bucket);
+
+  // CLOCK_MONOTONIC, for histograms of durations.
+  static
+  uint64_t        GetNanoseconds();
 
-  Statistics();
-  ~Statistics();
-protected:
-  
 private:
+  static const size_t PAGE_SLOTS = 512;
+  static const size_t MAX_PAGES = 256;
+
+  // Slots one thread writes. Pages are allocated on first use.
+  struct Shard {
+    std::atomic<std::atomic<uint64_t>*> pages[MAX_PAGES];
+  };
+  struct Metric;
+  struct Registry;
+  struct ShardOwner;
+
+  static thread_local Shard* shard_;
 
-/** FUNC_NAME 
- *    DESCRIPTION
- *  Input
- *    DESCRIPTION_ABOUT_PARAMETERS
- *  Returns
- *    void NOTHING
- */
-  void sampleFunc();
-  
+  static
+  void            add(uint32_t slot, uint64_t value) {
+    std::atomic<uint64_t>& counter = Statistics::getSlot(slot);
+    counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+  }
+
+  static
+  std::atomic<uint64_t>& getSlot(uint32_t slot) {
+    Shard* shard = Statistics::shard_;
+    if (shard == nullptr) {
+      shard = Statistics::acquireShard();
+    }
+    std::atomic<uint64_t>* page = shard->pages[slot / PAGE_SLOTS].load(std::memory_order_relaxed);
+    if (page == nullptr) {
+      page = Statistics::allocatePage(shard, slot / PAGE_SLOTS);
+    }
+    return page[slot % PAGE_SLOTS];
+  }
+
+  static
+  Registry&       getRegistry();
+  static
+  Metric*         registerMetric(const string& name, const string& help, Kind kind);
+  // Shard of the calling thread. Given back when the thread exits.
+  static
+  Shard*          acquireShard();
+  static
+  std::atomic<uint64_t>* allocatePage(Shard* shard, size_t pageIndex);
+  // Sum over shards. Registry mutex has to be held.
+  static
+  uint64_t        sumSlot(const Registry& registry, uint32_t slot);
+  static
+  void            fillSample(const Registry& registry, const Metric& metric, Sample& sample);
+
+  Statistics() = delete;
 };
 
 }
 
 #endif
-
@@ -8,6 +8,11 @@
 #include <chrono>
 #include <string>
 #include <map>
+#include <thread>
+#include <vector>
+
+#include <cstdint>
+#include <ctime> // clock_gettime()
 
 
 
@@ -67,6 +72,40 @@ namespace Test {
 
     static std::map<std::string, std::pair<highrestime, highrestime>> Timers;
   };
+
+  inline
+  uint64_t GetNanoseconds() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) now.tv_sec * 1000 * 1000 * 1000 + now.tv_nsec;
+  }
+
+  // Calls call(i) numCalls times on each of numThreads threads, and prints
+  // nanoseconds per call. With one thread, it runs on the calling thread.
+  template <typename Call>
+  double Measure(const std::string& name, size_t numThreads, size_t numCalls, Call call) {
+    const uint64_t start = GetNanoseconds();
+    if (numThreads == 1) {
+      for (size_t i = 0; numCalls > i; ++i) {
+        call(i);
+      }
+    } else {
+      std::vector<std::thread> threads;
+      for (size_t i = 0; numThreads > i; ++i) {
+        threads.emplace_back([numCalls, &call] {
+          for (size_t j = 0; numCalls > j; ++j) {
+            call(j);
+          }
+        });
+      }
+      for (std::thread& thread : threads) {
+        thread.join();
+      }
+    }
+    const double nsPerCall = (double) (GetNanoseconds() - start) / (numThreads * numCalls);
+    std::cout << std::setw(36) << std::left << name << nsPerCall << " ns/op" << std::endl;
+    return nsPerCall;
+  }
 }
 
 }
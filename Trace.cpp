@@ -0,0 +1,597 @@
+#include "Trace.hpp"
+
+#define _UNIT_TEST false
+#include "liolib/Test.hpp"
+
+#include <algorithm> // max()
+#include <map>
+#include <mutex>
+
+#include <cerrno>
+#include <cstdio> // snprintf()
+#include <cstring> // strcmp()
+#include <ctime> // clock_gettime()
+
+#include <fcntl.h> // open()
+#include <sys/syscall.h>
+#include <unistd.h> // getpid(), syscall(), write()
+
+#if defined(__x86_64__) || defined(__i386__)
+  #include <x86intrin.h> // __rdtsc()
+#endif
+
+namespace lio {
+
+// Marks one thread writes. Indexes only grow, slot is index % RING_SIZE.
+struct Trace::Ring {
+  struct Slot {
+    std::atomic<uint64_t>     ticks;
+    std::atomic<const char*>  name;
+    std::atomic<uint64_t>     requestId;
+    std::atomic<uint8_t>      phase;
+  };
+
+  std::atomic<uint64_t> head; // Next index to write.
+  std::atomic<uint64_t> tail; // First index to read. Moved by Clear().
+  std::atomic<uint32_t> threadId;
+  uint64_t        requestId; // Of the owner thread.
+  Slot            slots[RING_SIZE];
+};
+
+struct Trace::Registry {
+  Registry() :
+    anchorTicks(Trace::getTicks()),
+    anchorNs(getMonotonicNs())
+  { }
+
+  // Measured from the anchor, so it gets better as the process runs.
+  double          GetNsPerTick() const {
+    const uint64_t ticks = Trace::getTicks();
+    const uint64_t ns = getMonotonicNs();
+    if (ticks <= this->anchorTicks || ns <= this->anchorNs) {
+      return 1.0;
+    }
+    return (double) (ns - this->anchorNs) / (ticks - this->anchorTicks);
+  }
+
+  static
+  uint64_t        getMonotonicNs() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) now.tv_sec * 1000 * 1000 * 1000 + now.tv_nsec;
+  }
+
+  std::mutex      mutex;
+  std::vector<Ring*> rings; // All of them, in use or free.
+  std::vector<Ring*> freeRings;
+  string          dumpPath;
+  const uint64_t  anchorTicks;
+  const uint64_t  anchorNs;
+};
+
+// Gives the ring back when its thread exits.
+struct Trace::RingOwner {
+  RingOwner() :
+    ring(nullptr)
+  { }
+
+  ~RingOwner() {
+    if (this->ring == nullptr) {
+      return;
+    }
+    Registry& registry = Trace::getRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    registry.freeRings.push_back(this->ring);
+    Trace::ring_ = nullptr;
+  }
+
+  Ring*           ring;
+};
+
+std::atomic<bool> Trace::isEnabled_(true);
+std::atomic<bool> Trace::isDumpRequested_(false);
+thread_local Trace::Ring* Trace::ring_ = nullptr;
+
+namespace {
+
+std::atomic<uint64_t> lastRequestId(0);
+
+void appendEscaped(string& json, const char* text) {
+  for (const char* c = text; *c != '\0'; ++c) {
+    if (*c == '"' || *c == '\\') {
+      json += '\\';
+      json += *c;
+    } else if ((unsigned char) *c < 0x20) {
+      char escaped[8];
+      snprintf(escaped, sizeof(escaped), "\\u%04x", (unsigned char) *c);
+      json += escaped;
+    } else {
+      json += *c;
+    }
+  }
+}
+
+}
+
+void Trace::SetRequestId(uint64_t requestId) {
+  Ring* ring = Trace::ring_;
+  if (ring == nullptr) {
+    ring = Trace::acquireRing();
+  }
+  ring->requestId = requestId;
+}
+
+uint64_t Trace::NewRequestId() {
+  return lastRequestId.fetch_add(1, std::memory_order_relaxed) + 1;
+}
+
+void Trace::SetEnabled(bool isEnabled) {
+  Trace::isEnabled_.store(isEnabled, std::memory_order_relaxed);
+}
+
+bool Trace::IsEnabled() {
+  return Trace::isEnabled_.load(std::memory_order_relaxed);
+}
+
+std::vector<std::vector<Trace::Mark>> Trace::GetMarks() {
+  Registry& registry = Trace::getRegistry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  std::vector<std::vector<Mark>> marks(registry.rings.size());
+  for (size_t i = 0; registry.rings.size() > i; ++i) {
+    const Ring& ring = *registry.rings[i];
+    const uint64_t head = ring.head.load(std::memory_order_acquire);
+    uint64_t start = ring.tail.load(std::memory_order_relaxed);
+    if (head >= RING_SIZE) {
+      start = std::max(start, head - RING_SIZE + 1);
+    }
+    for (uint64_t index = start; head > index; ++index) {
+      const Ring::Slot& slot = ring.slots[index % RING_SIZE];
+      Mark mark;
+      mark.ticks = slot.ticks.load(std::memory_order_relaxed);
+      mark.name = slot.name.load(std::memory_order_relaxed);
+      mark.requestId = slot.requestId.load(std::memory_order_relaxed);
+      mark.phase = (Phase) slot.phase.load(std::memory_order_relaxed);
+      marks[i].push_back(mark);
+    }
+
+    // The owner may have written over the first ones meanwhile.
+    std::atomic_thread_fence(std::memory_order_acquire);
+    const uint64_t newHead = ring.head.load(std::memory_order_relaxed);
+    if (newHead >= RING_SIZE && newHead - RING_SIZE + 1 > start) {
+      const size_t numOverwritten =
+        std::min<uint64_t>(newHead - RING_SIZE + 1 - start, marks[i].size());
+      marks[i].erase(marks[i].begin(), marks[i].begin() + numOverwritten);
+    }
+  }
+  return marks;
+}
+
+void Trace::Clear() {
+  Registry& registry = Trace::getRegistry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  for (Ring* ring : registry.rings) {
+    ring->tail.store(ring->head.load(std::memory_order_acquire), std::memory_order_relaxed);
+  }
+}
+
+string Trace::ToChromeJson() {
+  Registry& registry = Trace::getRegistry();
+  const std::vector<std::vector<Mark>> marks = Trace::GetMarks();
+  std::vector<uint32_t> threadIds;
+  {
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    for (size_t i = 0; marks.size() > i; ++i) {
+      threadIds.push_back(registry.rings[i]->threadId.load(std::memory_order_relaxed));
+    }
+  }
+  const double nsPerTick = registry.GetNsPerTick();
+  const int pid = getpid();
+
+  string json = "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+  bool isFirst = true;
+  char buffer[128];
+  for (size_t i = 0; marks.size() > i; ++i) {
+    for (const Mark& mark : marks[i]) {
+      if (isFirst == false) {
+        json += ",\n";
+      }
+      isFirst = false;
+      json += "{\"name\":\"";
+      appendEscaped(json, mark.name);
+      // Marks before the anchor come out negative, which the viewers take.
+      const double microseconds =
+        (double) (int64_t) (mark.ticks - registry.anchorTicks) * nsPerTick / 1000;
+      snprintf(buffer, sizeof(buffer),
+               "\",\"cat\":\"lio\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":%d,\"tid\":%u",
+               (mark.phase == Phase::BEGIN) ? 'B' : 'E', microseconds, pid, threadIds[i]);
+      json += buffer;
+      if (mark.phase == Phase::BEGIN && mark.requestId != 0) {
+        snprintf(buffer, sizeof(buffer), ",\"args\":{\"request\":%llu}",
+                 (unsigned long long) mark.requestId);
+        json += buffer;
+      }
+      json += "}";
+    }
+  }
+  json += "]}\n";
+  return json;
+}
+
+bool Trace::DumpChromeJson(const string& path) {
+  const string json = Trace::ToChromeJson();
+  const int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd < 0) {
+    DEBUG_cerr << "Failed to open " << path << ". errno: " << errno << endl;
+    return false;
+  }
+  size_t written = 0;
+  while (json.length() > written) {
+    const ssize_t result = write(fd, json.data() + written, json.length() - written);
+    if (result < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      DEBUG_cerr << "Failed to write " << path << ". errno: " << errno << endl;
+      close(fd);
+      return false;
+    }
+    written += result;
+  }
+  close(fd);
+  return true;
+}
+
+void Trace::SetDumpSignal(const string& path, int signalNumber) {
+  Registry& registry = Trace::getRegistry();
+  {
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    registry.dumpPath = path;
+  }
+
+  struct sigaction action;
+  memset(&action, 0, sizeof(action));
+  action.sa_handler = &Trace::onDumpSignal;
+  action.sa_flags = SA_RESTART;
+  sigemptyset(&action.sa_mask);
+  sigaction(signalNumber, &action, nullptr);
+}
+
+std::vector<Statistics::Sample> Trace::GetBreakdown() {
+  const std::vector<std::vector<Mark>> marks = Trace::GetMarks();
+  const double nsPerTick = Trace::getRegistry().GetNsPerTick();
+
+  std::map<string, Statistics::HistogramSnapshot> histograms;
+  std::vector<const Mark*> open;
+  for (const std::vector<Mark>& threadMarks : marks) {
+    open.clear();
+    for (const Mark& mark : threadMarks) {
+      if (mark.phase == Phase::BEGIN) {
+        open.push_back(&mark);
+        continue;
+      }
+
+      // Ends without a begin had theirs overwritten.
+      size_t depth = open.size();
+      while (depth > 0 && strcmp(open[depth - 1]->name, mark.name) != 0) {
+        --depth;
+      }
+      if (depth == 0) {
+        continue;
+      }
+      const Mark& begin = *open[depth - 1];
+      open.resize(depth - 1);
+
+      const uint64_t ns = (mark.ticks > begin.ticks) ?
+                          (uint64_t) ((mark.ticks - begin.ticks) * nsPerTick) : 0;
+      Statistics::HistogramSnapshot& histogram = histograms[mark.name];
+      if (histogram.buckets.empty() == true) {
+        histogram.buckets.resize(Statistics::NUM_BUCKETS, 0);
+      }
+      histogram.buckets[Statistics::GetBucket(ns)] += 1;
+      histogram.count += 1;
+      histogram.sum += ns;
+      histogram.max = std::max(histogram.max, ns);
+    }
+  }
+
+  std::vector<Statistics::Sample> samples;
+  for (auto& itr : histograms) {
+    Statistics::Sample sample;
+    sample.name = "trace_" + itr.first + "_nanoseconds";
+    std::replace_if(sample.name.begin(), sample.name.end(),
+                    [](char c) { return isalnum(c) == false && c != '_'; }, '_');
+    sample.help = "Durations of " + itr.first + " spans in the trace rings.";
+    sample.kind = Statistics::Kind::HISTOGRAM;
+    sample.value = 0;
+    sample.histogram = std::move(itr.second);
+    samples.push_back(std::move(sample));
+  }
+  return samples;
+}
+
+void Trace::record(const char* name, Phase phase) {
+  Ring* ring = Trace::ring_;
+  if (ring == nullptr) {
+    ring = Trace::acquireRing();
+  }
+  const uint64_t head = ring->head.load(std::memory_order_relaxed);
+  // Readers that see the slot written see the head before it.
+  std::atomic_thread_fence(std::memory_order_release);
+  Ring::Slot& slot = ring->slots[head % RING_SIZE];
+  slot.ticks.store(Trace::getTicks(), std::memory_order_relaxed);
+  slot.name.store(name, std::memory_order_relaxed);
+  slot.requestId.store(ring->requestId, std::memory_order_relaxed);
+  slot.phase.store((uint8_t) phase, std::memory_order_relaxed);
+  ring->head.store(head + 1, std::memory_order_release);
+}
+
+Trace::Registry& Trace::getRegistry() {
+  // Never destroyed. Threads may exit after static destructors ran.
+  static Registry* registry = new Registry();
+  return *registry;
+}
+
+Trace::Ring* Trace::acquireRing() {
+  static thread_local RingOwner owner;
+
+  Registry& registry = Trace::getRegistry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  Ring* ring = nullptr;
+  if (registry.freeRings.empty() == false) {
+    // Marks of the thread before would be shown as this one's.
+    ring = registry.freeRings.back();
+    registry.freeRings.pop_back();
+    ring->tail.store(ring->head.load(std::memory_order_relaxed), std::memory_order_relaxed);
+  } else {
+    ring = new Ring();
+    registry.rings.push_back(ring);
+  }
+  ring->threadId.store(syscall(SYS_gettid), std::memory_order_relaxed);
+  ring->requestId = 0;
+  owner.ring = ring;
+  Trace::ring_ = ring;
+  return ring;
+}
+
+void Trace::dumpRequested() {
+  if (Trace::isDumpRequested_.exchange(false) == false) {
+    return;
+  }
+  Registry& registry = Trace::getRegistry();
+  string path;
+  {
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    path = registry.dumpPath;
+  }
+  Trace::DumpChromeJson(path);
+}
+
+void Trace::onDumpSignal(int signalNumber) {
+  Trace::isDumpRequested_.store(true, std::memory_order_relaxed);
+}
+
+uint64_t Trace::getTicks() {
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint64_t) now.tv_sec * 1000 * 1000 * 1000 + now.tv_nsec;
+#endif
+}
+
+}
+
+
+#if _UNIT_TEST
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include <chrono>
+#include <fstream>
+#include <iomanip> // setw()
+#include <iostream>
+#include <sstream>
+#include <thread>
+
+using namespace lio;
+using std::string;
+
+namespace {
+
+// Marks of the rings that have any.
+std::vector<std::vector<Trace::Mark>> getRecordedMarks() {
+  std::vector<std::vector<Trace::Mark>> recorded;
+  for (std::vector<Trace::Mark>& marks : Trace::GetMarks()) {
+    if (marks.empty() == false) {
+      recorded.push_back(std::move(marks));
+    }
+  }
+  return recorded;
+}
+
+const Statistics::Sample* findSample(const std::vector<Statistics::Sample>& samples,
+                                     const string& name)
+{
+  for (const Statistics::Sample& sample : samples) {
+    if (sample.name == name) {
+      return &sample;
+    }
+  }
+  return nullptr;
+}
+
+}
+
+TEST(TraceTest, Spans) {
+  Trace::Clear();
+  Trace::SetRequestId(5);
+  {
+    Trace::Span outer("outer");
+    Trace::Span inner("inner");
+  }
+  Trace::SetRequestId(0);
+
+  const std::vector<std::vector<Trace::Mark>> recorded = getRecordedMarks();
+  ASSERT_EQ(1, recorded.size());
+  const std::vector<Trace::Mark>& marks = recorded[0];
+  ASSERT_EQ(4, marks.size());
+  EXPECT_STREQ("outer", marks[0].name);
+  EXPECT_EQ(Trace::Phase::BEGIN, marks[0].phase);
+  EXPECT_STREQ("inner", marks[1].name);
+  EXPECT_STREQ("inner", marks[2].name);
+  EXPECT_EQ(Trace::Phase::END, marks[2].phase);
+  EXPECT_STREQ("outer", marks[3].name);
+  EXPECT_EQ(5, marks[3].requestId);
+  EXPECT_LE(marks[0].ticks, marks[3].ticks);
+
+  Trace::SetEnabled(false);
+  {
+    Trace::Span span("disabled");
+  }
+  Trace::SetEnabled(true);
+  EXPECT_EQ(4, getRecordedMarks()[0].size());
+
+  const uint64_t requestId = Trace::NewRequestId();
+  EXPECT_LT(requestId, Trace::NewRequestId());
+}
+
+TEST(TraceTest, RingOverwrites) {
+  Trace::Clear();
+  for (size_t i = 0; Trace::RING_SIZE + 10 > i; ++i) {
+    Trace::Begin("overwritten");
+  }
+  Trace::End("last");
+
+  const std::vector<std::vector<Trace::Mark>> recorded = getRecordedMarks();
+  ASSERT_EQ(1, recorded.size());
+  EXPECT_EQ(Trace::RING_SIZE - 1, recorded[0].size());
+  EXPECT_STREQ("last", recorded[0].back().name);
+}
+
+TEST(TraceTest, Breakdown) {
+  Trace::Clear();
+  for (size_t i = 0; 3 > i; ++i) {
+    Trace::Span request("request");
+    {
+      Trace::Span parse("http.parse");
+    }
+    Trace::Span sleep("sleep");
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+  }
+  Trace::End("never.begun");
+
+  const std::vector<Statistics::Sample> samples = Trace::GetBreakdown();
+  EXPECT_EQ(3, samples.size());
+  const Statistics::Sample* sleep = findSample(samples, "trace_sleep_nanoseconds");
+  ASSERT_NE(nullptr, sleep);
+  EXPECT_EQ(3, sleep->histogram.count);
+  EXPECT_LE(3 * 1000 * 1000, sleep->histogram.sum);
+  const Statistics::Sample* parse = findSample(samples, "trace_http_parse_nanoseconds");
+  ASSERT_NE(nullptr, parse);
+  EXPECT_EQ(3, parse->histogram.count);
+  const Statistics::Sample* request = findSample(samples, "trace_request_nanoseconds");
+  ASSERT_NE(nullptr, request);
+  EXPECT_LE(sleep->histogram.sum, request->histogram.sum);
+
+  EXPECT_NE(string::npos, Statistics::ToText(samples).find("trace_sleep_nanoseconds_count 3"));
+}
+
+TEST(TraceTest, ChromeJson) {
+  Trace::Clear();
+  Trace::SetRequestId(7);
+  {
+    Trace::Span span("gzip.compress");
+  }
+  Trace::SetRequestId(0);
+
+  const string json = Trace::ToChromeJson();
+  EXPECT_EQ(0, json.find("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[{\"name\":\"gzip.compress\""));
+  EXPECT_NE(string::npos, json.find("\"ph\":\"B\""));
+  EXPECT_NE(string::npos, json.find("\"ph\":\"E\""));
+  EXPECT_NE(string::npos, json.find("\"args\":{\"request\":7}"));
+
+  const string path = "./trace_test.json";
+  Trace::SetDumpSignal(path);
+  raise(SIGUSR2);
+  Trace::DumpIfRequested();
+  std::ifstream file(path);
+  std::stringstream content;
+  content << file.rdbuf();
+  EXPECT_NE(string::npos, content.str().find("gzip.compress"));
+  unlink(path.c_str());
+  signal(SIGUSR2, SIG_DFL);
+}
+
+TEST(TraceTest, Threads) {
+  Trace::Clear();
+  std::atomic<bool> isDone(false);
+  std::atomic<size_t> numStarted(0);
+  std::vector<std::thread> threads;
+  for (size_t i = 0; 4 > i; ++i) {
+    threads.emplace_back([&isDone, &numStarted] {
+      {
+        Trace::Span span("thread");
+      }
+      ++numStarted;
+      while (isDone == false) {
+        Trace::Span span("thread");
+      }
+    });
+  }
+  while (4 > numStarted) {
+    std::this_thread::yield();
+  }
+  size_t numTorn = 0;
+  for (size_t i = 0; 20 > i; ++i) {
+    for (const std::vector<Trace::Mark>& marks : Trace::GetMarks()) {
+      for (const Trace::Mark& mark : marks) {
+        if (mark.name == nullptr || strcmp(mark.name, "thread") != 0) {
+          ++numTorn;
+        }
+      }
+    }
+  }
+  isDone = true;
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(0, numTorn);
+  EXPECT_LE(4, getRecordedMarks().size());
+}
+
+TEST(TraceTest, Benchmark) {
+  PERFTEST {
+    const size_t numCalls = 10 * 1000 * 1000;
+    for (size_t numThreads : { 1, 4 }) {
+      std::cout << numThreads << " thread(s)" << endl;
+      lio::Test::Measure("  Span", numThreads, numCalls / numThreads, [](size_t) {
+        Trace::Span span("benchmark");
+      });
+      Trace::SetEnabled(false);
+      lio::Test::Measure("  Span, disabled", numThreads, numCalls / numThreads, [](size_t) {
+        Trace::Span span("benchmark");
+      });
+      Trace::SetEnabled(true);
+    }
+
+    const uint64_t start = lio::Test::GetNanoseconds();
+    const string json = Trace::ToChromeJson();
+    std::cout << "ToChromeJson() of " << json.length() << " bytes in "
+              << (lio::Test::GetNanoseconds() - start) / 1000 << " us" << endl;
+  }
+}
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleMock(&argc, argv);
+  return RUN_ALL_TESTS();
+}
+
+#else
+// Executable File's Main Comes here.
+
+
+#endif
+
+#undef _UNIT_TEST
@@ -0,0 +1,190 @@
+#ifndef _TRACE_HPP_
+#define _TRACE_HPP_
+/*
+  Name
+    Trace
+
+  Description
+    Spans of work, recorded per thread, to see where the time of a slow
+    request went: event dispatch, read, parse, build, gzip or write.
+
+    Trace::Span marks a begin on construction and an end on destruction.
+    A mark is a TSC timestamp, the name and the request of the thread,
+    stored into a ring of the calling thread. There are no locks and no
+    allocation after the first mark of a thread. When the ring is full,
+    the oldest marks are overwritten, so it always holds the latest
+    RING_SIZE marks of every thread.
+
+      Trace::SetRequestId(Trace::NewRequestId());
+      {
+        Trace::Span span("http.parse");
+        ...
+      }
+
+    Names are kept as pointers, so they have to be literals.
+
+    ToChromeJson() and DumpChromeJson() write the rings in the Trace Event
+    Format, for chrome://tracing or Perfetto. SetDumpSignal() dumps on a
+    signal, SIGUSR2 by default. The handler only sets a flag and the dump
+    happens at the next DumpIfRequested(), which AsyncSockets calls on
+    every wakeup.
+
+    GetBreakdown() pairs the marks and returns a histogram of durations
+    per span name, as Statistics samples, for Statistics::ToText().
+
+  Last Modified Date
+    Oct 19, 2026
+
+  History
+    October 19, 2026
+      Created
+
+  ToDos
+
+
+
+  Milestones
+    1.0
+
+
+  Learning Resources
+    Trace Event Format
+      https://docs.google.com/document/d/1CvAClvFfyA5R-PhYUmn5OOQtYMH4h6I0nSsKchNAySU
+
+  Copyright (c) All rights reserved to LIFEINO.
+*/
+
+#ifdef _DEBUG
+  #undef _DEBUG
+#endif
+#define _DEBUG false
+
+#include "liolib/Debug.hpp"
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+#include <csignal> // SIGUSR2
+#include <cstdint>
+
+#include "liolib/Statistics.hpp"
+
+namespace lio {
+
+using std::string;
+
+
+class Trace {
+public:
+  static const size_t RING_SIZE = 8192; // Marks per thread.
+
+  enum class Phase : std::uint8_t {
+    BEGIN,
+    END
+  };
+
+  struct Mark {
+    uint64_t      ticks;
+    const char*   name;
+    uint64_t      requestId;
+    Phase         phase;
+  };
+
+  class Span {
+  public:
+    explicit Span(const char* name) : name_(name) {
+      Trace::Begin(name);
+    }
+    ~Span() {
+      Trace::End(this->name_);
+    }
+
+  private:
+    const char*   name_;
+
+    Span(const Span&) = delete;
+    Span& operator=(const Span&) = delete;
+  };
+
+  static
+  void            Begin(const char* name) {
+    if (Trace::isEnabled_.load(std::memory_order_relaxed) == true) {
+      Trace::record(name, Phase::BEGIN);
+    }
+  }
+
+  static
+  void            End(const char* name) {
+    if (Trace::isEnabled_.load(std::memory_order_relaxed) == true) {
+      Trace::record(name, Phase::END);
+    }
+  }
+
+  // Marks of the calling thread carry it until the next call. 0 for none.
+  static
+  void            SetRequestId(uint64_t requestId);
+  static
+  uint64_t        NewRequestId();
+
+  // Enabled by default.
+  static
+  void            SetEnabled(bool isEnabled);
+  static
+  bool            IsEnabled();
+
+  // Marks in the rings, per thread, oldest first.
+  static
+  std::vector<std::vector<Mark>> GetMarks();
+  // Drops the marks recorded so far.
+  static
+  void            Clear();
+
+  static
+  string          ToChromeJson();
+  static
+  bool            DumpChromeJson(const string& path);
+
+  static
+  void            SetDumpSignal(const string& path, int signalNumber = SIGUSR2);
+  static
+  void            DumpIfRequested() {
+    if (Trace::isDumpRequested_.load(std::memory_order_relaxed) == true) {
+      Trace::dumpRequested();
+    }
+  }
+
+  // Durations of spans in nanoseconds, per name. Sample names are
+  // "trace_<name>_nanoseconds".
+  static
+  std::vector<Statistics::Sample> GetBreakdown();
+
+private:
+  struct Ring;
+  struct Registry;
+  struct RingOwner;
+
+  static std::atomic<bool> isEnabled_;
+  static std::atomic<bool> isDumpRequested_;
+  static thread_local Ring* ring_;
+
+  static
+  void            record(const char* name, Phase phase);
+  static
+  Registry&       getRegistry();
+  // Ring of the calling thread. Given back when the thread exits.
+  static
+  Ring*           acquireRing();
+  static
+  void            dumpRequested();
+  static
+  void            onDumpSignal(int signalNumber);
+  static
+  uint64_t        getTicks();
+
+  Trace() = delete;
+};
+
+}
+
+#endif
@@ -285,6 +285,19 @@ namespace Time {
     return std::chrono::system_clock::now();
   }
 
+  datetime GetNowCoarse() {
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME_COARSE, &now);
+    return datetime(std::chrono::duration_cast<datetime::duration>(
+        std::chrono::seconds(now.tv_sec) + std::chrono::nanoseconds(now.tv_nsec)));
+  }
+
+  time_t GetSecondsCoarse() {
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME_COARSE, &now);
+    return now.tv_sec;
+  }
+
   uint64_t GetMillisecondsSinceEpoch(datetime tp) {
     uint64_t milliseconds_since_epoch = 
       std::chrono::duration_cast<std::chrono::milliseconds>(tp.time_since_epoch()).count();
@@ -342,11 +355,11 @@ namespace Time {
   }
 
   std::string Timestamp(const std::string& format, bool in_localtime) {
-    return ToString(std::chrono::system_clock::now(), format, in_localtime);
+    return ToString(GetSecondsCoarse(), format, in_localtime);
   }
 
   std::string TimestampNum() {
-    return ToString(std::chrono::system_clock::now(), "%Y%m%d%H%M%S");
+    return ToString(GetSecondsCoarse(), "%Y%m%d%H%M%S");
   }
 
   std::string TimeToString(const datetime tp, const std::string& format) {
@@ -375,16 +388,28 @@ namespace Time {
 
   std::string ToString(const time_t rawTime, const std::string& format,
                        bool in_localtime) {
-    struct tm* time;
-    std::string buffer(32, '\0');
+    struct Cache {
+      time_t rawTime;
+      bool isLocal;
+      std::string format;
+      std::string value;
+    };
+    static thread_local Cache cache = { -1, false, "", "" };
+    if (cache.rawTime == rawTime && cache.isLocal == in_localtime &&
+        cache.format == format) {
+      return cache.value;
+    }
+
+    struct tm time;
     if (in_localtime == true) {
-      time = std::localtime(&rawTime);
+      localtime_r(&rawTime, &time);
     } else {
-      time = std::gmtime(&rawTime);
+      gmtime_r(&rawTime, &time);
     }
 
-    if (Util::String::ToLower(format) == "http") {
-      const_cast<std::string&>(format) = "%a, %d %b %Y %H:%M:%S %Z";
+    const char* timeFormat = format.c_str();
+    if (strcasecmp(timeFormat, "http") == 0) {
+      timeFormat = "%a, %d %b %Y %H:%M:%S %Z";
     }
 
     // Time to Formatted String
@@ -392,16 +417,50 @@ namespace Time {
     //   %F = yyyy-MM-dd
     //   %T = HH:mm:ss
     //   %Z = GMT or PST (Time Zone)
-    strftime((char*)buffer.c_str(), 32, format.c_str(), time);
-
-    std::size_t len = std::strlen(buffer.c_str());
-    buffer.resize(len);
-    return buffer;
+    char buffer[64];
+    const size_t length = strftime(buffer, sizeof(buffer), timeFormat, &time);
+
+    cache.rawTime = rawTime;
+    cache.isLocal = in_localtime;
+    cache.format = format;
+    cache.value.assign(buffer, length);
+    return cache.value;
     //std::stringstream ss;
     //ss << std::put_time(std::localtime(&rawTime), format.c_str());
     //return ss.str();
   }
 
+  size_t FormatTimestamp(char* buffer, datetime tp) {
+    static thread_local time_t cachedSecond = -1;
+    static thread_local char cachedValue[20]; // "%F %T"
+
+    const int64_t milliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(
+        tp.time_since_epoch()).count();
+    const time_t second = milliseconds / 1000;
+    if (second != cachedSecond) {
+      struct tm time;
+      gmtime_r(&second, &time);
+      strftime(cachedValue, sizeof(cachedValue), "%F %T", &time);
+      cachedSecond = second;
+    }
+
+    memcpy(buffer, cachedValue, 19);
+    buffer[19] = '.';
+    FormatMilliseconds(buffer + 20, milliseconds % 1000);
+    memcpy(buffer + 23, " GMT", 4);
+    return TIMESTAMP_LENGTH;
+  }
+
+  void FormatMilliseconds(char* buffer, uint32_t milliseconds) {
+    // x * 41 >> 12 is x / 100 and x * 103 >> 10 is x / 10 in this range.
+    const uint32_t hundreds = (milliseconds * 41) >> 12;
+    const uint32_t rest = milliseconds - hundreds * 100;
+    const uint32_t tens = (rest * 103) >> 10;
+    buffer[0] = '0' + hundreds;
+    buffer[1] = '0' + tens;
+    buffer[2] = '0' + (rest - tens * 10);
+  }
+
   time_t steady_clock_to_time_t(const std::chrono::steady_clock::time_point t) {
       return std::chrono::system_clock::to_time_t(
           std::chrono::system_clock::now() +
@@ -409,6 +468,139 @@ namespace Time {
   }
 }
 
+namespace Hash {
+  static const uint64_t XXH_PRIME64_1 = 0x9E3779B185EBCA87ULL;
+  static const uint64_t XXH_PRIME64_2 = 0xC2B2AE3D27D4EB4FULL;
+  static const uint64_t XXH_PRIME64_3 = 0x165667B19E3779F9ULL;
+  static const uint64_t XXH_PRIME64_4 = 0x85EBCA77C2B2AE63ULL;
+  static const uint64_t XXH_PRIME64_5 = 0x27D4EB2F165667C5ULL;
+
+  static inline uint64_t xxhRotate(uint64_t value, int bits) {
+    return (value << bits) | (value >> (64 - bits));
+  }
+
+  // Little endian reads. memcpy() so unaligned data is fine.
+  static inline uint64_t xxhRead64(const uint8_t* p) {
+    uint64_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+  }
+
+  static inline uint32_t xxhRead32(const uint8_t* p) {
+    uint32_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+  }
+
+  static inline uint64_t xxhRound(uint64_t acc, uint64_t input) {
+    acc += input * XXH_PRIME64_2;
+    acc = xxhRotate(acc, 31);
+    return acc * XXH_PRIME64_1;
+  }
+
+  static inline uint64_t xxhMergeRound(uint64_t acc, uint64_t value) {
+    acc ^= xxhRound(0, value);
+    return acc * XXH_PRIME64_1 + XXH_PRIME64_4;
+  }
+
+  uint64_t Xxh64(const void* data, size_t length, uint64_t seed) {
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    const uint8_t* const end = p + length;
+    uint64_t hash = 0;
+
+    if (length >= 32) {
+      // Four independent lanes over 32 byte stripes.
+      uint64_t v1 = seed + XXH_PRIME64_1 + XXH_PRIME64_2;
+      uint64_t v2 = seed + XXH_PRIME64_2;
+      uint64_t v3 = seed;
+      uint64_t v4 = seed - XXH_PRIME64_1;
+      const uint8_t* const limit = end - 32;
+      do {
+        v1 = xxhRound(v1, xxhRead64(p));
+        v2 = xxhRound(v2, xxhRead64(p + 8));
+        v3 = xxhRound(v3, xxhRead64(p + 16));
+        v4 = xxhRound(v4, xxhRead64(p + 24));
+        p += 32;
+      } while (limit >= p);
+
+      hash = xxhRotate(v1, 1) + xxhRotate(v2, 7) + xxhRotate(v3, 12) + xxhRotate(v4, 18);
+      hash = xxhMergeRound(hash, v1);
+      hash = xxhMergeRound(hash, v2);
+      hash = xxhMergeRound(hash, v3);
+      hash = xxhMergeRound(hash, v4);
+    } else {
+      hash = seed + XXH_PRIME64_5;
+    }
+
+    hash += (uint64_t) length;
+
+    while (end - p >= 8) {
+      hash ^= xxhRound(0, xxhRead64(p));
+      hash = xxhRotate(hash, 27) * XXH_PRIME64_1 + XXH_PRIME64_4;
+      p += 8;
+    }
+    if (end - p >= 4) {
+      hash ^= (uint64_t) xxhRead32(p) * XXH_PRIME64_1;
+      hash = xxhRotate(hash, 23) * XXH_PRIME64_2 + XXH_PRIME64_3;
+      p += 4;
+    }
+    while (end > p) {
+      hash ^= (*p) * XXH_PRIME64_5;
+      hash = xxhRotate(hash, 11) * XXH_PRIME64_1;
+      p += 1;
+    }
+
+    hash ^= hash >> 33;
+    hash *= XXH_PRIME64_2;
+    hash ^= hash >> 29;
+    hash *= XXH_PRIME64_3;
+    hash ^= hash >> 32;
+    return hash;
+  }
+}
+
+namespace Process {
+
+namespace {
+std::atomic<pid_t> cachedPid(0);
+}
+
+pid_t GetPid() {
+  pid_t pid = cachedPid.load(std::memory_order_relaxed);
+  if (pid != 0) {
+    return pid;
+  }
+  static const bool isRegistered = (pthread_atfork(nullptr, nullptr, [] {
+    cachedPid.store(0, std::memory_order_relaxed);
+  }) == 0);
+  (void) isRegistered;
+
+  pid = getpid();
+  cachedPid.store(pid, std::memory_order_relaxed);
+  return pid;
+}
+
+bool IsAlive(pid_t pid) {
+  if (kill(pid, 0) == -1 && errno == ESRCH) {
+    return false;
+  }
+  // Zombies exist until their parent reaps them.
+  char path[32];
+  snprintf(path, sizeof(path), "/proc/%d/stat", pid);
+  FILE* stat = fopen(path, "r");
+  if (stat == nullptr) {
+    return errno != ENOENT;
+  }
+  char state = 'R';
+  if (fscanf(stat, "%*d (%*[^)]) %c", &state) != 1) {
+    state = 'R';
+  }
+  fclose(stat);
+  return state != 'Z' && state != 'X';
+}
+
+}
+
 namespace String {
 
 
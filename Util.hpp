@@ -9,11 +9,16 @@
     [ETL] Eun T. Leem (eunleem@gmail.com)
 
   Last Modified Date
-    Sep 28, 2015
+    Oct 19, 2026
   
   History
     September 23, 2013
       Created
+    October 19, 2026
+      Hash::Xxh64()
+      Time::GetNowCoarse(), Time::FormatTimestamp() and per second caching
+      of Time::ToString().
+      Process::GetPid() and Process::IsAlive().
 
   ToDos
     CONVERT TEST TO GTEST and ADD MORE TESTS
@@ -33,6 +38,7 @@
 
 
 #include <algorithm> 
+#include <atomic>
 #include <cctype>
 #include <chrono>
 #include <exception>
@@ -50,9 +56,12 @@
 #include <cstdlib> // srand rand
 #include <ctime> // time_t time() gmtime() strftime() struct tm
 #include <cstring> // memset()
+#include <strings.h> // strcasecmp()
 #include <cctype> // toupper(), tolower()
 
 #include <dirent.h> // opendir()
+#include <pthread.h> // pthread_atfork()
+#include <signal.h> // kill()
 #include <sys/ipc.h> // ftok()
 #include <sys/types.h> // ftok() key_t
 #include <sys/stat.h> // stat() mkdir()
@@ -201,6 +210,10 @@ namespace File {
   
 namespace Time {
   datetime GetNow();
+  // CLOCK_REALTIME_COARSE. Only as fine as the timer tick, a few ms, and
+  // cheaper than GetNow(). Good enough for anything shown in seconds.
+  datetime GetNowCoarse();
+  time_t GetSecondsCoarse();
   uint64_t GetMillisecondsSinceEpoch(datetime tp = GetNow());
   uint64_t GetMillisecondsSinceEpoch(steadytime tp);
 
@@ -222,12 +235,35 @@ namespace Time {
   std::string ToString(const steadytime tp, const std::string& format = "%F %T %Z", bool in_localtime = true);
   std::string ToString(const datetime tp, const std::string& format = "%F %T %Z", bool in_localtime = true);
 
+  // The last result is kept per thread, so calls within the same second
+  // and format skip localtime() and strftime().
   std::string ToString(const time_t rawTime, const std::string& format = "%F %T %Z", bool in_localtime = true);
-  
+
+  // "2026-10-19 12:34:56.789 GMT" into buffer of TIMESTAMP_LENGTH bytes,
+  // not null terminated. Up to the second it is formatted once per
+  // second per thread. Returns TIMESTAMP_LENGTH.
+  size_t FormatTimestamp(char* buffer, datetime tp = GetNowCoarse());
+  static const size_t TIMESTAMP_LENGTH = 27;
+  // Three digits of milliseconds, 0 to 999, without branches.
+  void FormatMilliseconds(char* buffer, uint32_t milliseconds);
 
   time_t steady_clock_to_time_t(const std::chrono::steady_clock::time_point tp);
 }
 
+namespace Hash {
+  // XXH64 by Yann Collet. Not cryptographic. For content ids like ETags.
+  // #REF: https://github.com/Cyan4973/xxHash/blob/dev/doc/xxhash_spec.md
+  uint64_t Xxh64(const void* data, size_t length, uint64_t seed = 0);
+}
+
+namespace Process {
+  // getpid() without the system call. Cached, reset in forked children.
+  pid_t GetPid();
+  // False for processes that exited, zombies included. For owners of
+  // locks in shared memory, whose parent may be the one waiting.
+  bool IsAlive(pid_t pid);
+}
+
 
 namespace String {
   
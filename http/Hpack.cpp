@@ -0,0 +1,768 @@
+
+#include "Hpack.hpp"
+
+#define _UNIT_TEST false
+#include "liolib/Test.hpp"
+
+
+namespace lio {
+
+// ===== Exception Implementation =====
+const char* const
+Hpack::Exception::exceptionMessages_[] = {
+  HPACK_EXCEPTION_MESSAGES
+};
+#undef HPACK_EXCEPTION_MESSAGES // undef helps reducing unnecessary preprocessing work.
+
+
+Hpack::Exception::Exception(ExceptionType exceptionType) :
+  exceptionType_(exceptionType) { }
+
+const char*
+Hpack::Exception::what() const noexcept {
+  return this->exceptionMessages_[(int) this->exceptionType_];
+}
+
+const Hpack::ExceptionType
+Hpack::Exception::type() const noexcept {
+  return this->exceptionType_;
+}
+// ===== Exception Implementation End =====
+
+const size_t Hpack::DEFAULT_TABLE_SIZE;
+const size_t Hpack::STATIC_TABLE_SIZE;
+
+// RFC7541 Appendix A
+const Hpack::HeaderField Hpack::staticTable_[STATIC_TABLE_SIZE] = {
+  HeaderField(":authority", ""),
+  HeaderField(":method", "GET"),
+  HeaderField(":method", "POST"),
+  HeaderField(":path", "/"),
+  HeaderField(":path", "/index.html"),
+  HeaderField(":scheme", "http"),
+  HeaderField(":scheme", "https"),
+  HeaderField(":status", "200"),
+  HeaderField(":status", "204"),
+  HeaderField(":status", "206"),
+  HeaderField(":status", "304"),
+  HeaderField(":status", "400"),
+  HeaderField(":status", "404"),
+  HeaderField(":status", "500"),
+  HeaderField("accept-charset", ""),
+  HeaderField("accept-encoding", "gzip, deflate"),
+  HeaderField("accept-language", ""),
+  HeaderField("accept-ranges", ""),
+  HeaderField("accept", ""),
+  HeaderField("access-control-allow-origin", ""),
+  HeaderField("age", ""),
+  HeaderField("allow", ""),
+  HeaderField("authorization", ""),
+  HeaderField("cache-control", ""),
+  HeaderField("content-disposition", ""),
+  HeaderField("content-encoding", ""),
+  HeaderField("content-language", ""),
+  HeaderField("content-length", ""),
+  HeaderField("content-location", ""),
+  HeaderField("content-range", ""),
+  HeaderField("content-type", ""),
+  HeaderField("cookie", ""),
+  HeaderField("date", ""),
+  HeaderField("etag", ""),
+  HeaderField("expect", ""),
+  HeaderField("expires", ""),
+  HeaderField("from", ""),
+  HeaderField("host", ""),
+  HeaderField("if-match", ""),
+  HeaderField("if-modified-since", ""),
+  HeaderField("if-none-match", ""),
+  HeaderField("if-range", ""),
+  HeaderField("if-unmodified-since", ""),
+  HeaderField("last-modified", ""),
+  HeaderField("link", ""),
+  HeaderField("location", ""),
+  HeaderField("max-forwards", ""),
+  HeaderField("proxy-authenticate", ""),
+  HeaderField("proxy-authorization", ""),
+  HeaderField("range", ""),
+  HeaderField("referer", ""),
+  HeaderField("refresh", ""),
+  HeaderField("retry-after", ""),
+  HeaderField("server", ""),
+  HeaderField("set-cookie", ""),
+  HeaderField("strict-transport-security", ""),
+  HeaderField("transfer-encoding", ""),
+  HeaderField("user-agent", ""),
+  HeaderField("vary", ""),
+  HeaderField("via", ""),
+  HeaderField("www-authenticate", "")
+};
+
+// RFC7541 Appendix B. Last one is EOS.
+const uint32_t Hpack::huffmanCodes_[257] = {
+  0x1ff8, 0x7fffd8, 0xfffffe2, 0xfffffe3, 0xfffffe4, 0xfffffe5, 0xfffffe6, 0xfffffe7,
+  0xfffffe8, 0xffffea, 0x3ffffffc, 0xfffffe9, 0xfffffea, 0x3ffffffd, 0xfffffeb, 0xfffffec,
+  0xfffffed, 0xfffffee, 0xfffffef, 0xffffff0, 0xffffff1, 0xffffff2, 0x3ffffffe, 0xffffff3,
+  0xffffff4, 0xffffff5, 0xffffff6, 0xffffff7, 0xffffff8, 0xffffff9, 0xffffffa, 0xffffffb,
+  0x14, 0x3f8, 0x3f9, 0xffa, 0x1ff9, 0x15, 0xf8, 0x7fa,
+  0x3fa, 0x3fb, 0xf9, 0x7fb, 0xfa, 0x16, 0x17, 0x18,
+  0x0, 0x1, 0x2, 0x19, 0x1a, 0x1b, 0x1c, 0x1d,
+  0x1e, 0x1f, 0x5c, 0xfb, 0x7ffc, 0x20, 0xffb, 0x3fc,
+  0x1ffa, 0x21, 0x5d, 0x5e, 0x5f, 0x60, 0x61, 0x62,
+  0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6a,
+  0x6b, 0x6c, 0x6d, 0x6e, 0x6f, 0x70, 0x71, 0x72,
+  0xfc, 0x73, 0xfd, 0x1ffb, 0x7fff0, 0x1ffc, 0x3ffc, 0x22,
+  0x7ffd, 0x3, 0x23, 0x4, 0x24, 0x5, 0x25, 0x26,
+  0x27, 0x6, 0x74, 0x75, 0x28, 0x29, 0x2a, 0x7,
+  0x2b, 0x76, 0x2c, 0x8, 0x9, 0x2d, 0x77, 0x78,
+  0x79, 0x7a, 0x7b, 0x7ffe, 0x7fc, 0x3ffd, 0x1ffd, 0xffffffc,
+  0xfffe6, 0x3fffd2, 0xfffe7, 0xfffe8, 0x3fffd3, 0x3fffd4, 0x3fffd5, 0x7fffd9,
+  0x3fffd6, 0x7fffda, 0x7fffdb, 0x7fffdc, 0x7fffdd, 0x7fffde, 0xffffeb, 0x7fffdf,
+  0xffffec, 0xffffed, 0x3fffd7, 0x7fffe0, 0xffffee, 0x7fffe1, 0x7fffe2, 0x7fffe3,
+  0x7fffe4, 0x1fffdc, 0x3fffd8, 0x7fffe5, 0x3fffd9, 0x7fffe6, 0x7fffe7, 0xffffef,
+  0x3fffda, 0x1fffdd, 0xfffe9, 0x3fffdb, 0x3fffdc, 0x7fffe8, 0x7fffe9, 0x1fffde,
+  0x7fffea, 0x3fffdd, 0x3fffde, 0xfffff0, 0x1fffdf, 0x3fffdf, 0x7fffeb, 0x7fffec,
+  0x1fffe0, 0x1fffe1, 0x3fffe0, 0x1fffe2, 0x7fffed, 0x3fffe1, 0x7fffee, 0x7fffef,
+  0xfffea, 0x3fffe2, 0x3fffe3, 0x3fffe4, 0x7ffff0, 0x3fffe5, 0x3fffe6, 0x7ffff1,
+  0x3ffffe0, 0x3ffffe1, 0xfffeb, 0x7fff1, 0x3fffe7, 0x7ffff2, 0x3fffe8, 0x1ffffec,
+  0x3ffffe2, 0x3ffffe3, 0x3ffffe4, 0x7ffffde, 0x7ffffdf, 0x3ffffe5, 0xfffff1, 0x1ffffed,
+  0x7fff2, 0x1fffe3, 0x3ffffe6, 0x7ffffe0, 0x7ffffe1, 0x3ffffe7, 0x7ffffe2, 0xfffff2,
+  0x1fffe4, 0x1fffe5, 0x3ffffe8, 0x3ffffe9, 0xffffffd, 0x7ffffe3, 0x7ffffe4, 0x7ffffe5,
+  0xfffec, 0xfffff3, 0xfffed, 0x1fffe6, 0x3fffe9, 0x1fffe7, 0x1fffe8, 0x7ffff3,
+  0x3fffea, 0x3fffeb, 0x1ffffee, 0x1ffffef, 0xfffff4, 0xfffff5, 0x3ffffea, 0x7ffff4,
+  0x3ffffeb, 0x7ffffe6, 0x3ffffec, 0x3ffffed, 0x7ffffe7, 0x7ffffe8, 0x7ffffe9, 0x7ffffea,
+  0x7ffffeb, 0xffffffe, 0x7ffffec, 0x7ffffed, 0x7ffffee, 0x7ffffef, 0x7fffff0, 0x3ffffee,
+  0x3fffffff
+};
+
+const uint8_t Hpack::huffmanCodeLengths_[257] = {
+  13, 23, 28, 28, 28, 28, 28, 28, 28, 24, 30, 28, 28, 30, 28, 28,
+  28, 28, 28, 28, 28, 28, 30, 28, 28, 28, 28, 28, 28, 28, 28, 28,
+  6, 10, 10, 12, 13, 6, 8, 11, 10, 10, 8, 11, 8, 6, 6, 6,
+  5, 5, 5, 6, 6, 6, 6, 6, 6, 6, 7, 8, 15, 6, 12, 10,
+  13, 6, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+  7, 7, 7, 7, 7, 7, 7, 7, 8, 7, 8, 13, 19, 13, 14, 6,
+  15, 5, 6, 5, 6, 5, 6, 6, 6, 5, 7, 7, 6, 6, 6, 5,
+  6, 7, 6, 5, 5, 6, 7, 7, 7, 7, 7, 15, 11, 14, 13, 28,
+  20, 22, 20, 20, 22, 22, 22, 23, 22, 23, 23, 23, 23, 23, 24, 23,
+  24, 24, 22, 23, 24, 23, 23, 23, 23, 21, 22, 23, 22, 23, 23, 24,
+  22, 21, 20, 22, 22, 23, 23, 21, 23, 22, 22, 24, 21, 22, 23, 23,
+  21, 21, 22, 21, 23, 22, 23, 23, 20, 22, 22, 22, 23, 22, 22, 23,
+  26, 26, 20, 19, 22, 23, 22, 25, 26, 26, 26, 27, 27, 26, 24, 25,
+  19, 21, 26, 27, 27, 26, 27, 24, 21, 21, 26, 26, 28, 27, 27, 27,
+  20, 24, 20, 21, 22, 21, 21, 23, 22, 22, 25, 25, 24, 24, 26, 23,
+  26, 27, 26, 26, 27, 27, 27, 27, 27, 28, 27, 27, 27, 27, 27, 26,
+  30
+};
+
+
+// ===== Huffman Decoding Table =====
+namespace {
+
+// One entry per (state, 4 bits of input). State is an internal node of
+// the code tree. 0 is the root.
+struct HuffmanTransition {
+  uint8_t   nextState;
+  int16_t   symbol; // -1 when no symbol is completed.
+  bool      isFailed; // EOS in the input.
+};
+
+struct HuffmanDecodeTable {
+  HuffmanTransition transitions[256][16];
+  bool              isAccepting[256]; // Valid place for the input to end.
+};
+
+}
+
+static HuffmanDecodeTable* buildHuffmanDecodeTable(const uint32_t* codes,
+                                                   const uint8_t* codeLengths) {
+  struct Node {
+    int16_t child[2];
+    int16_t symbol;
+  };
+
+  std::vector<Node> nodes;
+  nodes.push_back(Node{{-1, -1}, -1});
+
+  for (int symbol = 0; 257 > symbol; ++symbol) {
+    size_t node = 0;
+    for (int bit = codeLengths[symbol] - 1; bit >= 0; --bit) {
+      int direction = (codes[symbol] >> bit) & 1;
+      if (nodes[node].child[direction] < 0) {
+        nodes[node].child[direction] = nodes.size();
+        nodes.push_back(Node{{-1, -1}, -1});
+      }
+      node = nodes[node].child[direction];
+    }
+    nodes[node].symbol = symbol;
+  }
+
+  // Number internal nodes in order so root is state 0.
+  std::vector<int16_t> stateOfNode(nodes.size(), -1);
+  std::vector<size_t> nodeOfState;
+  for (size_t i = 0; nodes.size() > i; ++i) {
+    if (nodes[i].symbol < 0) {
+      stateOfNode[i] = nodeOfState.size();
+      nodeOfState.push_back(i);
+    }
+  }
+
+  HuffmanDecodeTable* table = new HuffmanDecodeTable();
+
+  // Padding is the most significant bits of EOS, which are all 1s,
+  // and must be shorter than 8 bits.
+  for (size_t state = 0; 256 > state; ++state) {
+    table->isAccepting[state] = false;
+  }
+  size_t node = 0;
+  for (int depth = 0; 8 > depth; ++depth) {
+    table->isAccepting[stateOfNode[node]] = true;
+    node = nodes[node].child[1];
+  }
+
+  for (size_t state = 0; nodeOfState.size() > state; ++state) {
+    for (int nibble = 0; 16 > nibble; ++nibble) {
+      HuffmanTransition& transition = table->transitions[state][nibble];
+      transition.symbol = -1;
+      transition.isFailed = false;
+
+      size_t current = nodeOfState[state];
+      for (int bit = 3; bit >= 0; --bit) {
+        current = nodes[current].child[(nibble >> bit) & 1];
+        if (nodes[current].symbol >= 0) {
+          if (nodes[current].symbol == 256) {
+            transition.isFailed = true;
+          }
+          transition.symbol = nodes[current].symbol;
+          current = 0;
+        }
+      }
+      transition.nextState = stateOfNode[current];
+    }
+  }
+
+  return table;
+}
+// ===== Huffman Decoding Table End =====
+
+
+void Hpack::EncodeInteger(uint64_t value, uint8_t prefixBits,
+                          uint8_t firstByte, string& out) {
+  const uint64_t maxPrefix = (1 << prefixBits) - 1;
+  if (value < maxPrefix) {
+    out.push_back((char) (firstByte | value));
+    return;
+  }
+  out.push_back((char) (firstByte | maxPrefix));
+  value -= maxPrefix;
+  while (value >= 128) {
+    out.push_back((char) ((value & 0x7F) | 0x80));
+    value >>= 7;
+  }
+  out.push_back((char) value);
+}
+
+uint64_t Hpack::DecodeInteger(const uint8_t*& pos, const uint8_t* end,
+                              uint8_t prefixBits) {
+  if (pos >= end) {
+    throw Exception(ExceptionType::BAD_INTEGER);
+  }
+  const uint64_t maxPrefix = (1 << prefixBits) - 1;
+  uint64_t value = *pos & maxPrefix;
+  pos += 1;
+  if (value < maxPrefix) {
+    return value;
+  }
+
+  unsigned int shift = 0;
+  while (true) {
+    if (pos >= end || shift > 56) {
+      throw Exception(ExceptionType::BAD_INTEGER);
+    }
+    const uint8_t byte = *pos;
+    pos += 1;
+    value += (uint64_t) (byte & 0x7F) << shift;
+    shift += 7;
+    if ((byte & 0x80) == 0) {
+      break;
+    }
+  }
+  return value;
+}
+
+size_t Hpack::GetHuffmanEncodedLength(const string& value) {
+  size_t numBits = 0;
+  for (unsigned char c : value) {
+    numBits += huffmanCodeLengths_[c];
+  }
+  return (numBits + 7) / 8;
+}
+
+void Hpack::HuffmanEncode(const string& value, string& out) {
+  uint64_t bits = 0;
+  unsigned int numBits = 0;
+  for (unsigned char c : value) {
+    bits = (bits << huffmanCodeLengths_[c]) | huffmanCodes_[c];
+    numBits += huffmanCodeLengths_[c];
+    while (numBits >= 8) {
+      numBits -= 8;
+      out.push_back((char) (bits >> numBits));
+    }
+  }
+  if (numBits > 0) {
+    // Pad with the most significant bits of EOS.
+    out.push_back((char) ((bits << (8 - numBits)) | (0xFF >> numBits)));
+  }
+}
+
+void Hpack::HuffmanDecode(const uint8_t* data, size_t length, string& out) {
+  static const HuffmanDecodeTable* table =
+    buildHuffmanDecodeTable(huffmanCodes_, huffmanCodeLengths_);
+
+  uint8_t state = 0;
+  for (size_t i = 0; length > i; ++i) {
+    const HuffmanTransition& high = table->transitions[state][data[i] >> 4];
+    if (high.isFailed == true) {
+      throw Exception(ExceptionType::BAD_HUFFMAN);
+    }
+    if (high.symbol >= 0) {
+      out.push_back((char) high.symbol);
+    }
+
+    const HuffmanTransition& low = table->transitions[high.nextState][data[i] & 0x0F];
+    if (low.isFailed == true) {
+      throw Exception(ExceptionType::BAD_HUFFMAN);
+    }
+    if (low.symbol >= 0) {
+      out.push_back((char) low.symbol);
+    }
+    state = low.nextState;
+  }
+
+  if (table->isAccepting[state] == false) {
+    throw Exception(ExceptionType::BAD_HUFFMAN);
+  }
+}
+
+
+// ===== DynamicTable =====
+Hpack::DynamicTable::DynamicTable(size_t maxSize) :
+  size_(0),
+  maxSize_(maxSize)
+{ }
+
+void Hpack::DynamicTable::Add(const HeaderField& field) {
+  const size_t fieldSize = field.GetSize();
+  if (fieldSize > this->maxSize_) {
+    // Adding an entry larger than the table empties the table.
+    this->entries_.clear();
+    this->size_ = 0;
+    return;
+  }
+  this->evict(fieldSize);
+  this->entries_.push_front(field);
+  this->entries_.front().isSensitive = false;
+  this->size_ += fieldSize;
+}
+
+void Hpack::DynamicTable::SetMaxSize(size_t maxSize) {
+  this->maxSize_ = maxSize;
+  this->evict(0);
+}
+
+const Hpack::HeaderField& Hpack::DynamicTable::Get(size_t index) const {
+  return this->entries_[index];
+}
+
+size_t Hpack::DynamicTable::GetNumEntries() const {
+  return this->entries_.size();
+}
+
+size_t Hpack::DynamicTable::GetSize() const {
+  return this->size_;
+}
+
+size_t Hpack::DynamicTable::GetMaxSize() const {
+  return this->maxSize_;
+}
+
+void Hpack::DynamicTable::evict(size_t requiredSize) {
+  while (this->entries_.empty() == false &&
+         this->size_ + requiredSize > this->maxSize_) {
+    this->size_ -= this->entries_.back().GetSize();
+    this->entries_.pop_back();
+  }
+}
+// ===== DynamicTable End =====
+
+
+// ===== Decoder =====
+Hpack::Decoder::Decoder(size_t maxTableSize, size_t maxHeaderListSize) :
+  table_(maxTableSize),
+  maxTableSize_(maxTableSize),
+  maxHeaderListSize_(maxHeaderListSize)
+{ }
+
+void Hpack::Decoder::Decode(const uint8_t* data, size_t length, HeaderList& headers) {
+  const uint8_t* pos = data;
+  const uint8_t* end = data + length;
+  size_t headerListSize = 0;
+  bool isSizeUpdateAllowed = true;
+
+  while (end > pos) {
+    const uint8_t first = *pos;
+    HeaderField field;
+
+    if (first & 0x80) {
+      // Indexed Header Field
+      field = this->getField(DecodeInteger(pos, end, 7));
+
+    } else if ((first & 0xE0) == 0x20) {
+      // Dynamic Table Size Update
+      if (isSizeUpdateAllowed == false) {
+        throw Exception(ExceptionType::BAD_TABLE_SIZE);
+      }
+      uint64_t newSize = DecodeInteger(pos, end, 5);
+      if (newSize > this->maxTableSize_) {
+        throw Exception(ExceptionType::BAD_TABLE_SIZE);
+      }
+      this->table_.SetMaxSize(newSize);
+      continue;
+
+    } else {
+      // Literal Header Field
+      //  01xxxxxx with Incremental Indexing
+      //  0000xxxx without Indexing
+      //  0001xxxx Never Indexed
+      const bool isIndexing = (first & 0xC0) == 0x40;
+      const uint8_t prefixBits = isIndexing ? 6 : 4;
+
+      uint64_t nameIndex = DecodeInteger(pos, end, prefixBits);
+      if (nameIndex == 0) {
+        field.name = this->readString(pos, end);
+      } else {
+        field.name = this->getField(nameIndex).name;
+      }
+      field.value = this->readString(pos, end);
+      field.isSensitive = (first & 0xF0) == 0x10;
+
+      if (isIndexing == true) {
+        this->table_.Add(field);
+      }
+    }
+
+    isSizeUpdateAllowed = false;
+    headerListSize += field.GetSize();
+    if (headerListSize > this->maxHeaderListSize_) {
+      throw Exception(ExceptionType::HEADER_LIST_TOO_LARGE);
+    }
+    headers.push_back(std::move(field));
+  }
+}
+
+void Hpack::Decoder::SetMaxTableSize(size_t maxTableSize) {
+  this->maxTableSize_ = maxTableSize;
+  if (this->table_.GetMaxSize() > maxTableSize) {
+    this->table_.SetMaxSize(maxTableSize);
+  }
+}
+
+const Hpack::DynamicTable& Hpack::Decoder::GetTable() const {
+  return this->table_;
+}
+
+const Hpack::HeaderField& Hpack::Decoder::getField(size_t index) const {
+  if (index == 0) {
+    throw Exception(ExceptionType::BAD_INDEX);
+  }
+  if (STATIC_TABLE_SIZE >= index) {
+    return staticTable_[index - 1];
+  }
+  index -= STATIC_TABLE_SIZE + 1;
+  if (index >= this->table_.GetNumEntries()) {
+    throw Exception(ExceptionType::BAD_INDEX);
+  }
+  return this->table_.Get(index);
+}
+
+string Hpack::Decoder::readString(const uint8_t*& pos, const uint8_t* end) {
+  if (pos >= end) {
+    throw Exception(ExceptionType::BAD_STRING);
+  }
+  const bool isHuffman = (*pos & 0x80) != 0;
+  uint64_t length = DecodeInteger(pos, end, 7);
+  if (length > (uint64_t) (end - pos)) {
+    throw Exception(ExceptionType::BAD_STRING);
+  }
+
+  string result;
+  if (isHuffman == true) {
+    result.reserve(length * 8 / 5);
+    HuffmanDecode(pos, length, result);
+  } else {
+    result.assign((const char*) pos, length);
+  }
+  pos += length;
+  return result;
+}
+// ===== Decoder End =====
+
+
+// ===== Encoder =====
+Hpack::Encoder::Encoder(size_t maxTableSize) :
+  table_(maxTableSize),
+  isTableSizeChanged_(false)
+{ }
+
+void Hpack::Encoder::Encode(const HeaderList& headers, string& out) {
+  for (const HeaderField& field : headers) {
+    this->Encode(field, out);
+  }
+}
+
+void Hpack::Encoder::Encode(const HeaderField& field, string& out) {
+  if (this->isTableSizeChanged_ == true) {
+    EncodeInteger(this->table_.GetMaxSize(), 5, 0x20, out);
+    this->isTableSizeChanged_ = false;
+  }
+
+  bool isValueMatched = false;
+  const size_t index = this->find(field, isValueMatched);
+
+  if (isValueMatched == true && field.isSensitive == false) {
+    EncodeInteger(index, 7, 0x80, out);
+    return;
+  }
+
+  if (field.isSensitive == true) {
+    EncodeInteger(index, 4, 0x10, out);
+  } else if (field.GetSize() > this->table_.GetMaxSize() / 2) {
+    // Would push most of the table out. Not worth indexing.
+    EncodeInteger(index, 4, 0x00, out);
+  } else {
+    EncodeInteger(index, 6, 0x40, out);
+    this->table_.Add(field);
+  }
+
+  if (index == 0) {
+    this->writeString(field.name, out);
+  }
+  this->writeString(field.value, out);
+}
+
+void Hpack::Encoder::SetMaxTableSize(size_t maxTableSize) {
+  // Table is never made bigger than the default to bound memory.
+  if (maxTableSize > DEFAULT_TABLE_SIZE) {
+    maxTableSize = DEFAULT_TABLE_SIZE;
+  }
+  if (maxTableSize != this->table_.GetMaxSize()) {
+    this->table_.SetMaxSize(maxTableSize);
+    this->isTableSizeChanged_ = true;
+  }
+}
+
+const Hpack::DynamicTable& Hpack::Encoder::GetTable() const {
+  return this->table_;
+}
+
+size_t Hpack::Encoder::find(const HeaderField& field, bool& isValueMatched) const {
+  size_t nameIndex = 0;
+  isValueMatched = false;
+
+  for (size_t i = 0; STATIC_TABLE_SIZE > i; ++i) {
+    const HeaderField& entry = staticTable_[i];
+    if (entry.name == field.name) {
+      if (entry.value == field.value) {
+        isValueMatched = true;
+        return i + 1;
+      }
+      if (nameIndex == 0) {
+        nameIndex = i + 1;
+      }
+    }
+  }
+
+  const size_t numEntries = this->table_.GetNumEntries();
+  for (size_t i = 0; numEntries > i; ++i) {
+    const HeaderField& entry = this->table_.Get(i);
+    if (entry.name == field.name) {
+      if (entry.value == field.value) {
+        isValueMatched = true;
+        return STATIC_TABLE_SIZE + 1 + i;
+      }
+      if (nameIndex == 0) {
+        nameIndex = STATIC_TABLE_SIZE + 1 + i;
+      }
+    }
+  }
+
+  return nameIndex;
+}
+
+void Hpack::Encoder::writeString(const string& value, string& out) {
+  const size_t huffmanLength = GetHuffmanEncodedLength(value);
+  if (huffmanLength < value.length()) {
+    EncodeInteger(huffmanLength, 7, 0x80, out);
+    HuffmanEncode(value, out);
+  } else {
+    EncodeInteger(value.length(), 7, 0x00, out);
+    out.append(value);
+  }
+}
+// ===== Encoder End =====
+
+//Hpack::
+
+}
+
+#if _UNIT_TEST
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include <string>
+
+using namespace lio;
+using std::string;
+
+static string fromHex(const string& hex) {
+  string result;
+  for (size_t i = 0; hex.length() > i + 1; ) {
+    if (hex[i] == ' ') {
+      i += 1;
+      continue;
+    }
+    result.push_back((char) std::stoi(hex.substr(i, 2), nullptr, 16));
+    i += 2;
+  }
+  return result;
+}
+
+static Hpack::HeaderList decode(Hpack::Decoder& decoder, const string& hex) {
+  string block = fromHex(hex);
+  Hpack::HeaderList headers;
+  decoder.Decode((const uint8_t*) block.c_str(), block.length(), headers);
+  return headers;
+}
+
+TEST(Hpack, Integer) {
+  // RFC7541 C.1
+  string out;
+  Hpack::EncodeInteger(10, 5, 0, out);
+  EXPECT_EQ(out, fromHex("0a"));
+  out.clear();
+  Hpack::EncodeInteger(1337, 5, 0, out);
+  EXPECT_EQ(out, fromHex("1f9a0a"));
+
+  const uint8_t* pos = (const uint8_t*) out.c_str();
+  EXPECT_EQ(Hpack::DecodeInteger(pos, pos + out.length(), 5), 1337);
+
+  string truncated = fromHex("1f9a");
+  pos = (const uint8_t*) truncated.c_str();
+  EXPECT_THROW(Hpack::DecodeInteger(pos, pos + truncated.length(), 5), Hpack::Exception);
+}
+
+TEST(Hpack, Huffman) {
+  string encoded;
+  Hpack::HuffmanEncode("www.example.com", encoded);
+  EXPECT_EQ(encoded, fromHex("f1e3 c2e5 f23a 6ba0 ab90 f4ff"));
+
+  string decoded;
+  Hpack::HuffmanDecode((const uint8_t*) encoded.c_str(), encoded.length(), decoded);
+  EXPECT_EQ(decoded, "www.example.com");
+
+  string all;
+  for (int i = 0; 256 > i; ++i) {
+    all.push_back((char) i);
+  }
+  encoded.clear();
+  decoded.clear();
+  Hpack::HuffmanEncode(all, encoded);
+  Hpack::HuffmanDecode((const uint8_t*) encoded.c_str(), encoded.length(), decoded);
+  EXPECT_EQ(decoded, all);
+
+  // Padding longer than 7 bits.
+  string badPadding = fromHex("f1e3 c2e5 f23a 6ba0 ab90 f4ff ff");
+  decoded.clear();
+  EXPECT_THROW(Hpack::HuffmanDecode((const uint8_t*) badPadding.c_str(),
+                                    badPadding.length(), decoded), Hpack::Exception);
+}
+
+TEST(Hpack, DecodeRequests) {
+  // RFC7541 C.4 Request Examples with Huffman Coding
+  Hpack::Decoder decoder;
+
+  Hpack::HeaderList headers = decode(decoder, "8286 8441 8cf1 e3c2 e5f2 3a6b a0ab 90f4 ff");
+  ASSERT_EQ(headers.size(), 4);
+  EXPECT_EQ(headers[0].name, ":method");
+  EXPECT_EQ(headers[0].value, "GET");
+  EXPECT_EQ(headers[3].name, ":authority");
+  EXPECT_EQ(headers[3].value, "www.example.com");
+  EXPECT_EQ(decoder.GetTable().GetSize(), 57);
+
+  headers = decode(decoder, "8286 84be 5886 a8eb 1064 9cbf");
+  ASSERT_EQ(headers.size(), 5);
+  EXPECT_EQ(headers[3].value, "www.example.com");
+  EXPECT_EQ(headers[4].name, "cache-control");
+  EXPECT_EQ(headers[4].value, "no-cache");
+  EXPECT_EQ(decoder.GetTable().GetSize(), 110);
+
+  headers = decode(decoder,
+      "8287 85bf 4088 25a8 49e9 5ba9 7d7f 8925 a849 e95b b8e8 b4bf");
+  ASSERT_EQ(headers.size(), 5);
+  EXPECT_EQ(headers[1].value, "https");
+  EXPECT_EQ(headers[2].value, "/index.html");
+  EXPECT_EQ(headers[4].name, "custom-key");
+  EXPECT_EQ(headers[4].value, "custom-value");
+  EXPECT_EQ(decoder.GetTable().GetSize(), 164);
+
+  EXPECT_THROW(decode(decoder, "ff00"), Hpack::Exception);
+}
+
+TEST(Hpack, EncodeDecode) {
+  Hpack::Encoder encoder;
+  Hpack::Decoder decoder;
+
+  Hpack::HeaderList headers;
+  headers.push_back(Hpack::HeaderField(":status", "200"));
+  headers.push_back(Hpack::HeaderField("content-type", "application/json"));
+  headers.push_back(Hpack::HeaderField("content-length", "27"));
+  headers.push_back(Hpack::HeaderField("set-cookie", "sid=secret", true));
+
+  for (int round = 0; 3 > round; ++round) {
+    string block;
+    encoder.Encode(headers, block);
+    if (round > 0) {
+      // Only the sensitive field is sent as a literal after the first block.
+      EXPECT_LT(block.length(), 16);
+    }
+
+    Hpack::HeaderList decoded;
+    decoder.Decode((const uint8_t*) block.c_str(), block.length(), decoded);
+    ASSERT_EQ(decoded.size(), headers.size());
+    for (size_t i = 0; headers.size() > i; ++i) {
+      EXPECT_EQ(decoded[i].name, headers[i].name);
+      EXPECT_EQ(decoded[i].value, headers[i].value);
+    }
+    EXPECT_EQ(decoded[3].isSensitive, true);
+  }
+
+  encoder.SetMaxTableSize(0);
+  string block;
+  encoder.Encode(headers, block);
+  Hpack::HeaderList decoded;
+  decoder.Decode((const uint8_t*) block.c_str(), block.length(), decoded);
+  EXPECT_EQ(decoder.GetTable().GetNumEntries(), 0);
+}
+
+int main (int argc, char** argv) {
+  ::testing::InitGoogleMock(&argc, argv);
+  return RUN_ALL_TESTS();
+}
+
+#else
+// Executable File's Main Comes here.
+
+
+#endif
+
+#undef _UNIT_TEST
@@ -0,0 +1,213 @@
+#ifndef _HPACK_HPP_
+#define _HPACK_HPP_
+/*
+  Name
+    Hpack
+      Header compression for HTTP/2.
+
+  Description
+    Decoder
+      Decodes a header block into HeaderList. Keeps its own dynamic table,
+      one per connection in the receiving direction.
+
+    Encoder
+      Encodes HeaderList into a header block. Fields found in the static or
+      dynamic table are sent as indexes. Others are added to the dynamic
+      table unless they are sensitive. String literals are Huffman coded
+      when it makes them shorter.
+
+    Huffman decoding walks the code tree 4 bits at a time using a state
+    table that is built once from the code table.
+
+  Last Modified Date
+    Oct 19, 2026
+
+  History
+    October 19, 2026
+      Created
+
+  ToDos
+
+
+  Milestones
+    1.0
+
+
+  Learning Resources
+    HPACK: Header Compression for HTTP/2
+      http://tools.ietf.org/html/rfc7541
+
+  Copyright (c) All rights reserved to LIFEINO.
+*/
+
+#ifdef _DEBUG
+  #undef _DEBUG
+#endif
+#define _DEBUG false
+
+#include "liolib/Debug.hpp"
+
+#include <string>
+#include <vector>
+#include <deque>
+
+#include <cstdint>
+
+namespace lio {
+
+using std::string;
+
+
+class Hpack {
+public:
+
+// ******** Exception Declaration *********
+enum class ExceptionType : std::uint8_t {
+  GENERAL,
+  BAD_INTEGER,
+  BAD_INDEX,
+  BAD_STRING,
+  BAD_HUFFMAN,
+  BAD_TABLE_SIZE,
+  HEADER_LIST_TOO_LARGE
+};
+#define HPACK_EXCEPTION_MESSAGES \
+  "Hpack Exception has been thrown.", \
+  "Integer is truncated or too big.", \
+  "Index is not in the table.", \
+  "String literal is truncated.", \
+  "Huffman coded string is invalid.", \
+  "Dynamic table size update is invalid.", \
+  "Decoded header list is too large."
+
+class Exception : public std::exception {
+public:
+  Exception (ExceptionType exceptionType = ExceptionType::GENERAL);
+
+  virtual const char*         what() const noexcept;
+  virtual const               ExceptionType type() const noexcept;
+
+private:
+  const ExceptionType         exceptionType_;
+  static const char* const    exceptionMessages_[];
+};
+// ******** Exception Declaration END*********
+
+  struct HeaderField {
+    HeaderField() :
+      isSensitive(false)
+    { }
+    HeaderField(const string& fieldName, const string& fieldValue,
+                bool isFieldSensitive = false) :
+      name(fieldName),
+      value(fieldValue),
+      isSensitive(isFieldSensitive)
+    { }
+
+    // Size as counted by the dynamic table.
+    size_t GetSize() const {
+      return this->name.length() + this->value.length() + 32;
+    }
+
+    string name;
+    string value;
+    bool isSensitive; // Never indexed.
+  };
+
+  typedef std::vector<HeaderField> HeaderList;
+
+  static const size_t DEFAULT_TABLE_SIZE = 4096;
+  static const size_t STATIC_TABLE_SIZE = 61;
+
+  class DynamicTable {
+  public:
+    DynamicTable(size_t maxSize = DEFAULT_TABLE_SIZE);
+
+    void              Add(const HeaderField& field);
+    void              SetMaxSize(size_t maxSize);
+
+    // index starts at 0 for the newest entry.
+    const HeaderField& Get(size_t index) const;
+    size_t            GetNumEntries() const;
+    size_t            GetSize() const;
+    size_t            GetMaxSize() const;
+
+  private:
+    std::deque<HeaderField> entries_;
+    size_t            size_;
+    size_t            maxSize_;
+
+    void              evict(size_t requiredSize);
+  };
+
+  class Decoder {
+  public:
+    Decoder(size_t maxTableSize = DEFAULT_TABLE_SIZE,
+            size_t maxHeaderListSize = 1024 * 64);
+
+    // Appends decoded fields to headers. Throws on malformed block.
+    void              Decode(const uint8_t* data, size_t length, HeaderList& headers);
+
+    // Upper bound the peer may set the table to. SETTINGS_HEADER_TABLE_SIZE.
+    void              SetMaxTableSize(size_t maxTableSize);
+
+    const DynamicTable& GetTable() const;
+
+  private:
+    DynamicTable      table_;
+    size_t            maxTableSize_;
+    size_t            maxHeaderListSize_;
+
+    const HeaderField& getField(size_t index) const;
+    string            readString(const uint8_t*& pos, const uint8_t* end);
+  };
+
+  class Encoder {
+  public:
+    Encoder(size_t maxTableSize = DEFAULT_TABLE_SIZE);
+
+    void              Encode(const HeaderList& headers, string& out);
+    void              Encode(const HeaderField& field, string& out);
+
+    // Peer's SETTINGS_HEADER_TABLE_SIZE. Size update is sent with next block.
+    void              SetMaxTableSize(size_t maxTableSize);
+
+    const DynamicTable& GetTable() const;
+
+  private:
+    DynamicTable      table_;
+    bool              isTableSizeChanged_;
+
+    // Returns 1 based index. 0 if not found. isValueMatched is set when
+    // both name and value matched.
+    size_t            find(const HeaderField& field, bool& isValueMatched) const;
+    void              writeString(const string& value, string& out);
+  };
+
+  static
+  void            EncodeInteger(uint64_t value, uint8_t prefixBits,
+                                uint8_t firstByte, string& out);
+  // Advances pos. Throws when truncated.
+  static
+  uint64_t        DecodeInteger(const uint8_t*& pos, const uint8_t* end,
+                                uint8_t prefixBits);
+
+  static
+  size_t          GetHuffmanEncodedLength(const string& value);
+  static
+  void            HuffmanEncode(const string& value, string& out);
+  static
+  void            HuffmanDecode(const uint8_t* data, size_t length, string& out);
+
+private:
+  static const HeaderField staticTable_[STATIC_TABLE_SIZE];
+  static const uint32_t huffmanCodes_[257];
+  static const uint8_t  huffmanCodeLengths_[257];
+
+  Hpack() = delete;
+};
+
+}
+
+#endif
+
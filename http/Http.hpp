@@ -45,6 +45,16 @@ const string RequestMethodString[] = {
   "CONNECT"
 };
     
+// Content codings of a body. Order is the server preference when
+// Accept-Encoding qualities tie. Best first.
+enum class ContentEncoding : uint8_t {
+  BROTLI = 0,
+  ZSTD,
+  GZIP,
+  IDENTITY
+};
+const size_t NUM_CONTENT_ENCODINGS = 4;
+
 enum class RequestField : uint8_t {
   ACCEPT = 0,
   ACCEPT_CHARSET,
@@ -164,7 +174,7 @@ const string ContentTypeString[] = {
   "audio/ogg",
   "application/zip",
   "application/x-www-form-urlencoded",
-  "multipart/formdata"
+  "multipart/form-data"
 };
 
 enum class ContentCharset : uint8_t {
@@ -181,12 +191,16 @@ enum class ResponseCode : uint8_t {
   UNDEF = 0,
   CONTINUE, // 100 continue
   OK, // 200 OK
+  PARTIAL_CONTENT, // 206 Partial Content
+  NOT_MODIFIED, // 304 Not Modified
   BAD_REQUEST, // 400 Bad Request
   NOT_FOUND, // 404 Not Found
   METHOD_NOT_ALLOWED, // 405 Method Not Allowed
   LENGTH_REQUIRED, // 411 Length Required
   REQUEST_ENTITY_TOO_LARGE, // The request is larger than the server is willing or able to process.
   REQUEST_URI_TOO_LONG,
+  PRECONDITION_FAILED, // 412 Precondition Failed
+  RANGE_NOT_SATISFIABLE, // 416 Range Not Satisfiable
   SERVER_ERROR, // 500 Internal Server Error
   SERVICE_UNAVAILABLE // 503 Service Unavailable
 };
@@ -195,17 +209,68 @@ const string ResponseCodeString[] = {
   "Undefined",
   "100 Continue",
   "200 OK",
+  "206 Partial Content",
+  "304 Not Modified",
   "400 Bad Request",
   "404 Not Found",
   "405 Method Not Allowed",
   "411 Length Required",
   "413 Request Entity Too Large",
   "414 Request-URI Too Long",
+  "412 Precondition Failed",
+  "416 Range Not Satisfiable",
   "500 Internal Server Error",
   "503 Service Unavailable"
 };
 
 
+// Bytes that are copied as they are into response headers.
+struct ByteTemplate {
+  const char* data;
+  size_t length;
+};
+#define HTTP_BYTE_TEMPLATE(text) { text, sizeof(text) - 1 }
+
+// Indexed by ResponseCode. Must be kept in sync with ResponseCodeString.
+const ByteTemplate StatusLineTemplate[] = {
+  HTTP_BYTE_TEMPLATE("HTTP/1.1 Undefined\r\n"),
+  HTTP_BYTE_TEMPLATE("HTTP/1.1 100 Continue\r\n"),
+  HTTP_BYTE_TEMPLATE("HTTP/1.1 200 OK\r\n"),
+  HTTP_BYTE_TEMPLATE("HTTP/1.1 206 Partial Content\r\n"),
+  HTTP_BYTE_TEMPLATE("HTTP/1.1 304 Not Modified\r\n"),
+  HTTP_BYTE_TEMPLATE("HTTP/1.1 400 Bad Request\r\n"),
+  HTTP_BYTE_TEMPLATE("HTTP/1.1 404 Not Found\r\n"),
+  HTTP_BYTE_TEMPLATE("HTTP/1.1 405 Method Not Allowed\r\n"),
+  HTTP_BYTE_TEMPLATE("HTTP/1.1 411 Length Required\r\n"),
+  HTTP_BYTE_TEMPLATE("HTTP/1.1 413 Request Entity Too Large\r\n"),
+  HTTP_BYTE_TEMPLATE("HTTP/1.1 414 Request-URI Too Long\r\n"),
+  HTTP_BYTE_TEMPLATE("HTTP/1.1 412 Precondition Failed\r\n"),
+  HTTP_BYTE_TEMPLATE("HTTP/1.1 416 Range Not Satisfiable\r\n"),
+  HTTP_BYTE_TEMPLATE("HTTP/1.1 500 Internal Server Error\r\n"),
+  HTTP_BYTE_TEMPLATE("HTTP/1.1 503 Service Unavailable\r\n")
+};
+
+enum class HeaderTemplate : uint8_t {
+  CONTENT_LENGTH = 0, // Followed by number and CRLF
+  CONTENT_TYPE, // Followed by type and CRLF
+  CONTENT_ENCODING_GZIP,
+  TRANSFER_ENCODING_CHUNKED,
+  CONNECTION_KEEP_ALIVE,
+  CONNECTION_CLOSE
+};
+
+const ByteTemplate HeaderTemplateBytes[] = {
+  HTTP_BYTE_TEMPLATE("Content-Length: "),
+  HTTP_BYTE_TEMPLATE("Content-Type: "),
+  HTTP_BYTE_TEMPLATE("Content-Encoding: gzip\r\n"),
+  HTTP_BYTE_TEMPLATE("Transfer-Encoding: chunked\r\n"),
+  HTTP_BYTE_TEMPLATE("Connection: keep-alive\r\n"),
+  HTTP_BYTE_TEMPLATE("Connection: close\r\n")
+};
+
+#undef HTTP_BYTE_TEMPLATE
+
+
 struct CookieOptions {
   CookieOptions() :
     domain(),
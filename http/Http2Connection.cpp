@@ -0,0 +1,1455 @@
+
+#include "Http2Connection.hpp"
+
+#define _UNIT_TEST false
+#include "liolib/Test.hpp"
+
+
+namespace lio {
+
+// ===== Exception Implementation =====
+const char* const
+Http2Connection::Exception::exceptionMessages_[] = {
+  HTTP2CONNECTION_EXCEPTION_MESSAGES
+};
+#undef HTTP2CONNECTION_EXCEPTION_MESSAGES // undef helps reducing unnecessary preprocessing work.
+
+
+Http2Connection::Exception::Exception(ExceptionType exceptionType) :
+  exceptionType_(exceptionType) { }
+
+const char*
+Http2Connection::Exception::what() const noexcept {
+  return this->exceptionMessages_[(int) this->exceptionType_];
+}
+
+const Http2Connection::ExceptionType
+Http2Connection::Exception::type() const noexcept {
+  return this->exceptionType_;
+}
+// ===== Exception Implementation End =====
+
+const size_t Http2Connection::PREFACE_LENGTH;
+const uint32_t Http2Connection::DEFAULT_FRAME_SIZE;
+const uint32_t Http2Connection::DEFAULT_WINDOW_SIZE;
+const size_t Http2Connection::FRAME_HEADER_LENGTH;
+const uint8_t Http2Connection::FLAG_END_STREAM;
+const uint8_t Http2Connection::FLAG_ACK;
+const uint8_t Http2Connection::FLAG_END_HEADERS;
+const uint8_t Http2Connection::FLAG_PADDED;
+const uint8_t Http2Connection::FLAG_PRIORITY;
+
+static const char CONNECTION_PREFACE[] = "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n";
+static const int64_t MAX_WINDOW_SIZE = 0x7FFFFFFF;
+
+
+Http2Connection::Http2Connection(int fd, RequestHandler handler, Config config) :
+  fd_(fd),
+  handler_(handler),
+  config_(config),
+  decoder_(Hpack::DEFAULT_TABLE_SIZE, config.maxHeaderListSize),
+  lastStreamId_(0),
+  isPrefaceReceived_(false),
+  isGoAwaySent_(false),
+  isGoAwayReceived_(false),
+  isInputPaused_(false),
+  isClosed_(false),
+  continuationStreamId_(0),
+  isContinuationEndStream_(false),
+  inputOffset_(0),
+  outputOffset_(0),
+  numQueuedControlFrames_(0),
+  connectionSendWindow_(DEFAULT_WINDOW_SIZE),
+  numConnectionUnackedBytes_(0),
+  peerInitialWindowSize_(DEFAULT_WINDOW_SIZE),
+  peerMaxFrameSize_(DEFAULT_FRAME_SIZE)
+{
+  DEBUG_FUNC_START; // Prints out function name in yellow
+
+  if (this->config_.maxFrameSize < DEFAULT_FRAME_SIZE) {
+    this->config_.maxFrameSize = DEFAULT_FRAME_SIZE;
+  }
+
+  this->writeSettings();
+  if (this->config_.initialWindowSize > DEFAULT_WINDOW_SIZE) {
+    // Connection window can only be changed by WINDOW_UPDATE.
+    this->writeWindowUpdate(0, this->config_.initialWindowSize - DEFAULT_WINDOW_SIZE);
+  }
+}
+
+Http2Connection::~Http2Connection() {
+  DEBUG_FUNC_START;
+
+}
+
+Http2Connection::Status Http2Connection::OnReadable() {
+  char buffer[1024 * 16];
+  while (this->isClosed_ == false && this->isInputPaused_ == false) {
+    ssize_t readCount = read(this->fd_, buffer, sizeof(buffer));
+    if (readCount < 0) {
+      if (errno == EINTR) {
+        continue;
+      } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+        break;
+      }
+      DEBUG_cerr << "read has failed. errno: " << errno << endl;
+      this->isClosed_ = true;
+      break;
+    } else if (readCount == 0) {
+      // Peer has closed the connection.
+      this->isClosed_ = true;
+      break;
+    }
+
+    this->input_.append(buffer, readCount);
+    this->process();
+  }
+
+  return this->flush();
+}
+
+Http2Connection::Status Http2Connection::OnWritable() {
+  Status status = this->flush();
+  if (status == Status::OK && this->isClosed_ == false) {
+    // Output has drained. Continue streams held back by the watermark.
+    this->sendPendingStreams();
+    if (this->isInputPaused_ == true) {
+      // Buffered input first, then the socket.
+      this->isInputPaused_ = false;
+      this->process();
+      return this->OnReadable();
+    }
+    status = this->flush();
+  }
+  return status;
+}
+
+Http2Connection::Status Http2Connection::Feed(const char* data, size_t length) {
+  if (this->isClosed_ == false) {
+    this->input_.append(data, length);
+    this->process();
+  }
+  return this->flush();
+}
+
+bool Http2Connection::IsClosed() const {
+  return this->isClosed_;
+}
+
+size_t Http2Connection::GetNumStreams() const {
+  return this->streams_.size();
+}
+
+size_t Http2Connection::GetPendingSize() const {
+  return this->output_.length() - this->outputOffset_;
+}
+
+bool Http2Connection::IsPreface(const char* data, size_t length) {
+  if (length > PREFACE_LENGTH) {
+    length = PREFACE_LENGTH;
+  }
+  return memcmp(data, CONNECTION_PREFACE, length) == 0;
+}
+
+void Http2Connection::process() {
+  while (this->isClosed_ == false) {
+    if (this->numQueuedControlFrames_ >= this->config_.maxQueuedControlFrames) {
+      const Status status = this->flush();
+      if (status == Status::CLOSED) {
+        break;
+      } else if (status == Status::WOULD_BLOCK) {
+        // Peer keeps asking for replies and does not read them. ex) PING flood
+        DEBUG_cerr << "Too many control frames are queued." << endl;
+        this->connectionError(ErrorCode::ENHANCE_YOUR_CALM);
+        break;
+      }
+    }
+    if (this->GetPendingSize() > this->config_.outputHighWatermark &&
+        this->flush() != Status::OK) {
+      // Peer is not reading. Input is kept until OnWritable() drains output.
+      this->isInputPaused_ = true;
+      break;
+    }
+
+    const size_t available = this->input_.length() - this->inputOffset_;
+    const uint8_t* data = (const uint8_t*) this->input_.c_str() + this->inputOffset_;
+
+    if (this->isPrefaceReceived_ == false) {
+      if (IsPreface((const char*) data, available) == false) {
+        DEBUG_cerr << "Invalid connection preface." << endl;
+        this->connectionError(ErrorCode::PROTOCOL_ERROR);
+        break;
+      }
+      if (PREFACE_LENGTH > available) {
+        break;
+      }
+      this->isPrefaceReceived_ = true;
+      this->inputOffset_ += PREFACE_LENGTH;
+      continue;
+    }
+
+    if (FRAME_HEADER_LENGTH > available) {
+      break;
+    }
+
+    const size_t length = (data[0] << 16) | (data[1] << 8) | data[2];
+    const FrameType type = (FrameType) data[3];
+    const uint8_t flags = data[4];
+    const uint32_t streamId = readUInt32(data + 5) & 0x7FFFFFFF;
+
+    if (length > this->config_.maxFrameSize) {
+      DEBUG_cerr << "Frame is larger than SETTINGS_MAX_FRAME_SIZE. length: " << length << endl;
+      this->connectionError(ErrorCode::FRAME_SIZE_ERROR);
+      break;
+    }
+    if (FRAME_HEADER_LENGTH + length > available) {
+      break;
+    }
+
+    this->inputOffset_ += FRAME_HEADER_LENGTH + length;
+    if (this->handleFrame(type, flags, streamId,
+                          data + FRAME_HEADER_LENGTH, length) == false) {
+      break;
+    }
+  }
+
+  // Drop processed bytes.
+  if (this->inputOffset_ > 0) {
+    this->input_.erase(0, this->inputOffset_);
+    this->inputOffset_ = 0;
+  }
+}
+
+bool Http2Connection::handleFrame(FrameType type, uint8_t flags, uint32_t streamId,
+                                  const uint8_t* payload, size_t length) {
+  if (this->continuationStreamId_ != 0 && type != FrameType::CONTINUATION) {
+    DEBUG_cerr << "CONTINUATION is expected." << endl;
+    return this->connectionError(ErrorCode::PROTOCOL_ERROR);
+  }
+
+  switch (type) {
+   case FrameType::DATA:
+    return this->handleData(flags, streamId, payload, length);
+
+   case FrameType::HEADERS:
+    return this->handleHeaders(flags, streamId, payload, length);
+
+   case FrameType::CONTINUATION:
+    return this->handleContinuation(flags, streamId, payload, length);
+
+   case FrameType::PRIORITY:
+    if (streamId == 0) {
+      return this->connectionError(ErrorCode::PROTOCOL_ERROR);
+    }
+    if (length != 5) {
+      this->streamError(streamId, ErrorCode::FRAME_SIZE_ERROR);
+    }
+    return true;
+
+   case FrameType::RST_STREAM:
+    if (streamId == 0 || streamId > this->lastStreamId_) {
+      return this->connectionError(ErrorCode::PROTOCOL_ERROR);
+    }
+    if (length != 4) {
+      return this->connectionError(ErrorCode::FRAME_SIZE_ERROR);
+    }
+    this->closeStream(streamId);
+    return true;
+
+   case FrameType::SETTINGS:
+    return this->handleSettings(flags, streamId, payload, length);
+
+   case FrameType::PUSH_PROMISE:
+    // Clients cannot push.
+    return this->connectionError(ErrorCode::PROTOCOL_ERROR);
+
+   case FrameType::PING:
+    if (streamId != 0) {
+      return this->connectionError(ErrorCode::PROTOCOL_ERROR);
+    }
+    if (length != 8) {
+      return this->connectionError(ErrorCode::FRAME_SIZE_ERROR);
+    }
+    if ((flags & FLAG_ACK) == 0) {
+      WriteFrameHeader(this->output_, 8, FrameType::PING, FLAG_ACK, 0);
+      this->output_.append((const char*) payload, 8);
+      this->numQueuedControlFrames_ += 1;
+    }
+    return true;
+
+   case FrameType::GOAWAY:
+    if (streamId != 0) {
+      return this->connectionError(ErrorCode::PROTOCOL_ERROR);
+    }
+    if (length < 8) {
+      return this->connectionError(ErrorCode::FRAME_SIZE_ERROR);
+    }
+    // Client is leaving. Streams opened so far are finished first, and
+    // GOAWAY in reply makes new streams ignored. Closed in flush().
+    DEBUG_cout << "GOAWAY received." << endl;
+    this->isGoAwayReceived_ = true;
+    this->writeGoAway(ErrorCode::NO_ERROR);
+    return true;
+
+   case FrameType::WINDOW_UPDATE:
+    return this->handleWindowUpdate(streamId, payload, length);
+  }
+
+  // Unknown frame types are ignored.
+  return true;
+}
+
+bool Http2Connection::handleData(uint8_t flags, uint32_t streamId,
+                                 const uint8_t* payload, size_t length) {
+  if (streamId == 0) {
+    return this->connectionError(ErrorCode::PROTOCOL_ERROR);
+  }
+
+  // Whole frame counts against flow control, padding included.
+  if (this->numConnectionUnackedBytes_ + length > this->config_.initialWindowSize) {
+    return this->connectionError(ErrorCode::FLOW_CONTROL_ERROR);
+  }
+  this->numConnectionUnackedBytes_ += length;
+  if (this->numConnectionUnackedBytes_ >= this->config_.initialWindowSize / 2) {
+    this->writeWindowUpdate(0, this->numConnectionUnackedBytes_);
+    this->numConnectionUnackedBytes_ = 0;
+  }
+
+  size_t dataLength = length;
+  const uint8_t* data = payload;
+  if (flags & FLAG_PADDED) {
+    if (length < 1 || payload[0] >= length) {
+      return this->connectionError(ErrorCode::PROTOCOL_ERROR);
+    }
+    dataLength = length - 1 - payload[0];
+    data = payload + 1;
+  }
+
+  auto found = this->streams_.find(streamId);
+  if (found == this->streams_.end()) {
+    if (streamId > this->lastStreamId_) {
+      // DATA on an idle stream.
+      return this->connectionError(ErrorCode::PROTOCOL_ERROR);
+    }
+    this->streamError(streamId, ErrorCode::STREAM_CLOSED);
+    return true;
+  }
+
+  Stream* stream = found->second.get();
+  if (stream->isEndStreamReceived == true) {
+    this->streamError(streamId, ErrorCode::STREAM_CLOSED);
+    return true;
+  }
+
+  if (stream->numUnackedBytes + length > this->config_.initialWindowSize) {
+    this->streamError(streamId, ErrorCode::FLOW_CONTROL_ERROR);
+    return true;
+  }
+  if (stream->body.length() + dataLength > this->config_.maxBodySize) {
+    DEBUG_cerr << "Request body is too large. streamId: " << streamId << endl;
+    this->streamError(streamId, ErrorCode::REFUSED_STREAM);
+    return true;
+  }
+
+  stream->body.append((const char*) data, dataLength);
+  stream->numUnackedBytes += length;
+
+  if (flags & FLAG_END_STREAM) {
+    stream->isEndStreamReceived = true;
+    this->onRequestComplete(stream);
+    return true;
+  }
+
+  if (stream->numUnackedBytes >= this->config_.initialWindowSize / 2) {
+    this->writeWindowUpdate(streamId, stream->numUnackedBytes);
+    stream->numUnackedBytes = 0;
+  }
+  return true;
+}
+
+bool Http2Connection::handleHeaders(uint8_t flags, uint32_t streamId,
+                                    const uint8_t* payload, size_t length) {
+  if (streamId == 0 || (streamId & 1) == 0) {
+    return this->connectionError(ErrorCode::PROTOCOL_ERROR);
+  }
+
+  size_t offset = 0;
+  size_t padLength = 0;
+  if (flags & FLAG_PADDED) {
+    if (length < 1) {
+      return this->connectionError(ErrorCode::PROTOCOL_ERROR);
+    }
+    padLength = payload[0];
+    offset += 1;
+  }
+  if (flags & FLAG_PRIORITY) {
+    offset += 5;
+  }
+  if (offset + padLength > length) {
+    return this->connectionError(ErrorCode::PROTOCOL_ERROR);
+  }
+
+  this->headerBlock_.assign((const char*) payload + offset, length - offset - padLength);
+
+  if ((flags & FLAG_END_HEADERS) == 0) {
+    this->continuationStreamId_ = streamId;
+    this->isContinuationEndStream_ = (flags & FLAG_END_STREAM) != 0;
+    return true;
+  }
+  return this->onHeaderBlock(streamId, (flags & FLAG_END_STREAM) != 0);
+}
+
+bool Http2Connection::handleContinuation(uint8_t flags, uint32_t streamId,
+                                         const uint8_t* payload, size_t length) {
+  if (this->continuationStreamId_ == 0 || streamId != this->continuationStreamId_) {
+    return this->connectionError(ErrorCode::PROTOCOL_ERROR);
+  }
+  if (this->headerBlock_.length() + length > this->config_.maxHeaderListSize) {
+    DEBUG_cerr << "Header block is too large." << endl;
+    return this->connectionError(ErrorCode::ENHANCE_YOUR_CALM);
+  }
+
+  this->headerBlock_.append((const char*) payload, length);
+  if ((flags & FLAG_END_HEADERS) == 0) {
+    return true;
+  }
+  this->continuationStreamId_ = 0;
+  return this->onHeaderBlock(streamId, this->isContinuationEndStream_);
+}
+
+bool Http2Connection::onHeaderBlock(uint32_t streamId, bool isEndStream) {
+  // Block is decoded even when the stream is refused to keep HPACK in sync.
+  Hpack::HeaderList headers;
+  try {
+    this->decoder_.Decode((const uint8_t*) this->headerBlock_.c_str(),
+                          this->headerBlock_.length(), headers);
+  } catch (Hpack::Exception& e) {
+    DEBUG_cerr << "Failed to decode header block. " << e.what() << endl;
+    return this->connectionError(ErrorCode::COMPRESSION_ERROR);
+  }
+  this->headerBlock_.clear();
+
+  auto found = this->streams_.find(streamId);
+  if (found != this->streams_.end()) {
+    // Trailers. Fields are dropped.
+    Stream* stream = found->second.get();
+    if (stream->isEndStreamReceived == true || isEndStream == false) {
+      this->streamError(streamId, ErrorCode::PROTOCOL_ERROR);
+      return true;
+    }
+    stream->isEndStreamReceived = true;
+    this->onRequestComplete(stream);
+    return true;
+  }
+
+  if (streamId <= this->lastStreamId_) {
+    // Stream is already closed.
+    return this->connectionError(ErrorCode::STREAM_CLOSED);
+  }
+  this->lastStreamId_ = streamId;
+
+  if (this->isGoAwaySent_ == true) {
+    return true;
+  }
+  if (this->streams_.size() >= this->config_.maxConcurrentStreams) {
+    this->writeRstStream(streamId, ErrorCode::REFUSED_STREAM);
+    return true;
+  }
+
+  Stream* stream = new Stream(streamId, this->peerInitialWindowSize_);
+  this->streams_[streamId] = std::unique_ptr<Stream>(stream);
+  stream->headers = std::move(headers);
+
+  if (isEndStream == true) {
+    stream->isEndStreamReceived = true;
+    this->onRequestComplete(stream);
+  }
+  return true;
+}
+
+bool Http2Connection::handleSettings(uint8_t flags, uint32_t streamId,
+                                     const uint8_t* payload, size_t length) {
+  if (streamId != 0) {
+    return this->connectionError(ErrorCode::PROTOCOL_ERROR);
+  }
+  if (flags & FLAG_ACK) {
+    if (length != 0) {
+      return this->connectionError(ErrorCode::FRAME_SIZE_ERROR);
+    }
+    return true;
+  }
+  if (length % 6 != 0) {
+    return this->connectionError(ErrorCode::FRAME_SIZE_ERROR);
+  }
+
+  for (size_t i = 0; length > i; i += 6) {
+    const Setting setting = (Setting) ((payload[i] << 8) | payload[i + 1]);
+    const uint32_t value = readUInt32(payload + i + 2);
+
+    switch (setting) {
+     case Setting::HEADER_TABLE_SIZE:
+      this->encoder_.SetMaxTableSize(value);
+      break;
+
+     case Setting::ENABLE_PUSH:
+      if (value > 1) {
+        return this->connectionError(ErrorCode::PROTOCOL_ERROR);
+      }
+      break;
+
+     case Setting::INITIAL_WINDOW_SIZE:
+      {
+        if (value > MAX_WINDOW_SIZE) {
+          return this->connectionError(ErrorCode::FLOW_CONTROL_ERROR);
+        }
+        // Change applies to windows of all open streams.
+        const int64_t delta = (int64_t) value - this->peerInitialWindowSize_;
+        for (auto& entry : this->streams_) {
+          entry.second->sendWindow += delta;
+          if (entry.second->sendWindow > MAX_WINDOW_SIZE) {
+            return this->connectionError(ErrorCode::FLOW_CONTROL_ERROR);
+          }
+        }
+        this->peerInitialWindowSize_ = value;
+      }
+      break;
+
+     case Setting::MAX_FRAME_SIZE:
+      if (value < DEFAULT_FRAME_SIZE || value > 0xFFFFFF) {
+        return this->connectionError(ErrorCode::PROTOCOL_ERROR);
+      }
+      this->peerMaxFrameSize_ = value;
+      break;
+
+     case Setting::MAX_CONCURRENT_STREAMS:
+     case Setting::MAX_HEADER_LIST_SIZE:
+      break;
+    }
+  }
+
+  WriteFrameHeader(this->output_, 0, FrameType::SETTINGS, FLAG_ACK, 0);
+  this->numQueuedControlFrames_ += 1;
+  this->sendPendingStreams();
+  return true;
+}
+
+bool Http2Connection::handleWindowUpdate(uint32_t streamId,
+                                         const uint8_t* payload, size_t length) {
+  if (length != 4) {
+    return this->connectionError(ErrorCode::FRAME_SIZE_ERROR);
+  }
+  const uint32_t increment = readUInt32(payload) & 0x7FFFFFFF;
+
+  if (streamId == 0) {
+    if (increment == 0) {
+      return this->connectionError(ErrorCode::PROTOCOL_ERROR);
+    }
+    this->connectionSendWindow_ += increment;
+    if (this->connectionSendWindow_ > MAX_WINDOW_SIZE) {
+      return this->connectionError(ErrorCode::FLOW_CONTROL_ERROR);
+    }
+    this->sendPendingStreams();
+    return true;
+  }
+
+  auto found = this->streams_.find(streamId);
+  if (found == this->streams_.end()) {
+    if (streamId > this->lastStreamId_) {
+      return this->connectionError(ErrorCode::PROTOCOL_ERROR);
+    }
+    // Stream has been closed recently. Ignored.
+    return true;
+  }
+
+  Stream* stream = found->second.get();
+  if (increment == 0) {
+    this->streamError(streamId, ErrorCode::PROTOCOL_ERROR);
+    return true;
+  }
+  stream->sendWindow += increment;
+  if (stream->sendWindow > MAX_WINDOW_SIZE) {
+    this->streamError(streamId, ErrorCode::FLOW_CONTROL_ERROR);
+    return true;
+  }
+
+  if (stream->isResponded == true && this->sendPendingData(stream) == true) {
+    this->closeStream(streamId);
+  }
+  return true;
+}
+
+void Http2Connection::onRequestComplete(Stream* stream) {
+  if (this->buildRequest(stream) == false) {
+    this->streamError(stream->id, ErrorCode::PROTOCOL_ERROR);
+    return;
+  }
+
+  if (this->handler_) {
+    this->handler_(stream->request, stream->response);
+  }
+  this->sendResponse(stream);
+}
+
+bool Http2Connection::buildRequest(Stream* stream) {
+  HttpRequest& request = stream->request;
+  bool hasMethod = false;
+  bool hasPath = false;
+  bool isRegularFieldSeen = false;
+
+  for (const Hpack::HeaderField& field : stream->headers) {
+    if (field.name.empty() == true) {
+      return false;
+    }
+
+    if (field.name[0] == ':') {
+      // Pseudo-header fields come before regular fields.
+      if (isRegularFieldSeen == true) {
+        return false;
+      }
+      if (field.name == ":method") {
+        hasMethod = request.SetRequestMethod(field.value);
+      } else if (field.name == ":path") {
+        hasPath = request.SetUri(field.value);
+      } else if (field.name == ":authority") {
+        request.SetHost(field.value);
+      } else if (field.name != ":scheme") {
+        return false;
+      }
+      continue;
+    }
+    isRegularFieldSeen = true;
+
+    // HttpRequest expects HTTP/1.x spelling. ex) user-agent -> User-Agent
+    string fieldName = field.name;
+    bool isWordStart = true;
+    for (char& c : fieldName) {
+      if (c >= 'A' && c <= 'Z') {
+        // Field names must be lower case in HTTP/2.
+        return false;
+      }
+      if (isWordStart == true && c >= 'a' && c <= 'z') {
+        c = c - 'a' + 'A';
+      }
+      isWordStart = c == '-';
+    }
+    if (fieldName == "Connection" || fieldName == "Transfer-Encoding") {
+      // Connection-specific fields are not allowed.
+      return false;
+    }
+    request.SetField(fieldName, field.value);
+  }
+
+  if (hasMethod == false || hasPath == false) {
+    return false;
+  }
+
+  if (stream->body.empty() == false) {
+    request.SetContentLength(stream->body.length());
+    request.SetContent(DataBlock<>((void*) stream->body.c_str(), 0,
+                                   stream->body.length()));
+  }
+  return true;
+}
+
+void Http2Connection::sendResponse(Stream* stream) {
+  DataBlock<string*> headerBlock = stream->response.GetHeader();
+  if (headerBlock.IsNull() == true) {
+    DEBUG_cerr << "Response header is not ready. streamId: " << stream->id << endl;
+    this->streamError(stream->id, ErrorCode::INTERNAL_ERROR);
+    return;
+  }
+  const string& header = headerBlock.GetValue();
+
+  // "HTTP/1.1 200 OK\r\n" + "Name: value\r\n"*
+  Hpack::HeaderList fields;
+  fields.push_back(Hpack::HeaderField(":status", header.substr(9, 3)));
+
+  size_t lineStart = header.find("\r\n");
+  while (lineStart != string::npos) {
+    lineStart += 2;
+    const size_t lineEnd = header.find("\r\n", lineStart);
+    if (lineEnd == string::npos || lineEnd == lineStart) {
+      break;
+    }
+    const size_t colon = header.find(':', lineStart);
+    if (colon != string::npos && lineEnd > colon) {
+      string name = Util::String::ToLower(header.substr(lineStart, colon - lineStart));
+      size_t valueStart = colon + 1;
+      while (lineEnd > valueStart && header[valueStart] == ' ') {
+        valueStart += 1;
+      }
+      if (name != "connection" && name != "keep-alive" &&
+          name != "transfer-encoding" && name != "proxy-connection" &&
+          name != "upgrade") {
+        fields.push_back(Hpack::HeaderField(name,
+              header.substr(valueStart, lineEnd - valueStart)));
+      }
+    }
+    lineStart = lineEnd;
+  }
+
+  string block;
+  this->encoder_.Encode(fields, block);
+
+  std::vector<struct iovec> body;
+  const size_t bodyLength = stream->response.GetBodyIovecs(body);
+  const bool hasBody = bodyLength > 0 && stream->response.IsChunked() == false;
+
+  // Header block larger than a frame continues in CONTINUATION frames.
+  size_t offset = 0;
+  FrameType type = FrameType::HEADERS;
+  do {
+    size_t fragmentLength = block.length() - offset;
+    uint8_t flags = 0;
+    if (fragmentLength > this->peerMaxFrameSize_) {
+      fragmentLength = this->peerMaxFrameSize_;
+    } else {
+      flags |= FLAG_END_HEADERS;
+    }
+    if (type == FrameType::HEADERS && hasBody == false) {
+      flags |= FLAG_END_STREAM;
+    }
+    WriteFrameHeader(this->output_, fragmentLength, type, flags, stream->id);
+    this->output_.append(block, offset, fragmentLength);
+    offset += fragmentLength;
+    type = FrameType::CONTINUATION;
+  } while (block.length() > offset);
+
+  stream->isResponded = true;
+  if (hasBody == false) {
+    this->closeStream(stream->id);
+    return;
+  }
+
+  // DATA frames are cut by flow control windows, so the body is copied once.
+  stream->pendingData.clear();
+  stream->pendingData.reserve(bodyLength);
+  for (const struct iovec& iov : body) {
+    stream->pendingData.append((const char*) iov.iov_base, iov.iov_len);
+  }
+  stream->pendingOffset = 0;
+  if (this->sendPendingData(stream) == true) {
+    this->closeStream(stream->id);
+  }
+}
+
+bool Http2Connection::sendPendingData(Stream* stream) {
+  while (stream->pendingData.length() > stream->pendingOffset) {
+    if (this->GetPendingSize() > this->config_.outputHighWatermark) {
+      return false;
+    }
+
+    int64_t window = this->connectionSendWindow_ < stream->sendWindow ?
+                     this->connectionSendWindow_ : stream->sendWindow;
+    if (window <= 0) {
+      return false;
+    }
+
+    size_t length = stream->pendingData.length() - stream->pendingOffset;
+    if (length > (size_t) window) {
+      length = window;
+    }
+    if (length > this->peerMaxFrameSize_) {
+      length = this->peerMaxFrameSize_;
+    }
+
+    const bool isLast = stream->pendingOffset + length == stream->pendingData.length();
+    WriteFrameHeader(this->output_, length, FrameType::DATA,
+                     isLast ? FLAG_END_STREAM : 0, stream->id);
+    this->output_.append(stream->pendingData, stream->pendingOffset, length);
+
+    stream->pendingOffset += length;
+    stream->sendWindow -= length;
+    this->connectionSendWindow_ -= length;
+  }
+  return true;
+}
+
+void Http2Connection::sendPendingStreams() {
+  auto it = this->streams_.begin();
+  while (it != this->streams_.end()) {
+    Stream* stream = it->second.get();
+    if (stream->isResponded == true && this->sendPendingData(stream) == true) {
+      it = this->streams_.erase(it);
+      continue;
+    }
+    ++it;
+  }
+}
+
+void Http2Connection::closeStream(uint32_t streamId) {
+  this->streams_.erase(streamId);
+}
+
+bool Http2Connection::connectionError(ErrorCode errorCode) {
+  DEBUG_cerr << "Connection error. errorCode: " << (uint32_t) errorCode << endl;
+  this->writeGoAway(errorCode);
+  this->streams_.clear();
+  this->isClosed_ = true;
+  return false;
+}
+
+void Http2Connection::streamError(uint32_t streamId, ErrorCode errorCode) {
+  DEBUG_cerr << "Stream error. streamId: " << streamId
+             << " errorCode: " << (uint32_t) errorCode << endl;
+  this->writeRstStream(streamId, errorCode);
+  this->closeStream(streamId);
+}
+
+void Http2Connection::writeSettings() {
+  struct {
+    Setting setting;
+    uint32_t value;
+  } settings[] = {
+    { Setting::MAX_CONCURRENT_STREAMS, this->config_.maxConcurrentStreams },
+    { Setting::INITIAL_WINDOW_SIZE, this->config_.initialWindowSize },
+    { Setting::MAX_FRAME_SIZE, this->config_.maxFrameSize },
+    { Setting::MAX_HEADER_LIST_SIZE, this->config_.maxHeaderListSize },
+    { Setting::ENABLE_PUSH, 0 }
+  };
+  const size_t numSettings = sizeof(settings) / sizeof(settings[0]);
+
+  WriteFrameHeader(this->output_, numSettings * 6, FrameType::SETTINGS, 0, 0);
+  for (size_t i = 0; numSettings > i; ++i) {
+    this->output_.push_back((char) ((uint16_t) settings[i].setting >> 8));
+    this->output_.push_back((char) ((uint16_t) settings[i].setting & 0xFF));
+    writeUInt32(this->output_, settings[i].value);
+  }
+}
+
+void Http2Connection::writeWindowUpdate(uint32_t streamId, uint32_t increment) {
+  WriteFrameHeader(this->output_, 4, FrameType::WINDOW_UPDATE, 0, streamId);
+  writeUInt32(this->output_, increment);
+  this->numQueuedControlFrames_ += 1;
+}
+
+void Http2Connection::writeRstStream(uint32_t streamId, ErrorCode errorCode) {
+  WriteFrameHeader(this->output_, 4, FrameType::RST_STREAM, 0, streamId);
+  writeUInt32(this->output_, (uint32_t) errorCode);
+  this->numQueuedControlFrames_ += 1;
+}
+
+void Http2Connection::writeGoAway(ErrorCode errorCode) {
+  if (this->isGoAwaySent_ == true) {
+    return;
+  }
+  WriteFrameHeader(this->output_, 8, FrameType::GOAWAY, 0, 0);
+  writeUInt32(this->output_, this->lastStreamId_);
+  writeUInt32(this->output_, (uint32_t) errorCode);
+  this->isGoAwaySent_ = true;
+}
+
+Http2Connection::Status Http2Connection::flush() {
+  while (this->GetPendingSize() > 0) {
+    ssize_t written = write(this->fd_, this->output_.c_str() + this->outputOffset_,
+                            this->GetPendingSize());
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+        return Status::WOULD_BLOCK;
+      }
+      DEBUG_cerr << "write has failed. errno: " << errno << endl;
+      this->isClosed_ = true;
+      return Status::CLOSED;
+    }
+    this->outputOffset_ += written;
+  }
+
+  this->output_.clear();
+  this->outputOffset_ = 0;
+  this->numQueuedControlFrames_ = 0;
+  if (this->isGoAwayReceived_ == true && this->streams_.empty() == true) {
+    // Every stream opened before GOAWAY has been answered.
+    this->isClosed_ = true;
+  }
+  if (this->isClosed_ == true) {
+    return Status::CLOSED;
+  }
+  return Status::OK;
+}
+
+void Http2Connection::WriteFrameHeader(string& out, size_t length, FrameType type,
+                                       uint8_t flags, uint32_t streamId) {
+  char header[FRAME_HEADER_LENGTH] = {
+    (char) (length >> 16), (char) (length >> 8), (char) length,
+    (char) type,
+    (char) flags,
+    (char) (streamId >> 24), (char) (streamId >> 16),
+    (char) (streamId >> 8), (char) streamId
+  };
+  out.append(header, FRAME_HEADER_LENGTH);
+}
+
+uint32_t Http2Connection::readUInt32(const uint8_t* data) {
+  return ((uint32_t) data[0] << 24) | ((uint32_t) data[1] << 16) |
+         ((uint32_t) data[2] << 8) | (uint32_t) data[3];
+}
+
+void Http2Connection::writeUInt32(string& out, uint32_t value) {
+  char bytes[4] = {
+    (char) (value >> 24), (char) (value >> 16), (char) (value >> 8), (char) value
+  };
+  out.append(bytes, 4);
+}
+
+//Http2Connection::
+
+}
+
+#if _UNIT_TEST
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include <sys/socket.h>
+
+using namespace lio;
+using std::string;
+using std::vector;
+
+// Minimal HTTP/2 client side used by the tests.
+class TestClient {
+public:
+  struct Response {
+    Hpack::HeaderList headers;
+    string body;
+    bool isEnded = false;
+  };
+
+  TestClient(int fd) : fd_(fd), numUnackedBytes_(0) {
+    this->output_.assign("PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n", 24);
+    Http2Connection::WriteFrameHeader(this->output_, 0,
+        Http2Connection::FrameType::SETTINGS, 0, 0);
+  }
+
+  void Request(uint32_t streamId, const string& method, const string& path,
+               const string& body = "") {
+    Hpack::HeaderList headers;
+    headers.push_back(Hpack::HeaderField(":method", method));
+    headers.push_back(Hpack::HeaderField(":scheme", "http"));
+    headers.push_back(Hpack::HeaderField(":path", path));
+    headers.push_back(Hpack::HeaderField(":authority", "localhost"));
+    headers.push_back(Hpack::HeaderField("user-agent", "lio-test"));
+    string block;
+    this->encoder_.Encode(headers, block);
+
+    Http2Connection::WriteFrameHeader(this->output_, block.length(),
+        Http2Connection::FrameType::HEADERS,
+        Http2Connection::FLAG_END_HEADERS |
+        (body.empty() ? Http2Connection::FLAG_END_STREAM : 0), streamId);
+    this->output_.append(block);
+
+    if (body.empty() == false) {
+      Http2Connection::WriteFrameHeader(this->output_, body.length(),
+          Http2Connection::FrameType::DATA, Http2Connection::FLAG_END_STREAM, streamId);
+      this->output_.append(body);
+    }
+  }
+
+  void Raw(const string& bytes) {
+    this->output_.append(bytes);
+  }
+
+  void Flush() {
+    size_t offset = 0;
+    while (this->output_.length() > offset) {
+      ssize_t written = write(this->fd_, this->output_.c_str() + offset,
+                              this->output_.length() - offset);
+      if (written <= 0) {
+        break;
+      }
+      offset += written;
+    }
+    this->output_.erase(0, offset);
+    this->numBytesWritten += offset;
+  }
+
+  // Reads what is available and parses complete frames.
+  void Read() {
+    char buffer[1024 * 64];
+    while (true) {
+      ssize_t readCount = read(this->fd_, buffer, sizeof(buffer));
+      if (readCount <= 0) {
+        break;
+      }
+      this->input_.append(buffer, readCount);
+      this->numBytesRead += readCount;
+    }
+
+    size_t offset = 0;
+    while (this->input_.length() >= offset + 9) {
+      const uint8_t* frame = (const uint8_t*) this->input_.c_str() + offset;
+      size_t length = (frame[0] << 16) | (frame[1] << 8) | frame[2];
+      if (offset + 9 + length > this->input_.length()) {
+        break;
+      }
+      Http2Connection::FrameType type = (Http2Connection::FrameType) frame[3];
+      uint8_t flags = frame[4];
+      uint32_t streamId = ((frame[5] & 0x7F) << 24) | (frame[6] << 16) |
+                          (frame[7] << 8) | frame[8];
+      const uint8_t* payload = frame + 9;
+
+      if (type == Http2Connection::FrameType::HEADERS) {
+        this->decoder_.Decode(payload, length, this->responses[streamId].headers);
+      } else if (type == Http2Connection::FrameType::DATA) {
+        this->responses[streamId].body.append((const char*) payload, length);
+        this->numDataBytes += length;
+        this->numUnackedBytes_ += length;
+      } else if (type == Http2Connection::FrameType::RST_STREAM) {
+        this->rstStreams.push_back(streamId);
+      } else if (type == Http2Connection::FrameType::GOAWAY) {
+        this->isGoAwayReceived = true;
+      } else if (type == Http2Connection::FrameType::PING) {
+        this->numPingAcks += (flags & Http2Connection::FLAG_ACK) ? 1 : 0;
+      }
+      if ((type == Http2Connection::FrameType::HEADERS ||
+           type == Http2Connection::FrameType::DATA) &&
+          (flags & Http2Connection::FLAG_END_STREAM)) {
+        this->responses[streamId].isEnded = true;
+        this->numEnded += 1;
+      }
+      offset += 9 + length;
+    }
+    this->input_.erase(0, offset);
+
+    // Give back the connection window like a real client does.
+    if (this->isAutoWindowUpdate == true && this->numUnackedBytes_ >= 1024 * 32) {
+      Http2Connection::WriteFrameHeader(this->output_, 4,
+          Http2Connection::FrameType::WINDOW_UPDATE, 0, 0);
+      const uint32_t increment = this->numUnackedBytes_;
+      const char bytes[4] = { (char) (increment >> 24), (char) (increment >> 16),
+                              (char) (increment >> 8), (char) increment };
+      this->output_.append(bytes, 4);
+      this->numUnackedBytes_ = 0;
+    }
+  }
+
+  std::map<uint32_t, Response> responses;
+  vector<uint32_t> rstStreams;
+  bool isGoAwayReceived = false;
+  size_t numPingAcks = 0;
+  size_t numEnded = 0;
+  size_t numDataBytes = 0;
+  bool isAutoWindowUpdate = true;
+  size_t numBytesWritten = 0;
+  size_t numBytesRead = 0;
+
+private:
+  int fd_;
+  size_t numUnackedBytes_;
+  string output_;
+  string input_;
+  Hpack::Encoder encoder_;
+  Hpack::Decoder decoder_;
+};
+
+static string findHeader(const Hpack::HeaderList& headers, const string& name) {
+  for (const Hpack::HeaderField& field : headers) {
+    if (field.name == name) {
+      return field.value;
+    }
+  }
+  return "";
+}
+
+class Http2ConnectionTest : public ::testing::Test {
+protected:
+  virtual void SetUp() {
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, this->fds), 0);
+  }
+  virtual void TearDown() {
+    close(this->fds[0]);
+    close(this->fds[1]);
+  }
+  int fds[2];
+};
+
+TEST_F(Http2ConnectionTest, MultiplexedRequests) {
+  Http2Connection connection(this->fds[0], [](HttpRequest& request,
+                                              HttpResponseBuilder& response) {
+      string* body = new string("{\"uri\":\"" + request.GetWholeUri() + "\"}");
+      response.SetHeaderField("Content-Type", "application/json");
+      response.SetBody(body);
+  });
+  TestClient client(this->fds[1]);
+
+  for (uint32_t id = 1; 20 > id; id += 2) {
+    client.Request(id, "GET", "/api/" + std::to_string(id));
+  }
+  client.Flush();
+  connection.OnReadable();
+  client.Read();
+
+  EXPECT_EQ(client.numEnded, 10);
+  EXPECT_EQ(connection.GetNumStreams(), 0);
+  for (uint32_t id = 1; 20 > id; id += 2) {
+    TestClient::Response& response = client.responses[id];
+    EXPECT_EQ(findHeader(response.headers, ":status"), "200");
+    EXPECT_EQ(findHeader(response.headers, "content-type"), "application/json");
+    EXPECT_EQ(response.body, "{\"uri\":\"/api/" + std::to_string(id) + "\"}");
+  }
+}
+
+TEST_F(Http2ConnectionTest, RequestBody) {
+  Http2Connection connection(this->fds[0], [](HttpRequest& request,
+                                              HttpResponseBuilder& response) {
+      DataBlock<> content = request.GetContent();
+      response.SetBody(new string((const char*) content.GetObject(),
+                                  request.GetContentLength()));
+  });
+  TestClient client(this->fds[1]);
+  client.Request(1, "POST", "/echo", "hello h2");
+  client.Flush();
+  connection.OnReadable();
+  client.Read();
+
+  EXPECT_EQ(client.responses[1].isEnded, true);
+  EXPECT_EQ(client.responses[1].body, "hello h2");
+}
+
+TEST_F(Http2ConnectionTest, FlowControl) {
+  const size_t BODY_SIZE = 200000;
+  Http2Connection connection(this->fds[0], [](HttpRequest& request,
+                                              HttpResponseBuilder& response) {
+      response.SetBody(new string(BODY_SIZE, 'x'));
+  });
+  TestClient client(this->fds[1]);
+  client.isAutoWindowUpdate = false;
+  client.Request(1, "GET", "/big");
+  client.Flush();
+  connection.OnReadable();
+  client.Read();
+
+  // Default window is 65535 bytes.
+  EXPECT_EQ(client.numDataBytes, Http2Connection::DEFAULT_WINDOW_SIZE);
+  EXPECT_EQ(connection.GetNumStreams(), 1);
+
+  for (int i = 0; 10 > i && client.numEnded == 0; ++i) {
+    string update;
+    Http2Connection::WriteFrameHeader(update, 4,
+        Http2Connection::FrameType::WINDOW_UPDATE, 0, 0);
+    update.append("\x00\x01\x00\x00", 4);
+    Http2Connection::WriteFrameHeader(update, 4,
+        Http2Connection::FrameType::WINDOW_UPDATE, 0, 1);
+    update.append("\x00\x01\x00\x00", 4);
+    client.Raw(update);
+    client.Flush();
+    connection.OnReadable();
+    client.Read();
+  }
+  EXPECT_EQ(client.responses[1].body.length(), BODY_SIZE);
+  EXPECT_EQ(connection.GetNumStreams(), 0);
+}
+
+TEST_F(Http2ConnectionTest, Errors) {
+  Http2Connection connection(this->fds[0], nullptr);
+  TestClient client(this->fds[1]);
+
+  string ping;
+  Http2Connection::WriteFrameHeader(ping, 8, Http2Connection::FrameType::PING, 0, 0);
+  ping.append("12345678");
+  client.Raw(ping);
+
+  // Even stream id is not allowed for client.
+  string headers;
+  Http2Connection::WriteFrameHeader(headers, 1, Http2Connection::FrameType::HEADERS,
+                                    Http2Connection::FLAG_END_HEADERS, 2);
+  headers.push_back((char) 0x82);
+  client.Raw(headers);
+  client.Flush();
+
+  EXPECT_EQ(connection.OnReadable(), Http2Connection::Status::CLOSED);
+  EXPECT_EQ(connection.IsClosed(), true);
+  client.Read();
+  EXPECT_EQ(client.numPingAcks, 1);
+  EXPECT_EQ(client.isGoAwayReceived, true);
+}
+
+// Fills the socket buffer so that nothing more can be written to fd.
+static void fillSocket(int fd) {
+  const char bytes[1024] = { 0 };
+  while (write(fd, bytes, sizeof(bytes)) > 0) { }
+  while (write(fd, bytes, 1) > 0) { }
+}
+
+static void drainSocket(int fd) {
+  char buffer[1024 * 64];
+  while (read(fd, buffer, sizeof(buffer)) > 0) { }
+}
+
+static string pingFrames(size_t numPings) {
+  string pings;
+  for (size_t i = 0; numPings > i; ++i) {
+    Http2Connection::WriteFrameHeader(pings, 8, Http2Connection::FrameType::PING, 0, 0);
+    pings.append("12345678");
+  }
+  return pings;
+}
+
+TEST_F(Http2ConnectionTest, Backpressure) {
+  const size_t NUM_PINGS = 200;
+  Http2Connection::Config config;
+  config.outputHighWatermark = 1024;
+  Http2Connection connection(this->fds[0], nullptr, config);
+  TestClient client(this->fds[1]);
+  fillSocket(this->fds[0]);
+
+  // PING ACKs cannot be written. Input stops being processed at the watermark.
+  client.Raw(pingFrames(NUM_PINGS));
+  client.Flush();
+  EXPECT_EQ(connection.OnReadable(), Http2Connection::Status::WOULD_BLOCK);
+  EXPECT_EQ(connection.IsClosed(), false);
+  EXPECT_GE(1024 + Http2Connection::FRAME_HEADER_LENGTH + 8, connection.GetPendingSize());
+
+  drainSocket(this->fds[1]);
+  EXPECT_EQ(connection.OnWritable(), Http2Connection::Status::OK);
+  client.Read();
+  EXPECT_EQ(client.numPingAcks, NUM_PINGS);
+  EXPECT_EQ(connection.IsClosed(), false);
+}
+
+TEST_F(Http2ConnectionTest, ControlFrameFlood) {
+  Http2Connection::Config config;
+  config.maxQueuedControlFrames = 100;
+  {
+    // Replies are read. Limit applies to unwritten frames only.
+    Http2Connection connection(this->fds[0], nullptr, config);
+    TestClient client(this->fds[1]);
+    client.Raw(pingFrames(500));
+    client.Flush();
+    EXPECT_EQ(connection.OnReadable(), Http2Connection::Status::OK);
+    client.Read();
+    EXPECT_EQ(client.numPingAcks, 500);
+  }
+  drainSocket(this->fds[0]);
+
+  Http2Connection connection(this->fds[0], nullptr, config);
+  TestClient client(this->fds[1]);
+  fillSocket(this->fds[0]);
+  client.Raw(pingFrames(500));
+  client.Flush();
+  // GOAWAY stays pending as the socket is full.
+  connection.OnReadable();
+  EXPECT_EQ(connection.IsClosed(), true);
+  drainSocket(this->fds[1]);
+  connection.OnWritable();
+  client.Read();
+  EXPECT_EQ(client.isGoAwayReceived, true);
+  EXPECT_GT(500, client.numPingAcks);
+}
+
+TEST_F(Http2ConnectionTest, GoAwayFinishesStreams) {
+  const size_t BODY_SIZE = 200000;
+  Http2Connection connection(this->fds[0], [](HttpRequest& request,
+                                              HttpResponseBuilder& response) {
+      response.SetBody(new string(BODY_SIZE, 'x'));
+  });
+  TestClient client(this->fds[1]);
+  client.isAutoWindowUpdate = false;
+  client.Request(1, "GET", "/big");
+  client.Flush();
+  connection.OnReadable();
+  client.Read();
+  EXPECT_EQ(client.numDataBytes, Http2Connection::DEFAULT_WINDOW_SIZE);
+
+  string goAway;
+  Http2Connection::WriteFrameHeader(goAway, 8, Http2Connection::FrameType::GOAWAY, 0, 0);
+  goAway.append(8, '\0');
+  client.Raw(goAway);
+  // Stream opened after GOAWAY is ignored.
+  client.Request(3, "GET", "/late");
+  client.Flush();
+  EXPECT_EQ(connection.OnReadable(), Http2Connection::Status::OK);
+  client.Read();
+  EXPECT_EQ(client.isGoAwayReceived, true);
+  EXPECT_EQ(connection.IsClosed(), false);
+  EXPECT_EQ(connection.GetNumStreams(), 1);
+
+  for (int i = 0; 10 > i && connection.IsClosed() == false; ++i) {
+    string update;
+    Http2Connection::WriteFrameHeader(update, 4,
+        Http2Connection::FrameType::WINDOW_UPDATE, 0, 0);
+    update.append("\x00\x01\x00\x00", 4);
+    Http2Connection::WriteFrameHeader(update, 4,
+        Http2Connection::FrameType::WINDOW_UPDATE, 0, 1);
+    update.append("\x00\x01\x00\x00", 4);
+    client.Raw(update);
+    client.Flush();
+    connection.OnReadable();
+    client.Read();
+  }
+  EXPECT_EQ(connection.IsClosed(), true);
+  EXPECT_EQ(client.responses[1].isEnded, true);
+  EXPECT_EQ(client.responses[1].body.length(), BODY_SIZE);
+  EXPECT_EQ(client.responses.count(3), 0);
+}
+
+TEST(Http2Connection, BenchmarkAgainstHttp11) {
+  PERFTEST {
+    const size_t NUM_REQUESTS = 100000;
+    const size_t NUM_IN_FLIGHT = 100;
+    const string BODY = "{\"id\":12345,\"name\":\"lio\",\"ok\":true}";
+    int fds[2];
+
+    // HTTP/2: requests multiplexed on one connection.
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, fds), 0);
+    {
+      Http2Connection::Config config;
+      config.maxConcurrentStreams = NUM_IN_FLIGHT;
+      Http2Connection connection(fds[0], [&BODY](HttpRequest& request,
+                                                 HttpResponseBuilder& response) {
+          response.SetHeaderField("Content-Type", "application/json");
+          response.SetBody(BODY);
+      }, config);
+      TestClient client(fds[1]);
+
+      auto start = std::chrono::steady_clock::now();
+      uint32_t nextStreamId = 1;
+      size_t numSent = 0;
+      while (client.numEnded < NUM_REQUESTS) {
+        while (numSent < NUM_REQUESTS && numSent - client.numEnded < NUM_IN_FLIGHT) {
+          client.Request(nextStreamId, "GET", "/api/items");
+          nextStreamId += 2;
+          numSent += 1;
+        }
+        client.Flush();
+        connection.OnReadable();
+        client.Read();
+        client.responses.clear();
+      }
+      double seconds = std::chrono::duration<double>(
+          std::chrono::steady_clock::now() - start).count();
+      std::cout << "HTTP/2 multiplexed     : " << (size_t) (NUM_REQUESTS / seconds)
+                << " requests/sec, "
+                << (client.numBytesWritten + client.numBytesRead) / NUM_REQUESTS
+                << " bytes/request" << endl;
+    }
+    close(fds[0]);
+    close(fds[1]);
+
+    // HTTP/1.1 keep-alive. One request in flight like usual clients,
+    // then pipelined with the same number in flight as HTTP/2.
+    for (size_t numInFlight : { (size_t) 1, NUM_IN_FLIGHT }) {
+      ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, fds), 0);
+      const string REQUEST =
+        "GET /api/items HTTP/1.1\r\n"
+        "Host: localhost\r\n"
+        "User-Agent: lio-test\r\n"
+        "Connection: keep-alive\r\n"
+        "\r\n";
+
+      auto start = std::chrono::steady_clock::now();
+      size_t numSent = 0;
+      size_t numReceived = 0;
+      size_t numBytes = 0;
+      string serverInput;
+      string clientInput;
+      char buffer[1024 * 64];
+      while (numReceived < NUM_REQUESTS) {
+        string out;
+        while (numSent < NUM_REQUESTS && numSent - numReceived < numInFlight) {
+          out.append(REQUEST);
+          numSent += 1;
+        }
+        numBytes += out.length();
+        while (out.empty() == false) {
+          ssize_t written = write(fds[1], out.c_str(), out.length());
+          if (written <= 0) {
+            break;
+          }
+          out.erase(0, written);
+        }
+
+        // Server: parse fields into HttpRequest and build the response.
+        ssize_t readCount;
+        while ((readCount = read(fds[0], buffer, sizeof(buffer))) > 0) {
+          serverInput.append(buffer, readCount);
+        }
+        string responses;
+        size_t requestStart = 0;
+        size_t requestEnd;
+        while ((requestEnd = serverInput.find("\r\n\r\n", requestStart)) != string::npos) {
+          HttpRequest request;
+          size_t lineEnd = serverInput.find("\r\n", requestStart);
+          size_t space = serverInput.find(' ', requestStart);
+          request.SetRequestMethod(serverInput.substr(requestStart, space - requestStart));
+          request.SetUri(serverInput.substr(space + 1,
+                serverInput.find(' ', space + 1) - space - 1));
+          while (lineEnd < requestEnd) {
+            size_t lineStart = lineEnd + 2;
+            lineEnd = serverInput.find("\r\n", lineStart);
+            size_t colon = serverInput.find(':', lineStart);
+            const string fieldName = serverInput.substr(lineStart, colon - lineStart);
+            const string fieldValue = serverInput.substr(colon + 2, lineEnd - colon - 2);
+            request.SetField(fieldName, fieldValue);
+          }
+
+          HttpResponseBuilder response;
+          response.SetHeaderField("Content-Type", "application/json");
+          response.SetHeaderField("Connection", "keep-alive");
+          response.SetBody(BODY);
+          responses.append(response.GetHeader().GetValue());
+          responses.append(BODY);
+          requestStart = requestEnd + 4;
+        }
+        serverInput.erase(0, requestStart);
+        size_t offset = 0;
+        while (responses.length() > offset) {
+          ssize_t written = write(fds[0], responses.c_str() + offset,
+                                  responses.length() - offset);
+          if (written <= 0) {
+            break;
+          }
+          offset += written;
+        }
+
+        // Client: split responses by Content-Length.
+        while ((readCount = read(fds[1], buffer, sizeof(buffer))) > 0) {
+          clientInput.append(buffer, readCount);
+          numBytes += readCount;
+        }
+        size_t position = 0;
+        while (true) {
+          size_t headerEnd = clientInput.find("\r\n\r\n", position);
+          if (headerEnd == string::npos) {
+            break;
+          }
+          size_t lengthPos = clientInput.find("Content-Length: ", position);
+          size_t contentLength = std::stoul(clientInput.substr(lengthPos + 16, 10));
+          if (headerEnd + 4 + contentLength > clientInput.length()) {
+            break;
+          }
+          position = headerEnd + 4 + contentLength;
+          numReceived += 1;
+        }
+        clientInput.erase(0, position);
+      }
+      double seconds = std::chrono::duration<double>(
+          std::chrono::steady_clock::now() - start).count();
+      std::cout << (numInFlight == 1 ? "HTTP/1.1 keep-alive    : " :
+                                       "HTTP/1.1 pipelined     : ")
+                << (size_t) (NUM_REQUESTS / seconds) << " requests/sec, "
+                << numBytes / NUM_REQUESTS << " bytes/request" << endl;
+      close(fds[0]);
+      close(fds[1]);
+    }
+  }
+}
+
+int main (int argc, char** argv) {
+  ::testing::InitGoogleMock(&argc, argv);
+  return RUN_ALL_TESTS();
+}
+
+#else
+// Executable File's Main Comes here.
+
+
+#endif
+
+#undef _UNIT_TEST
@@ -0,0 +1,326 @@
+#ifndef _HTTP2CONNECTION_HPP_
+#define _HTTP2CONNECTION_HPP_
+/*
+  Name
+    Http2Connection
+      Server side of one HTTP/2 connection.
+
+  Description
+    Cleartext HTTP/2 with prior knowledge (h2c). Client starts by sending
+    the connection preface. IsPreface() tells an HTTP/1.x reader to hand
+    the connection and the bytes it has already read over to this class.
+
+    Each stream gets its own HttpRequest and HttpResponseBuilder. When a
+    request is complete (END_STREAM), RequestHandler is called, and the
+    response built on HttpResponseBuilder is converted to a HEADERS frame
+    (HPACK) and DATA frames.
+
+    Event loop calls OnReadable() on EPOLLIN and OnWritable() on EPOLLOUT.
+    fd must be non-blocking. Once IsClosed() is true, the caller closes fd.
+
+    Flow Control
+      Receiving: WINDOW_UPDATE is sent once half of a window is consumed.
+      Sending: DATA frames never exceed the connection and stream windows.
+      Streams that run out of window continue when WINDOW_UPDATE arrives.
+      DATA frames are not produced while pending output is over
+      outputHighWatermark, so a slow reader does not grow memory.
+
+    Backpressure
+      Input is not processed while pending output is over
+      outputHighWatermark and cannot be written. Reading resumes in
+      OnWritable(). PING ACK, SETTINGS ACK, RST_STREAM and WINDOW_UPDATE
+      are counted, and a peer that keeps more than maxQueuedControlFrames
+      of them unread gets GOAWAY with ENHANCE_YOUR_CALM.
+
+    GOAWAY
+      GOAWAY from the client is answered with GOAWAY. New streams are
+      ignored, streams already opened are finished, and the connection is
+      closed once they are all sent.
+
+    Not Supported
+      Server push, priority (frames are accepted and ignored), chunked
+      HttpResponseStream bodies.
+
+  Last Modified Date
+    Oct 19, 2026
+
+  History
+    October 19, 2026
+      Created
+    October 19, 2026
+      Control frame limit, input backpressure, graceful GOAWAY
+
+  ToDos
+
+
+  Milestones
+    1.0
+
+
+  Learning Resources
+    Hypertext Transfer Protocol Version 2 (HTTP/2)
+      http://tools.ietf.org/html/rfc7540
+
+  Copyright (c) All rights reserved to LIFEINO.
+*/
+
+#ifdef _DEBUG
+  #undef _DEBUG
+#endif
+#define _DEBUG false
+
+#include "liolib/Debug.hpp"
+
+#include <string>
+#include <map>
+#include <memory> // unique_ptr
+#include <functional> // function
+
+#include <cstdint>
+#include <cerrno>
+
+#include <unistd.h> // read() write()
+
+#include "liolib/http/Http.hpp"
+#include "liolib/http/Hpack.hpp"
+#include "liolib/http/HttpRequest.hpp"
+#include "liolib/http/HttpResponseBuilder.hpp"
+
+namespace lio {
+
+using std::string;
+
+
+class Http2Connection {
+public:
+
+// ******** Exception Declaration *********
+enum class ExceptionType : std::uint8_t {
+  GENERAL,
+  WRITE_FAIL
+};
+#define HTTP2CONNECTION_EXCEPTION_MESSAGES \
+  "Http2Connection Exception has been thrown.", \
+  "Failed to write to the socket."
+
+class Exception : public std::exception {
+public:
+  Exception (ExceptionType exceptionType = ExceptionType::GENERAL);
+
+  virtual const char*         what() const noexcept;
+  virtual const               ExceptionType type() const noexcept;
+
+private:
+  const ExceptionType         exceptionType_;
+  static const char* const    exceptionMessages_[];
+};
+// ******** Exception Declaration END*********
+
+  enum class FrameType : uint8_t {
+    DATA = 0x0,
+    HEADERS = 0x1,
+    PRIORITY = 0x2,
+    RST_STREAM = 0x3,
+    SETTINGS = 0x4,
+    PUSH_PROMISE = 0x5,
+    PING = 0x6,
+    GOAWAY = 0x7,
+    WINDOW_UPDATE = 0x8,
+    CONTINUATION = 0x9
+  };
+
+  enum class ErrorCode : uint32_t {
+    NO_ERROR = 0x0,
+    PROTOCOL_ERROR = 0x1,
+    INTERNAL_ERROR = 0x2,
+    FLOW_CONTROL_ERROR = 0x3,
+    SETTINGS_TIMEOUT = 0x4,
+    STREAM_CLOSED = 0x5,
+    FRAME_SIZE_ERROR = 0x6,
+    REFUSED_STREAM = 0x7,
+    CANCEL = 0x8,
+    COMPRESSION_ERROR = 0x9,
+    CONNECT_ERROR = 0xa,
+    ENHANCE_YOUR_CALM = 0xb,
+    INADEQUATE_SECURITY = 0xc,
+    HTTP_1_1_REQUIRED = 0xd
+  };
+
+  enum class Setting : uint16_t {
+    HEADER_TABLE_SIZE = 0x1,
+    ENABLE_PUSH = 0x2,
+    MAX_CONCURRENT_STREAMS = 0x3,
+    INITIAL_WINDOW_SIZE = 0x4,
+    MAX_FRAME_SIZE = 0x5,
+    MAX_HEADER_LIST_SIZE = 0x6
+  };
+
+  struct Config {
+    Config() :
+      maxConcurrentStreams(100),
+      initialWindowSize(1024 * 1024),
+      maxFrameSize(DEFAULT_FRAME_SIZE),
+      maxHeaderListSize(1024 * 64),
+      maxBodySize(1024 * 1024 * 8),
+      outputHighWatermark(1024 * 256),
+      maxQueuedControlFrames(1000)
+    { }
+    uint32_t maxConcurrentStreams;
+    uint32_t initialWindowSize; // Receive window for each stream and the connection.
+    uint32_t maxFrameSize;
+    uint32_t maxHeaderListSize;
+    size_t maxBodySize; // Request body. Stream is reset when it is exceeded.
+    size_t outputHighWatermark;
+    size_t maxQueuedControlFrames; // Replies to the peer's frames not written yet.
+  };
+
+  enum class Status : uint8_t {
+    OK, // Everything has been sent.
+    WOULD_BLOCK, // Some bytes are pending. Wait for EPOLLOUT.
+    CLOSED
+  };
+
+  // Called once per request. Fill response the same way as for HTTP/1.x.
+  typedef std::function<void(HttpRequest& request, HttpResponseBuilder& response)> RequestHandler;
+
+  static const size_t PREFACE_LENGTH = 24;
+  static const uint32_t DEFAULT_FRAME_SIZE = 16384;
+  static const uint32_t DEFAULT_WINDOW_SIZE = 65535;
+  static const size_t FRAME_HEADER_LENGTH = 9;
+
+  // fd must be non-blocking. Server SETTINGS is queued right away.
+  Http2Connection(int fd, RequestHandler handler, Config config = Config());
+  ~Http2Connection();
+
+  // Call on EPOLLIN. Reads until EAGAIN.
+  Status          OnReadable();
+  // Call on EPOLLOUT. Also resumes reading held back by backpressure.
+  Status          OnWritable();
+
+  // Processes bytes that have been read elsewhere. Replies are flushed.
+  Status          Feed(const char* data, size_t length);
+
+  bool            IsClosed() const;
+  size_t          GetNumStreams() const;
+  size_t          GetPendingSize() const;
+
+  // True when data so far matches the client connection preface.
+  static
+  bool            IsPreface(const char* data, size_t length);
+
+  static
+  void            WriteFrameHeader(string& out, size_t length, FrameType type,
+                                   uint8_t flags, uint32_t streamId);
+
+  static const uint8_t FLAG_END_STREAM = 0x1;
+  static const uint8_t FLAG_ACK = 0x1;
+  static const uint8_t FLAG_END_HEADERS = 0x4;
+  static const uint8_t FLAG_PADDED = 0x8;
+  static const uint8_t FLAG_PRIORITY = 0x20;
+
+private:
+  struct Stream {
+    Stream(uint32_t streamId, int32_t initialSendWindow) :
+      id(streamId),
+      sendWindow(initialSendWindow),
+      numUnackedBytes(0),
+      isEndStreamReceived(false),
+      isResponded(false),
+      pendingOffset(0)
+    { }
+
+    uint32_t            id;
+    HttpRequest         request;
+    HttpResponseBuilder response;
+    Hpack::HeaderList   headers;
+    string              body;
+
+    int64_t             sendWindow;
+    size_t              numUnackedBytes; // Received but WINDOW_UPDATE not sent.
+    bool                isEndStreamReceived;
+    bool                isResponded;
+
+    string              pendingData; // Response body not sent yet.
+    size_t              pendingOffset;
+  };
+
+  int             fd_;
+  RequestHandler  handler_;
+  Config          config_;
+
+  Hpack::Decoder  decoder_;
+  Hpack::Encoder  encoder_;
+
+  std::map<uint32_t, std::unique_ptr<Stream>> streams_;
+  uint32_t        lastStreamId_;
+
+  bool            isPrefaceReceived_;
+  bool            isGoAwaySent_;
+  bool            isGoAwayReceived_;
+  bool            isInputPaused_; // Output is over the watermark and blocked.
+  bool            isClosed_;
+
+  // HEADERS without END_HEADERS is followed by CONTINUATION on the stream.
+  uint32_t        continuationStreamId_;
+  bool            isContinuationEndStream_;
+  string          headerBlock_;
+
+  string          input_;
+  size_t          inputOffset_;
+  string          output_;
+  size_t          outputOffset_;
+  size_t          numQueuedControlFrames_;
+
+  int64_t         connectionSendWindow_;
+  size_t          numConnectionUnackedBytes_;
+  int32_t         peerInitialWindowSize_;
+  uint32_t        peerMaxFrameSize_;
+
+  void            process();
+  // Returns false when the connection has to be closed.
+  bool            handleFrame(FrameType type, uint8_t flags, uint32_t streamId,
+                              const uint8_t* payload, size_t length);
+
+  bool            handleData(uint8_t flags, uint32_t streamId,
+                             const uint8_t* payload, size_t length);
+  bool            handleHeaders(uint8_t flags, uint32_t streamId,
+                                const uint8_t* payload, size_t length);
+  bool            handleContinuation(uint8_t flags, uint32_t streamId,
+                                     const uint8_t* payload, size_t length);
+  bool            handleSettings(uint8_t flags, uint32_t streamId,
+                                 const uint8_t* payload, size_t length);
+  bool            handleWindowUpdate(uint32_t streamId,
+                                     const uint8_t* payload, size_t length);
+  bool            onHeaderBlock(uint32_t streamId, bool isEndStream);
+
+  void            onRequestComplete(Stream* stream);
+  bool            buildRequest(Stream* stream);
+  void            sendResponse(Stream* stream);
+  // Sends as much of pending data as windows allow. Returns true when done.
+  bool            sendPendingData(Stream* stream);
+  void            sendPendingStreams();
+  void            closeStream(uint32_t streamId);
+
+  bool            connectionError(ErrorCode errorCode);
+  void            streamError(uint32_t streamId, ErrorCode errorCode);
+
+  void            writeSettings();
+  void            writeWindowUpdate(uint32_t streamId, uint32_t increment);
+  void            writeRstStream(uint32_t streamId, ErrorCode errorCode);
+  void            writeGoAway(ErrorCode errorCode);
+
+  Status          flush();
+
+  static
+  uint32_t        readUInt32(const uint8_t* data);
+  static
+  void            writeUInt32(string& out, uint32_t value);
+
+  Http2Connection(const Http2Connection&) = delete;
+  Http2Connection& operator=(const Http2Connection&) = delete;
+};
+
+}
+
+#endif
+
@@ -0,0 +1,301 @@
+
+#include "HttpChunkedDecoder.hpp"
+
+#define _UNIT_TEST false
+#include "liolib/Test.hpp"
+
+
+namespace lio {
+
+// ===== Exception Implementation =====
+const char* const
+HttpChunkedDecoder::Exception::exceptionMessages_[] = {
+  HTTPCHUNKEDDECODER_EXCEPTION_MESSAGES
+};
+#undef HTTPCHUNKEDDECODER_EXCEPTION_MESSAGES // undef helps reducing unnecessary preprocessing work.
+
+
+HttpChunkedDecoder::Exception::Exception(ExceptionType exceptionType) :
+  exceptionType_(exceptionType) { }
+
+const char*
+HttpChunkedDecoder::Exception::what() const noexcept {
+  return this->exceptionMessages_[(int) this->exceptionType_];
+}
+
+const HttpChunkedDecoder::ExceptionType
+HttpChunkedDecoder::Exception::type() const noexcept {
+  return this->exceptionType_;
+}
+// ===== Exception Implementation End =====
+
+
+HttpChunkedDecoder::HttpChunkedDecoder(DataHandler handler, Config config) :
+  handler_(handler),
+  config_(config),
+  state_(State::SIZE),
+  chunkSize_(0),
+  chunkRemaining_(0),
+  bodySize_(0),
+  numSizeDigits_(0)
+{
+  DEBUG_FUNC_START; // Prints out function name in yellow
+
+}
+
+HttpChunkedDecoder::~HttpChunkedDecoder() {
+  DEBUG_FUNC_START;
+
+}
+
+size_t HttpChunkedDecoder::Feed(const char* data, size_t length) {
+  if (this->state_ == State::DONE) {
+    DEBUG_cerr << "Feeding data to a finished decoder." << endl;
+    throw Exception(ExceptionType::ALREADY_DONE);
+  }
+
+  size_t i = 0;
+  while (length > i && this->state_ != State::DONE) {
+    const char c = data[i];
+
+    switch (this->state_) {
+     case State::SIZE:
+      {
+        int digit = -1;
+        if (c >= '0' && c <= '9') {
+          digit = c - '0';
+        } else if (c >= 'a' && c <= 'f') {
+          digit = c - 'a' + 10;
+        } else if (c >= 'A' && c <= 'F') {
+          digit = c - 'A' + 10;
+        }
+
+        if (digit >= 0) {
+          // 15 hex digits is more than any sane chunk. Stops overflow early.
+          if (this->numSizeDigits_ >= 15) {
+            throw Exception(ExceptionType::BAD_CHUNK_SIZE);
+          }
+          this->chunkSize_ = (this->chunkSize_ << 4) | digit;
+          this->numSizeDigits_ += 1;
+        } else if (this->numSizeDigits_ == 0) {
+          DEBUG_cerr << "Chunk size line does not start with hex digit." << endl;
+          throw Exception(ExceptionType::BAD_CHUNK_SIZE);
+        } else if (c == ';' || c == ' ' || c == '\t') {
+          this->state_ = State::SIZE_EXTENSION;
+        } else if (c == '\r') {
+          this->state_ = State::SIZE_LF;
+        } else if (c == '\n') {
+          this->onSizeLineEnd();
+        } else {
+          throw Exception(ExceptionType::BAD_CHUNK_SIZE);
+        }
+        i += 1;
+      }
+      break;
+
+     case State::SIZE_EXTENSION:
+      // Chunk extensions are ignored.
+      if (c == '\r') {
+        this->state_ = State::SIZE_LF;
+      } else if (c == '\n') {
+        this->onSizeLineEnd();
+      }
+      i += 1;
+      break;
+
+     case State::SIZE_LF:
+      if (c != '\n') {
+        throw Exception(ExceptionType::BAD_FORMAT);
+      }
+      this->onSizeLineEnd();
+      i += 1;
+      break;
+
+     case State::DATA:
+      {
+        size_t available = length - i;
+        size_t toHandOut = available < this->chunkRemaining_ ?
+                           available : this->chunkRemaining_;
+        if (this->handler_) {
+          this->handler_(data + i, toHandOut);
+        }
+        this->chunkRemaining_ -= toHandOut;
+        i += toHandOut;
+        if (this->chunkRemaining_ == 0) {
+          this->state_ = State::DATA_CR;
+        }
+      }
+      break;
+
+     case State::DATA_CR:
+      if (c == '\r') {
+        this->state_ = State::DATA_LF;
+      } else if (c == '\n') {
+        this->state_ = State::SIZE;
+      } else {
+        throw Exception(ExceptionType::BAD_FORMAT);
+      }
+      i += 1;
+      break;
+
+     case State::DATA_LF:
+      if (c != '\n') {
+        throw Exception(ExceptionType::BAD_FORMAT);
+      }
+      this->state_ = State::SIZE;
+      i += 1;
+      break;
+
+     case State::TRAILER_LINE_START:
+      if (c == '\r') {
+        this->state_ = State::TRAILER_END_LF;
+      } else if (c == '\n') {
+        this->state_ = State::DONE;
+      } else {
+        this->state_ = State::TRAILER_LINE;
+      }
+      i += 1;
+      break;
+
+     case State::TRAILER_LINE:
+      if (c == '\n') {
+        this->state_ = State::TRAILER_LINE_START;
+      }
+      i += 1;
+      break;
+
+     case State::TRAILER_END_LF:
+      if (c != '\n') {
+        throw Exception(ExceptionType::BAD_FORMAT);
+      }
+      this->state_ = State::DONE;
+      i += 1;
+      break;
+
+     case State::DONE:
+      break;
+    }
+  }
+
+  return i;
+}
+
+void HttpChunkedDecoder::onSizeLineEnd() {
+  if (this->chunkSize_ == 0) {
+    this->state_ = State::TRAILER_LINE_START;
+    return;
+  }
+
+  if (this->chunkSize_ > this->config_.maxChunkSize) {
+    DEBUG_cerr << "Chunk is too big. chunkSize: " << this->chunkSize_ << endl;
+    throw Exception(ExceptionType::OVERSIZE);
+  }
+
+  this->bodySize_ += this->chunkSize_;
+  if (this->config_.maxBodySize != 0 &&
+      this->bodySize_ > this->config_.maxBodySize) {
+    DEBUG_cerr << "Chunked body is too big. bodySize: " << this->bodySize_ << endl;
+    throw Exception(ExceptionType::OVERSIZE);
+  }
+
+  this->chunkRemaining_ = this->chunkSize_;
+  this->chunkSize_ = 0;
+  this->numSizeDigits_ = 0;
+  this->state_ = State::DATA;
+}
+
+HttpChunkedDecoder::Status HttpChunkedDecoder::GetStatus() const {
+  if (this->state_ == State::DONE) {
+    return Status::DONE;
+  }
+  return Status::READING;
+}
+
+bool HttpChunkedDecoder::IsDone() const {
+  return this->state_ == State::DONE;
+}
+
+size_t HttpChunkedDecoder::GetBodySize() const {
+  return this->bodySize_;
+}
+
+void HttpChunkedDecoder::Reset() {
+  this->state_ = State::SIZE;
+  this->chunkSize_ = 0;
+  this->chunkRemaining_ = 0;
+  this->bodySize_ = 0;
+  this->numSizeDigits_ = 0;
+}
+
+//HttpChunkedDecoder::
+
+}
+
+#if _UNIT_TEST
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include <string>
+
+using namespace lio;
+using std::string;
+
+TEST(HttpChunkedDecoder, WholeBody) {
+  string body;
+  HttpChunkedDecoder decoder([&body](const char* data, size_t length) {
+      body.append(data, length);
+  });
+
+  string raw = "4\r\nWiki\r\n5;name=value\r\npedia\r\nE\r\n in\r\n\r\nchunks.\r\n0\r\n\r\nGET /";
+  size_t consumed = decoder.Feed(raw.c_str(), raw.length());
+
+  EXPECT_EQ(decoder.IsDone(), true);
+  EXPECT_EQ(body, "Wikipedia in\r\n\r\nchunks.");
+  EXPECT_EQ(decoder.GetBodySize(), body.length());
+  EXPECT_EQ(raw.substr(consumed), "GET /");
+}
+
+TEST(HttpChunkedDecoder, ByteByByteWithTrailer) {
+  string body;
+  HttpChunkedDecoder decoder([&body](const char* data, size_t length) {
+      body.append(data, length);
+  });
+
+  string raw = "a\r\n0123456789\r\n1\r\nX\r\n0\r\nExpires: never\r\n\r\n";
+  for (size_t i = 0; raw.length() > i; ++i) {
+    EXPECT_EQ(decoder.Feed(raw.c_str() + i, 1), 1);
+  }
+
+  EXPECT_EQ(decoder.IsDone(), true);
+  EXPECT_EQ(body, "0123456789X");
+}
+
+TEST(HttpChunkedDecoder, BadInput) {
+  HttpChunkedDecoder decoder(nullptr);
+  string raw = "zz\r\n";
+  EXPECT_THROW(decoder.Feed(raw.c_str(), raw.length()), HttpChunkedDecoder::Exception);
+
+  decoder.Reset();
+  raw = "3\r\nabcX";
+  EXPECT_THROW(decoder.Feed(raw.c_str(), raw.length()), HttpChunkedDecoder::Exception);
+
+  HttpChunkedDecoder::Config config;
+  config.maxBodySize = 8;
+  HttpChunkedDecoder limited(nullptr, config);
+  raw = "5\r\n12345\r\n5\r\n";
+  EXPECT_THROW(limited.Feed(raw.c_str(), raw.length()), HttpChunkedDecoder::Exception);
+}
+
+int main (int argc, char** argv) {
+  ::testing::InitGoogleMock(&argc, argv);
+  return RUN_ALL_TESTS();
+}
+
+#else
+// Executable File's Main Comes here.
+
+
+#endif
+
+#undef _UNIT_TEST
@@ -0,0 +1,158 @@
+#ifndef _HTTPCHUNKEDDECODER_HPP_
+#define _HTTPCHUNKEDDECODER_HPP_
+/*
+  Name
+    HttpChunkedDecoder
+      Incremental decoder for "Transfer-Encoding: chunked" request bodies.
+
+  Description
+    Bytes can be fed in any split (even one byte at a time).
+    Decoded body bytes are handed to DataHandler as soon as they arrive,
+    so the whole body never has to sit in one DataBlock.
+
+  Last Modified Date
+    Oct 19, 2026
+
+  History
+    October 19, 2026
+      Created
+
+  ToDos
+    Expose trailer fields. They are skipped for now.
+
+
+  Milestones
+    1.0
+
+
+  Alias
+    Chunk = ChunkSize [ ;ext ] CRLF + ChunkData + CRLF
+    LastChunk = 0 [ ;ext ] CRLF + Trailer* + CRLF
+
+  Learning Resources
+    Chunked Transfer Coding
+      http://www.w3.org/Protocols/rfc2616/rfc2616-sec3.html#sec3.6.1
+
+  Copyright (c) All rights reserved to LIFEINO.
+*/
+
+#ifdef _DEBUG
+  #undef _DEBUG
+#endif
+#define _DEBUG false
+
+#include "liolib/Debug.hpp"
+
+#include <functional> // function
+
+#include <cstdint>
+#include <cstddef> // size_t
+
+namespace lio {
+
+
+class HttpChunkedDecoder {
+public:
+
+// ******** Exception Declaration *********
+enum class ExceptionType : std::uint8_t {
+  GENERAL,
+  BAD_CHUNK_SIZE,
+  BAD_FORMAT,
+  OVERSIZE,
+  ALREADY_DONE
+};
+#define HTTPCHUNKEDDECODER_EXCEPTION_MESSAGES \
+  "HttpChunkedDecoder Exception has been thrown.", \
+  "Chunk size line is invalid.", \
+  "Chunk is not terminated with CRLF.", \
+  "Chunk or body is larger than the configured limit.", \
+  "Last chunk has already been decoded."
+
+class Exception : public std::exception {
+public:
+  Exception (ExceptionType exceptionType = ExceptionType::GENERAL);
+
+  virtual const char*         what() const noexcept;
+  virtual const               ExceptionType type() const noexcept;
+
+private:
+  const ExceptionType         exceptionType_;
+  static const char* const    exceptionMessages_[];
+};
+// ******** Exception Declaration END*********
+
+  struct Config {
+    Config() :
+      maxChunkSize(1024 * 1024 * 16),
+      maxBodySize(1024 * 1024 * 64)
+    { }
+    size_t maxChunkSize;
+    size_t maxBodySize; // 0 = UNLIMITED
+  };
+
+  enum class Status : uint8_t {
+    READING,
+    DONE
+  };
+
+  // Called for every decoded slice of body. Slices point into the fed buffer.
+  typedef std::function<void(const char* data, size_t length)> DataHandler;
+
+  HttpChunkedDecoder(DataHandler handler, Config config = Config());
+  ~HttpChunkedDecoder();
+
+  /* Name
+   *  Feed
+   * Description
+   *  Decodes as much of the given bytes as possible.
+   *  Stops right after the terminating CRLF of the last chunk,
+   *  so pipelined bytes of the next request are not consumed.
+   * Output
+   *  Returns
+   *    size_t - number of bytes consumed.
+   *  Throws
+   *    Exception when the chunked stream is malformed or oversize.
+   */
+  size_t          Feed(const char* data, size_t length);
+
+  Status          GetStatus() const;
+  bool            IsDone() const;
+  size_t          GetBodySize() const;
+
+  void            Reset();
+
+protected:
+
+private:
+  enum class State : uint8_t {
+    SIZE,
+    SIZE_EXTENSION,
+    SIZE_LF,
+    DATA,
+    DATA_CR,
+    DATA_LF,
+    TRAILER_LINE_START,
+    TRAILER_LINE,
+    TRAILER_END_LF,
+    DONE
+  };
+
+  DataHandler     handler_;
+  Config          config_;
+
+  State           state_;
+  size_t          chunkSize_;
+  size_t          chunkRemaining_;
+  size_t          bodySize_;
+  uint8_t         numSizeDigits_;
+
+  inline
+  void            onSizeLineEnd();
+
+};
+
+}
+
+#endif
+
@@ -0,0 +1,648 @@
+#include "HttpConditional.hpp"
+
+#define _UNIT_TEST false
+#include "liolib/Test.hpp"
+
+#include <atomic>
+
+#include <cstdio> // snprintf()
+#include <cstring> // strncasecmp()
+
+#include "liolib/http/HttpHeaderWriter.hpp"
+#include "liolib/Util.hpp"
+
+
+namespace lio {
+
+const size_t HttpConditional::MAX_RANGES;
+const size_t HttpConditional::HTTP_DATE_LENGTH;
+
+HttpConditional::Multipart::Multipart() :
+  length_(0)
+{ }
+
+void HttpConditional::Multipart::Build(const Decision& decision,
+                                       const Representation& representation) {
+  // Unique per response. Parts of cached files could contain any fixed one.
+  static std::atomic<uint64_t> counter(0);
+  char boundary[20];
+  snprintf(boundary, sizeof(boundary), "%016llx",
+           (unsigned long long) Util::Hash::Xxh64(representation.etag.data(),
+                                                 representation.etag.length(),
+                                                 counter.fetch_add(1)));
+  this->boundary_.assign(boundary);
+
+  string contentTypeLine;
+  if (representation.contentType != http::ContentType::UNDEF) {
+    contentTypeLine = "Content-Type: " +
+                      http::ContentTypeString[static_cast<int>(representation.contentType)] + "\r\n";
+  }
+
+  // Headers are written first so iovecs can point into them.
+  const uint64_t length = representation.data.length;
+  size_t offsets[MAX_RANGES + 1];
+  this->headers_.clear();
+  for (size_t i = 0; decision.numRanges > i; ++i) {
+    const ByteRange& range = decision.ranges[i];
+    offsets[i] = this->headers_.length();
+    if (i != 0) {
+      this->headers_.append("\r\n"); // Ends the previous part.
+    }
+    this->headers_.append("--").append(this->boundary_).append("\r\n");
+    this->headers_.append(contentTypeLine);
+    this->headers_.append("Content-Range: bytes ");
+    this->headers_.append(std::to_string(range.first)).append("-");
+    this->headers_.append(std::to_string(range.first + range.length - 1)).append("/");
+    this->headers_.append(std::to_string(length)).append("\r\n\r\n");
+  }
+  offsets[decision.numRanges] = this->headers_.length();
+  this->headers_.append("\r\n--").append(this->boundary_).append("--\r\n");
+
+  this->iovecs_.clear();
+  this->length_ = 0;
+  char* headers = &this->headers_[0];
+  char* data = static_cast<char*>(representation.data.object);
+  for (size_t i = 0; decision.numRanges > i; ++i) {
+    struct iovec header = { headers + offsets[i], offsets[i + 1] - offsets[i] };
+    struct iovec part = { data + decision.ranges[i].first, decision.ranges[i].length };
+    this->iovecs_.push_back(header);
+    this->iovecs_.push_back(part);
+    this->length_ += header.iov_len + part.iov_len;
+  }
+  struct iovec closing = { headers + offsets[decision.numRanges],
+                           this->headers_.length() - offsets[decision.numRanges] };
+  this->iovecs_.push_back(closing);
+  this->length_ += closing.iov_len;
+}
+
+const string& HttpConditional::Multipart::GetBoundary() const {
+  return this->boundary_;
+}
+
+const std::vector<struct iovec>& HttpConditional::Multipart::GetIovecs() const {
+  return this->iovecs_;
+}
+
+size_t HttpConditional::Multipart::GetLength() const {
+  return this->length_;
+}
+
+HttpConditional::Decision HttpConditional::Evaluate(const HttpRequest& request,
+                                                    const Representation& representation) {
+  Decision decision;
+  const http::RequestMethod method = request.GetRequestMethod();
+  const bool isGetOrHead = method == http::RequestMethod::GET ||
+                           method == http::RequestMethod::HEAD;
+
+  // RFC 7232 6. Step 1 and 2.
+  if (request.GetIfMatch().empty() == false) {
+    if (MatchEtag(request.GetIfMatch(), representation.etag, false) == false) {
+      decision.result = Result::PRECONDITION_FAILED;
+      return decision;
+    }
+  } else if (request.GetIfUnmodifiedSince().empty() == false) {
+    const time_t since = ParseHttpDate(request.GetIfUnmodifiedSince());
+    if (since != -1 && representation.lastModified > since) {
+      decision.result = Result::PRECONDITION_FAILED;
+      return decision;
+    }
+  }
+
+  // Step 3 and 4. If-Modified-Since is ignored when If-None-Match is sent.
+  if (request.GetIfNoneMatch().empty() == false) {
+    if (MatchEtag(request.GetIfNoneMatch(), representation.etag, true) == true) {
+      decision.result = isGetOrHead ? Result::NOT_MODIFIED : Result::PRECONDITION_FAILED;
+      return decision;
+    }
+  } else if (isGetOrHead == true && request.GetIfModifiedSince().empty() == false) {
+    const time_t since = ParseHttpDate(request.GetIfModifiedSince());
+    if (since != -1 && representation.lastModified != 0 &&
+        representation.lastModified <= since) {
+      decision.result = Result::NOT_MODIFIED;
+      return decision;
+    }
+  }
+
+  // Step 5. Range is only defined for GET.
+  if (method == http::RequestMethod::GET && request.GetRange().empty() == false &&
+      isRangeCurrent(request.GetIfRange(), representation) == true) {
+    Decision ranged;
+    if (ParseRange(request.GetRange(), representation.data.length, ranged) == true) {
+      return ranged;
+    }
+  }
+  return decision;
+}
+
+void HttpConditional::Respond(const Decision& decision, const Representation& representation,
+                              HttpResponseBuilder& response, Multipart* multipart) {
+  const uint64_t length = representation.data.length;
+  char digits[HttpHeaderWriter::MAX_NUMBER_LENGTH];
+
+  switch (decision.result) {
+  case Result::NOT_MODIFIED:
+    // No body and no Content-Length. Validators tell what is still fresh.
+    response.SetResponseCode(ResponseCode::NOT_MODIFIED);
+    setValidators(representation, response);
+    if (representation.encoding != http::ContentEncoding::IDENTITY) {
+      response.SetHeaderField("Vary", "Accept-Encoding");
+    }
+    return;
+
+  case Result::PRECONDITION_FAILED:
+    response.SetResponseCode(ResponseCode::PRECONDITION_FAILED);
+    response.SetBody(DataBlock<>());
+    return;
+
+  case Result::RANGE_NOT_SATISFIABLE: {
+    response.SetResponseCode(ResponseCode::RANGE_NOT_SATISFIABLE);
+    const size_t numDigits = HttpHeaderWriter::FormatNumber(length, digits);
+    response.SetHeaderField("Content-Range", "bytes */" + string(digits, numDigits));
+    response.SetBody(DataBlock<>());
+    return;
+  }
+
+  case Result::PARTIAL:
+    if (decision.numRanges == 1) {
+      const ByteRange& range = decision.ranges[0];
+      response.SetResponseCode(ResponseCode::PARTIAL_CONTENT);
+      setValidators(representation, response);
+      response.SetHeaderField("Content-Range",
+                              "bytes " + std::to_string(range.first) + "-" +
+                              std::to_string(range.first + range.length - 1) + "/" +
+                              std::to_string(length));
+      DataBlock<> slice(static_cast<char*>(representation.data.object) + range.first,
+                        0, range.length);
+      response.SetBody(slice, representation.encoding);
+      return;
+    }
+    if (multipart != nullptr && decision.numRanges > 1) {
+      multipart->Build(decision, representation);
+      response.SetResponseCode(ResponseCode::PARTIAL_CONTENT);
+      setValidators(representation, response);
+      // Content-Encoding and Vary, then the parts as the body chain.
+      response.SetBody(DataBlock<>(), representation.encoding);
+      response.SetHeaderField("Content-Type",
+                              "multipart/byteranges; boundary=" + multipart->GetBoundary());
+      const std::vector<struct iovec>& iovecs = multipart->GetIovecs();
+      response.SetBody(iovecs.data(), iovecs.size());
+      return;
+    }
+    break; // Whole representation instead.
+
+  default:
+    break;
+  }
+
+  response.SetResponseCode(ResponseCode::OK);
+  setValidators(representation, response);
+  response.SetHeaderField("Accept-Ranges", "bytes");
+  response.SetBody(representation.data, representation.encoding);
+}
+
+bool HttpConditional::ParseRange(const string& fieldValue, uint64_t length, Decision& decision) {
+  static const char PREFIX[] = "bytes=";
+  static const size_t PREFIX_LENGTH = sizeof(PREFIX) - 1;
+  if (fieldValue.length() <= PREFIX_LENGTH ||
+      strncasecmp(fieldValue.c_str(), PREFIX, PREFIX_LENGTH) != 0) {
+    return false;
+  }
+
+  const char* p = fieldValue.c_str() + PREFIX_LENGTH;
+  size_t numRanges = 0;
+  size_t numSpecs = 0;
+  while (*p != '\0') {
+    while (*p == ' ' || *p == '\t') {
+      ++p;
+    }
+    if (*p == ',') {
+      ++p; // Empty list elements are allowed.
+      continue;
+    }
+
+    // first-last, first- or -suffix.
+    bool hasFirst = false;
+    bool hasLast = false;
+    uint64_t first = 0;
+    uint64_t last = 0;
+    size_t numDigits = 0;
+    for (; *p >= '0' && *p <= '9'; ++p, ++numDigits) {
+      first = first * 10 + (*p - '0');
+    }
+    hasFirst = numDigits != 0;
+    if (*p != '-' || numDigits > 18) {
+      return false;
+    }
+    ++p;
+    numDigits = 0;
+    for (; *p >= '0' && *p <= '9'; ++p, ++numDigits) {
+      last = last * 10 + (*p - '0');
+    }
+    hasLast = numDigits != 0;
+    if (numDigits > 18 || (hasFirst == false && hasLast == false) ||
+        (hasFirst == true && hasLast == true && first > last)) {
+      return false;
+    }
+    while (*p == ' ' || *p == '\t') {
+      ++p;
+    }
+    if (*p != ',' && *p != '\0') {
+      return false;
+    }
+
+    numSpecs += 1;
+    if (numSpecs > MAX_RANGES) {
+      // Many small ranges cost more than the whole body.
+      return false;
+    }
+
+    ByteRange range;
+    if (hasFirst == false) {
+      if (last == 0 || length == 0) {
+        continue;
+      }
+      const uint64_t suffix = (last > length) ? length : last;
+      range.first = length - suffix;
+      range.length = suffix;
+    } else {
+      if (first >= length) {
+        continue;
+      }
+      if (hasLast == false || last >= length) {
+        last = length - 1;
+      }
+      range.first = first;
+      range.length = last - first + 1;
+    }
+    decision.ranges[numRanges] = range;
+    numRanges += 1;
+  }
+
+  if (numSpecs == 0) {
+    return false;
+  }
+  if (numRanges == 0) {
+    decision.result = Result::RANGE_NOT_SATISFIABLE;
+    decision.numRanges = 0;
+    return true;
+  }
+
+  // Insertion sort. There are only a few.
+  for (size_t i = 1; numRanges > i; ++i) {
+    const ByteRange range = decision.ranges[i];
+    size_t j = i;
+    for (; j > 0 && decision.ranges[j - 1].first > range.first; --j) {
+      decision.ranges[j] = decision.ranges[j - 1];
+    }
+    decision.ranges[j] = range;
+  }
+
+  // Overlapping and adjacent ranges are merged.
+  size_t numMerged = 1;
+  for (size_t i = 1; numRanges > i; ++i) {
+    ByteRange& previous = decision.ranges[numMerged - 1];
+    const ByteRange& range = decision.ranges[i];
+    const uint64_t previousEnd = previous.first + previous.length;
+    if (range.first <= previousEnd) {
+      const uint64_t end = range.first + range.length;
+      if (end > previousEnd) {
+        previous.length = end - previous.first;
+      }
+    } else {
+      decision.ranges[numMerged] = range;
+      numMerged += 1;
+    }
+  }
+
+  decision.result = Result::PARTIAL;
+  decision.numRanges = numMerged;
+  return true;
+}
+
+bool HttpConditional::MatchEtag(const string& fieldValue, const string& etag, bool isWeak) {
+  if (etag.empty() == true) {
+    return false;
+  }
+
+  const char* p = fieldValue.c_str();
+  while (*p != '\0') {
+    while (*p == ' ' || *p == '\t' || *p == ',') {
+      ++p;
+    }
+    if (*p == '*') {
+      return true; // The representation exists.
+    }
+
+    bool isWeakTag = false;
+    if (p[0] == 'W' && p[1] == '/') {
+      isWeakTag = true;
+      p += 2;
+    }
+    if (*p != '"') {
+      return false;
+    }
+    const char* end = strchr(p + 1, '"');
+    if (end == nullptr) {
+      return false;
+    }
+    const size_t tagLength = end + 1 - p;
+
+    // Our tags are strong. Weak comparison ignores the W/ of the request.
+    if ((isWeak == true || isWeakTag == false) &&
+        tagLength == etag.length() && etag.compare(0, tagLength, p, tagLength) == 0) {
+      return true;
+    }
+    p = end + 1;
+  }
+  return false;
+}
+
+time_t HttpConditional::ParseHttpDate(const string& value) {
+  static const char* const FORMATS[] = {
+    "%a, %d %b %Y %H:%M:%S GMT", // IMF-fixdate. Sun, 06 Nov 1994 08:49:37 GMT
+    "%A, %d-%b-%y %H:%M:%S GMT", // RFC 850. Sunday, 06-Nov-94 08:49:37 GMT
+    "%a %b %e %H:%M:%S %Y" // asctime. Sun Nov  6 08:49:37 1994
+  };
+
+  for (const char* format : FORMATS) {
+    struct tm tm;
+    memset(&tm, 0, sizeof(tm));
+    const char* end = strptime(value.c_str(), format, &tm);
+    if (end != nullptr && *end == '\0') {
+      return timegm(&tm);
+    }
+  }
+  return -1;
+}
+
+size_t HttpConditional::FormatHttpDate(time_t time, char* buffer) {
+  struct tm tm;
+  gmtime_r(&time, &tm);
+  return strftime(buffer, HTTP_DATE_LENGTH + 1, "%a, %d %b %Y %H:%M:%S GMT", &tm);
+}
+
+bool HttpConditional::isRangeCurrent(const string& ifRange, const Representation& representation) {
+  if (ifRange.empty() == true) {
+    return true;
+  }
+  if (ifRange[0] == '"' || ifRange[0] == 'W') {
+    // Ranges of different bytes must not be combined. Strong only.
+    return MatchEtag(ifRange, representation.etag, false);
+  }
+  return representation.lastModified != 0 &&
+         ParseHttpDate(ifRange) == representation.lastModified;
+}
+
+void HttpConditional::setValidators(const Representation& representation,
+                                    HttpResponseBuilder& response) {
+  if (representation.etag.empty() == false) {
+    response.SetHeaderField("ETag", representation.etag);
+  }
+  if (representation.lastModified != 0) {
+    char date[HTTP_DATE_LENGTH + 1];
+    const size_t dateLength = FormatHttpDate(representation.lastModified, date);
+    response.SetHeaderField("Last-Modified", string(date, dateLength));
+  }
+}
+
+}
+
+#if _UNIT_TEST
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include <string>
+
+using namespace lio;
+using std::string;
+
+class HttpConditionalTest : public ::testing::Test {
+protected:
+  HttpConditionalTest() :
+    body("0123456789abcdefghijklmnopqrstuvwxyz"),
+    etag("\"0123456789abcdef\""),
+    lastModified(784111777), // Sun, 06 Nov 1994 08:49:37 GMT
+    representation(DataBlock<>((void*) body.data(), 0, body.length()),
+                   http::ContentEncoding::IDENTITY, etag, lastModified,
+                   http::ContentType::PLAINTEXT)
+  { }
+
+  HttpConditional::Decision evaluate(const string& field, const string& value,
+                                     http::RequestMethod method = http::RequestMethod::GET) {
+    HttpRequest request;
+    request.SetRequestMethod(method);
+    request.SetField(field, value);
+    return HttpConditional::Evaluate(request, this->representation);
+  }
+
+  static string header(HttpResponseBuilder& response) {
+    DataBlock<string*> header = response.GetHeader();
+    return *header.object;
+  }
+
+  const string body;
+  const string etag;
+  const time_t lastModified;
+  HttpConditional::Representation representation;
+};
+
+TEST_F(HttpConditionalTest, NotModified) {
+  typedef HttpConditional::Result Result;
+  EXPECT_EQ(this->evaluate("If-None-Match", this->etag).result, Result::NOT_MODIFIED);
+  EXPECT_EQ(this->evaluate("If-None-Match", "\"x\", W/" + this->etag).result, Result::NOT_MODIFIED);
+  EXPECT_EQ(this->evaluate("If-None-Match", "*").result, Result::NOT_MODIFIED);
+  EXPECT_EQ(this->evaluate("If-None-Match", "\"x\"").result, Result::FULL);
+  EXPECT_EQ(this->evaluate("If-None-Match", this->etag, http::RequestMethod::POST).result,
+            Result::PRECONDITION_FAILED);
+
+  EXPECT_EQ(this->evaluate("If-Modified-Since", "Sun, 06 Nov 1994 08:49:37 GMT").result,
+            Result::NOT_MODIFIED);
+  EXPECT_EQ(this->evaluate("If-Modified-Since", "Sunday, 06-Nov-94 08:49:37 GMT").result,
+            Result::NOT_MODIFIED);
+  EXPECT_EQ(this->evaluate("If-Modified-Since", "Sun Nov  6 08:49:37 1994").result,
+            Result::NOT_MODIFIED);
+  EXPECT_EQ(this->evaluate("If-Modified-Since", "Sun, 06 Nov 1994 08:49:36 GMT").result,
+            Result::FULL);
+  EXPECT_EQ(this->evaluate("If-Modified-Since", "yesterday").result, Result::FULL);
+
+  HttpConditional::Decision decision = this->evaluate("If-None-Match", this->etag);
+  HttpResponseBuilder response;
+  HttpConditional::Respond(decision, this->representation, response);
+  const string text = header(response);
+  EXPECT_EQ(text.compare(0, 27, "HTTP/1.1 304 Not Modified\r\n"), 0);
+  EXPECT_NE(text.find("ETag: " + this->etag + "\r\n"), string::npos);
+  EXPECT_NE(text.find("Last-Modified: Sun, 06 Nov 1994 08:49:37 GMT\r\n"), string::npos);
+  EXPECT_EQ(text.find("Content-Length"), string::npos);
+  EXPECT_EQ(response.GetBody().length, 0);
+}
+
+TEST_F(HttpConditionalTest, Precondition) {
+  typedef HttpConditional::Result Result;
+  EXPECT_EQ(this->evaluate("If-Match", this->etag).result, Result::FULL);
+  EXPECT_EQ(this->evaluate("If-Match", "W/" + this->etag).result, Result::PRECONDITION_FAILED);
+  EXPECT_EQ(this->evaluate("If-Unmodified-Since", "Sat, 05 Nov 1994 08:49:37 GMT").result,
+            Result::PRECONDITION_FAILED);
+  EXPECT_EQ(this->evaluate("If-Unmodified-Since", "Sun, 06 Nov 1994 08:49:37 GMT").result,
+            Result::FULL);
+}
+
+TEST_F(HttpConditionalTest, ParseRange) {
+  typedef HttpConditional::Result Result;
+  HttpConditional::Decision decision;
+  ASSERT_EQ(HttpConditional::ParseRange("bytes=0-9", 36, decision), true);
+  EXPECT_EQ(decision.result, Result::PARTIAL);
+  EXPECT_EQ(decision.numRanges, 1);
+  EXPECT_EQ(decision.ranges[0].first, 0);
+  EXPECT_EQ(decision.ranges[0].length, 10);
+
+  decision = HttpConditional::Decision();
+  ASSERT_EQ(HttpConditional::ParseRange("bytes=-6, 30-, 20-25,0-0,1-2", 36, decision), true);
+  ASSERT_EQ(decision.numRanges, 3);
+  EXPECT_EQ(decision.ranges[0].first, 0); // 0-0 and 1-2 are adjacent.
+  EXPECT_EQ(decision.ranges[0].length, 3);
+  EXPECT_EQ(decision.ranges[1].first, 20);
+  EXPECT_EQ(decision.ranges[1].length, 6);
+  EXPECT_EQ(decision.ranges[2].first, 30); // -6 and 30- are the same.
+  EXPECT_EQ(decision.ranges[2].length, 6);
+
+  decision = HttpConditional::Decision();
+  ASSERT_EQ(HttpConditional::ParseRange("bytes=5-100,-100", 36, decision), true);
+  ASSERT_EQ(decision.numRanges, 1);
+  EXPECT_EQ(decision.ranges[0].first, 0);
+  EXPECT_EQ(decision.ranges[0].length, 36);
+
+  decision = HttpConditional::Decision();
+  ASSERT_EQ(HttpConditional::ParseRange("bytes=36-40", 36, decision), true);
+  EXPECT_EQ(decision.result, Result::RANGE_NOT_SATISFIABLE);
+
+  // Ignored.
+  EXPECT_EQ(HttpConditional::ParseRange("bytes=9-1", 36, decision), false);
+  EXPECT_EQ(HttpConditional::ParseRange("bytes=a-", 36, decision), false);
+  EXPECT_EQ(HttpConditional::ParseRange("lines=1-2", 36, decision), false);
+  EXPECT_EQ(HttpConditional::ParseRange("bytes=-", 36, decision), false);
+  EXPECT_EQ(HttpConditional::ParseRange("bytes=99999999999999999999-", 36, decision), false);
+  string many = "bytes=0-0";
+  for (size_t i = 1; HttpConditional::MAX_RANGES >= i; ++i) {
+    many += "," + std::to_string(i * 2) + "-" + std::to_string(i * 2);
+  }
+  EXPECT_EQ(HttpConditional::ParseRange(many, 1000, decision), false);
+}
+
+TEST_F(HttpConditionalTest, SingleRange) {
+  HttpConditional::Decision decision = this->evaluate("Range", "bytes=10-15");
+  ASSERT_EQ(decision.result, HttpConditional::Result::PARTIAL);
+
+  HttpResponseBuilder response;
+  HttpConditional::Respond(decision, this->representation, response);
+  const string text = header(response);
+  EXPECT_EQ(text.compare(0, 30, "HTTP/1.1 206 Partial Content\r\n"), 0);
+  EXPECT_NE(text.find("Content-Range: bytes 10-15/36\r\n"), string::npos);
+  EXPECT_NE(text.find("Content-Length: 6\r\n"), string::npos);
+  DataBlock<> part = response.GetBody();
+  EXPECT_EQ(part.object, this->body.data() + 10); // Not a copy.
+  EXPECT_EQ(string((char*) part.object, part.length), "abcdef");
+
+  // Stale If-Range gets the whole body.
+  HttpRequest request;
+  request.SetRequestMethod(http::RequestMethod::GET);
+  const string rangeField = "Range";
+  const string ifRangeField = "If-Range";
+  request.SetField(rangeField, "bytes=10-15");
+  request.SetField(ifRangeField, "\"old\"");
+  EXPECT_EQ(HttpConditional::Evaluate(request, this->representation).result,
+            HttpConditional::Result::FULL);
+  request.SetField(ifRangeField, "Sun, 06 Nov 1994 08:49:37 GMT");
+  EXPECT_EQ(HttpConditional::Evaluate(request, this->representation).result,
+            HttpConditional::Result::PARTIAL);
+
+  // Not for HEAD.
+  EXPECT_EQ(this->evaluate("Range", "bytes=10-15", http::RequestMethod::HEAD).result,
+            HttpConditional::Result::FULL);
+
+  HttpResponseBuilder unsatisfiable;
+  HttpConditional::Respond(this->evaluate("Range", "bytes=100-"), this->representation,
+                           unsatisfiable);
+  const string unsatisfiableText = header(unsatisfiable);
+  EXPECT_EQ(unsatisfiableText.compare(0, 36, "HTTP/1.1 416 Range Not Satisfiable\r\n"), 0);
+  EXPECT_NE(unsatisfiableText.find("Content-Range: bytes */36\r\n"), string::npos);
+}
+
+TEST_F(HttpConditionalTest, Multipart) {
+  HttpConditional::Decision decision = this->evaluate("Range", "bytes=0-1,-2");
+  ASSERT_EQ(decision.numRanges, 2);
+
+  HttpConditional::Multipart multipart;
+  HttpResponseBuilder response;
+  HttpConditional::Respond(decision, this->representation, response, &multipart);
+
+  string multipartBody;
+  for (const struct iovec& iov : multipart.GetIovecs()) {
+    multipartBody.append((const char*) iov.iov_base, iov.iov_len);
+  }
+  const string boundary = multipart.GetBoundary();
+  EXPECT_EQ(multipartBody,
+            "--" + boundary + "\r\n"
+            "Content-Type: text/plain\r\n"
+            "Content-Range: bytes 0-1/36\r\n\r\n"
+            "01\r\n"
+            "--" + boundary + "\r\n"
+            "Content-Type: text/plain\r\n"
+            "Content-Range: bytes 34-35/36\r\n\r\n"
+            "yz\r\n"
+            "--" + boundary + "--\r\n");
+  EXPECT_EQ(multipart.GetIovecs()[1].iov_base, this->body.data()); // Not a copy.
+  EXPECT_EQ(multipart.GetLength(), multipartBody.length());
+  std::vector<struct iovec> bodyIovecs;
+  EXPECT_EQ(response.GetBodyIovecs(bodyIovecs), multipartBody.length());
+  EXPECT_EQ(bodyIovecs.size(), multipart.GetIovecs().size());
+
+  const string text = header(response);
+  EXPECT_NE(text.find("Content-Type: multipart/byteranges; boundary=" + boundary + "\r\n"),
+            string::npos);
+  EXPECT_NE(text.find("Content-Length: " + std::to_string(multipartBody.length()) + "\r\n"),
+            string::npos);
+
+  // Without multipart, the whole body.
+  HttpResponseBuilder full;
+  HttpConditional::Respond(decision, this->representation, full);
+  EXPECT_EQ(header(full).compare(0, 17, "HTTP/1.1 200 OK\r\n"), 0);
+  EXPECT_NE(header(full).find("Accept-Ranges: bytes\r\n"), string::npos);
+  EXPECT_EQ(full.GetBody().length, this->body.length());
+}
+
+TEST_F(HttpConditionalTest, Benchmark) {
+  PERFTEST {
+    const size_t NUM_REQUESTS = 1000000;
+    HttpRequest request;
+    request.SetRequestMethod(http::RequestMethod::GET);
+    const string field = "If-None-Match";
+    request.SetField(field, this->etag);
+
+    size_t numNotModified = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; NUM_REQUESTS > i; ++i) {
+      if (HttpConditional::Evaluate(request, this->representation).result ==
+          HttpConditional::Result::NOT_MODIFIED) {
+        numNotModified += 1;
+      }
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                     std::chrono::steady_clock::now() - start).count();
+    EXPECT_EQ(numNotModified, NUM_REQUESTS);
+    std::cout << "Evaluate: " << elapsed / NUM_REQUESTS << " ns per request" << endl;
+  }
+}
+
+int main (int argc, char** argv) {
+  ::testing::InitGoogleMock(&argc, argv);
+  return RUN_ALL_TESTS();
+}
+
+#else
+// Executable File's Main Comes here.
+
+
+#endif
+
+#undef _UNIT_TEST
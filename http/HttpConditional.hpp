@@ -0,0 +1,192 @@
+#ifndef _HTTPCONDITIONAL_HPP_
+#define _HTTPCONDITIONAL_HPP_
+/*
+  Name
+    HttpConditional
+      If-None-Match, If-Modified-Since, If-Match, If-Unmodified-Since, Range
+      and If-Range of static representations.
+
+  Description
+    Evaluate() decides what a request gets before any body work is done.
+    Preconditions are checked in the order of RFC 7232 section 6, so a
+    revalidating client gets its 304 without the body being looked at.
+
+      If-Match            strong comparison, or If-Unmodified-Since -> 412
+      If-None-Match       weak comparison, or If-Modified-Since     -> 304
+      Range of GET        when If-Range still matches               -> 206
+                          nothing satisfiable                       -> 416
+
+    Ranges are sorted and overlapping or adjacent ones are merged. More
+    than MAX_RANGES ranges or bad syntax and the header is ignored, as
+    RFC 7233 allows.
+
+    Respond() writes the status line, validators and body into a
+    HttpResponseBuilder. A single range is a DataBlock into the
+    representation. Several ranges become a Multipart, whose iovecs point
+    into the representation too and are set as the body chain, so bytes
+    of FileCache entries and mapped files are never copied.
+
+    Representation is what GetDataBlock(), GetEtag() and mtime of a
+    FileCache::Entry give for the selected encoding. Ranges and ETags are
+    of the encoded bytes.
+
+  Last Modified Date
+    Oct 19, 2026
+
+  History
+    October 19, 2026
+      Created
+
+  ToDos
+
+
+  Milestones
+    1.0
+
+
+  Learning Resources
+    HTTP/1.1 Conditional Requests
+      https://tools.ietf.org/html/rfc7232
+    HTTP/1.1 Range Requests
+      https://tools.ietf.org/html/rfc7233
+
+  Copyright (c) All rights reserved to LIFEINO.
+*/
+
+#ifdef _DEBUG
+  #undef _DEBUG
+#endif
+#define _DEBUG false
+
+#include "liolib/Debug.hpp"
+
+#include <string>
+#include <vector>
+
+#include <cstdint>
+#include <ctime> // time_t
+
+#include <sys/uio.h> // iovec
+
+#include "liolib/DataBlock.hpp"
+#include "liolib/http/Http.hpp"
+#include "liolib/http/HttpRequest.hpp"
+#include "liolib/http/HttpResponseBuilder.hpp"
+
+namespace lio {
+
+using std::string;
+
+
+class HttpConditional {
+public:
+  enum class Result : uint8_t {
+    FULL, // 200
+    NOT_MODIFIED, // 304
+    PRECONDITION_FAILED, // 412
+    PARTIAL, // 206
+    RANGE_NOT_SATISFIABLE // 416
+  };
+
+  struct ByteRange {
+    uint64_t        first;
+    uint64_t        length;
+  };
+  static const size_t MAX_RANGES = 16;
+
+  struct Decision {
+    Decision() :
+      result(Result::FULL),
+      numRanges(0)
+    { }
+    Result          result;
+    size_t          numRanges; // Of PARTIAL. Sorted, not overlapping.
+    ByteRange       ranges[MAX_RANGES];
+  };
+
+  // Bytes and validators of what is sent. Data and etag are not copied,
+  // so both have to outlive the Representation.
+  struct Representation {
+    Representation(const DataBlock<>& data, http::ContentEncoding encoding,
+                   const string& etag, time_t lastModified,
+                   http::ContentType contentType = http::ContentType::UNDEF) :
+      data(data),
+      encoding(encoding),
+      etag(etag),
+      lastModified(lastModified),
+      contentType(contentType)
+    { }
+    DataBlock<>     data;
+    http::ContentEncoding encoding;
+    const string&   etag; // Quoted. Empty when there is none.
+    time_t          lastModified; // 0 when unknown.
+    http::ContentType contentType; // For parts of multipart/byteranges.
+  };
+
+  // multipart/byteranges body of a PARTIAL decision with several ranges.
+  // Only delimiters and part headers are owned. Parts point into the
+  // representation, which has to outlive this.
+  class Multipart {
+  public:
+    Multipart();
+
+    void            Build(const Decision& decision, const Representation& representation);
+
+    const string&   GetBoundary() const;
+    // Whole body in order. Write with writev().
+    const std::vector<struct iovec>& GetIovecs() const;
+    size_t          GetLength() const;
+
+  private:
+    string          boundary_;
+    string          headers_; // Delimiters and part headers back to back.
+    std::vector<struct iovec> iovecs_;
+    size_t          length_;
+
+    Multipart(const Multipart&) = delete;
+    Multipart& operator=(const Multipart&) = delete;
+  };
+
+  static
+  Decision        Evaluate(const HttpRequest& request, const Representation& representation);
+
+  // Status line, ETag, Last-Modified and body of the decision. Several
+  // ranges are built into multipart, which has to outlive the response.
+  // When multipart is nullptr, the full representation is sent instead.
+  static
+  void            Respond(const Decision& decision, const Representation& representation,
+                          HttpResponseBuilder& response, Multipart* multipart = nullptr);
+
+  // "bytes=0-99,-100". RANGE_NOT_SATISFIABLE when no range is in length,
+  // PARTIAL with the merged ranges otherwise. False when the header has
+  // to be ignored.
+  static
+  bool            ParseRange(const string& fieldValue, uint64_t length, Decision& decision);
+
+  // True when an entity tag of the list, or "*", matches etag.
+  // Strong comparison never matches a weak "W/" tag.
+  static
+  bool            MatchEtag(const string& fieldValue, const string& etag, bool isWeak);
+
+  // IMF-fixdate, RFC 850 and asctime formats. -1 when invalid.
+  static
+  time_t          ParseHttpDate(const string& value);
+  // "Sun, 06 Nov 1994 08:49:37 GMT". Returns length.
+  static
+  size_t          FormatHttpDate(time_t time, char* buffer);
+  static const size_t HTTP_DATE_LENGTH = 29;
+
+private:
+  // No If-Range, or it still names the representation.
+  static
+  bool            isRangeCurrent(const string& ifRange, const Representation& representation);
+  static
+  void            setValidators(const Representation& representation,
+                                HttpResponseBuilder& response);
+
+  HttpConditional() = delete;
+};
+
+}
+
+#endif
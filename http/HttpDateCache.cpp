@@ -0,0 +1,182 @@
+
+#include "HttpDateCache.hpp"
+
+#define _UNIT_TEST false
+#include "liolib/Test.hpp"
+
+#include "liolib/SeqLock.hpp"
+
+
+namespace lio {
+
+namespace {
+
+struct Date {
+  time_t        time;
+  char          field[HttpDateCache::FIELD_LENGTH + 1];
+};
+
+Date formatDate(time_t now) {
+  struct tm gmt;
+  gmtime_r(&now, &gmt);
+  Date date;
+  date.time = now;
+  strftime(date.field, sizeof(date.field), "Date: %a, %d %b %Y %H:%M:%S GMT\r\n", &gmt);
+  return date;
+}
+
+// Constructed on first use, so GetField() works during static initialization.
+SeqLock<Date>& getDate() {
+  static SeqLock<Date> date;
+  return date;
+}
+
+// Copy of the field this thread returns pointers to. Only this thread writes it.
+thread_local Date threadDate = { 0, { 0 } };
+
+}
+
+const size_t HttpDateCache::FIELD_LENGTH;
+const size_t HttpDateCache::VALUE_LENGTH;
+
+std::atomic<time_t> HttpDateCache::lastUpdated_(0);
+std::atomic<bool> HttpDateCache::isUpdating_(false);
+
+bool HttpDateCache::Update() {
+  return Update(time(nullptr));
+}
+
+bool HttpDateCache::Update(time_t now) {
+  if (lastUpdated_.load(std::memory_order_relaxed) == now) {
+    return false;
+  }
+  // One formats, the others keep the current field.
+  if (isUpdating_.exchange(true, std::memory_order_acquire) == true) {
+    return false;
+  }
+  if (lastUpdated_.load(std::memory_order_relaxed) == now) {
+    isUpdating_.store(false, std::memory_order_release);
+    return false;
+  }
+
+  getDate().Store(formatDate(now));
+  lastUpdated_.store(now, std::memory_order_release);
+  isUpdating_.store(false, std::memory_order_release);
+  return true;
+}
+
+const char* HttpDateCache::GetField() {
+  // time() is a vDSO call that reads a cached second.
+  return GetField(time(nullptr));
+}
+
+const char* HttpDateCache::GetField(time_t now) {
+  if (lastUpdated_.load(std::memory_order_relaxed) != now) {
+    Update(now);
+  }
+  // Copied again only when the second has changed.
+  const time_t updated = lastUpdated_.load(std::memory_order_acquire);
+  if (updated == 0) {
+    // The first Update() has not finished yet. Nothing to copy.
+    threadDate = formatDate(now);
+  } else if (threadDate.time != updated) {
+    threadDate = getDate().Load();
+  }
+  return threadDate.field;
+}
+
+const char* HttpDateCache::GetValue() {
+  return GetField() + 6;
+}
+
+const char* HttpDateCache::GetValue(time_t now) {
+  return GetField(now) + 6;
+}
+
+}
+
+#if _UNIT_TEST
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace lio;
+using std::string;
+
+namespace {
+
+string format(time_t time) {
+  struct tm gmt;
+  gmtime_r(&time, &gmt);
+  char field[HttpDateCache::FIELD_LENGTH + 1];
+  strftime(field, sizeof(field), "Date: %a, %d %b %Y %H:%M:%S GMT\r\n", &gmt);
+  return field;
+}
+
+// A field taken apart between two updates reads as another date, mostly
+// with the wrong weekday.
+bool isWhole(const string& field) {
+  struct tm gmt = {};
+  if (strptime(field.c_str(), "Date: %a, %d %b %Y %H:%M:%S GMT", &gmt) == nullptr) {
+    return false;
+  }
+  return format(timegm(&gmt)) == field;
+}
+
+}
+
+TEST(HttpDateCache, Format) {
+  EXPECT_EQ(HttpDateCache::Update(784111777), true);
+  EXPECT_EQ(HttpDateCache::Update(784111777), false);
+  EXPECT_EQ(HttpDateCache::Update(784111778), true);
+  EXPECT_EQ(string(HttpDateCache::GetField(784111778), HttpDateCache::FIELD_LENGTH),
+            "Date: Sun, 06 Nov 1994 08:49:38 GMT\r\n");
+  EXPECT_EQ(string(HttpDateCache::GetValue(784111778), HttpDateCache::VALUE_LENGTH),
+            "Sun, 06 Nov 1994 08:49:38 GMT");
+
+  // GetField() moves it to now.
+  const time_t before = time(nullptr);
+  const string field(HttpDateCache::GetField(), HttpDateCache::FIELD_LENGTH);
+  const string value(HttpDateCache::GetValue(), HttpDateCache::VALUE_LENGTH);
+  const time_t after = time(nullptr);
+  EXPECT_TRUE(field == format(before) || field == format(after));
+  EXPECT_EQ(value, field.substr(6, HttpDateCache::VALUE_LENGTH));
+}
+
+TEST(HttpDateCache, Writers) {
+  // Far apart, so a torn field is seen.
+  const time_t times[] = { 784111777, 1600000000 + 86400 * 3 + 3600 * 7 };
+  std::atomic<size_t> numTorn(0);
+  std::vector<std::thread> threads;
+  for (size_t i = 0; 4 > i; ++i) {
+    threads.emplace_back([&times, &numTorn] {
+      for (size_t j = 0; 100 * 1000 > j; ++j) {
+        HttpDateCache::Update(times[j & 1]);
+        if (isWhole(string(HttpDateCache::GetField(), HttpDateCache::FIELD_LENGTH)) == false) {
+          numTorn += 1;
+        }
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(numTorn, 0);
+}
+
+int main (int argc, char** argv) {
+  ::testing::InitGoogleMock(&argc, argv);
+  return RUN_ALL_TESTS();
+}
+
+#else
+// Executable File's Main Comes here.
+
+
+#endif
+
+#undef _UNIT_TEST
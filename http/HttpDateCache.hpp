@@ -0,0 +1,93 @@
+#ifndef _HTTPDATECACHE_HPP_
+#define _HTTPDATECACHE_HPP_
+/*
+  Name
+    HttpDateCache
+      "Date: ...\r\n" header field formatted once per second.
+
+  Description
+    Formatting the date for every response costs a gmtime_r() and a
+    strftime(). GetField() checks time() and the field is only reformatted
+    when the second has changed.
+
+    The field is kept in a SeqLock. Every thread copies it once a second
+    into a thread local field, and GetField() points there, so a pointer
+    is never written by another thread while it is read.
+    Only one thread updates at a time. The others keep the current field,
+    which is at most a second old.
+
+  Last Modified Date
+    Oct 19, 2026
+
+  History
+    October 19, 2026
+      Created
+      Single writer. Refreshed by GetField() instead of the event loop.
+      Read through a SeqLock into a thread local copy.
+
+  ToDos
+
+
+  Milestones
+    1.0
+
+
+  Learning Resources
+    HTTP Date format
+      http://www.w3.org/Protocols/rfc2616/rfc2616-sec3.html#sec3.3.1
+
+  Copyright (c) All rights reserved to LIFEINO.
+*/
+
+#ifdef _DEBUG
+  #undef _DEBUG
+#endif
+#define _DEBUG false
+
+#include "liolib/Debug.hpp"
+
+#include <atomic>
+
+#include <ctime> // time() gmtime_r()
+
+namespace lio {
+
+
+class HttpDateCache {
+public:
+  // "Date: Sun, 06 Nov 1994 08:49:37 GMT\r\n"
+  static const size_t FIELD_LENGTH = 37;
+
+  // Returns true when the field has been reformatted. False when it is
+  // current or another thread is updating it.
+  static
+  bool            Update();
+  static
+  bool            Update(time_t now);
+
+  // Points to FIELD_LENGTH bytes of this thread. Valid until its next call.
+  // Not null terminated.
+  static
+  const char*     GetField();
+  // Field of now, or of the current second when another thread is updating.
+  static
+  const char*     GetField(time_t now);
+
+  // Same as GetField() but without "Date: " and CRLF.
+  static
+  const char*     GetValue();
+  static
+  const char*     GetValue(time_t now);
+  static const size_t VALUE_LENGTH = FIELD_LENGTH - 8;
+
+private:
+  static std::atomic<time_t>  lastUpdated_;
+  static std::atomic<bool>    isUpdating_;
+
+  HttpDateCache() = delete;
+};
+
+}
+
+#endif
+
@@ -0,0 +1,321 @@
+
+#include "HttpHeaderWriter.hpp"
+
+#define _UNIT_TEST false
+#include "liolib/Test.hpp"
+
+
+namespace lio {
+
+const size_t HttpHeaderWriter::INLINE_CAPACITY;
+const size_t HttpHeaderWriter::MAX_NUMBER_LENGTH;
+
+HttpHeaderWriter::HttpHeaderWriter() :
+  buffer_(inlineBuffer_),
+  capacity_(INLINE_CAPACITY),
+  length_(0),
+  isOverflowed_(false)
+{ }
+
+HttpHeaderWriter::HttpHeaderWriter(char* buffer, size_t capacity) :
+  buffer_(buffer),
+  capacity_(capacity),
+  length_(0),
+  isOverflowed_(false)
+{ }
+
+bool HttpHeaderWriter::Append(const char* data, size_t length) {
+  if (this->capacity_ - this->length_ < length) {
+    DEBUG_cerr << "Header does not fit in the buffer. capacity: " << this->capacity_ << endl;
+    this->isOverflowed_ = true;
+    return false;
+  }
+  memcpy(this->buffer_ + this->length_, data, length);
+  this->length_ += length;
+  return true;
+}
+
+bool HttpHeaderWriter::WriteStatusLine(const ResponseCode responseCode) {
+  const http::ByteTemplate& statusLine =
+    http::StatusLineTemplate[static_cast<int>(responseCode)];
+  return this->Append(statusLine.data, statusLine.length);
+}
+
+bool HttpHeaderWriter::WriteField(const char* field, size_t fieldLength,
+                                  const char* value, size_t valueLength) {
+  if (this->capacity_ - this->length_ < fieldLength + valueLength + 4) {
+    this->isOverflowed_ = true;
+    return false;
+  }
+  char* dest = this->buffer_ + this->length_;
+  memcpy(dest, field, fieldLength);
+  dest += fieldLength;
+  *dest++ = ':';
+  *dest++ = ' ';
+  memcpy(dest, value, valueLength);
+  dest += valueLength;
+  *dest++ = '\r';
+  *dest++ = '\n';
+  this->length_ = dest - this->buffer_;
+  return true;
+}
+
+bool HttpHeaderWriter::WriteField(const string& field, const string& value) {
+  return this->WriteField(field.c_str(), field.length(), value.c_str(), value.length());
+}
+
+bool HttpHeaderWriter::WriteTemplate(const http::HeaderTemplate headerTemplate) {
+  const http::ByteTemplate& bytes =
+    http::HeaderTemplateBytes[static_cast<int>(headerTemplate)];
+  return this->Append(bytes.data, bytes.length);
+}
+
+bool HttpHeaderWriter::WriteContentLength(uint64_t length) {
+  const http::ByteTemplate& prefix =
+    http::HeaderTemplateBytes[static_cast<int>(http::HeaderTemplate::CONTENT_LENGTH)];
+  if (this->capacity_ - this->length_ < prefix.length + MAX_NUMBER_LENGTH + 2) {
+    this->isOverflowed_ = true;
+    return false;
+  }
+  char* dest = this->buffer_ + this->length_;
+  memcpy(dest, prefix.data, prefix.length);
+  dest += prefix.length;
+  dest += FormatNumber(length, dest);
+  *dest++ = '\r';
+  *dest++ = '\n';
+  this->length_ = dest - this->buffer_;
+  return true;
+}
+
+bool HttpHeaderWriter::WriteContentType(const ContentType contentType, bool isUtf8) {
+  static const char UTF8_SUFFIX[] = "; charset=utf-8\r\n";
+
+  const http::ByteTemplate& prefix =
+    http::HeaderTemplateBytes[static_cast<int>(http::HeaderTemplate::CONTENT_TYPE)];
+  const string& typeString = http::ContentTypeString[static_cast<int>(contentType)];
+
+  if (this->capacity_ - this->length_ <
+      prefix.length + typeString.length() + sizeof(UTF8_SUFFIX)) {
+    this->isOverflowed_ = true;
+    return false;
+  }
+  this->Append(prefix.data, prefix.length);
+  this->Append(typeString.c_str(), typeString.length());
+  if (isUtf8 == true) {
+    return this->Append(UTF8_SUFFIX, sizeof(UTF8_SUFFIX) - 1);
+  }
+  return this->Append("\r\n", 2);
+}
+
+bool HttpHeaderWriter::WriteDate() {
+  return this->Append(HttpDateCache::GetField(), HttpDateCache::FIELD_LENGTH);
+}
+
+bool HttpHeaderWriter::End() {
+  return this->Append("\r\n", 2);
+}
+
+const char* HttpHeaderWriter::GetData() const {
+  return this->buffer_;
+}
+
+size_t HttpHeaderWriter::GetLength() const {
+  return this->length_;
+}
+
+size_t HttpHeaderWriter::GetCapacity() const {
+  return this->capacity_;
+}
+
+bool HttpHeaderWriter::IsOverflowed() const {
+  return this->isOverflowed_;
+}
+
+void HttpHeaderWriter::Reset() {
+  this->length_ = 0;
+  this->isOverflowed_ = false;
+}
+
+size_t HttpHeaderWriter::FormatNumber(uint64_t value, char* dest) {
+  static const char DIGIT_PAIRS[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+  char reversed[MAX_NUMBER_LENGTH];
+  size_t numDigits = 0;
+  while (value >= 100) {
+    const size_t pair = (value % 100) * 2;
+    value /= 100;
+    reversed[numDigits++] = DIGIT_PAIRS[pair + 1];
+    reversed[numDigits++] = DIGIT_PAIRS[pair];
+  }
+  if (value >= 10) {
+    const size_t pair = value * 2;
+    reversed[numDigits++] = DIGIT_PAIRS[pair + 1];
+    reversed[numDigits++] = DIGIT_PAIRS[pair];
+  } else {
+    reversed[numDigits++] = '0' + value;
+  }
+
+  for (size_t i = 0; numDigits > i; ++i) {
+    dest[i] = reversed[numDigits - 1 - i];
+  }
+  return numDigits;
+}
+
+//HttpHeaderWriter::
+
+}
+
+#if _UNIT_TEST
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include <chrono>
+#include <limits>
+#include <string>
+
+#include "liolib/http/HttpResponseBuilder.hpp"
+
+using namespace lio;
+using std::string;
+
+TEST(HttpHeaderWriter, FormatNumber) {
+  char digits[HttpHeaderWriter::MAX_NUMBER_LENGTH];
+  const uint64_t values[] = { 0, 7, 10, 99, 100, 12345, 1000000,
+                              std::numeric_limits<uint64_t>::max() };
+  for (uint64_t value : values) {
+    size_t numDigits = HttpHeaderWriter::FormatNumber(value, digits);
+    EXPECT_EQ(string(digits, numDigits), std::to_string(value));
+  }
+}
+
+TEST(HttpHeaderWriter, Header) {
+  const string dateBefore(HttpDateCache::GetField(), HttpDateCache::FIELD_LENGTH);
+  HttpHeaderWriter writer;
+  writer.WriteStatusLine(ResponseCode::OK);
+  writer.WriteContentType(ContentType::JSON, true);
+  writer.WriteContentLength(27);
+  writer.WriteTemplate(http::HeaderTemplate::CONNECTION_KEEP_ALIVE);
+  writer.WriteDate();
+  writer.WriteField("Server", "lio");
+  writer.End();
+
+  const string dateAfter(HttpDateCache::GetField(), HttpDateCache::FIELD_LENGTH);
+
+  EXPECT_EQ(writer.IsOverflowed(), false);
+  const string header(writer.GetData(), writer.GetLength());
+  const string head = "HTTP/1.1 200 OK\r\n"
+                      "Content-Type: application/json; charset=utf-8\r\n"
+                      "Content-Length: 27\r\n"
+                      "Connection: keep-alive\r\n";
+  const string tail = "Server: lio\r\n"
+                      "\r\n";
+  EXPECT_TRUE(header == head + dateBefore + tail || header == head + dateAfter + tail) << header;
+}
+
+TEST(HttpHeaderWriter, Overflow) {
+  char buffer[24];
+  HttpHeaderWriter writer(buffer, sizeof(buffer));
+  EXPECT_EQ(writer.WriteStatusLine(ResponseCode::OK), true);
+  EXPECT_EQ(writer.WriteContentLength(1024), false);
+  EXPECT_EQ(writer.IsOverflowed(), true);
+  EXPECT_EQ(string(writer.GetData(), writer.GetLength()), "HTTP/1.1 200 OK\r\n");
+
+  writer.Reset();
+  EXPECT_EQ(writer.IsOverflowed(), false);
+  EXPECT_EQ(writer.GetLength(), 0);
+}
+
+TEST(HttpHeaderWriter, ResponseBuilder) {
+  const string dateBefore(HttpDateCache::GetField(), HttpDateCache::FIELD_LENGTH);
+  string body = "{\"id\":1}";
+  HttpResponseBuilder response;
+  response.SetHeaderField("Content-Type", "application/json");
+  response.SetBody(body);
+  response.SetHeaderField("Content-Type", "text/plain");
+  response.AddDateField();
+  DataBlock<string*> header = response.GetHeader();
+  const string dateAfter(HttpDateCache::GetField(), HttpDateCache::FIELD_LENGTH);
+
+  const string head = "HTTP/1.1 200 OK\r\n"
+                      "Content-Length: 8\r\n"
+                      "Content-Type: text/plain\r\n";
+  EXPECT_TRUE(header.GetValue() == head + dateBefore + "\r\n" ||
+              header.GetValue() == head + dateAfter + "\r\n") << header.GetValue();
+}
+
+TEST(HttpHeaderWriter, SmallJsonBenchmark) {
+  PERFTEST {
+    const size_t NUM_RESPONSES = 1000000;
+    const string body = "{\"id\":12345,\"name\":\"lio\",\"ok\":true}";
+    size_t checksum = 0;
+
+    auto report = [](const char* name, std::chrono::steady_clock::time_point start) {
+      double seconds = std::chrono::duration<double>(
+          std::chrono::steady_clock::now() - start).count();
+      std::cout << name << ": " << (size_t) (NUM_RESPONSES / seconds)
+                << " responses/sec" << endl;
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; NUM_RESPONSES > i; ++i) {
+      // How headers were built before templates.
+      string header = "HTTP/1.1 ";
+      header.append(http::ResponseCodeString[(int) ResponseCode::OK]);
+      header.append("\r\n");
+      header.append(string("Content-Type") + ": " + "application/json" + "\r\n");
+      header.append(string("Content-Length") + ": " + std::to_string(body.length()) + "\r\n");
+      header.append("\r\n");
+      checksum += header.length();
+    }
+    report("String concatenation", start);
+
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; NUM_RESPONSES > i; ++i) {
+      HttpResponseBuilder response;
+      response.SetHeaderField("Content-Type", "application/json");
+      response.SetBody(body);
+      response.AddDateField();
+      checksum += response.GetHeader().GetLength();
+    }
+    report("HttpResponseBuilder", start);
+
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; NUM_RESPONSES > i; ++i) {
+      HttpDateCache::Update();
+      HttpHeaderWriter writer;
+      writer.WriteStatusLine(ResponseCode::OK);
+      writer.WriteContentType(ContentType::JSON);
+      writer.WriteContentLength(body.length());
+      writer.WriteDate();
+      writer.End();
+      checksum += writer.GetLength();
+    }
+    report("HttpHeaderWriter", start);
+
+    EXPECT_GT(checksum, 0);
+  }
+}
+
+int main (int argc, char** argv) {
+  ::testing::InitGoogleMock(&argc, argv);
+  return RUN_ALL_TESTS();
+}
+
+#else
+// Executable File's Main Comes here.
+
+
+#endif
+
+#undef _UNIT_TEST
@@ -0,0 +1,112 @@
+#ifndef _HTTPHEADERWRITER_HPP_
+#define _HTTPHEADERWRITER_HPP_
+/*
+  Name
+    HttpHeaderWriter
+      Writes a response header into a fixed-capacity buffer.
+
+  Description
+    Nothing is allocated. Buffer is either the inline one, which puts the
+    whole writer on the stack, or a caller provided one (arena, pool block).
+
+    Status lines and common fields are copied from the templates in
+    Http.hpp. Numbers are formatted by hand instead of std::to_string().
+
+    When a write does not fit, nothing is written, false is returned and
+    IsOverflowed() stays true until Reset().
+
+  Last Modified Date
+    Oct 19, 2026
+
+  History
+    October 19, 2026
+      Created
+
+  ToDos
+
+
+  Milestones
+    1.0
+
+
+  Learning Resources
+    HTTP Protocol
+      Http Request/Response Structure
+        http://www.w3.org/Protocols/rfc2616/rfc2616-sec4.html
+
+  Copyright (c) All rights reserved to LIFEINO.
+*/
+
+#ifdef _DEBUG
+  #undef _DEBUG
+#endif
+#define _DEBUG false
+
+#include "liolib/Debug.hpp"
+
+#include <string>
+
+#include <cstdint>
+#include <cstring> // memcpy()
+
+#include "liolib/http/Http.hpp"
+#include "liolib/http/HttpDateCache.hpp"
+
+namespace lio {
+
+using std::string;
+using lio::http::ContentType;
+using lio::http::ResponseCode;
+
+
+class HttpHeaderWriter {
+public:
+  static const size_t INLINE_CAPACITY = 1024;
+
+  // Enough for the digits of uint64_t.
+  static const size_t MAX_NUMBER_LENGTH = 20;
+
+  HttpHeaderWriter();
+  HttpHeaderWriter(char* buffer, size_t capacity);
+
+  bool            WriteStatusLine(const ResponseCode responseCode);
+  bool            WriteField(const char* field, size_t fieldLength,
+                             const char* value, size_t valueLength);
+  bool            WriteField(const string& field, const string& value);
+  bool            WriteTemplate(const http::HeaderTemplate headerTemplate);
+  bool            WriteContentLength(uint64_t length);
+  bool            WriteContentType(const ContentType contentType, bool isUtf8 = false);
+  bool            WriteDate();
+
+  // Writes the empty line that ends the header.
+  bool            End();
+
+  bool            Append(const char* data, size_t length);
+
+  const char*     GetData() const;
+  size_t          GetLength() const;
+  size_t          GetCapacity() const;
+  bool            IsOverflowed() const;
+  void            Reset();
+
+  // Writes decimal digits of value to dest. dest must have
+  // MAX_NUMBER_LENGTH bytes. Returns number of digits written.
+  static
+  size_t          FormatNumber(uint64_t value, char* dest);
+
+private:
+  char*           buffer_;
+  size_t          capacity_;
+  size_t          length_;
+  bool            isOverflowed_;
+
+  char            inlineBuffer_[INLINE_CAPACITY];
+
+  HttpHeaderWriter(const HttpHeaderWriter&) = delete;
+  HttpHeaderWriter& operator=(const HttpHeaderWriter&) = delete;
+};
+
+}
+
+#endif
+
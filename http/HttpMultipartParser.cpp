@@ -0,0 +1,581 @@
+
+#include "HttpMultipartParser.hpp"
+
+#define _UNIT_TEST false
+#include "liolib/Test.hpp"
+
+
+namespace lio {
+
+// ===== Exception Implementation =====
+const char* const
+HttpMultipartParser::Exception::exceptionMessages_[] = {
+  HTTPMULTIPARTPARSER_EXCEPTION_MESSAGES
+};
+#undef HTTPMULTIPARTPARSER_EXCEPTION_MESSAGES // undef helps reducing unnecessary preprocessing work.
+
+
+HttpMultipartParser::Exception::Exception(ExceptionType exceptionType) :
+  exceptionType_(exceptionType) { }
+
+const char*
+HttpMultipartParser::Exception::what() const noexcept {
+  return this->exceptionMessages_[(int) this->exceptionType_];
+}
+
+const HttpMultipartParser::ExceptionType
+HttpMultipartParser::Exception::type() const noexcept {
+  return this->exceptionType_;
+}
+// ===== Exception Implementation End =====
+
+
+// ===== FileSink =====
+HttpMultipartParser::FileSink::FileSink() :
+  fd_(-1),
+  writtenSize_(0)
+{ }
+
+HttpMultipartParser::FileSink::~FileSink() {
+  this->Close();
+}
+
+bool HttpMultipartParser::FileSink::Open(const string& filePath) {
+  this->Close();
+  // An existing file is never overwritten. EEXIST fails the upload.
+  this->fd_ = open(filePath.c_str(), O_WRONLY | O_CREAT | O_EXCL, 0640);
+  if (this->fd_ < 0) {
+    DEBUG_cerr << "Failed to open file. path: " << filePath << " errno: " << errno << endl;
+    return false;
+  }
+  this->writtenSize_ = 0;
+  return true;
+}
+
+bool HttpMultipartParser::FileSink::Write(const char* data, size_t length) {
+  if (this->fd_ < 0) {
+    return false;
+  }
+  while (length > 0) {
+    ssize_t written = write(this->fd_, data, length);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      DEBUG_cerr << "Failed to write to file. errno: " << errno << endl;
+      return false;
+    }
+    data += written;
+    length -= written;
+    this->writtenSize_ += written;
+  }
+  return true;
+}
+
+bool HttpMultipartParser::FileSink::Close() {
+  if (this->fd_ < 0) {
+    return false;
+  }
+  close(this->fd_);
+  this->fd_ = -1;
+  return true;
+}
+
+bool HttpMultipartParser::FileSink::IsOpen() const {
+  return this->fd_ >= 0;
+}
+
+size_t HttpMultipartParser::FileSink::GetWrittenSize() const {
+  return this->writtenSize_;
+}
+// ===== FileSink End =====
+
+
+HttpMultipartParser::HttpMultipartParser(const string& boundary, Config config) :
+  config_(config),
+  state_(State::PREAMBLE),
+  numParts_(0)
+{
+  DEBUG_FUNC_START; // Prints out function name in yellow
+
+  // RFC2046: boundary is 1 to 70 characters.
+  if (boundary.empty() == true || boundary.length() > 70) {
+    DEBUG_cerr << "Invalid boundary. boundary: " << boundary << endl;
+    throw Exception(ExceptionType::BAD_BOUNDARY);
+  }
+
+  this->delimiter_ = "\r\n--" + boundary;
+
+  const size_t delimiterLength = this->delimiter_.length();
+  for (size_t i = 0; 256 > i; ++i) {
+    this->skipTable_[i] = delimiterLength;
+  }
+  for (size_t i = 0; delimiterLength - 1 > i; ++i) {
+    this->skipTable_[(uint8_t) this->delimiter_[i]] = delimiterLength - 1 - i;
+  }
+
+  // First delimiter may come without leading CRLF.
+  // Pretend there was one so every delimiter looks the same.
+  this->tail_ = "\r\n";
+}
+
+HttpMultipartParser::~HttpMultipartParser() {
+  DEBUG_FUNC_START;
+
+}
+
+void HttpMultipartParser::SetPartBeginHandler(PartBeginHandler handler) {
+  this->partBeginHandler_ = handler;
+}
+
+void HttpMultipartParser::SetPartDataHandler(PartDataHandler handler) {
+  this->partDataHandler_ = handler;
+}
+
+void HttpMultipartParser::SetPartEndHandler(PartEndHandler handler) {
+  this->partEndHandler_ = handler;
+}
+
+size_t HttpMultipartParser::Feed(const char* data, size_t length) {
+  size_t offset = 0;
+  while (length > offset && this->state_ != State::DONE) {
+    const char c = data[offset];
+
+    switch (this->state_) {
+     case State::PREAMBLE:
+     case State::DATA:
+      offset += this->feedData(data + offset, length - offset);
+      break;
+
+     case State::AFTER_DELIMITER:
+      if (c == '-') {
+        this->state_ = State::CLOSE_DASH;
+      } else if (c == '\r') {
+        this->state_ = State::AFTER_DELIMITER_LF;
+      } else if (c == '\n') {
+        this->headerBuffer_.clear();
+        this->state_ = State::HEADERS;
+      } else if (c != ' ' && c != '\t') { // Transport padding is allowed.
+        throw Exception(ExceptionType::BAD_FORMAT);
+      }
+      offset += 1;
+      break;
+
+     case State::AFTER_DELIMITER_LF:
+      if (c != '\n') {
+        throw Exception(ExceptionType::BAD_FORMAT);
+      }
+      this->headerBuffer_.clear();
+      this->state_ = State::HEADERS;
+      offset += 1;
+      break;
+
+     case State::CLOSE_DASH:
+      if (c != '-') {
+        throw Exception(ExceptionType::BAD_FORMAT);
+      }
+      this->state_ = State::DONE;
+      offset += 1;
+      break;
+
+     case State::HEADERS:
+      this->headerBuffer_.push_back(c);
+      offset += 1;
+      if (this->headerBuffer_.length() > this->config_.maxHeaderSize) {
+        DEBUG_cerr << "Part header is too large." << endl;
+        throw Exception(ExceptionType::HEADER_TOO_LARGE);
+      }
+      if (c == '\n') {
+        const size_t headerLength = this->headerBuffer_.length();
+        if (headerLength == 2 ||
+            (headerLength >= 4 &&
+             this->headerBuffer_.compare(headerLength - 4, 4, "\r\n\r\n") == 0)) {
+          this->parseHeaders();
+          this->state_ = State::DATA;
+        }
+      }
+      break;
+
+     case State::DONE:
+      break;
+    }
+  }
+
+  return offset;
+}
+
+size_t HttpMultipartParser::feedData(const char* data, size_t length) {
+  const size_t delimiterLength = this->delimiter_.length();
+  const bool isEmitting = this->state_ == State::DATA;
+
+  if (this->tail_.empty() == false) {
+    // Check if the delimiter starts in the tail and continues in data.
+    char window[160];
+    const size_t tailLength = this->tail_.length();
+    const size_t numTaken = length < delimiterLength ? length : delimiterLength;
+    memcpy(window, this->tail_.c_str(), tailLength);
+    memcpy(window + tailLength, data, numTaken);
+
+    const size_t foundPosition = this->findDelimiter(window, tailLength + numTaken);
+    if (foundPosition < tailLength) {
+      if (isEmitting && foundPosition > 0 && this->partDataHandler_) {
+        this->partDataHandler_(this->tail_.c_str(), foundPosition);
+      }
+      const size_t consumed = foundPosition + delimiterLength - tailLength;
+      this->tail_.clear();
+      this->onDelimiterFound();
+      return consumed;
+    }
+
+    if (foundPosition == tailLength + numTaken && numTaken < delimiterLength) {
+      // Too short to decide. Keep everything that can still be a delimiter.
+      this->tail_.append(data, length);
+      size_t numKeep = 0;
+      const size_t newTailLength = this->tail_.length();
+      const size_t maxKeep = newTailLength < delimiterLength - 1 ?
+                             newTailLength : delimiterLength - 1;
+      for (size_t keep = maxKeep; keep > 0; --keep) {
+        if (memcmp(this->tail_.c_str() + newTailLength - keep,
+                   this->delimiter_.c_str(), keep) == 0) {
+          numKeep = keep;
+          break;
+        }
+      }
+      if (isEmitting && newTailLength > numKeep && this->partDataHandler_) {
+        this->partDataHandler_(this->tail_.c_str(), newTailLength - numKeep);
+      }
+      this->tail_.erase(0, newTailLength - numKeep);
+      return length;
+    }
+
+    // Delimiter does not start in the tail.
+    if (isEmitting && this->partDataHandler_) {
+      this->partDataHandler_(this->tail_.c_str(), tailLength);
+    }
+    this->tail_.clear();
+  }
+
+  const size_t foundPosition = this->findDelimiter(data, length);
+  if (foundPosition < length) {
+    if (isEmitting && foundPosition > 0 && this->partDataHandler_) {
+      this->partDataHandler_(data, foundPosition);
+    }
+    this->onDelimiterFound();
+    return foundPosition + delimiterLength;
+  }
+
+  // Last few bytes may be the beginning of a delimiter. Every delimiter
+  // starts with '\r' so only those positions need to be compared.
+  size_t numKeep = 0;
+  const size_t maxKeep = length < delimiterLength - 1 ? length : delimiterLength - 1;
+  for (size_t keep = maxKeep; keep > 0; --keep) {
+    const char* candidate = data + length - keep;
+    if (*candidate == '\r' &&
+        memcmp(candidate, this->delimiter_.c_str(), keep) == 0) {
+      numKeep = keep;
+      break;
+    }
+  }
+
+  if (isEmitting && length > numKeep && this->partDataHandler_) {
+    this->partDataHandler_(data, length - numKeep);
+  }
+  if (numKeep > 0) {
+    this->tail_.assign(data + length - numKeep, numKeep);
+  }
+  return length;
+}
+
+size_t HttpMultipartParser::findDelimiter(const char* data, size_t length) const {
+  const size_t delimiterLength = this->delimiter_.length();
+  const char* delimiter = this->delimiter_.c_str();
+  const char lastChar = delimiter[delimiterLength - 1];
+
+  size_t position = 0;
+  while (length >= position + delimiterLength) {
+    const char c = data[position + delimiterLength - 1];
+    if (c == lastChar &&
+        memcmp(data + position, delimiter, delimiterLength - 1) == 0) {
+      return position;
+    }
+    position += this->skipTable_[(uint8_t) c];
+  }
+  return length;
+}
+
+void HttpMultipartParser::onDelimiterFound() {
+  if (this->state_ == State::DATA && this->partEndHandler_) {
+    this->partEndHandler_();
+  }
+  this->state_ = State::AFTER_DELIMITER;
+}
+
+void HttpMultipartParser::parseHeaders() {
+  this->numParts_ += 1;
+  if (this->numParts_ > this->config_.maxNumParts) {
+    DEBUG_cerr << "Too many parts. numParts: " << this->numParts_ << endl;
+    throw Exception(ExceptionType::TOO_MANY_PARTS);
+  }
+
+  this->currentPart_ = Part();
+  this->currentPart_.index = this->numParts_ - 1;
+
+  size_t lineStart = 0;
+  while (true) {
+    size_t lineEnd = this->headerBuffer_.find("\r\n", lineStart);
+    if (lineEnd == string::npos || lineEnd == lineStart) {
+      break;
+    }
+
+    const size_t colonPosition = this->headerBuffer_.find(':', lineStart);
+    if (colonPosition == string::npos || colonPosition > lineEnd) {
+      DEBUG_cerr << "Invalid part header line." << endl;
+      throw Exception(ExceptionType::BAD_FORMAT);
+    }
+
+    string fieldName = Util::String::ToLower(
+        this->headerBuffer_.substr(lineStart, colonPosition - lineStart));
+    string fieldValue =
+        this->headerBuffer_.substr(colonPosition + 1, lineEnd - colonPosition - 1);
+    Util::String::Trim(fieldName);
+    Util::String::Trim(fieldValue);
+
+    if (fieldName == "content-disposition") {
+      this->currentPart_.name = getParameter(fieldValue, "name");
+      this->currentPart_.fileName = getParameter(fieldValue, "filename");
+    } else if (fieldName == "content-type") {
+      this->currentPart_.contentType = fieldValue;
+    }
+    this->currentPart_.headers[fieldName] = fieldValue;
+
+    lineStart = lineEnd + 2;
+  }
+
+  if (this->partBeginHandler_) {
+    this->partBeginHandler_(this->currentPart_);
+  }
+}
+
+bool HttpMultipartParser::IsDone() const {
+  return this->state_ == State::DONE;
+}
+
+size_t HttpMultipartParser::GetNumParts() const {
+  return this->numParts_;
+}
+
+string HttpMultipartParser::GetBoundary(const string& contentTypeFieldValue) {
+  return getParameter(contentTypeFieldValue, "boundary");
+}
+
+string HttpMultipartParser::getParameter(const string& fieldValue,
+                                         const string& paramName) {
+  // fieldValue ex) form-data; name="file"; filename="a.txt"
+  size_t position = fieldValue.find(';');
+  while (position != string::npos) {
+    position += 1;
+    while (fieldValue.length() > position &&
+           (fieldValue[position] == ' ' || fieldValue[position] == '\t')) {
+      position += 1;
+    }
+
+    const size_t equalPosition = fieldValue.find('=', position);
+    if (equalPosition == string::npos) {
+      break;
+    }
+
+    string key = fieldValue.substr(position, equalPosition - position);
+    Util::String::Trim(key);
+
+    string value;
+    size_t valueEnd = equalPosition + 1;
+    if (fieldValue.length() > valueEnd && fieldValue[valueEnd] == '"') {
+      valueEnd = fieldValue.find('"', equalPosition + 2);
+      if (valueEnd == string::npos) {
+        break;
+      }
+      value = fieldValue.substr(equalPosition + 2, valueEnd - equalPosition - 2);
+      valueEnd += 1;
+    } else {
+      valueEnd = fieldValue.find(';', equalPosition + 1);
+      value = fieldValue.substr(equalPosition + 1,
+          valueEnd == string::npos ? string::npos : valueEnd - equalPosition - 1);
+      Util::String::Trim(value);
+    }
+
+    if (Util::String::CaseInsensitiveCompare(key, paramName) == true) {
+      return value;
+    }
+
+    position = fieldValue.find(';', valueEnd);
+  }
+  return "";
+}
+
+//HttpMultipartParser::
+
+}
+
+#if _UNIT_TEST
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include <sys/stat.h> // stat()
+
+using namespace lio;
+using std::string;
+using std::vector;
+
+struct ParsedPart {
+  HttpMultipartParser::Part part;
+  string data;
+  bool isEnded;
+};
+
+static vector<ParsedPart> parseInPieces(const string& boundary,
+                                        const string& body,
+                                        size_t pieceSize) {
+  vector<ParsedPart> parts;
+  HttpMultipartParser parser(boundary);
+  parser.SetPartBeginHandler([&parts](const HttpMultipartParser::Part& part) {
+      ParsedPart parsed;
+      parsed.part = part;
+      parsed.isEnded = false;
+      parts.push_back(parsed);
+  });
+  parser.SetPartDataHandler([&parts](const char* data, size_t length) {
+      parts.back().data.append(data, length);
+  });
+  parser.SetPartEndHandler([&parts]() {
+      parts.back().isEnded = true;
+  });
+
+  for (size_t i = 0; body.length() > i; i += pieceSize) {
+    parser.Feed(body.c_str() + i, std::min(pieceSize, body.length() - i));
+  }
+  EXPECT_EQ(parser.IsDone(), true);
+  return parts;
+}
+
+static const string BOUNDARY = "----WebKitFormBoundary7MA4YWxkTrZu0gW";
+static const string BODY =
+  "preamble\r\n"
+  "------WebKitFormBoundary7MA4YWxkTrZu0gW\r\n"
+  "Content-Disposition: form-data; name=\"title\"\r\n"
+  "\r\n"
+  "Hello\r\n--World\r\n"
+  "------WebKitFormBoundary7MA4YWxkTrZu0gW\r\n"
+  "Content-Disposition: form-data; name=\"upload\"; filename=\"a.txt\"\r\n"
+  "Content-Type: text/plain\r\n"
+  "\r\n"
+  "\r\n------WebKitFormBoundary7MA4YWxkTrZu0g almost\r\n"
+  "------WebKitFormBoundary7MA4YWxkTrZu0gW--\r\n"
+  "epilogue";
+
+TEST(HttpMultipartParser, AnySplit) {
+  for (size_t pieceSize = 1; BODY.length() >= pieceSize; ++pieceSize) {
+    vector<ParsedPart> parts = parseInPieces(BOUNDARY, BODY, pieceSize);
+    ASSERT_EQ(parts.size(), 2);
+
+    EXPECT_EQ(parts[0].part.name, "title");
+    EXPECT_EQ(parts[0].part.IsFile(), false);
+    EXPECT_EQ(parts[0].data, "Hello\r\n--World");
+    EXPECT_EQ(parts[0].isEnded, true);
+
+    EXPECT_EQ(parts[1].part.name, "upload");
+    EXPECT_EQ(parts[1].part.fileName, "a.txt");
+    EXPECT_EQ(parts[1].part.contentType, "text/plain");
+    EXPECT_EQ(parts[1].data, "\r\n------WebKitFormBoundary7MA4YWxkTrZu0g almost");
+    EXPECT_EQ(parts[1].isEnded, true);
+  }
+}
+
+TEST(HttpMultipartParser, GetBoundary) {
+  EXPECT_EQ(HttpMultipartParser::GetBoundary(
+        "multipart/form-data; boundary=----WebKitFormBoundary7MA4YWxkTrZu0gW"),
+      BOUNDARY);
+  EXPECT_EQ(HttpMultipartParser::GetBoundary(
+        "multipart/form-data; charset=utf-8; Boundary=\"a b\""), "a b");
+  EXPECT_EQ(HttpMultipartParser::GetBoundary("multipart/form-data"), "");
+}
+
+TEST(HttpMultipartParser, FileSink) {
+  const string path = "/tmp/.HttpMultipartParserTest";
+  HttpMultipartParser::FileSink sink;
+  HttpMultipartParser parser(BOUNDARY);
+  parser.SetPartBeginHandler([&sink, &path](const HttpMultipartParser::Part& part) {
+      if (part.IsFile()) {
+        sink.Open(path);
+      }
+  });
+  parser.SetPartDataHandler([&sink](const char* data, size_t length) {
+      sink.Write(data, length);
+  });
+  parser.SetPartEndHandler([&sink]() {
+      sink.Close();
+  });
+  parser.Feed(BODY.c_str(), BODY.length());
+
+  EXPECT_EQ(sink.GetWrittenSize(),
+            string("\r\n------WebKitFormBoundary7MA4YWxkTrZu0g almost").length());
+
+  // Name collides with the file written above. It is kept as it is.
+  HttpMultipartParser::FileSink again;
+  EXPECT_EQ(again.Open(path), false);
+  struct stat status;
+  ASSERT_EQ(stat(path.c_str(), &status), 0);
+  EXPECT_EQ((size_t) status.st_size, sink.GetWrittenSize());
+  unlink(path.c_str());
+}
+
+TEST(HttpMultipartParser, Throughput) {
+  PERFTEST {
+    const size_t BODY_SIZE = 1024UL * 1024 * 1024;
+    const size_t CHUNK_SIZE = 1024 * 64;
+
+    string chunk(CHUNK_SIZE, '\0');
+    for (size_t i = 0; CHUNK_SIZE > i; ++i) {
+      chunk[i] = (char) Util::Test::RandomNumber(255);
+    }
+    const string head = "--" + BOUNDARY + "\r\n"
+      "Content-Disposition: form-data; name=\"upload\"; filename=\"big.bin\"\r\n\r\n";
+    const string foot = "\r\n--" + BOUNDARY + "--\r\n";
+
+    size_t received = 0;
+    HttpMultipartParser parser(BOUNDARY);
+    parser.SetPartDataHandler([&received](const char* data, size_t length) {
+        received += length;
+    });
+
+    auto start = std::chrono::steady_clock::now();
+    parser.Feed(head.c_str(), head.length());
+    for (size_t fed = 0; BODY_SIZE > fed; fed += CHUNK_SIZE) {
+      parser.Feed(chunk.c_str(), CHUNK_SIZE);
+    }
+    parser.Feed(foot.c_str(), foot.length());
+    auto end = std::chrono::steady_clock::now();
+
+    EXPECT_EQ(received, BODY_SIZE);
+    double seconds = std::chrono::duration<double>(end - start).count();
+    std::cout << "1GB multipart upload parsed in " << seconds << " s. "
+              << (BODY_SIZE / 1024.0 / 1024.0) / seconds << " MB/s" << endl;
+  }
+}
+
+int main (int argc, char** argv) {
+  ::testing::InitGoogleMock(&argc, argv);
+  return RUN_ALL_TESTS();
+}
+
+#else
+// Executable File's Main Comes here.
+
+
+#endif
+
+#undef _UNIT_TEST
@@ -0,0 +1,226 @@
+#ifndef _HTTPMULTIPARTPARSER_HPP_
+#define _HTTPMULTIPARTPARSER_HPP_
+/*
+  Name
+    HttpMultipartParser
+      Streaming parser for multipart/form-data bodies.
+
+  Description
+    Body is fed in chunks as it is read from the socket. Nothing but the
+    part headers and a tail shorter than the delimiter is ever buffered.
+    Part data is handed out as slices pointing into the fed chunk.
+
+    Delimiter ("\r\n--" + boundary) is searched with Boyer-Moore-Horspool.
+    Bytes at the end of a chunk that may be the beginning of a delimiter
+    are kept in tail_ and checked again with the next chunk.
+
+    Handlers
+      PartBeginHandler  Called after headers of a part are parsed.
+      PartDataHandler   Called zero or more times with data slices.
+      PartEndHandler    Called when the delimiter after a part is found.
+
+    FileSink can be used in the handlers to write file parts straight to disk.
+
+  Last Modified Date
+    Oct 19, 2026
+
+  History
+    October 19, 2026
+      Created
+
+  ToDos
+
+
+  Milestones
+    1.0
+
+
+  Alias
+    Delimiter = CRLF + "--" + boundary
+    Part = Delimiter + CRLF + Header* + CRLF + Data
+    Body = Preamble + Part* + Delimiter + "--" + Epilogue
+
+  Learning Resources
+    multipart/form-data
+      http://tools.ietf.org/html/rfc2388
+      http://tools.ietf.org/html/rfc2046#section-5.1.1
+    Boyer-Moore-Horspool
+      http://en.wikipedia.org/wiki/Boyer%E2%80%93Moore%E2%80%93Horspool_algorithm
+
+  Copyright (c) All rights reserved to LIFEINO.
+*/
+
+#ifdef _DEBUG
+  #undef _DEBUG
+#endif
+#define _DEBUG false
+
+#include "liolib/Debug.hpp"
+
+#include <string>
+#include <map>
+#include <functional> // function
+
+#include <cstdint>
+
+#include <fcntl.h> // open()
+#include <unistd.h> // write() close()
+
+#include "liolib/Util.hpp"
+
+namespace lio {
+
+using std::string;
+using std::map;
+
+
+class HttpMultipartParser {
+public:
+
+// ******** Exception Declaration *********
+enum class ExceptionType : std::uint8_t {
+  GENERAL,
+  BAD_BOUNDARY,
+  BAD_FORMAT,
+  HEADER_TOO_LARGE,
+  TOO_MANY_PARTS
+};
+#define HTTPMULTIPARTPARSER_EXCEPTION_MESSAGES \
+  "HttpMultipartParser Exception has been thrown.", \
+  "Boundary is empty or too long.", \
+  "Multipart body is malformed.", \
+  "Part header is too large.", \
+  "Too many parts in the body."
+
+class Exception : public std::exception {
+public:
+  Exception (ExceptionType exceptionType = ExceptionType::GENERAL);
+
+  virtual const char*         what() const noexcept;
+  virtual const               ExceptionType type() const noexcept;
+
+private:
+  const ExceptionType         exceptionType_;
+  static const char* const    exceptionMessages_[];
+};
+// ******** Exception Declaration END*********
+
+  struct Config {
+    Config() :
+      maxHeaderSize(1024 * 8),
+      maxNumParts(1024)
+    { }
+    size_t maxHeaderSize;
+    size_t maxNumParts;
+  };
+
+  struct Part {
+    Part() :
+      index(0)
+    { }
+    bool IsFile() const {
+      return this->fileName.empty() == false;
+    }
+
+    size_t index;
+    string name; // Content-Disposition: form-data; name="..."
+    string fileName; // Content-Disposition: form-data; filename="..."
+    string contentType;
+    map<string, string> headers;
+  };
+
+  // Writes part data to a file as it arrives.
+  class FileSink {
+  public:
+    FileSink();
+    ~FileSink();
+
+    // False if filePath exists. It is never truncated.
+    bool Open(const string& filePath);
+    bool Write(const char* data, size_t length);
+    bool Close();
+
+    bool IsOpen() const;
+    size_t GetWrittenSize() const;
+
+  private:
+    int fd_;
+    size_t writtenSize_;
+  };
+
+  typedef std::function<void(const Part& part)> PartBeginHandler;
+  typedef std::function<void(const char* data, size_t length)> PartDataHandler;
+  typedef std::function<void()> PartEndHandler;
+
+  HttpMultipartParser(const string& boundary, Config config = Config());
+  ~HttpMultipartParser();
+
+  void            SetPartBeginHandler(PartBeginHandler handler);
+  void            SetPartDataHandler(PartDataHandler handler);
+  void            SetPartEndHandler(PartEndHandler handler);
+
+  /* Name
+   *  Feed
+   * Description
+   *  Parses next chunk of body. Chunks can be split anywhere.
+   * Output
+   *  Returns
+   *    size_t - number of bytes consumed. Always length unless
+   *             the closing delimiter has been found.
+   *  Throws
+   *    Exception when the body is malformed.
+   */
+  size_t          Feed(const char* data, size_t length);
+
+  bool            IsDone() const;
+  size_t          GetNumParts() const;
+
+  // Value of boundary= parameter in Content-Type field. Empty if not found.
+  static
+  string          GetBoundary(const string& contentTypeFieldValue);
+
+protected:
+
+private:
+  enum class State : uint8_t {
+    PREAMBLE,
+    AFTER_DELIMITER,
+    AFTER_DELIMITER_LF,
+    CLOSE_DASH,
+    HEADERS,
+    DATA,
+    DONE
+  };
+
+  Config          config_;
+  State           state_;
+
+  string          delimiter_;
+  size_t          skipTable_[256];
+
+  string          tail_;
+  string          headerBuffer_;
+  Part            currentPart_;
+  size_t          numParts_;
+
+  PartBeginHandler  partBeginHandler_;
+  PartDataHandler   partDataHandler_;
+  PartEndHandler    partEndHandler_;
+
+  // Boyer-Moore-Horspool. Returns length when not found.
+  size_t          findDelimiter(const char* data, size_t length) const;
+
+  // Preamble is run through the same path with handlers muted.
+  size_t          feedData(const char* data, size_t length);
+  void            onDelimiterFound();
+  void            parseHeaders();
+
+  static
+  string          getParameter(const string& fieldValue, const string& paramName);
+
+};
+
+}
+
+#endif
+
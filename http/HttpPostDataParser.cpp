@@ -69,18 +69,11 @@ bool HttpPostDataParser::SetData(const string& fieldValue) {
   this->contentType = type;
 
   if (this->contentType == http::ContentType::FORMDATA_MULTIPART) {
-    DEBUG_cerr << "Form multipart is not supported yet." << endl; 
-    return false;
-
-    pos = fieldValue.find("boundary=");
-    if (pos != string::npos) {
-
-    } else {
-      DEBUG_cerr << "WARN: Boundary value might be required. but it's not provided." << endl; 
+    this->boundary = this->getBoundary(fieldValue);
+    if (this->boundary.empty() == true) {
+      DEBUG_cerr << "Boundary is required for multipart data but not provided." << endl; 
+      return false;
     }
-
-  } else if (this->contentType == http::ContentType::FORMDATA) {
-
   }
   DEBUG_cout << "SetData returned true." << endl; 
 
@@ -105,17 +98,18 @@ bool HttpPostDataParser::ParsePostData() {
     
   } else if (this->contentType == http::ContentType::FORMDATA_MULTIPART) {
     // FORMDATA MULTIPART
-    static_assert(true, "Not yet implemented.");
-    return false;
+    return this->parseMultipart();
   } 
   
   return true;
 }
 
 string HttpPostDataParser::getBoundary(const string& fieldValue) {
-  static_assert(true, "Not yet implemented.");
-  return "";
+  return HttpMultipartParser::GetBoundary(fieldValue);
+}
 
+void HttpPostDataParser::SetUploadDirectory(const string& dirPath) {
+  this->uploadDirectory = dirPath;
 }
 
 map<string, string>& HttpPostDataParser::GetPostData() {
@@ -183,6 +177,92 @@ void HttpPostDataParser::parse() {
   DEBUG_cout << count << " fields have been parsed!" << endl; 
 }
 
+bool HttpPostDataParser::parseMultipart() {
+  const size_t MAX_FIELD_LENGTH = 1024 * 256;
+
+  HttpMultipartParser parser(this->boundary);
+  HttpMultipartParser::FileSink fileSink;
+  string* currentValue = nullptr;
+  std::vector<std::pair<string, string>> uploads; // Part name and file path.
+  bool isFailed = false;
+
+  parser.SetPartBeginHandler([this, &fileSink, &currentValue, &uploads, &isFailed]
+                             (const HttpMultipartParser::Part& part) {
+    currentValue = nullptr;
+    if (part.name.empty() == true || isFailed == true) {
+      return;
+    }
+
+    if (part.IsFile() == true) {
+      if (this->uploadDirectory.empty() == true) {
+        DEBUG_cerr << "Upload directory is not set. File is dropped. name: " << part.name << endl; 
+        return;
+      } 
+      string filePath = this->uploadDirectory + "/" + Util::String::RandomString(16);
+      if (fileSink.Open(filePath) == false) {
+        isFailed = true;
+        return;
+      } 
+      uploads.push_back(std::make_pair(part.name, filePath));
+      this->postData[part.name] = filePath;
+      return;
+    } 
+
+    currentValue = &this->postData[part.name];
+    currentValue->clear();
+  });
+
+  parser.SetPartDataHandler([&fileSink, &currentValue, &isFailed]
+                            (const char* data, size_t length) {
+    if (isFailed == true) {
+      return;
+    }
+    if (fileSink.IsOpen() == true) {
+      if (fileSink.Write(data, length) == false) {
+        // Disk full and such. A partial upload is not kept.
+        isFailed = true;
+      }
+    } else if (currentValue != nullptr) {
+      if (currentValue->length() + length > MAX_FIELD_LENGTH) {
+        DEBUG_cerr << "Posted field is way... too big." << endl; 
+        isFailed = true;
+        return;
+      } 
+      currentValue->append(data, length);
+    } 
+  });
+
+  parser.SetPartEndHandler([&fileSink, &currentValue]() {
+    fileSink.Close();
+    currentValue = nullptr;
+  });
+
+  try {
+    parser.Feed((const char*) this->content.GetObject(), this->content.GetLength());
+  } catch (HttpMultipartParser::Exception& e) {
+    DEBUG_cerr << "Failed to parse multipart data. " << e.what() << endl; 
+    isFailed = true;
+  }
+
+  if (isFailed == false && parser.IsDone() == false) {
+    DEBUG_cerr << "Multipart data is incomplete." << endl; 
+    isFailed = true;
+  } 
+
+  if (isFailed == true) {
+    // Files written so far would be left behind with no one to remove them.
+    fileSink.Close();
+    for (const std::pair<string, string>& upload : uploads) {
+      unlink(upload.second.c_str());
+      this->postData.erase(upload.first);
+    }
+    return false;
+  }
+
+  DEBUG_cout << parser.GetNumParts() << " parts have been parsed!" << endl; 
+  return true;
+}
+
 
 //HttpPostDataParser::
 
@@ -197,7 +277,16 @@ void HttpPostDataParser::parse() {
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 
+#include <string>
+
+#include <csignal> // signal()
+
+#include <dirent.h> // opendir()
+#include <sys/resource.h> // setrlimit()
+#include <sys/stat.h>
+
 using namespace lio;
+using std::string;
 
 class MockHttpPostDataParser : public HttpPostDataParser {
 public:
@@ -211,6 +300,92 @@ TEST(HttpPostDataParser, TESTNAME) {
   MockHttpPostDataParser mockHttpPostDataParser;
 }
 
+TEST(HttpPostDataParser, Multipart) {
+  std::string body =
+    "--xyz\r\n"
+    "Content-Disposition: form-data; name=\"title\"\r\n\r\n"
+    "Hello World\r\n"
+    "--xyz\r\n"
+    "Content-Disposition: form-data; name=\"upload\"; filename=\"a.txt\"\r\n\r\n"
+    "file content\r\n"
+    "--xyz--\r\n";
+
+  HttpPostDataParser parser;
+  ASSERT_EQ(parser.SetData("multipart/form-data; boundary=xyz"), true);
+  parser.SetContent(DataBlock<>((void*) body.c_str(), 0, body.length()));
+  parser.SetUploadDirectory("/tmp");
+  ASSERT_EQ(parser.ParsePostData(), true);
+
+  map<string, string>& postData = parser.GetPostData();
+  EXPECT_EQ(postData["title"], "Hello World");
+  ASSERT_EQ(postData.count("upload"), 1);
+  struct stat fileStat;
+  ASSERT_EQ(stat(postData["upload"].c_str(), &fileStat), 0);
+  EXPECT_EQ(fileStat.st_size, 12);
+  unlink(postData["upload"].c_str());
+}
+
+// Number of files in dirPath.
+size_t countFiles(const string& dirPath) {
+  size_t numFiles = 0;
+  DIR* dir = opendir(dirPath.c_str());
+  while (struct dirent* entry = readdir(dir)) {
+    if (entry->d_name[0] != '.') {
+      ++numFiles;
+    }
+  }
+  closedir(dir);
+  return numFiles;
+}
+
+TEST(HttpPostDataParser, MultipartFailures) {
+  const string uploadDirectory = "./postdata_test";
+  mkdir(uploadDirectory.c_str(), 0755);
+  const string filePart =
+    "--xyz\r\n"
+    "Content-Disposition: form-data; name=\"upload\"; filename=\"a.txt\"\r\n\r\n"
+    "file content\r\n";
+
+  // Truncated after a file part.
+  std::string truncated = filePart + "--xyz\r\nContent-Disposition: form-data; name=\"title\"\r\n\r\nHel";
+  HttpPostDataParser truncatedParser;
+  truncatedParser.SetData("multipart/form-data; boundary=xyz");
+  truncatedParser.SetContent(DataBlock<>((void*) truncated.c_str(), 0, truncated.length()));
+  truncatedParser.SetUploadDirectory(uploadDirectory);
+  EXPECT_EQ(truncatedParser.ParsePostData(), false);
+  EXPECT_EQ(truncatedParser.GetPostData().count("upload"), 0);
+  EXPECT_EQ(countFiles(uploadDirectory), 0);
+
+  // Field over MAX_FIELD_LENGTH.
+  std::string oversized = filePart + "--xyz\r\nContent-Disposition: form-data; name=\"title\"\r\n\r\n" +
+                          string(1024 * 256 + 1, 'a') + "\r\n--xyz--\r\n";
+  HttpPostDataParser oversizedParser;
+  oversizedParser.SetData("multipart/form-data; boundary=xyz");
+  oversizedParser.SetContent(DataBlock<>((void*) oversized.c_str(), 0, oversized.length()));
+  oversizedParser.SetUploadDirectory(uploadDirectory);
+  EXPECT_EQ(oversizedParser.ParsePostData(), false);
+  EXPECT_EQ(countFiles(uploadDirectory), 0);
+
+  // Write fails, as on a full disk.
+  std::string complete = filePart + "--xyz--\r\n";
+  HttpPostDataParser failingParser;
+  failingParser.SetData("multipart/form-data; boundary=xyz");
+  failingParser.SetContent(DataBlock<>((void*) complete.c_str(), 0, complete.length()));
+  failingParser.SetUploadDirectory(uploadDirectory);
+  struct rlimit original;
+  getrlimit(RLIMIT_FSIZE, &original);
+  struct rlimit limited = { 4, original.rlim_max };
+  signal(SIGXFSZ, SIG_IGN);
+  setrlimit(RLIMIT_FSIZE, &limited);
+  const bool isParsed = failingParser.ParsePostData();
+  setrlimit(RLIMIT_FSIZE, &original);
+  signal(SIGXFSZ, SIG_DFL);
+  EXPECT_EQ(isParsed, false);
+  EXPECT_EQ(countFiles(uploadDirectory), 0);
+
+  rmdir(uploadDirectory.c_str());
+}
+
 int main (int argc, char** argv) {
   ::testing::InitGoogleMock(&argc, argv);
   return RUN_ALL_TESTS();
@@ -40,6 +40,7 @@
 #include <vector>
 
 #include "liolib/http/Http.hpp"
+#include "liolib/http/HttpMultipartParser.hpp"
 #include "liolib/DataBlock.hpp"
 #include "liolib/Util.hpp"
 
@@ -79,6 +80,10 @@ private:
   bool SetData(const string& fieldValue);
   bool SetContent(DataBlock<> content);
 
+  // File parts of multipart data are saved here and postData[name] is set
+  // to the saved path. File parts are dropped when it is not set.
+  void SetUploadDirectory(const string& dirPath);
+
   bool ParsePostData();
 
   map<string, string>& GetPostData();
@@ -88,9 +93,11 @@ private:
   DataBlock<> content;
   http::ContentType contentType;
   string boundary; // To be used for MULTIPART data.
+  string uploadDirectory;
   map<string, string> postData;
 
   void parse();
+  bool parseMultipart();
 
   inline
   string getBoundary(const string& fieldValue);
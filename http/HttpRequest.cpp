@@ -3,6 +3,8 @@
 #define _UNIT_TEST false
 #include "liolib/Test.hpp"
 
+#include "liolib/Precompressor.hpp" // GetMask()
+
 
 namespace lio {
 
@@ -35,10 +37,13 @@ HttpRequest::HttpRequest() :
   method(http::RequestMethod::UNDEF),
   uri(),
   contentLength(0),
+  hasContentLength(false),
   contentType(http::ContentType::UNDEF),
   language(Language::ENGLISH),
   isKeepAliveSupported(false),
   isGzipSupported(false),
+  isChunked(false),
+  acceptEncodingQualities{0, 0, 0, 1000}, // Only identity without the header.
   content(),
   postDataParser(nullptr)
 {
@@ -52,9 +57,12 @@ HttpRequest::HttpRequest(DataBlock<char*> buffer) :
   method(http::RequestMethod::UNDEF),
   uri(),
   contentLength(0),
+  hasContentLength(false),
   contentType(http::ContentType::UNDEF),
   isKeepAliveSupported(false),
   isGzipSupported(false),
+  isChunked(false),
+  acceptEncodingQualities{0, 0, 0, 1000}, // Only identity without the header.
   content(),
   postDataParser(nullptr)
 {
@@ -190,6 +198,55 @@ bool HttpRequest::IsGzipSupported() const {
   return this->isGzipSupported;
 }
 
+uint16_t HttpRequest::GetAcceptEncodingQuality(http::ContentEncoding encoding) const {
+  return this->acceptEncodingQualities[static_cast<int>(encoding)];
+}
+
+http::ContentEncoding HttpRequest::SelectEncoding(uint8_t availableMask) const {
+  http::ContentEncoding selected = http::ContentEncoding::IDENTITY;
+  uint16_t selectedQuality = 0;
+  for (size_t i = 0; http::NUM_CONTENT_ENCODINGS > i; ++i) {
+    const http::ContentEncoding encoding = static_cast<http::ContentEncoding>(i);
+    if (encoding != http::ContentEncoding::IDENTITY &&
+        (availableMask & Precompressor::GetMask(encoding)) == 0) {
+      continue;
+    }
+    if (this->acceptEncodingQualities[i] > selectedQuality) {
+      selected = encoding;
+      selectedQuality = this->acceptEncodingQualities[i];
+    }
+  }
+  return selected;
+}
+
+const string& HttpRequest::GetIfMatch() const {
+  return this->ifMatch;
+}
+
+const string& HttpRequest::GetIfNoneMatch() const {
+  return this->ifNoneMatch;
+}
+
+const string& HttpRequest::GetIfModifiedSince() const {
+  return this->ifModifiedSince;
+}
+
+const string& HttpRequest::GetIfUnmodifiedSince() const {
+  return this->ifUnmodifiedSince;
+}
+
+const string& HttpRequest::GetIfRange() const {
+  return this->ifRange;
+}
+
+const string& HttpRequest::GetRange() const {
+  return this->range;
+}
+
+bool HttpRequest::IsChunked() const {
+  return this->isChunked;
+}
+
 
 bool HttpRequest::SetBuffer (DataBlock<char*>& buffer) {
   if (buffer.IsNull()) {
@@ -279,6 +336,11 @@ bool HttpRequest::SetField (const string& fieldName, const string& fieldValue) {
     result = this->SetUserAgent(fieldValue);
 
   } else if (fieldName == "Content-Length") {
+    if (this->isChunked == true) {
+      // Framed two ways, see IsChunked().
+      return false;
+    }
+    this->hasContentLength = true;
     result = this->SetContentLength(Util::String::To<size_t>(fieldValue));
 
   } else if (fieldName == "Connection") {
@@ -290,11 +352,16 @@ bool HttpRequest::SetField (const string& fieldName, const string& fieldValue) {
     result = true;
 
   } else if (fieldName == "Accept-Encoding") {
-    if (fieldValue.find("gzip") != string::npos) {
-      this->SetIsGzipSupported(true);
-    }
+    this->parseAcceptEncoding(fieldValue);
     result = true;
 
+  } else if (fieldName == "Transfer-Encoding") {
+    if (this->hasContentLength == true || this->isChunked == true) {
+      // Another field would append codings after chunked.
+      return false;
+    }
+    result = this->parseTransferEncoding(fieldValue);
+
   } else if (fieldName == "Accept-Language") {
     string fieldValueLower = Util::String::ToLower(fieldValue);
     if (fieldValueLower.find("ko-kr") != string::npos) {
@@ -314,6 +381,30 @@ bool HttpRequest::SetField (const string& fieldName, const string& fieldValue) {
   } else if (fieldName == "Cookie") {
     result = this->SetCookies(fieldValue);
 
+  } else if (fieldName == "If-None-Match") {
+    this->ifNoneMatch = fieldValue;
+    result = true;
+
+  } else if (fieldName == "If-Modified-Since") {
+    this->ifModifiedSince = fieldValue;
+    result = true;
+
+  } else if (fieldName == "If-Match") {
+    this->ifMatch = fieldValue;
+    result = true;
+
+  } else if (fieldName == "If-Unmodified-Since") {
+    this->ifUnmodifiedSince = fieldValue;
+    result = true;
+
+  } else if (fieldName == "If-Range") {
+    this->ifRange = fieldValue;
+    result = true;
+
+  } else if (fieldName == "Range") {
+    this->range = fieldValue;
+    result = true;
+
     
   } 
 
@@ -436,6 +527,11 @@ bool HttpRequest::SetIsGzipSupported(const bool isSupported) {
   return true;
 }
 
+bool HttpRequest::SetIsChunked(const bool isChunked) {
+  this->isChunked = isChunked;
+  return true;
+}
+
 bool HttpRequest::SetContent(const DataBlock<void*>& content) {
   // What kind of check should be done here??
   this->content = content;
@@ -449,6 +545,101 @@ bool HttpRequest::SetContentType(const http::ContentType contentType) {
 
 // ==============================
 
+// "gzip, deflate, br;q=0.9, *;q=0.1" RFC 7231 5.3.4
+bool HttpRequest::parseTransferEncoding(const string& fieldValue) {
+  // RFC 7230 3.3.3. Length of the body is only known when chunked is the
+  // last coding, and chunked is applied only once.
+  bool isChunkedLast = false;
+  size_t pos = 0;
+  while (fieldValue.length() > pos) {
+    size_t end = fieldValue.find(',', pos);
+    if (end == string::npos) {
+      end = fieldValue.length();
+    }
+    string coding = Util::String::ToLower(fieldValue.substr(pos, end - pos));
+    pos = end + 1;
+    Util::String::Trim(coding);
+    if (coding.empty() == true) {
+      continue;
+    }
+    if (isChunkedLast == true) {
+      return false;
+    }
+    isChunkedLast = (coding == "chunked");
+  }
+  if (isChunkedLast == false) {
+    return false;
+  }
+  this->SetIsChunked(true);
+  return true;
+}
+
+void HttpRequest::parseAcceptEncoding(const string& fieldValue) {
+  const size_t IDENTITY = static_cast<size_t>(http::ContentEncoding::IDENTITY);
+  uint16_t qualities[http::NUM_CONTENT_ENCODINGS] = { 0, 0, 0, 0 };
+  uint8_t listedMask = 0;
+  bool hasWildcard = false;
+  uint16_t wildcardQuality = 0;
+
+  size_t pos = 0;
+  while (fieldValue.length() > pos) {
+    size_t end = fieldValue.find(',', pos);
+    if (end == string::npos) {
+      end = fieldValue.length();
+    }
+    const string item = Util::String::ToLower(fieldValue.substr(pos, end - pos));
+    pos = end + 1;
+
+    const size_t semicolonPos = item.find(';');
+    string coding = item.substr(0, semicolonPos);
+    Util::String::Trim(coding);
+    uint16_t quality = 1000;
+    if (semicolonPos != string::npos) {
+      const size_t qPos = item.find("q=", semicolonPos);
+      if (qPos != string::npos) {
+        double value = std::strtod(item.c_str() + qPos + 2, nullptr);
+        value = (value < 0) ? 0 : ((value > 1) ? 1 : value);
+        quality = static_cast<uint16_t>(value * 1000 + 0.5);
+      }
+    }
+
+    if (coding == "*") {
+      hasWildcard = true;
+      wildcardQuality = quality;
+      continue;
+    }
+
+    size_t index = 0;
+    if (coding == "gzip" || coding == "x-gzip") {
+      index = static_cast<size_t>(http::ContentEncoding::GZIP);
+    } else if (coding == "br") {
+      index = static_cast<size_t>(http::ContentEncoding::BROTLI);
+    } else if (coding == "zstd") {
+      index = static_cast<size_t>(http::ContentEncoding::ZSTD);
+    } else if (coding == "identity") {
+      index = IDENTITY;
+    } else {
+      continue; // deflate, compress and others are not served.
+    }
+    qualities[index] = quality;
+    listedMask |= 1 << index;
+  }
+
+  for (size_t i = 0; http::NUM_CONTENT_ENCODINGS > i; ++i) {
+    if ((listedMask & (1 << i)) != 0) {
+      this->acceptEncodingQualities[i] = qualities[i];
+    } else if (hasWildcard == true) {
+      this->acceptEncodingQualities[i] = wildcardQuality;
+    } else {
+      // Identity is acceptable unless excluded explicitly.
+      this->acceptEncodingQualities[i] = (i == IDENTITY) ? 1000 : 0;
+    }
+  }
+
+  this->SetIsGzipSupported(
+      this->acceptEncodingQualities[static_cast<size_t>(http::ContentEncoding::GZIP)] > 0);
+}
+
 bool HttpRequest::parseRequestMethod() {
   static_assert(true, "I'm not sure to implement this or not yet. Don't use it yet.");
 
@@ -485,6 +676,77 @@ TEST(HttpRequest, TESTNAME) {
   MockHttpRequest mockHttpRequest;
 }
 
+TEST(HttpRequest, SelectEncoding) {
+  typedef Precompressor::Encoding Encoding;
+  const uint8_t all = Precompressor::GetMask(Encoding::GZIP) |
+                      Precompressor::GetMask(Encoding::BROTLI) |
+                      Precompressor::GetMask(Encoding::ZSTD);
+  const uint8_t gzipOnly = Precompressor::GetMask(Encoding::GZIP);
+  const string field = "Accept-Encoding";
+
+  HttpRequest noHeader;
+  EXPECT_EQ(noHeader.SelectEncoding(all), Encoding::IDENTITY);
+
+  HttpRequest browser;
+  browser.SetField(field, "gzip, deflate, br, zstd");
+  EXPECT_EQ(browser.IsGzipSupported(), true);
+  EXPECT_EQ(browser.SelectEncoding(all), Encoding::BROTLI);
+  EXPECT_EQ(browser.SelectEncoding(gzipOnly), Encoding::GZIP);
+  EXPECT_EQ(browser.SelectEncoding(0), Encoding::IDENTITY);
+
+  HttpRequest weighted;
+  weighted.SetField(field, "br;q=0.5, GZIP;q=0.8, identity;q=0.1");
+  EXPECT_EQ(weighted.GetAcceptEncodingQuality(Encoding::GZIP), 800);
+  EXPECT_EQ(weighted.SelectEncoding(all), Encoding::GZIP);
+
+  HttpRequest refused;
+  refused.SetField(field, "gzip;q=0, *;q=0.3");
+  EXPECT_EQ(refused.IsGzipSupported(), false);
+  EXPECT_EQ(refused.GetAcceptEncodingQuality(Encoding::IDENTITY), 300);
+  EXPECT_EQ(refused.SelectEncoding(gzipOnly), Encoding::IDENTITY);
+  EXPECT_EQ(refused.SelectEncoding(all), Encoding::BROTLI);
+}
+
+TEST(HttpRequest, ContentLengthWithChunked) {
+  const string lengthField = "Content-Length";
+  const string encodingField = "Transfer-Encoding";
+  const string length = "5";
+  const string chunked = "chunked";
+
+  HttpRequest lengthFirst;
+  EXPECT_EQ(lengthFirst.SetField(lengthField, length), true);
+  EXPECT_EQ(lengthFirst.SetField(encodingField, chunked), false);
+  EXPECT_EQ(lengthFirst.IsChunked(), false);
+
+  HttpRequest chunkedFirst;
+  EXPECT_EQ(chunkedFirst.SetField(encodingField, chunked), true);
+  EXPECT_EQ(chunkedFirst.SetField(lengthField, length), false);
+  EXPECT_EQ(chunkedFirst.GetContentLength(), 0);
+}
+
+TEST(HttpRequest, TransferEncoding) {
+  const string field = "Transfer-Encoding";
+  const string accepted[] = { "chunked", "gzip, chunked", " Gzip ,CHUNKED ", ", chunked" };
+  for (const string& value : accepted) {
+    HttpRequest request;
+    EXPECT_EQ(request.SetField(field, value), true) << value;
+    EXPECT_EQ(request.IsChunked(), true) << value;
+  }
+
+  const string refused[] = { "gzip", "chunked, gzip", "chunked, chunked", "xchunked",
+                             "chunkedx", "" };
+  for (const string& value : refused) {
+    HttpRequest request;
+    EXPECT_EQ(request.SetField(field, value), false) << value;
+    EXPECT_EQ(request.IsChunked(), false) << value;
+  }
+
+  // A second field lists codings after chunked.
+  HttpRequest twoFields;
+  EXPECT_EQ(twoFields.SetField(field, string("chunked")), true);
+  EXPECT_EQ(twoFields.SetField(field, string("gzip")), false);
+}
+
 int main (int argc, char** argv) {
   ::testing::InitGoogleMock(&argc, argv);
   return RUN_ALL_TESTS();
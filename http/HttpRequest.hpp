@@ -8,11 +8,15 @@
     [ETL] Eun T. Leem (eunleem@gmail.com)
 
   Last Modified Date
-    Aug 26, 2014
+    Oct 19, 2026
   
   History
     April 01, 2014
       Created
+    October 19, 2026
+      Keeps conditional and Range fields for HttpConditional.
+      Refuses Content-Length together with Transfer-Encoding.
+      Requires chunked to be the last transfer coding.
 
   ToDos
     
@@ -128,6 +132,25 @@ enum class Language {
 
   bool IsKeepAliveSupported() const;
   bool IsGzipSupported() const;
+  // Accept-Encoding quality value times 1000. 0 means not acceptable.
+  uint16_t GetAcceptEncodingQuality(http::ContentEncoding encoding) const;
+  // Best encoding by quality among availableMask (Precompressor::GetMask()).
+  // Ties go to the earlier ContentEncoding. IDENTITY when nothing else is acceptable.
+  http::ContentEncoding SelectEncoding(uint8_t availableMask) const;
+  // Raw values of conditional fields. Empty when not sent.
+  // Evaluated by HttpConditional.
+  const string&         GetIfMatch() const;
+  const string&         GetIfNoneMatch() const;
+  const string&         GetIfModifiedSince() const;
+  const string&         GetIfUnmodifiedSince() const;
+  const string&         GetIfRange() const;
+  const string&         GetRange() const;
+
+  // Transfer-Encoding: chunked. Body has to be read with HttpChunkedDecoder.
+  // SetField() returns false for Content-Length together with
+  // Transfer-Encoding, and for codings where chunked is not the last one.
+  // Answer 400, RFC 7230 3.3.3.
+  bool IsChunked() const;
 
   bool SetBuffer(DataBlock<char*>& buffer);
 
@@ -147,6 +170,7 @@ enum class Language {
   bool SetAcceptLanguae(const Language acceptLanguage);
   bool SetIsKeepAliveSupported(const bool isKeepAliveSupported);
   bool SetIsGzipSupported(const bool isGzipSupported);
+  bool SetIsChunked(const bool isChunked);
   bool SetContent(const DataBlock<void*>& content);
   bool SetContentType(const http::ContentType contentType);
 
@@ -165,11 +189,21 @@ private:
   string referer;
   map<string, string> cookies;
   size_t contentLength;
+  bool hasContentLength;
   http::ContentType contentType;
   Language language;
   
   bool isKeepAliveSupported;
   bool isGzipSupported;
+  bool isChunked;
+  uint16_t acceptEncodingQualities[http::NUM_CONTENT_ENCODINGS];
+
+  string ifMatch;
+  string ifNoneMatch;
+  string ifModifiedSince;
+  string ifUnmodifiedSince;
+  string ifRange;
+  string range;
 
 
   DataBlock<void*> content;
@@ -180,6 +214,9 @@ private:
   bool parseUri();
 
   int  parsePostData(const string& fieldValue);
+  // False unless chunked is the last coding.
+  bool parseTransferEncoding(const string& fieldValue);
+  void parseAcceptEncoding(const string& fieldValue);
 
 
 
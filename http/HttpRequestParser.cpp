@@ -36,11 +36,13 @@ const size_t HttpRequestParser::FIELD_LENGTH_MAX = 1024;
 
 HttpRequestParser::HttpRequestParser(const string* requestRawStr) :
   requestStrMap_(const_cast<string*>(requestRawStr)),
+  isChunked_(false),
   bodyLength_(0)
 {
   DEBUG_FUNC_START;
 
   // #TODO: It does too much work in constructor. Change Design.
+  Trace::Span span("http.parse");
   this->parseEssentialFields(requestRawStr);
 }
 
@@ -73,9 +75,25 @@ bool HttpRequestParser::parseEssentialFields(const string* requestStr) {
     size_t contentLengthFieldPosition = this->findHeaderField(requestStr,
                                                               "Content-Length",
                                                               headerEndPosition);
+    size_t transferEncodingFieldPosition =
+      this->findHeaderField(requestStr, "Transfer-Encoding", headerEndPosition);
+    if (contentLengthFieldPosition != consts::STRING_NOT_FOUND &&
+        transferEncodingFieldPosition != consts::STRING_NOT_FOUND) {
+      // Framed two ways. A proxy in front may have picked the other one, so
+      // the rest of the body would be read as the next request.
+      // RFC 7230 3.3.3
+      DEBUG_cerr << "Both Content-Length and Transfer-Encoding are present. " << endl;
+      throw Exception(ExceptionType::BAD_REQUEST);
+    }
     if (contentLengthFieldPosition == consts::STRING_NOT_FOUND) {
-      DEBUG_cerr << "Cannot find the end of Content-Length field. " << endl;
-      throw Exception(ExceptionType::CONTENT_LENGTH_REQUIRED); 
+      if (transferEncodingFieldPosition == consts::STRING_NOT_FOUND ||
+          Util::String::ToLower(this->requestStrMap_.GetValueByKey("Transfer-Encoding"))
+            .find("chunked") == consts::STRING_NOT_FOUND) {
+        DEBUG_cerr << "Cannot find the end of Content-Length field. " << endl;
+        throw Exception(ExceptionType::CONTENT_LENGTH_REQUIRED); 
+      }
+      // Body is fed to HttpChunkedDecoder from contentBodyStartPosition_.
+      this->isChunked_ = true;
     }
     
 
@@ -88,7 +106,9 @@ bool HttpRequestParser::parseEssentialFields(const string* requestStr) {
       throw Exception(ExceptionType::BAD_REQUEST);
     }
     
-    this->findContentBody (requestStr, headerEndPosition);
+    if (this->isChunked_ == false) {
+      this->findContentBody (requestStr, headerEndPosition);
+    }
   }
 
   return true;
@@ -363,6 +383,14 @@ DataBlock<string*> HttpRequestParser::GetBodyContent() const {
   return DataBlock<string*>();
 }
 
+bool HttpRequestParser::IsChunked() const {
+  return this->isChunked_;
+}
+
+size_t HttpRequestParser::GetBodyStartPosition() const {
+  return this->contentBodyStartPosition_;
+}
+
 string HttpRequestParser::GetContentType() const {
   try {
     return this->requestStrMap_.GetValueByKey("Content-Type");
@@ -538,6 +566,15 @@ int main() {
 
   string userAgent = reqParser.GetUserAgent();
   UnitTest::Test<string>(userAgent, "Firefox 24 Linux(x86) Blah!", "UserAgent Test");
+
+  string smuggledReqStr = "POST /upload HTTP/1.1\r\nHost: www.lifeino.com\r\nContent-Type: text/plain\r\nContent-Length: 5\r\nTransfer-Encoding: chunked\r\n\r\n0\r\n\r\n";
+  bool isRejected = false;
+  try {
+    HttpRequestParser smuggledParser (&smuggledReqStr);
+  } catch (HttpRequestParser::Exception& e) {
+    isRejected = (e.type() == HttpRequestParser::ExceptionType::BAD_REQUEST);
+  }
+  UnitTest::Test<bool>(isRejected, true, "Content-Length with Transfer-Encoding TEST");
   UnitTest::PerformanceTestEnd("All Tests");
 
   UnitTest::ReportTestResult();
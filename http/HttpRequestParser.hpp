@@ -10,9 +10,12 @@
   Description
 
   Last Modified Date
-    May 12, 2014
+    Oct 19, 2026
   
   History
+    October 19, 2026
+      Trace span of parsing.
+      Rejects Content-Length together with Transfer-Encoding.
 
   ToDos
     Handle multiple requests in one Request string.
@@ -42,6 +45,7 @@
 #include "liolib/Consts.hpp" // STRING_NOT_FOUND
 
 #include "liolib/Util.hpp" //Util::String::ToUpper
+#include "liolib/Trace.hpp"
 
 #include "liolib/http/Http.hpp" // Http RequestMethods
 
@@ -118,6 +122,11 @@ private:
   bool IsGzipSupported();
   bool IsKeepAliveSupported();
 
+  // Transfer-Encoding: chunked. GetBodyContent() is empty in this case.
+  // Feed the bytes from GetBodyStartPosition() to HttpChunkedDecoder.
+  bool IsChunked() const;
+  size_t GetBodyStartPosition() const;
+
   //void        Parse();
 
 
@@ -132,6 +141,8 @@ private:
   // Location for Memory Address and Pointer. Position for numeric value of a relative position.
   size_t contentBodyStartPosition_ = string::npos;
 
+  bool isChunked_;
+
 
   bool parseEssentialFields(const string* requestStr);
 
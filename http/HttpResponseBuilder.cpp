@@ -3,6 +3,8 @@
 #define _UNIT_TEST false
 #include "liolib/Test.hpp"
 
+#include "liolib/Precompressor.hpp" // GetName()
+
 namespace lio {
 
 // ===== Exception Implementation =====
@@ -26,8 +28,35 @@ HttpResponseBuilder::Exception::type() const noexcept {
 }
 // ===== Exception Implementation End =====
 
+thread_local HttpResponseBuilder::SegmentPool HttpResponseBuilder::segmentPool_;
+
+HttpResponseBuilder::SegmentPool::~SegmentPool() {
+  for (char* segment : this->segments_) {
+    delete[] segment;
+  }
+}
+
+char* HttpResponseBuilder::SegmentPool::Acquire() {
+  if (this->segments_.empty() == true) {
+    return new char[SEGMENT_SIZE];
+  }
+  char* segment = this->segments_.back();
+  this->segments_.pop_back();
+  return segment;
+}
+
+void HttpResponseBuilder::SegmentPool::Release(char* segment) {
+  if (this->segments_.size() >= MAX_POOLED_SEGMENTS) {
+    delete[] segment;
+    return;
+  }
+  this->segments_.push_back(segment);
+}
+
 HttpResponseBuilder::HttpResponseBuilder (const ResponseCode responseCode) :
-  tempTextBody(nullptr)
+  tempTextBody(nullptr),
+  isGzipped_(false),
+  isChunked_(false)
 {
   DEBUG_FUNC_START;
 
@@ -38,6 +67,7 @@ HttpResponseBuilder::HttpResponseBuilder (const ResponseCode responseCode) :
 
 HttpResponseBuilder::~HttpResponseBuilder() {
   DEBUG_FUNC_START;
+  this->clearBody();
   if (this->tempTextBody != nullptr) {
     delete tempTextBody;
   } 
@@ -65,36 +95,68 @@ DataBlock<> HttpResponseBuilder::GetBody() const {
   return this->responseContent_;
 }
 
+size_t HttpResponseBuilder::GetBodyIovecs(std::vector<struct iovec>& iovecs) const {
+  size_t length = 0;
+  if (this->bodyChain_.empty() == false) {
+    for (const struct iovec& iov : this->bodyChain_) {
+      iovecs.push_back(iov);
+      length += iov.iov_len;
+    }
+    return length;
+  }
+
+  if (this->responseContent_.IsNull() == false && this->responseContent_.length > 0) {
+    struct iovec iov = {
+      (char*) this->responseContent_.object + this->responseContent_.index,
+      this->responseContent_.length
+    };
+    iovecs.push_back(iov);
+    length = iov.iov_len;
+  }
+  return length;
+}
+
+size_t HttpResponseBuilder::GetIovecs(std::vector<struct iovec>& iovecs) {
+  Trace::Span span("http.build");
+  DataBlock<string*> header = this->GetHeader();
+  if (header.IsNull() == true) {
+    return 0;
+  }
+  struct iovec iov = { &this->responseHeader_[0], this->responseHeader_.length() };
+  iovecs.push_back(iov);
+  return iov.iov_len + this->GetBodyIovecs(iovecs);
+}
+
+bool HttpResponseBuilder::SetResponseCode(const ResponseCode responseCode) {
+  const http::ByteTemplate& statusLine =
+    http::StatusLineTemplate[static_cast<int>(responseCode)];
+  size_t endPos = this->responseHeader_.find("\r\n");
+  if (endPos == string::npos) {
+    return this->setResponseCode(responseCode);
+  }
+  this->responseHeader_.replace(0, endPos + 2, statusLine.data, statusLine.length);
+  return true;
+}
+
 bool HttpResponseBuilder::AddHeaderField(const string& field, const string& fieldValue) {
   DEBUG_cerr << "DEPRECATED FUNCTION. Use SetHeaderField instead." << endl; 
   return this->SetHeaderField(field, fieldValue);
 }
 
 bool HttpResponseBuilder::SetHeaderField (const string& field, const string& fieldValue) {
-
-  size_t startPos = this->responseHeader_.find(field + ": ");
-  if (startPos != string::npos) {
-    // Already Existing.
-    DEBUG_cout << "HeaderField already exists. It will be replaced." << endl; 
-    size_t endPos = this->responseHeader_.find_first_of("\r\n", startPos, 1024);
-    if (endPos != string::npos) {
-      this->responseHeader_.erase(startPos, endPos);
-    } 
-  } 
-
-  this->responseHeader_.append(field + ": " + fieldValue + "\r\n");
-  return true;
+  return this->setHeaderField(field.c_str(), field.length(),
+                              fieldValue.c_str(), fieldValue.length());
 }
 
 bool HttpResponseBuilder::AddToHeaderField(const string& field, const string& additionalContent) {
-  size_t startPos = this->responseHeader_.find(field + ": ");
+  size_t startPos = this->findHeaderField(field.c_str(), field.length());
   string existingValue;
   if (startPos != string::npos) {
     DEBUG_cout << "HeaderField already exists. It will be replaced." << endl; 
-    size_t endPos = this->responseHeader_.find_first_of("\r\n", startPos, 1024);
+    size_t valuePos = startPos + field.length() + 2;
+    size_t endPos = this->responseHeader_.find("\r\n", valuePos);
     if (endPos != string::npos) {
-      existingValue = this->responseHeader_.substr(startPos + field.length() + 2, endPos);
-      this->responseHeader_.erase(startPos, endPos);
+      existingValue = this->responseHeader_.substr(valuePos, endPos - valuePos);
     } 
   } else {
     // Header field not found
@@ -105,12 +167,39 @@ bool HttpResponseBuilder::AddToHeaderField(const string& field, const string& ad
   return this->SetHeaderField (field, existingValue + "," + additionalContent);
 }
 
+bool HttpResponseBuilder::AddDateField() {
+  if (this->findHeaderField("Date", 4) != string::npos) {
+    return this->setHeaderField("Date", 4, HttpDateCache::GetValue(),
+                                HttpDateCache::VALUE_LENGTH);
+  } 
+  this->responseHeader_.append(HttpDateCache::GetField(), HttpDateCache::FIELD_LENGTH);
+  return true;
+}
+
 bool HttpResponseBuilder::SetBody(const DataBlock<>& bodyDataBlock, bool isGzipped) {
-  this->SetHeaderField("Content-Length", std::to_string(bodyDataBlock.length));
+  this->clearBody();
+  this->setContentLength(bodyDataBlock.length);
   this->isGzipped_ = isGzipped;
   if (isGzipped) {
-    this->SetHeaderField("Content-Encoding", "gzip");
+    this->setHeaderField("Content-Encoding", 16, "gzip", 4);
+  }
+
+  this->responseContent_ = bodyDataBlock;
+
+  return true;
+}
+
+bool HttpResponseBuilder::SetBody(const DataBlock<>& bodyDataBlock,
+                                  http::ContentEncoding encoding) {
+  this->clearBody();
+  this->setContentLength(bodyDataBlock.length);
+  this->isGzipped_ = (encoding == http::ContentEncoding::GZIP);
+  if (encoding != http::ContentEncoding::IDENTITY) {
+    const string& name = Precompressor::GetName(encoding);
+    this->setHeaderField("Content-Encoding", 16, name.c_str(), name.length());
   }
+  // Caches must not hand one variant to a client that asked for another.
+  this->setHeaderField("Vary", 4, "Accept-Encoding", 15);
 
   this->responseContent_ = bodyDataBlock;
 
@@ -118,10 +207,11 @@ bool HttpResponseBuilder::SetBody(const DataBlock<>& bodyDataBlock, bool isGzipp
 }
 
 bool HttpResponseBuilder::SetBody(const string& text, bool isGzipped) {
-  this->SetHeaderField("Content-Length", std::to_string(text.length()));
+  this->clearBody();
+  this->setContentLength(text.length());
   this->isGzipped_ = isGzipped;
   if (isGzipped) {
-    this->SetHeaderField("Content-Encoding", "gzip");
+    this->setHeaderField("Content-Encoding", 16, "gzip", 4);
   }
 
   DataBlock<> bodyDataBlock((void*)text.c_str(), 0, text.length());
@@ -131,10 +221,11 @@ bool HttpResponseBuilder::SetBody(const string& text, bool isGzipped) {
 }
 
 bool HttpResponseBuilder::SetBody(string* text, bool isGzipped) {
-  this->SetHeaderField("Content-Length", std::to_string(text->length()));
+  this->clearBody();
+  this->setContentLength(text->length());
   this->isGzipped_ = isGzipped;
   if (isGzipped) {
-    this->SetHeaderField("Content-Encoding", "gzip");
+    this->setHeaderField("Content-Encoding", 16, "gzip", 4);
   }
 
   if (this->tempTextBody != nullptr) {
@@ -150,6 +241,7 @@ bool HttpResponseBuilder::SetBody(string* text, bool isGzipped) {
 }
 
 bool HttpResponseBuilder::SetBody(const rapidjson::Document& jsondoc) {
+  this->clearBody();
   rapidjson::StringBuffer buffer;
   rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
 
@@ -162,7 +254,7 @@ bool HttpResponseBuilder::SetBody(const rapidjson::Document& jsondoc) {
 
   this->tempTextBody = new string(buffer.GetString());
 
-  this->SetHeaderField("Content-Length", std::to_string(tempTextBody->length()));
+  this->setContentLength(tempTextBody->length());
 
   DataBlock<> bodyDataBlock((void*)tempTextBody->c_str(), 0, tempTextBody->length());
   this->responseContent_ = bodyDataBlock;
@@ -170,6 +262,86 @@ bool HttpResponseBuilder::SetBody(const rapidjson::Document& jsondoc) {
   return true;
 }
 
+bool HttpResponseBuilder::SetBody(const struct iovec* iov, size_t iovCount) {
+  this->clearBody();
+  size_t length = 0;
+  for (size_t i = 0; iovCount > i; ++i) {
+    if (iov[i].iov_len == 0) {
+      continue;
+    }
+    if (this->bodyChain_.size() + 1 >= (size_t) IOV_MAX) { // One is for the header.
+      DEBUG_cerr << "Too many body buffers for one writev(). iovCount: " << iovCount << endl;
+      this->clearBody();
+      return false;
+    }
+    this->bodyChain_.push_back(iov[i]);
+    length += iov[i].iov_len;
+  }
+  this->responseContent_ = DataBlock<>();
+  return this->setContentLength(length);
+}
+
+bool HttpResponseBuilder::GzipBody(const void* data, size_t length, int level) {
+  Trace::Span span("http.gzip");
+  this->clearBody();
+  this->responseContent_ = DataBlock<>();
+
+  // Deflate fills each segment to the end before the next one is taken.
+  GzipStream gzip(GzipStream::Mode::COMPRESS, level);
+  const char* input = static_cast<const char*>(data);
+  size_t numRemaining = length;
+  size_t bodyLength = 0;
+  size_t segmentSize = SEGMENT_SIZE;
+  try {
+    while (gzip.IsFinished() == false) {
+      struct iovec out;
+      if (MAX_POOLED_CHAIN > this->segments_.size()) {
+        out.iov_base = segmentPool_.Acquire();
+      } else {
+        segmentSize *= 2;
+        out.iov_base = new char[segmentSize];
+      }
+      out.iov_len = segmentSize;
+      this->segments_.push_back(out);
+      size_t numConsumed = 0;
+      out.iov_len = gzip.Write(input, numRemaining, &out, 1, numConsumed,
+                               GzipStream::Flush::FINISH);
+      input += numConsumed;
+      numRemaining -= numConsumed;
+      if (out.iov_len != 0) {
+        this->bodyChain_.push_back(out);
+        bodyLength += out.iov_len;
+      }
+    }
+  } catch (GzipStream::Exception& e) {
+    DEBUG_cerr << "Failed to compress body. " << e.what() << endl;
+    this->clearBody();
+    return false;
+  }
+
+  this->isGzipped_ = true;
+  this->setHeaderField("Content-Encoding", 16, "gzip", 4);
+  this->setHeaderField("Vary", 4, "Accept-Encoding", 15);
+  return this->setContentLength(bodyLength);
+}
+
+bool HttpResponseBuilder::SetChunked() {
+  if (this->isChunked_ == true) {
+    return true;
+  }
+  if (this->responseContent_.IsNull() == false || this->bodyChain_.empty() == false) {
+    DEBUG_cerr << "Body is already set. Cannot switch to chunked response." << endl;
+    return false;
+  }
+
+  this->isChunked_ = true;
+  return this->setHeaderField("Transfer-Encoding", 17, "chunked", 7);
+}
+
+bool HttpResponseBuilder::IsChunked() const {
+  return this->isChunked_;
+}
+
 #if 0
 bool HttpResponseBuilder::SetBody(string&& text, bool isGzipped) {
   this->AddHeaderField("Content-Length", std::to_string(text.length()));
@@ -192,56 +364,236 @@ bool HttpResponseBuilder::setResponseCode(const ResponseCode responseCode) {
     DEBUG_clog << "WARNING: ResponseHeader is not empty. It will be overwritten." << endl;
   }
 
-  this->responseHeader_ = "HTTP/1.1 ";
-  this->responseHeader_.append(http::ResponseCodeString[static_cast<int>(responseCode)]);
-  this->responseHeader_.append("\r\n");
+  const http::ByteTemplate& statusLine =
+    http::StatusLineTemplate[static_cast<int>(responseCode)];
+  this->responseHeader_.reserve(HEADER_RESERVE_SIZE);
+  this->responseHeader_.assign(statusLine.data, statusLine.length);
+
+  return true;
+}
+
+bool HttpResponseBuilder::setHeaderField(const char* field, size_t fieldLength,
+                                         const char* fieldValue, size_t valueLength) {
+  size_t startPos = this->findHeaderField(field, fieldLength);
+  if (startPos != string::npos) {
+    // Already Existing.
+    DEBUG_cout << "HeaderField already exists. It will be replaced." << endl; 
+    size_t endPos = this->responseHeader_.find("\r\n", startPos);
+    if (endPos != string::npos) {
+      this->responseHeader_.erase(startPos, endPos + 2 - startPos);
+    } 
+  } 
 
+  this->responseHeader_.append(field, fieldLength);
+  this->responseHeader_.append(": ", 2);
+  this->responseHeader_.append(fieldValue, valueLength);
+  this->responseHeader_.append("\r\n", 2);
   return true;
 }
 
+bool HttpResponseBuilder::setContentLength(size_t length) {
+  char digits[HttpHeaderWriter::MAX_NUMBER_LENGTH];
+  size_t numDigits = HttpHeaderWriter::FormatNumber(length, digits);
+  return this->setHeaderField("Content-Length", 14, digits, numDigits);
+}
+
+void HttpResponseBuilder::clearBody() {
+  this->bodyChain_.clear();
+  for (const struct iovec& segment : this->segments_) {
+    if (segment.iov_len == SEGMENT_SIZE) {
+      segmentPool_.Release((char*) segment.iov_base);
+    } else {
+      delete[] (char*) segment.iov_base;
+    }
+  }
+  this->segments_.clear();
+}
+
+size_t HttpResponseBuilder::findHeaderField(const char* field, size_t fieldLength) const {
+  size_t pos = this->responseHeader_.find(field, 0, fieldLength);
+  while (pos != string::npos) {
+    if (pos >= 2 && this->responseHeader_[pos - 1] == '\n' &&
+        this->responseHeader_.compare(pos + fieldLength, 2, ": ") == 0) {
+      return pos;
+    } 
+    pos = this->responseHeader_.find(field, pos + fieldLength, fieldLength);
+  }
+  return string::npos;
+}
+
 }
 
 #if _UNIT_TEST
 
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
 
-#include <iostream>
-#include <functional>
+#include <chrono>
+#include <string>
 
 using namespace lio;
+using std::string;
 
-int main() {
-  HttpResponseBuilder* response =
-    new HttpResponseBuilder(HttpResponseBuilder::ResponseCode::OK);
+static string joinIovecs(const std::vector<struct iovec>& iovecs) {
+  string joined;
+  for (const struct iovec& iov : iovecs) {
+    joined.append((const char*) iov.iov_base, iov.iov_len);
+  }
+  return joined;
+}
 
-  string field = "Host";
-  string fieldValue = "test.com";
-  response->SetHeaderField(field, fieldValue);
+TEST(HttpResponseBuilder, Body) {
+  HttpResponseBuilder response;
+  response.SetHeaderField("Host", "test.com");
+  const string body = "<html><body>CONTENT</body></html>";
+  response.SetBody(body);
 
-  DEBUG_cout << "A1" << endl;
+  EXPECT_EQ(response.GetHeader().GetValue(),
+            "HTTP/1.1 200 OK\r\nHost: test.com\r\nContent-Length: 33\r\n\r\n");
+  EXPECT_EQ(response.GetBody().object, body.data());
 
-  string body = "<html><body>CONTENT</body></html>";
-  DEBUG_cout << "body Address: " << std::hex << &body << endl;
+  std::vector<struct iovec> iovecs;
+  EXPECT_EQ(response.GetIovecs(iovecs), response.GetHeader().GetLength() + body.length());
+  ASSERT_EQ(iovecs.size(), 2);
+  EXPECT_EQ(iovecs[1].iov_base, body.data());
+}
+
+TEST(HttpResponseBuilder, GzipBody) {
+  string text;
+  for (int i = 0; 20000 > i; ++i) {
+    text.append("<li>" + std::to_string(i * 7919 % 100003) + "</li>\n");
+  }
 
-  response->SetBody(DataBlock(static_cast<void*>(&body), 0, body.length()));
-  DEBUG_cout << "A2" << endl;
+  HttpResponseBuilder response;
+  ASSERT_EQ(response.GzipBody(text.data(), text.length()), true);
+  EXPECT_EQ(response.GetBody().IsNull(), true);
+
+  std::vector<struct iovec> body;
+  const size_t bodyLength = response.GetBodyIovecs(body);
+  EXPECT_GT(body.size(), 1); // Spans segments.
+  const string header = response.GetHeader().GetValue();
+  EXPECT_NE(header.find("Content-Length: " + std::to_string(bodyLength) + "\r\n"), string::npos);
+  EXPECT_NE(header.find("Content-Encoding: gzip\r\n"), string::npos);
+
+  string decompressed;
+  const string compressed = joinIovecs(body);
+  GzipStream::Decompress(compressed.data(), compressed.length(), decompressed);
+  EXPECT_EQ(decompressed, text);
+
+  // Replaced by a plain body. Segments go back to the pool.
+  response.SetBody(text);
+  body.clear();
+  EXPECT_EQ(response.GetBodyIovecs(body), text.length());
+  EXPECT_EQ(body.size(), 1);
+
+  ASSERT_EQ(response.GzipBody("", 0), true);
+  body.clear();
+  EXPECT_GT(response.GetBodyIovecs(body), 0); // Header and trailer.
+}
 
-  DataBlock headerBlock = response->GetHeader();
-  DataBlock bodyBlock = response->GetBody();
-  DEBUG bodyBlock._PrintInfo();
+TEST(HttpResponseBuilder, LargeGzipBody) {
+  // Barely compresses, so 16KB segments alone would need more than IOV_MAX.
+  string data(24 * 1024 * 1024, '\0');
+  uint32_t seed = 1;
+  for (char& c : data) {
+    seed = seed * 1103515245 + 12345;
+    c = (char) (seed >> 24);
+  }
 
-  string* header = static_cast<string*>(headerBlock.address);
-  string* bodyA = static_cast<string*>(bodyBlock.address);
-  DEBUG_cout << "body Address: " << std::hex << bodyBlock.address << endl;
+  HttpResponseBuilder response;
+  ASSERT_EQ(response.GzipBody(data.data(), data.length(), 1), true);
+  std::vector<struct iovec> iovecs;
+  const size_t length = response.GetIovecs(iovecs);
+  EXPECT_GT(length, data.length());
+  EXPECT_LE(iovecs.size(), (size_t) IOV_MAX);
+
+  string decompressed;
+  const string compressed = joinIovecs(iovecs).substr(response.GetHeader().GetLength());
+  GzipStream::Decompress(compressed.data(), compressed.length(), decompressed);
+  EXPECT_EQ(decompressed == data, true);
+
+  // Large chain is freed, and the next body starts from pooled segments again.
+  ASSERT_EQ(response.GzipBody(data.data(), 1000), true);
+  iovecs.clear();
+  EXPECT_EQ(response.GetBodyIovecs(iovecs) > 0, true);
+}
 
-  const bool MUST_FAIL = true;
-  UnitTest::Test<string>((*header),"HTTP/1.1 200 OK\r\nHost: test.com\r\n\r\n","Header", MUST_FAIL);
-  DEBUG_cout << "A3" << endl;
-  UnitTest::Test<string>((*header),"HTTP/1.1 200 OK\r\nHost: test.com\r\nContent-Length: 33\r\n\r\n","Header w body");
-  DEBUG_cout << "A4" << endl;
-  UnitTest::Test<string>((*bodyA),body,"Body");
-  DEBUG_cout << "A5" << endl;
-  UnitTest::ReportTestResult();
-  return 0;
+TEST(HttpResponseBuilder, IovecBody) {
+  const string a = "Hello, ";
+  const string b = "World";
+  struct iovec iov[] = {
+    { (void*) a.data(), a.length() },
+    { nullptr, 0 },
+    { (void*) b.data(), b.length() }
+  };
+
+  HttpResponseBuilder response;
+  response.SetBody(iov, 3);
+  EXPECT_EQ(response.SetChunked(), false);
+
+  std::vector<struct iovec> iovecs;
+  response.GetIovecs(iovecs);
+  EXPECT_EQ(joinIovecs(iovecs),
+            "HTTP/1.1 200 OK\r\nContent-Length: 12\r\n\r\nHello, World");
+
+  std::vector<struct iovec> many(IOV_MAX, iov[0]);
+  EXPECT_EQ(response.SetBody(many.data(), many.size()), false);
+  EXPECT_EQ(response.SetBody(many.data(), many.size() - 1), true);
+  iovecs.clear();
+  response.GetIovecs(iovecs);
+  EXPECT_EQ(iovecs.size(), (size_t) IOV_MAX);
 }
+
+TEST(HttpResponseBuilder, GzipBenchmark) {
+  PERFTEST {
+    const size_t NUM_RESPONSES = 2000;
+    string text;
+    for (int i = 0; 3000 > i; ++i) {
+      text.append("{\"id\":" + std::to_string(i) + ",\"name\":\"item" + std::to_string(i) + "\"},");
+    }
+    size_t checksum = 0;
+
+    auto report = [&](const char* name, std::chrono::steady_clock::time_point start) {
+      double seconds = std::chrono::duration<double>(
+          std::chrono::steady_clock::now() - start).count();
+      std::cout << name << ": " << (size_t) (NUM_RESPONSES / seconds)
+                << " responses/sec" << endl;
+    };
+
+    // Compressed into a string, then header and body copied into one buffer.
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; NUM_RESPONSES > i; ++i) {
+      HttpResponseBuilder response;
+      string compressed;
+      GzipStream::Compress(text.data(), text.length(), compressed);
+      response.SetBody(compressed, true);
+      string wire = response.GetHeader().GetValue();
+      wire.append(compressed);
+      checksum += wire.length();
+    }
+    report("Compress and copy", start);
+
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; NUM_RESPONSES > i; ++i) {
+      HttpResponseBuilder response;
+      response.GzipBody(text.data(), text.length());
+      std::vector<struct iovec> iovecs;
+      checksum += response.GetIovecs(iovecs);
+    }
+    report("GzipBody           ", start);
+    EXPECT_GT(checksum, 0);
+  }
+}
+
+int main (int argc, char** argv) {
+  ::testing::InitGoogleMock(&argc, argv);
+  return RUN_ALL_TESTS();
+}
+
+#else
+// Executable File's Main Comes here.
+
+
 #endif
+
 #undef _UNIT_TEST
@@ -8,13 +8,25 @@
     [ETL] Eun T. Leem (eunleem@gmail.com)
 
   Description
+    Header is a string reserved once. Body is either one DataBlock or a
+    chain of buffers. GzipBody() deflates straight into pooled segments
+    that become the chain, and Content-Length is set once the size is
+    known, so compressed bytes are never copied before they are sent.
+    GetIovecs() gives header and body for a single writev(). The chain
+    is kept under IOV_MAX: segments past MAX_POOLED_CHAIN double in size,
+    and SetBody() refuses more buffers than one writev() takes.
 
   Last Modified Date
-    Jul 28, 2014
+    Oct 19, 2026
   
   History
     October 16, 2013
       Created
+    October 19, 2026
+      SetResponseCode() for 206, 304 and such decided after fields are set.
+      Body chain. GzipBody() and SetBody() of iovecs.
+      Trace spans of GetIovecs() and GzipBody().
+      Body chain kept under IOV_MAX.
 
   ToDos
     1. AddHeaderField(HeaderField);
@@ -49,6 +61,10 @@
 #include "liolib/Debug.hpp"
 
 #include <string>
+#include <vector>
+
+#include <climits> // IOV_MAX
+#include <sys/uio.h> // iovec
 
 #include "include/rapidjson/document.h"
 #include "include/rapidjson/writer.h"
@@ -56,7 +72,11 @@
 
 
 #include "liolib/http/Http.hpp"
+#include "liolib/http/HttpDateCache.hpp"
+#include "liolib/http/HttpHeaderWriter.hpp"
 #include "liolib/DataBlock.hpp"
+#include "liolib/GzipStream.hpp"
+#include "liolib/Trace.hpp"
 
 
 namespace lio {
@@ -96,7 +116,15 @@ private:
   ~HttpResponseBuilder();
 
   DataBlock<string*>  GetHeader();
+  // Null for chained bodies. Use GetBodyIovecs().
   DataBlock<>         GetBody() const;
+  // Appends body buffers in order. Returns body length.
+  size_t              GetBodyIovecs(std::vector<struct iovec>& iovecs) const;
+  // Appends header and body buffers. Returns total length.
+  size_t              GetIovecs(std::vector<struct iovec>& iovecs);
+
+  // Replaces the status line. Header fields already set are kept.
+  bool          SetResponseCode (const ResponseCode responseCode);
 
 
   // #DEPRECATED
@@ -106,26 +134,76 @@ private:
   bool          SetHeaderField (const string& field, const string& fieldValue);
   bool          AddToHeaderField (const string& field, const string& additionalValue);
 
+  // Date is taken from HttpDateCache.
+  bool          AddDateField ();
   
 
   // Set Body will Always REPLACE existing body.
   bool          SetBody (const DataBlock<>& bodyDataBlock, bool isGzipped = false);
+  // Body picked by HttpRequest::SelectEncoding(). Adds Vary: Accept-Encoding.
+  bool          SetBody (const DataBlock<>& bodyDataBlock, http::ContentEncoding encoding);
   bool          SetBody (const string& text, bool isGzipped = false);
   bool          SetBody (string* text, bool isGzipped = false);
   //bool          SetBody (string&& text, bool isGzipped = false);
   bool          SetBody (const rapidjson::Document& jsondoc);
+  // Buffers are referenced, not copied. They have to outlive the response.
+  // False when header and buffers do not fit in one writev() (IOV_MAX).
+  bool          SetBody (const struct iovec* iov, size_t iovCount);
+  // Compresses data into pooled segments owned by the response. data can
+  // be released right after. Sets Content-Encoding: gzip.
+  bool          GzipBody (const void* data, size_t length,
+                          int level = Z_DEFAULT_COMPRESSION);
+
+  // Body will be sent later in chunks by HttpResponseStream.
+  // Content-Length is not set for chunked response.
+  bool          SetChunked ();
+  bool          IsChunked () const;
 
 protected:
   
 private:
+  // Header is reserved once so appending fields does not reallocate.
+  static const size_t HEADER_RESERVE_SIZE = 512;
+  // Compressed output segment. 1024 of them (IOV_MAX) would only be 16MB,
+  // so segments past MAX_POOLED_CHAIN double in size and are not pooled.
+  // 256 pooled ones are 4MB; 40 more doubling ones reach terabytes.
+  static const size_t SEGMENT_SIZE = 16 * 1024;
+  static const size_t MAX_POOLED_CHAIN = 256;
+  static const size_t MAX_POOLED_SEGMENTS = 64;
+
+  // Free segments of the thread.
+  class SegmentPool {
+  public:
+    ~SegmentPool();
+
+    char*           Acquire();
+    void            Release(char* segment);
+
+  private:
+    std::vector<char*> segments_;
+  };
+
+  static thread_local SegmentPool segmentPool_;
+
   string        responseHeader_;
   DataBlock<>   responseContent_;
 
   string* tempTextBody;
 
   bool          isGzipped_;
+  bool          isChunked_;
+  std::vector<struct iovec> bodyChain_; // Used instead of responseContent_ when not empty.
+  std::vector<struct iovec> segments_; // Of GzipBody(). iov_len is the capacity.
 
   bool          setResponseCode (const ResponseCode responseCode);
+  bool          setHeaderField (const char* field, size_t fieldLength,
+                                const char* fieldValue, size_t valueLength);
+  bool          setContentLength (size_t length);
+  // Drops the chain and gives segments back to the pool.
+  void          clearBody ();
+
+  // Position of "field: " at the beginning of a line. npos if not found.
+  size_t        findHeaderField (const char* field, size_t fieldLength) const;
 
 };
 
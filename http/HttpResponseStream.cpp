@@ -0,0 +1,386 @@
+
+#include "HttpResponseStream.hpp"
+
+#define _UNIT_TEST false
+#include "liolib/Test.hpp"
+
+
+namespace lio {
+
+// ===== Exception Implementation =====
+const char* const
+HttpResponseStream::Exception::exceptionMessages_[] = {
+  HTTPRESPONSESTREAM_EXCEPTION_MESSAGES
+};
+#undef HTTPRESPONSESTREAM_EXCEPTION_MESSAGES // undef helps reducing unnecessary preprocessing work.
+
+
+HttpResponseStream::Exception::Exception(ExceptionType exceptionType) :
+  exceptionType_(exceptionType) { }
+
+const char*
+HttpResponseStream::Exception::what() const noexcept {
+  return this->exceptionMessages_[(int) this->exceptionType_];
+}
+
+const HttpResponseStream::ExceptionType
+HttpResponseStream::Exception::type() const noexcept {
+  return this->exceptionType_;
+}
+// ===== Exception Implementation End =====
+
+
+HttpResponseStream::HttpResponseStream(int fd, HttpResponseBuilder& response,
+                                       Config config) :
+  fd_(fd),
+  config_(config),
+  isHeaderSent_(false),
+  isEnded_(false),
+  isClosed_(false),
+  isAboveHighWatermark_(false),
+  pendingOffset_(0),
+  bodySize_(0)
+{
+  DEBUG_FUNC_START; // Prints out function name in yellow
+
+  response.SetChunked();
+  DataBlock<string*> header = response.GetHeader();
+  if (header.IsNull() == true) {
+    DEBUG_cerr << "Response header is not ready." << endl;
+    throw Exception(ExceptionType::GENERAL);
+  }
+  this->header_ = header.GetValue();
+}
+
+HttpResponseStream::~HttpResponseStream() {
+  DEBUG_FUNC_START;
+  if (this->isEnded_ == false) {
+    DEBUG_cerr << "Response stream destroyed before End() is called." << endl;
+  }
+}
+
+bool HttpResponseStream::Write(const void* data, size_t length) {
+  if (this->isEnded_ == true) {
+    DEBUG_cerr << "Write is called after End()." << endl;
+    throw Exception(ExceptionType::ALREADY_ENDED);
+  }
+
+  if (length == 0) {
+    return this->IsWritable();
+  }
+
+  this->bodySize_ += length;
+  this->writeFrame((const char*) data, length, false);
+  return this->IsWritable();
+}
+
+bool HttpResponseStream::Write(const string& text) {
+  return this->Write(text.c_str(), text.length());
+}
+
+HttpResponseStream::Status HttpResponseStream::End() {
+  if (this->isEnded_ == true) {
+    throw Exception(ExceptionType::ALREADY_ENDED);
+  }
+  this->isEnded_ = true;
+  return this->writeFrame(nullptr, 0, true);
+}
+
+HttpResponseStream::Status HttpResponseStream::OnWritable() {
+  Trace::Span span("socket.write");
+  Status status = this->flushPending();
+
+  if (this->isAboveHighWatermark_ == true &&
+      this->GetPendingSize() <= this->config_.lowWatermark) {
+    this->isAboveHighWatermark_ = false;
+    if (this->drainHandler_ && this->isEnded_ == false) {
+      this->drainHandler_();
+    }
+  }
+
+  return status;
+}
+
+void HttpResponseStream::SetDrainHandler(std::function<void()> handler) {
+  this->drainHandler_ = handler;
+}
+
+bool HttpResponseStream::IsWritable() const {
+  return this->isAboveHighWatermark_ == false && this->isClosed_ == false;
+}
+
+bool HttpResponseStream::IsEnded() const {
+  return this->isEnded_;
+}
+
+bool HttpResponseStream::IsFinished() const {
+  return this->isEnded_ == true && this->GetPendingSize() == 0;
+}
+
+size_t HttpResponseStream::GetPendingSize() const {
+  return this->pending_.length() - this->pendingOffset_;
+}
+
+size_t HttpResponseStream::GetBodySize() const {
+  return this->bodySize_;
+}
+
+HttpResponseStream::Status HttpResponseStream::flushPending() {
+  if (this->isClosed_ == true) {
+    return Status::CLOSED;
+  }
+
+  while (this->GetPendingSize() > 0) {
+    ssize_t written = write(this->fd_,
+                            this->pending_.c_str() + this->pendingOffset_,
+                            this->GetPendingSize());
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+        return Status::WOULD_BLOCK;
+      }
+      DEBUG_cerr << "write has failed. errno: " << errno << endl;
+      this->isClosed_ = true;
+      return Status::CLOSED;
+    }
+    this->pendingOffset_ += written;
+  }
+
+  this->pending_.clear();
+  this->pendingOffset_ = 0;
+  return Status::OK;
+}
+
+HttpResponseStream::Status HttpResponseStream::writeFrame(const char* data,
+                                                          size_t length,
+                                                          bool isLast) {
+  static const char CRLF[] = "\r\n";
+  static const char LAST_CHUNK[] = "0\r\n\r\n";
+
+  if (this->isClosed_ == true) {
+    // Failed before. Write() returns false and End() CLOSED.
+    return Status::CLOSED;
+  }
+  Trace::Span span("socket.write");
+
+  char sizeLine[24];
+  size_t sizeLineLength = 0;
+
+  struct iovec iov[5];
+  int iovCount = 0;
+
+  if (this->isHeaderSent_ == false) {
+    iov[iovCount].iov_base = (void*) this->header_.c_str();
+    iov[iovCount].iov_len = this->header_.length();
+    iovCount += 1;
+    this->isHeaderSent_ = true;
+  }
+
+  if (length > 0) {
+    sizeLineLength = formatChunkSize(length, sizeLine);
+    iov[iovCount].iov_base = sizeLine;
+    iov[iovCount].iov_len = sizeLineLength;
+    iov[iovCount + 1].iov_base = (void*) data;
+    iov[iovCount + 1].iov_len = length;
+    iov[iovCount + 2].iov_base = (void*) CRLF;
+    iov[iovCount + 2].iov_len = sizeof(CRLF) - 1;
+    iovCount += 3;
+  }
+
+  if (isLast == true) {
+    iov[iovCount].iov_base = (void*) LAST_CHUNK;
+    iov[iovCount].iov_len = sizeof(LAST_CHUNK) - 1;
+    iovCount += 1;
+  }
+
+  size_t written = 0;
+  if (this->flushPending() == Status::OK) {
+    // Nothing is pending. Frame can go out without being copied.
+    while (true) {
+      ssize_t result = writev(this->fd_, iov, iovCount);
+      if (result < 0) {
+        if (errno == EINTR) {
+          continue;
+        } else if (errno != EAGAIN && errno != EWOULDBLOCK) {
+          DEBUG_cerr << "writev has failed. errno: " << errno << endl;
+          this->isClosed_ = true;
+          return Status::CLOSED;
+        }
+      } else {
+        written = result;
+      }
+      break;
+    }
+  }
+
+  // Keep what the socket did not take.
+  for (int i = 0; iovCount > i; ++i) {
+    if (written >= iov[i].iov_len) {
+      written -= iov[i].iov_len;
+      continue;
+    }
+    this->pending_.append((const char*) iov[i].iov_base + written,
+                          iov[i].iov_len - written);
+    written = 0;
+  }
+
+  if (this->GetPendingSize() > this->config_.highWatermark) {
+    this->isAboveHighWatermark_ = true;
+  }
+
+  if (this->GetPendingSize() > 0) {
+    return Status::WOULD_BLOCK;
+  }
+  return Status::OK;
+}
+
+size_t HttpResponseStream::formatChunkSize(size_t length, char* dest) {
+  static const char HEX[] = "0123456789abcdef";
+  char reversed[16];
+  size_t numDigits = 0;
+  do {
+    reversed[numDigits++] = HEX[length & 0xF];
+    length >>= 4;
+  } while (length > 0);
+
+  size_t i = 0;
+  while (numDigits > 0) {
+    dest[i++] = reversed[--numDigits];
+  }
+  dest[i++] = '\r';
+  dest[i++] = '\n';
+  return i;
+}
+
+//HttpResponseStream::
+
+}
+
+#if _UNIT_TEST
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include <string>
+
+#include <csignal> // signal()
+
+#include <fcntl.h>
+#include <sys/socket.h>
+
+#include "liolib/http/HttpChunkedDecoder.hpp"
+
+using namespace lio;
+using std::string;
+
+static string readAll(int fd) {
+  string result;
+  char buffer[1024 * 16];
+  while (true) {
+    ssize_t readCount = read(fd, buffer, sizeof(buffer));
+    if (readCount <= 0) {
+      break;
+    }
+    result.append(buffer, readCount);
+  }
+  return result;
+}
+
+TEST(HttpResponseStream, RoundTrip) {
+  int fds[2];
+  ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, fds), 0);
+
+  HttpResponseBuilder response;
+  HttpResponseStream stream(fds[0], response);
+  stream.Write(string("[{\"id\":1},"));
+  stream.Write(string("{\"id\":2}]"));
+  EXPECT_EQ(stream.End(), HttpResponseStream::Status::OK);
+  EXPECT_EQ(stream.IsFinished(), true);
+
+  string raw = readAll(fds[1]);
+  size_t headerEnd = raw.find("\r\n\r\n");
+  ASSERT_NE(headerEnd, string::npos);
+  EXPECT_NE(raw.find("Transfer-Encoding: chunked\r\n"), string::npos);
+  EXPECT_EQ(raw.find("Content-Length"), string::npos);
+
+  string body;
+  HttpChunkedDecoder decoder([&body](const char* data, size_t length) {
+      body.append(data, length);
+  });
+  string chunked = raw.substr(headerEnd + 4);
+  EXPECT_EQ(decoder.Feed(chunked.c_str(), chunked.length()), chunked.length());
+  EXPECT_EQ(decoder.IsDone(), true);
+  EXPECT_EQ(body, "[{\"id\":1},{\"id\":2}]");
+
+  close(fds[0]);
+  close(fds[1]);
+}
+
+TEST(HttpResponseStream, Backpressure) {
+  int fds[2];
+  ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, fds), 0);
+
+  HttpResponseBuilder response;
+  HttpResponseStream::Config config;
+  config.highWatermark = 1024 * 64;
+  config.lowWatermark = 1024 * 16;
+  HttpResponseStream stream(fds[0], response, config);
+
+  bool isDrained = false;
+  stream.SetDrainHandler([&isDrained]() { isDrained = true; });
+
+  string piece(1024 * 8, 'x');
+  size_t numWrites = 0;
+  while (stream.Write(piece) == true) {
+    numWrites += 1;
+    ASSERT_LT(numWrites, 100000);
+  }
+  EXPECT_EQ(stream.IsWritable(), false);
+
+  size_t received = 0;
+  while (isDrained == false) {
+    received += readAll(fds[1]).length();
+    stream.OnWritable();
+  }
+  EXPECT_EQ(stream.IsWritable(), true);
+
+  stream.End();
+  while (stream.IsFinished() == false) {
+    received += readAll(fds[1]).length();
+    stream.OnWritable();
+  }
+  received += readAll(fds[1]).length();
+  EXPECT_GT(received, stream.GetBodySize());
+
+  close(fds[0]);
+  close(fds[1]);
+}
+
+TEST(HttpResponseStream, PeerClosed) {
+  int fds[2];
+  ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, fds), 0);
+  signal(SIGPIPE, SIG_IGN);
+  close(fds[1]);
+
+  HttpResponseBuilder response;
+  HttpResponseStream stream(fds[0], response);
+  EXPECT_EQ(stream.Write(string("first")), false);
+  EXPECT_EQ(stream.Write(string("second")), false);
+  EXPECT_EQ(stream.End(), HttpResponseStream::Status::CLOSED);
+
+  close(fds[0]);
+}
+
+int main (int argc, char** argv) {
+  ::testing::InitGoogleMock(&argc, argv);
+  return RUN_ALL_TESTS();
+}
+
+#else
+// Executable File's Main Comes here.
+
+
+#endif
+
+#undef _UNIT_TEST
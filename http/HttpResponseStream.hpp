@@ -0,0 +1,167 @@
+#ifndef _HTTPRESPONSESTREAM_HPP_
+#define _HTTPRESPONSESTREAM_HPP_
+/*
+  Name
+    HttpResponseStream
+      Streams a response body with "Transfer-Encoding: chunked".
+
+  Description
+    Producers call Write() as data becomes available. Every Write() becomes
+    one chunk frame. Frames are sent with writev() right away when the socket
+    can take them, and are only copied into the pending buffer when the
+    socket would block.
+
+    Backpressure
+      Write() returns false once pending bytes go over highWatermark.
+      Producer should stop and wait for DrainHandler, which is called from
+      OnWritable() (EPOLLOUT) when pending bytes drop under lowWatermark.
+
+  Last Modified Date
+    Oct 19, 2026
+
+  History
+    October 19, 2026
+      Created
+      Trace spans of socket writes.
+
+  ToDos
+
+
+  Milestones
+    1.0
+
+
+  Learning Resources
+    Chunked Transfer Coding
+      http://www.w3.org/Protocols/rfc2616/rfc2616-sec3.html#sec3.6.1
+
+  Copyright (c) All rights reserved to LIFEINO.
+*/
+
+#ifdef _DEBUG
+  #undef _DEBUG
+#endif
+#define _DEBUG false
+
+#include "liolib/Debug.hpp"
+
+#include <string>
+#include <functional> // function
+
+#include <cerrno>
+
+#include <sys/uio.h> // writev()
+#include <unistd.h> // write()
+
+#include "liolib/http/HttpResponseBuilder.hpp"
+#include "liolib/Trace.hpp"
+
+namespace lio {
+
+using std::string;
+
+
+class HttpResponseStream {
+public:
+
+// ******** Exception Declaration *********
+enum class ExceptionType : std::uint8_t {
+  GENERAL,
+  WRITE_FAIL,
+  ALREADY_ENDED
+};
+#define HTTPRESPONSESTREAM_EXCEPTION_MESSAGES \
+  "HttpResponseStream Exception has been thrown.", \
+  "Failed to write to the socket.", \
+  "Response stream has already ended."
+
+class Exception : public std::exception {
+public:
+  Exception (ExceptionType exceptionType = ExceptionType::GENERAL);
+
+  virtual const char*         what() const noexcept;
+  virtual const               ExceptionType type() const noexcept;
+
+private:
+  const ExceptionType         exceptionType_;
+  static const char* const    exceptionMessages_[];
+};
+// ******** Exception Declaration END*********
+
+  struct Config {
+    Config() :
+      highWatermark(1024 * 256),
+      lowWatermark(1024 * 64)
+    { }
+    size_t highWatermark;
+    size_t lowWatermark;
+  };
+
+  enum class Status : uint8_t {
+    OK, // Everything has been sent.
+    WOULD_BLOCK, // Some bytes are pending. Wait for EPOLLOUT.
+    CLOSED
+  };
+
+  // fd must be non-blocking. Header is taken from response and
+  // Transfer-Encoding: chunked is set on it.
+  HttpResponseStream(int fd, HttpResponseBuilder& response, Config config = Config());
+  ~HttpResponseStream();
+
+  /* Name
+   *  Write
+   * Description
+   *  Sends length bytes as one chunk. Empty writes are ignored since
+   *  zero length chunk means end of body.
+   * Output
+   *  Returns
+   *    true  - Producer may keep writing.
+   *    false - Pending bytes are over highWatermark. Wait for DrainHandler.
+   */
+  bool            Write(const void* data, size_t length);
+  bool            Write(const string& text);
+
+  // Sends the last chunk. Remaining bytes are flushed by OnWritable().
+  Status          End();
+
+  // Call on EPOLLOUT.
+  Status          OnWritable();
+
+  void            SetDrainHandler(std::function<void()> handler);
+
+  bool            IsWritable() const;
+  bool            IsEnded() const;
+  bool            IsFinished() const;
+  size_t          GetPendingSize() const;
+  size_t          GetBodySize() const;
+
+protected:
+
+private:
+  int             fd_;
+  Config          config_;
+
+  string          header_;
+  bool            isHeaderSent_;
+  bool            isEnded_;
+  bool            isClosed_;
+  bool            isAboveHighWatermark_;
+
+  string          pending_;
+  size_t          pendingOffset_;
+  size_t          bodySize_;
+
+  std::function<void()> drainHandler_;
+
+  Status          flushPending();
+  Status          writeFrame(const char* data, size_t length, bool isLast);
+
+  static
+  size_t          formatChunkSize(size_t length, char* dest);
+
+};
+
+}
+
+#endif
+
@@ -0,0 +1,647 @@
+#include "HttpRouter.hpp"
+
+#define _UNIT_TEST false
+#include "liolib/Test.hpp"
+
+
+namespace lio {
+
+// ===== Exception Implementation =====
+const char* const
+HttpRouter::Exception::exceptionMessages_[] = {
+  HTTPROUTER_EXCEPTION_MESSAGES
+};
+#undef HTTPROUTER_EXCEPTION_MESSAGES // undef helps reducing unnecessary preprocessing work.
+
+
+HttpRouter::Exception::Exception(ExceptionType exceptionType) :
+  exceptionType_(exceptionType) { }
+
+const char*
+HttpRouter::Exception::what() const noexcept {
+  return this->exceptionMessages_[(int) this->exceptionType_];
+}
+
+const HttpRouter::ExceptionType
+HttpRouter::Exception::type() const noexcept {
+  return this->exceptionType_;
+}
+// ===== Exception Implementation End =====
+
+const size_t HttpRouter::Params::MAX_PARAMS;
+const size_t HttpRouter::NUM_METHODS;
+const uint32_t HttpRouter::NONE;
+
+const HttpRouter::Param* HttpRouter::Params::Find(const char* name) const {
+  const size_t nameLength = strlen(name);
+  for (size_t i = 0; this->size_ > i; ++i) {
+    const Param& param = this->params_[i];
+    if (param.nameLength == nameLength &&
+        memcmp(param.name, name, nameLength) == 0) {
+      return &param;
+    }
+  }
+  return nullptr;
+}
+
+string HttpRouter::Params::GetString(const char* name) const {
+  const Param* param = this->Find(name);
+  if (param == nullptr) {
+    return "";
+  }
+  return string(param->value, param->valueLength);
+}
+
+HttpRouter::HttpRouter() :
+  isCompiled_(false)
+{ }
+
+HttpRouter::~HttpRouter() { }
+
+void HttpRouter::Add(RequestMethod method, const string& pattern, Handler handler) {
+  DEBUG_FUNC_START;
+
+  if (pattern.empty() == true || pattern[0] != '/') {
+    DEBUG_cerr << "Pattern must start with '/'. pattern: " << pattern << endl;
+    throw Exception(ExceptionType::BAD_PATTERN);
+  }
+
+  auto isSpecial = [&pattern](size_t pos) {
+    return pattern[pos - 1] == '/' && (pattern[pos] == ':' || pattern[pos] == '*');
+  };
+
+  std::vector<string> paramNames;
+  BuildNode* node = &this->root_;
+  size_t pos = 0;
+  while (pattern.length() > pos) {
+    if (pos > 0 && isSpecial(pos) == true) {
+      const bool isWildcard = pattern[pos] == '*';
+      size_t nameEnd = pattern.find('/', pos);
+      if (nameEnd == string::npos) {
+        nameEnd = pattern.length();
+      }
+      if ((isWildcard == false && nameEnd == pos + 1) ||
+          (isWildcard == true && nameEnd != pattern.length())) {
+        DEBUG_cerr << "Invalid parameter in pattern: " << pattern << endl;
+        throw Exception(ExceptionType::BAD_PATTERN);
+      }
+      if (paramNames.size() >= Params::MAX_PARAMS) {
+        throw Exception(ExceptionType::TOO_MANY_PARAMS);
+      }
+      paramNames.push_back(pattern.substr(pos + 1, nameEnd - pos - 1));
+
+      std::unique_ptr<BuildNode>& child =
+        isWildcard ? node->wildcardChild : node->paramChild;
+      if (child == nullptr) {
+        child.reset(new BuildNode());
+      }
+      node = child.get();
+      pos = nameEnd;
+      continue;
+    }
+
+    size_t textEnd = pos + 1;
+    while (pattern.length() > textEnd && isSpecial(textEnd) == false) {
+      textEnd += 1;
+    }
+    this->insertStatic(node, pattern.data() + pos, textEnd - pos);
+    pos = textEnd;
+  }
+
+  if (node->routeIndex == NONE) {
+    node->routeIndex = this->routes_.size();
+    this->routes_.emplace_back();
+    this->routes_.back().pattern = pattern;
+    this->routes_.back().paramNames = paramNames;
+  }
+
+  RouteEntry& route = this->routes_[node->routeIndex];
+  if (route.paramNames != paramNames) {
+    DEBUG_cerr << pattern << " conflicts with " << route.pattern << endl;
+    throw Exception(ExceptionType::PARAM_NAME_CONFLICT);
+  }
+
+  Handler& slot = route.handlers[static_cast<size_t>(method)];
+  if (slot) {
+    DEBUG_cerr << "Route already exists. pattern: " << pattern << endl;
+    throw Exception(ExceptionType::DUPLICATE_ROUTE);
+  }
+  slot = std::move(handler);
+  this->isCompiled_ = false;
+}
+
+void HttpRouter::insertStatic(BuildNode*& node, const char* text, size_t length) {
+  while (length > 0) {
+    BuildNode* next = nullptr;
+    for (auto& child : node->children) {
+      if (child->label[0] == text[0]) {
+        next = child.get();
+        break;
+      }
+    }
+
+    if (next == nullptr) {
+      std::unique_ptr<BuildNode> child(new BuildNode());
+      child->label.assign(text, length);
+      node->children.push_back(std::move(child));
+      node = node->children.back().get();
+      return;
+    }
+
+    size_t numCommon = 1;
+    while (length > numCommon && next->label.length() > numCommon &&
+           next->label[numCommon] == text[numCommon]) {
+      numCommon += 1;
+    }
+
+    if (next->label.length() > numCommon) {
+      // Split next. The tail takes over everything below it.
+      std::unique_ptr<BuildNode> tail(new BuildNode());
+      tail->label = next->label.substr(numCommon);
+      tail->children = std::move(next->children);
+      tail->paramChild = std::move(next->paramChild);
+      tail->wildcardChild = std::move(next->wildcardChild);
+      tail->routeIndex = next->routeIndex;
+
+      next->label.resize(numCommon);
+      next->children.clear();
+      next->children.push_back(std::move(tail));
+      next->routeIndex = NONE;
+    }
+
+    node = next;
+    text += numCommon;
+    length -= numCommon;
+  }
+}
+
+void HttpRouter::Compile() {
+  DEBUG_FUNC_START;
+
+  this->nodes_.clear();
+  this->labels_.clear();
+  this->dispatch_.clear();
+
+  // Breadth first so that static children of a node get adjacent indexes.
+  std::vector<std::pair<const BuildNode*, uint32_t>> queue;
+  this->nodes_.emplace_back();
+  queue.emplace_back(&this->root_, 0);
+
+  for (size_t i = 0; queue.size() > i; ++i) {
+    const BuildNode* buildNode = queue[i].first;
+    Node node;
+    node.labelOffset = this->labels_.length();
+    node.labelLength = buildNode->label.length();
+    this->labels_.append(buildNode->label);
+    node.routeIndex = buildNode->routeIndex;
+
+    node.firstChild = this->nodes_.size();
+    node.dispatchOffset = this->dispatch_.size();
+    node.dispatchLength = 0;
+    node.minByte = 0;
+    if (buildNode->children.empty() == false) {
+      uint8_t minByte = 0xff;
+      uint8_t maxByte = 0;
+      for (auto& child : buildNode->children) {
+        const uint8_t byte = child->label[0];
+        minByte = std::min(minByte, byte);
+        maxByte = std::max(maxByte, byte);
+      }
+      node.minByte = minByte;
+      node.dispatchLength = maxByte - minByte + 1;
+      this->dispatch_.resize(this->dispatch_.size() + node.dispatchLength, 0);
+
+      this->nodes_.resize(this->nodes_.size() + buildNode->children.size());
+      for (size_t c = 0; buildNode->children.size() > c; ++c) {
+        const uint8_t byte = buildNode->children[c]->label[0];
+        this->dispatch_[node.dispatchOffset + byte - minByte] = c + 1;
+        queue.emplace_back(buildNode->children[c].get(), node.firstChild + c);
+      }
+    }
+
+    node.paramChild = NONE;
+    if (buildNode->paramChild != nullptr) {
+      node.paramChild = this->nodes_.size();
+      this->nodes_.emplace_back();
+      queue.emplace_back(buildNode->paramChild.get(), node.paramChild);
+    }
+    node.wildcardChild = NONE;
+    if (buildNode->wildcardChild != nullptr) {
+      node.wildcardChild = this->nodes_.size();
+      this->nodes_.emplace_back();
+      queue.emplace_back(buildNode->wildcardChild.get(), node.wildcardChild);
+    }
+
+    this->nodes_[queue[i].second] = node;
+  }
+
+  this->nodes_.shrink_to_fit();
+  this->dispatch_.shrink_to_fit();
+  this->isCompiled_ = true;
+}
+
+HttpRouter::Result HttpRouter::Match(RequestMethod method, const char* path, size_t length,
+                                     const Handler*& handler, Params& params) const {
+  if (this->isCompiled_ == false) {
+    throw Exception(ExceptionType::NOT_COMPILED);
+  }
+
+  const char* query = (const char*) memchr(path, '?', length);
+  if (query != nullptr) {
+    length = query - path;
+  }
+
+  params.size_ = 0;
+  uint32_t routeIndex = NONE;
+  if (this->matchNode(0, path, path + length, params, routeIndex) == false) {
+    return Result::NOT_FOUND;
+  }
+
+  const RouteEntry& route = this->routes_[routeIndex];
+  for (size_t i = 0; params.size_ > i; ++i) {
+    params.params_[i].name = route.paramNames[i].c_str();
+    params.params_[i].nameLength = route.paramNames[i].length();
+  }
+
+  const Handler* found = &route.handlers[static_cast<size_t>(method)];
+  if (!(*found) && method == RequestMethod::HEAD) {
+    found = &route.handlers[static_cast<size_t>(RequestMethod::GET)];
+  }
+  if (!(*found)) {
+    return Result::METHOD_NOT_ALLOWED;
+  }
+  handler = found;
+  return Result::FOUND;
+}
+
+bool HttpRouter::matchNode(uint32_t nodeIndex, const char* path, const char* end,
+                           Params& params, uint32_t& routeIndex) const {
+  const Node& node = this->nodes_[nodeIndex];
+  if ((size_t) (end - path) < node.labelLength ||
+      memcmp(path, this->labels_.data() + node.labelOffset, node.labelLength) != 0) {
+    return false;
+  }
+  path += node.labelLength;
+
+  if (path == end && node.routeIndex != NONE) {
+    routeIndex = node.routeIndex;
+    return true;
+  }
+
+  if (path != end && node.dispatchLength > 0) {
+    const size_t slot = (size_t) ((uint8_t) *path - node.minByte);
+    if (node.dispatchLength > slot) {
+      const uint16_t child = this->dispatch_[node.dispatchOffset + slot];
+      if (child != 0 &&
+          this->matchNode(node.firstChild + child - 1, path, end, params, routeIndex) == true) {
+        return true;
+      }
+    }
+  }
+
+  if (node.paramChild != NONE && path != end && *path != '/') {
+    const char* segmentEnd = (const char*) memchr(path, '/', end - path);
+    if (segmentEnd == nullptr) {
+      segmentEnd = end;
+    }
+    Param& param = params.params_[params.size_++];
+    param.value = path;
+    param.valueLength = segmentEnd - path;
+    if (this->matchNode(node.paramChild, segmentEnd, end, params, routeIndex) == true) {
+      return true;
+    }
+    params.size_ -= 1;
+  }
+
+  if (node.wildcardChild != NONE) {
+    Param& param = params.params_[params.size_++];
+    param.value = path;
+    param.valueLength = end - path;
+    routeIndex = this->nodes_[node.wildcardChild].routeIndex;
+    return true;
+  }
+
+  return false;
+}
+
+HttpRouter::Result HttpRouter::Route(HttpRequest& request, HttpResponseBuilder& response) const {
+  const string& uri = request.GetWholeUri();
+  const Handler* handler = nullptr;
+  Params params;
+  Result result = this->Match(request.GetRequestMethod(), uri.data(), uri.length(),
+                              handler, params);
+  if (result == Result::FOUND) {
+    (*handler)(request, response, params);
+  }
+  return result;
+}
+
+size_t HttpRouter::GetNumRoutes() const {
+  return this->routes_.size();
+}
+
+size_t HttpRouter::GetNumNodes() const {
+  return this->nodes_.size();
+}
+
+//HttpRouter::
+
+}
+
+#if _UNIT_TEST
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include <chrono>
+#include <string>
+#include <cstdlib>
+
+using namespace lio;
+using std::string;
+
+// Counts allocations so tests can check that matching does not allocate.
+// malloc is interposed rather than operator new, so that every form of new
+// and delete keeps its standard definition and the counter still sees them.
+static size_t numAllocations = 0;
+
+extern "C" void* __libc_malloc(size_t size);
+
+extern "C" void* malloc(size_t size) noexcept {
+  numAllocations += 1;
+  return __libc_malloc(size);
+}
+
+class HttpRouterTest : public ::testing::Test {
+protected:
+  void SetUp() {
+    const char* patterns[] = {
+      "/",
+      "/users",
+      "/users/:id",
+      "/users/:id/posts",
+      "/users/:id/posts/:postId",
+      "/users/me",
+      "/user",
+      "/static/*path",
+      "/files/:name/raw",
+      "/files/readme/raw2"
+    };
+    for (const char* pattern : patterns) {
+      const string name = pattern;
+      this->router.Add(RequestMethod::GET, name,
+          [this, name](HttpRequest&, HttpResponseBuilder&, const HttpRouter::Params&) {
+            this->lastPattern = name;
+          });
+    }
+    this->router.Add(RequestMethod::POST, "/users",
+        [this](HttpRequest&, HttpResponseBuilder&, const HttpRouter::Params&) {
+          this->lastPattern = "POST /users";
+        });
+    this->router.Compile();
+  }
+
+  string match(RequestMethod method, const string& path) {
+    // Params point into the path, so it has to outlive them.
+    this->path = path;
+    const HttpRouter::Handler* handler = nullptr;
+    HttpRouter::Result result = this->router.Match(
+        method, this->path.data(), this->path.length(), handler, this->params);
+    if (result == HttpRouter::Result::NOT_FOUND) {
+      return "404";
+    } else if (result == HttpRouter::Result::METHOD_NOT_ALLOWED) {
+      return "405";
+    }
+    (*handler)(this->request, this->response, this->params);
+    return this->lastPattern;
+  }
+
+  HttpRouter router;
+  string path;
+  HttpRouter::Params params;
+  HttpRequest request;
+  HttpResponseBuilder response;
+  string lastPattern;
+};
+
+TEST_F(HttpRouterTest, Static) {
+  EXPECT_EQ(this->match(RequestMethod::GET, "/"), "/");
+  EXPECT_EQ(this->match(RequestMethod::GET, "/users"), "/users");
+  EXPECT_EQ(this->match(RequestMethod::GET, "/user"), "/user");
+  EXPECT_EQ(this->match(RequestMethod::GET, "/users/me"), "/users/me");
+  EXPECT_EQ(this->match(RequestMethod::GET, "/users?sort=name"), "/users");
+  EXPECT_EQ(this->match(RequestMethod::GET, "/use"), "404");
+  EXPECT_EQ(this->match(RequestMethod::GET, "/usersx"), "404");
+  EXPECT_EQ(this->match(RequestMethod::GET, ""), "404");
+  EXPECT_EQ(this->params.GetSize(), 0);
+}
+
+TEST_F(HttpRouterTest, Params) {
+  EXPECT_EQ(this->match(RequestMethod::GET, "/users/42"), "/users/:id");
+  EXPECT_EQ(this->params.GetString("id"), "42");
+
+  EXPECT_EQ(this->match(RequestMethod::GET, "/users/42/posts/7?x=1"), "/users/:id/posts/:postId");
+  EXPECT_EQ(this->params.GetSize(), 2);
+  EXPECT_EQ(this->params.GetString("id"), "42");
+  EXPECT_EQ(this->params.GetString("postId"), "7");
+  EXPECT_EQ(this->params.Find("none"), nullptr);
+
+  // Static wins, parameter is tried when static fails further down.
+  EXPECT_EQ(this->match(RequestMethod::GET, "/users/me/posts"), "/users/:id/posts");
+  EXPECT_EQ(this->params.GetString("id"), "me");
+  EXPECT_EQ(this->match(RequestMethod::GET, "/files/readme/raw"), "/files/:name/raw");
+  EXPECT_EQ(this->params.GetString("name"), "readme");
+
+  EXPECT_EQ(this->match(RequestMethod::GET, "/users/"), "404");
+  EXPECT_EQ(this->match(RequestMethod::GET, "/users/42/"), "404");
+}
+
+TEST_F(HttpRouterTest, Wildcard) {
+  EXPECT_EQ(this->match(RequestMethod::GET, "/static/css/main.css"), "/static/*path");
+  EXPECT_EQ(this->params.GetString("path"), "css/main.css");
+  EXPECT_EQ(this->match(RequestMethod::GET, "/static/"), "/static/*path");
+  EXPECT_EQ(this->params.GetString("path"), "");
+}
+
+TEST_F(HttpRouterTest, Methods) {
+  EXPECT_EQ(this->match(RequestMethod::POST, "/users"), "POST /users");
+  EXPECT_EQ(this->match(RequestMethod::HEAD, "/users"), "/users");
+  EXPECT_EQ(this->match(RequestMethod::DELETE, "/users"), "405");
+  EXPECT_EQ(this->match(RequestMethod::POST, "/users/1"), "405");
+}
+
+TEST_F(HttpRouterTest, NoAllocation) {
+  const string path = "/users/42/posts/7";
+  const HttpRouter::Handler* handler = nullptr;
+  HttpRouter::Params params;
+
+  size_t numBefore = numAllocations;
+  for (int i = 0; 1000 > i; ++i) {
+    this->router.Match(RequestMethod::GET, path.data(), path.length(), handler, params);
+  }
+  EXPECT_EQ(numAllocations, numBefore);
+}
+
+TEST(HttpRouter, Errors) {
+  HttpRouter router;
+  auto handler = [](HttpRequest&, HttpResponseBuilder&, const HttpRouter::Params&) { };
+
+  const char* badPatterns[] = { "", "users", "/users/:", "/static/*path/more" };
+  for (const char* pattern : badPatterns) {
+    try {
+      router.Add(RequestMethod::GET, pattern, handler);
+      ADD_FAILURE() << pattern;
+    } catch (HttpRouter::Exception& e) {
+      EXPECT_EQ(e.type(), HttpRouter::ExceptionType::BAD_PATTERN);
+    }
+  }
+
+  router.Add(RequestMethod::GET, "/a/:id", handler);
+  try {
+    router.Add(RequestMethod::GET, "/a/:id", handler);
+    ADD_FAILURE();
+  } catch (HttpRouter::Exception& e) {
+    EXPECT_EQ(e.type(), HttpRouter::ExceptionType::DUPLICATE_ROUTE);
+  }
+  try {
+    router.Add(RequestMethod::POST, "/a/:name", handler);
+    ADD_FAILURE();
+  } catch (HttpRouter::Exception& e) {
+    EXPECT_EQ(e.type(), HttpRouter::ExceptionType::PARAM_NAME_CONFLICT);
+  }
+
+  const HttpRouter::Handler* found = nullptr;
+  HttpRouter::Params params;
+  EXPECT_THROW(router.Match(RequestMethod::GET, "/a/1", 4, found, params),
+               HttpRouter::Exception);
+  router.Compile();
+  EXPECT_EQ(router.Match(RequestMethod::GET, "/a/1", 4, found, params),
+            HttpRouter::Result::FOUND);
+}
+
+// What a router without a tree does: try every pattern segment by segment.
+static bool matchPattern(const string& pattern, const char* path, size_t length) {
+  size_t p = 0;
+  size_t i = 0;
+  while (pattern.length() > p) {
+    if (pattern[p] == '*') {
+      return true;
+    } else if (pattern[p] == ':') {
+      if (length == i || path[i] == '/') {
+        return false;
+      }
+      while (pattern.length() > p && pattern[p] != '/') {
+        p += 1;
+      }
+      while (length > i && path[i] != '/') {
+        i += 1;
+      }
+    } else {
+      if (length == i || pattern[p] != path[i]) {
+        return false;
+      }
+      p += 1;
+      i += 1;
+    }
+  }
+  return i == length;
+}
+
+TEST(HttpRouter, Benchmark) {
+  PERFTEST {
+    const size_t NUM_ROUTES = 1000;
+    const size_t NUM_LOOKUPS = 2000000;
+
+    std::vector<string> patterns;
+    std::vector<string> paths;
+    for (size_t i = 0; NUM_ROUTES > i; ++i) {
+      const string n = std::to_string(i);
+      switch (i % 4) {
+      case 0:
+        patterns.push_back("/api/v1/resource" + n + "/list");
+        paths.push_back("/api/v1/resource" + n + "/list");
+        break;
+      case 1:
+        patterns.push_back("/api/v1/resource" + n + "/:id");
+        paths.push_back("/api/v1/resource" + n + "/12345?fields=all");
+        break;
+      case 2:
+        patterns.push_back("/users/:userId/group" + n + "/:itemId/detail");
+        paths.push_back("/users/u9876/group" + n + "/item42/detail");
+        break;
+      case 3:
+        patterns.push_back("/static/bundle" + n + "/*path");
+        paths.push_back("/static/bundle" + n + "/js/app.min.js");
+        break;
+      }
+    }
+
+    HttpRouter router;
+    size_t numCalled = 0;
+    for (const string& pattern : patterns) {
+      router.Add(RequestMethod::GET, pattern,
+          [&numCalled](HttpRequest&, HttpResponseBuilder&, const HttpRouter::Params&) {
+            numCalled += 1;
+          });
+    }
+    router.Compile();
+    std::cout << NUM_ROUTES << " routes, " << router.GetNumNodes() << " nodes" << endl;
+
+    auto report = [](const char* name, std::chrono::steady_clock::time_point start) {
+      double seconds = std::chrono::duration<double>(
+          std::chrono::steady_clock::now() - start).count();
+      std::cout << name << ": " << (size_t) (NUM_LOOKUPS / seconds)
+                << " lookups/sec" << endl;
+    };
+
+    size_t numFound = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; NUM_LOOKUPS / 10 > i; ++i) {
+      const string& path = paths[(i * 7919) % paths.size()];
+      size_t length = path.find('?');
+      if (length == string::npos) {
+        length = path.length();
+      }
+      for (const string& pattern : patterns) {
+        if (matchPattern(pattern, path.data(), length) == true) {
+          numFound += 1;
+          break;
+        }
+      }
+    }
+    double seconds = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+    std::cout << "Linear scan  : " << (size_t) (NUM_LOOKUPS / 10 / seconds)
+              << " lookups/sec" << endl;
+    EXPECT_EQ(numFound, NUM_LOOKUPS / 10);
+
+    numFound = 0;
+    const HttpRouter::Handler* handler = nullptr;
+    HttpRouter::Params params;
+    const size_t numAllocationsBefore = numAllocations;
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; NUM_LOOKUPS > i; ++i) {
+      const string& path = paths[(i * 7919) % paths.size()];
+      if (router.Match(RequestMethod::GET, path.data(), path.length(),
+                       handler, params) == HttpRouter::Result::FOUND) {
+        numFound += 1;
+      }
+    }
+    report("HttpRouter   ", start);
+    EXPECT_EQ(numFound, NUM_LOOKUPS);
+    EXPECT_EQ(numAllocations, numAllocationsBefore);
+  }
+}
+
+int main (int argc, char** argv) {
+  ::testing::InitGoogleMock(&argc, argv);
+  return RUN_ALL_TESTS();
+}
+
+#else
+// Executable File's Main Comes here.
+
+
+#endif
+
+#undef _UNIT_TEST
@@ -0,0 +1,217 @@
+#ifndef _HTTPROUTER_HPP_
+#define _HTTPROUTER_HPP_
+/*
+  Name
+    HttpRouter
+      Maps request method and URI path to a handler.
+
+  Description
+    Patterns
+      /users              Static path.
+      /users/:id          Parameter. Matches one segment, up to the next '/'.
+      *path               Wildcard. Matches the rest of the path. Must be the
+                          last segment, as in "/static/" followed by "*path".
+
+      ':' and '*' are special only at the start of a segment.
+      A match prefers static, then parameter, then wildcard, and backtracks
+      when the preferred branch fails further down.
+
+    Routes are added to a radix tree built from heap nodes. Compile()
+    flattens it into one node array: static children of a node sit next
+    to each other, labels live in one string, and each node has a table
+    indexed by the first byte of its children's labels. Match() walks
+    that array with memcmp() and never allocates. Parameter values point
+    into the path that was passed in.
+
+    Call Compile() once after all routes are added. Adding a route later
+    requires another Compile().
+
+    HEAD falls back to the GET handler when no HEAD handler is set.
+
+  Last Modified Date
+    Oct 19, 2026
+
+  History
+    October 19, 2026
+      Created
+
+  ToDos
+
+
+  Milestones
+    1.0
+
+
+  Learning Resources
+    Radix tree
+      https://en.wikipedia.org/wiki/Radix_tree
+
+  Copyright (c) All rights reserved to LIFEINO.
+*/
+
+#ifdef _DEBUG
+  #undef _DEBUG
+#endif
+#define _DEBUG false
+
+#include "liolib/Debug.hpp"
+
+#include <string>
+#include <vector>
+#include <memory> // unique_ptr
+#include <functional> // function
+
+#include <cstdint>
+#include <cstring> // memcmp()
+
+#include "liolib/http/Http.hpp"
+#include "liolib/http/HttpRequest.hpp"
+#include "liolib/http/HttpResponseBuilder.hpp"
+
+namespace lio {
+
+using std::string;
+using lio::http::RequestMethod;
+
+
+class HttpRouter {
+public:
+
+// ******** Exception Declaration *********
+enum class ExceptionType : std::uint8_t {
+  GENERAL,
+  BAD_PATTERN,
+  TOO_MANY_PARAMS,
+  DUPLICATE_ROUTE,
+  PARAM_NAME_CONFLICT,
+  NOT_COMPILED
+};
+#define HTTPROUTER_EXCEPTION_MESSAGES \
+  "HttpRouter Exception has been thrown.", \
+  "Route pattern is invalid.", \
+  "Route pattern has too many parameters.", \
+  "Route is already registered for the method.", \
+  "Same route is registered with different parameter names.", \
+  "Compile() must be called before Match()."
+
+class Exception : public std::exception {
+public:
+  Exception (ExceptionType exceptionType = ExceptionType::GENERAL);
+
+  virtual const char*         what() const noexcept;
+  virtual const               ExceptionType type() const noexcept;
+
+private:
+  const ExceptionType         exceptionType_;
+  static const char* const    exceptionMessages_[];
+};
+// ******** Exception Declaration END*********
+
+  struct Param {
+    const char*     name;
+    size_t          nameLength;
+    const char*     value; // Points into the matched path.
+    size_t          valueLength;
+  };
+
+  class Params {
+  public:
+    static const size_t MAX_PARAMS = 8;
+
+    Params() : size_(0) { }
+
+    size_t          GetSize() const { return this->size_; }
+    const Param&    operator[](size_t index) const { return this->params_[index]; }
+
+    // Returns nullptr when there is no such parameter.
+    const Param*    Find(const char* name) const;
+    // Allocates. Empty string when there is no such parameter.
+    string          GetString(const char* name) const;
+
+  private:
+    friend class HttpRouter;
+
+    Param           params_[MAX_PARAMS];
+    size_t          size_;
+  };
+
+  typedef std::function<void(HttpRequest& request, HttpResponseBuilder& response,
+                             const Params& params)> Handler;
+
+  enum class Result : uint8_t {
+    FOUND,
+    NOT_FOUND,
+    METHOD_NOT_ALLOWED
+  };
+
+  HttpRouter();
+  ~HttpRouter();
+
+  void            Add(RequestMethod method, const string& pattern, Handler handler);
+  void            Compile();
+
+  // path ends at the first '?' or at length.
+  Result          Match(RequestMethod method, const char* path, size_t length,
+                        const Handler*& handler, Params& params) const;
+
+  // Matches the request URI and calls the handler when found.
+  Result          Route(HttpRequest& request, HttpResponseBuilder& response) const;
+
+  size_t          GetNumRoutes() const;
+  size_t          GetNumNodes() const;
+
+private:
+  static const size_t NUM_METHODS = static_cast<size_t>(RequestMethod::CONNECT) + 1;
+  static const uint32_t NONE = 0xffffffff;
+
+  struct RouteEntry {
+    string          pattern;
+    std::vector<string> paramNames;
+    Handler         handlers[NUM_METHODS];
+  };
+
+  // Node used while adding routes.
+  struct BuildNode {
+    BuildNode() : routeIndex(NONE) { }
+
+    string          label;
+    std::vector<std::unique_ptr<BuildNode>> children; // Static. Distinct first bytes.
+    std::unique_ptr<BuildNode> paramChild;
+    std::unique_ptr<BuildNode> wildcardChild;
+    uint32_t        routeIndex;
+  };
+
+  // Node of the compiled tree.
+  struct Node {
+    uint32_t        labelOffset;
+    uint32_t        labelLength;
+    uint32_t        firstChild; // Static children are nodes_[firstChild ...].
+    uint32_t        dispatchOffset;
+    uint16_t        dispatchLength;
+    uint8_t         minByte;
+    uint32_t        paramChild;
+    uint32_t        wildcardChild;
+    uint32_t        routeIndex;
+  };
+
+  BuildNode       root_;
+  std::vector<RouteEntry> routes_;
+
+  std::vector<Node> nodes_;
+  string          labels_;
+  // dispatch_[node.dispatchOffset + byte - node.minByte] is child number + 1, 0 if none.
+  std::vector<uint16_t> dispatch_;
+  bool            isCompiled_;
+
+  void            insertStatic(BuildNode*& node, const char* text, size_t length);
+  bool            matchNode(uint32_t nodeIndex, const char* path, const char* end,
+                            Params& params, uint32_t& routeIndex) const;
+
+  HttpRouter(const HttpRouter&) = delete;
+  HttpRouter& operator=(const HttpRouter&) = delete;
+};
+
+}
+
+#endif
+